@@ -13,8 +13,48 @@
 #include <debug.h>
 #include <elf.h>
 #include <error.h>
+#include <log.h>
 #include <serial.h>
 
+/**
+ * Boot log ring.
+ * Refer to definition in debug.h
+ */
+CHAR8 boot_log_buffer[BOOT_LOG_BUFFER_SIZE];
+/**
+ * Boot log length.
+ * Refer to definition in debug.h
+ */
+UINTN boot_log_length = 0;
+
+/**
+ * @brief Appends a line to the boot log.
+ * @param[in] line The null terminated line to append.
+ */
+static void append_to_boot_log(IN const CHAR16* line);
+
+
+/**
+ * append_to_boot_log
+ */
+static void append_to_boot_log(IN const CHAR16* line)
+{
+	/** The encoding of the current character. */
+	CHAR8 encoded[3];
+	/** The length of the encoding of the current character. */
+	UINTN encoded_length = 0;
+
+	while(*line) {
+		encoded_length = encode_utf8(*line++, encoded);
+
+		for(UINTN i = 0; i < encoded_length; i++) {
+			boot_log_buffer[boot_log_length & (BOOT_LOG_BUFFER_SIZE - 1)] = encoded[i];
+			boot_log_length++;
+		}
+	}
+}
+
+
 EFI_STATUS debug_print_line(IN CHAR16* fmt,
 	...)
 {
@@ -22,6 +62,20 @@ EFI_STATUS debug_print_line(IN CHAR16* fmt,
 	EFI_STATUS status;
 	/** The variadic argument list passed to the VSPrintf function. */
 	va_list args;
+
+	va_start(args, fmt);
+	status = debug_vprint_line(fmt, args);
+	va_end(args);
+
+	return status;
+}
+
+
+EFI_STATUS debug_vprint_line(IN CHAR16* fmt,
+	IN va_list args)
+{
+	/** Main bootloader application status. */
+	EFI_STATUS status;
 	/**
 	 * The output message buffer.
 	 * The string content is copied into this buffer. The maximum length is set
@@ -29,28 +83,51 @@ EFI_STATUS debug_print_line(IN CHAR16* fmt,
 	 */
 	CHAR16 output_message[MAX_SERIAL_OUT_STRING_LENGTH];
 
-	va_start(args, fmt);
+	VSPrint(output_message, MAX_SERIAL_OUT_STRING_LENGTH, fmt, args);
 
-	// If the serial service has been initialised, use this as the output medium.
-	// Otherwise use the default GNU-EFI output.
-	if(serial_service.protocol) {
-		VSPrint(output_message, MAX_SERIAL_OUT_STRING_LENGTH, fmt, args);
+	append_to_boot_log(output_message);
 
-		status = print_to_serial_out(serial_service.protocol, output_message);
-		if(EFI_ERROR(status)) {
-			Print(L"Error: Error printing to serial output: %s\n",
-				get_efi_error_message(status));
+	#if BOOT_LOG_SERIAL_MIRROR
+		// If the serial service has been initialised, use this as the output
+		// medium. Otherwise use the default GNU-EFI output.
+		if(serial_service.protocol) {
+			status = print_to_serial_out(&serial_service, output_message);
+			if(EFI_ERROR(status)) {
+				Print(L"Error: Error printing to serial output: %s\n",
+					get_efi_error_message(status));
 
-			return status;
+				return status;
+			}
+		} else {
+			Print(L"%s", output_message);
 		}
-	} else {
-		VPrint(fmt, args);
+	#else
+		(void)status;
+	#endif
+
+	return EFI_SUCCESS;
+};
+
+EFI_STATUS debug_flush(void)
+{
+	/** The program status. */
+	EFI_STATUS status;
+
+	// Output printed with the default GNU-EFI output is not buffered.
+	if(!serial_service.protocol) {
+		return EFI_SUCCESS;
 	}
 
-	va_end(args);
+	status = flush_serial_out(&serial_service);
+	if(EFI_ERROR(status)) {
+		Print(L"Error: Error flushing serial output: %s\n",
+			get_efi_error_message(status));
+
+		return status;
+	}
 
 	return EFI_SUCCESS;
-};
+}
 
 void debug_print_memory_map(
 	IN EFI_MEMORY_DESCRIPTOR* memory_map,
@@ -73,21 +150,19 @@ void debug_print_memory_map(
 		current_descriptor = (VOID*)memory_map + (i * descriptor_size);
 
 		if (current_descriptor->Attribute > 16) {
-			#ifdef DEBUG
-				debug_print_line(
-					L"Descriptor:\n"
-					L"  Type: %u\n"
-					L"  Physical Address: 0x%llx\n"
-					L"  Virtual Address: 0x%llx\n"
-					L"  Size In Pages: %u\n"
-					L"  Attributes: 0x%llx\n\n",
-					current_descriptor->Type,
-					current_descriptor->PhysicalStart,
-					current_descriptor->VirtualStart,
-					current_descriptor->NumberOfPages,
-					current_descriptor->Attribute
-				);
-			#endif
+			LOG_TRACE(
+				L"Descriptor:\n"
+				L"  Type: %u\n"
+				L"  Physical Address: 0x%llx\n"
+				L"  Virtual Address: 0x%llx\n"
+				L"  Size In Pages: %u\n"
+				L"  Attributes: 0x%llx\n\n",
+				current_descriptor->Type,
+				current_descriptor->PhysicalStart,
+				current_descriptor->VirtualStart,
+				current_descriptor->NumberOfPages,
+				current_descriptor->Attribute
+			);
 		}
 	}
 }
@@ -13,6 +13,7 @@
 #include <bootloader.h>
 #include <debug.h>
 #include <error.h>
+#include <log.h>
 
 /**
  * @brief Error message string buffer.
@@ -46,12 +47,22 @@ bool check_for_fatal_error(IN EFI_STATUS const status,
 		/** Input key type used to capture user input. */
 		EFI_INPUT_KEY input_key;
 
-		debug_print_line(L"Fatal Error: %s: %s\n", error_message,
+		LOG_ERROR(L"Fatal Error: %s: %s\n", error_message,
 			get_efi_error_message(status));
 
+		// Without the serial mirror the error would only be recorded in the boot
+		// log, which is never replayed if the kernel is not reached.
+		#if !BOOT_LOG_SERIAL_MIRROR
+			Print(L"Fatal Error: %s: %s\n", error_message,
+				get_efi_error_message(status));
+		#endif
+
 		#if PROMPT_FOR_INPUT_BEFORE_REBOOT_ON_FATAL_ERROR
-			debug_print_line(L"Press any key to reboot...");
+			LOG_ERROR(L"Press any key to reboot...");
+			debug_flush();
 			wait_for_input(&input_key);
+		#else
+			debug_flush();
 		#endif
 
 		return TRUE;
@@ -13,6 +13,7 @@
 #include <debug.h>
 #include <error.h>
 #include <fs.h>
+#include <log.h>
 
 
 /**
@@ -20,22 +21,18 @@
  */
 EFI_STATUS init_file_system_service(void)
 {
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Initialising File System service\n");
-	#endif
+	LOG_DEBUG(L"Debug: Initialising File System service\n");
 
 	EFI_STATUS status = uefi_call_wrapper(gBS->LocateProtocol, 3,
 		&gEfiSimpleFileSystemProtocolGuid, NULL, &file_system_service.protocol);
 	if(EFI_ERROR(status)) {
-		debug_print_line(L"Fatal Error: Error locating Simple File System Protocol: %s\n",
+		LOG_ERROR(L"Fatal Error: Error locating Simple File System Protocol: %s\n",
 			get_efi_error_message(status));
 
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Located Simple File System Protocol\n");
-	#endif
+	LOG_DEBUG(L"Debug: Located Simple File System Protocol\n");
 
 	return status;
 }
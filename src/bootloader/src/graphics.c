@@ -14,6 +14,7 @@
 #include <debug.h>
 #include <error.h>
 #include <graphics.h>
+#include <log.h>
 
 #define TEST_SCREEN_COL_NUM             4
 #define TEST_SCREEN_ROW_NUM             3
@@ -124,14 +125,12 @@ EFI_STATUS find_video_mode(IN EFI_GRAPHICS_OUTPUT_PROTOCOL* const protocol,
 
 	UINTN i = 0;
 	for(i = 0; i < protocol->Mode->MaxMode; i++) {
-		#ifdef DEBUG
-			debug_print_line(L"Debug: Testing video mode: '%llu'\n", i);
-		#endif
+		LOG_TRACE(L"Trace: Testing video mode: '%llu'\n", i);
 
 		status = uefi_call_wrapper(protocol->QueryMode, 4,
 			protocol, i, &size_of_mode_info, &mode_info);
 		if(EFI_ERROR(status)) {
-			debug_print_line(L"Error: Error querying video mode: %s\n",
+			LOG_ERROR(L"Error: Error querying video mode: %s\n",
 				get_efi_error_message(status));
 
 			return status;
@@ -141,10 +140,8 @@ EFI_STATUS find_video_mode(IN EFI_GRAPHICS_OUTPUT_PROTOCOL* const protocol,
 			mode_info->VerticalResolution == target_height &&
 			mode_info->PixelFormat == target_pixel_format) {
 
-			#ifdef DEBUG
-				debug_print_line(L"Debug: Matched video mode: '%llu' for '%lu*%lu*%u'\n", i,
-					target_width, target_height, target_pixel_format);
-			#endif
+			LOG_DEBUG(L"Debug: Matched video mode: '%llu' for '%lu*%lu*%u'\n", i,
+				target_width, target_height, target_pixel_format);
 
 			*video_mode = i;
 			return EFI_SUCCESS;
@@ -163,25 +160,21 @@ EFI_STATUS init_graphics_output_service(void)
 	/** Program status. */
 	EFI_STATUS status;
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Initialising Graphics Output Service\n");
-	#endif
+	LOG_DEBUG(L"Debug: Initialising Graphics Output Service\n");
 
 	// Populate graphics service handle buffer.
 	status = uefi_call_wrapper(gBS->LocateHandleBuffer, 5,
 		ByProtocol, &gEfiGraphicsOutputProtocolGuid, NULL,
 		&graphics_service.handle_count, &graphics_service.handle_buffer);
 	if(EFI_ERROR(status)) {
-		debug_print_line(L"Error: Error locating GOP handle buffer: %s\n",
+		LOG_ERROR(L"Error: Error locating GOP handle buffer: %s\n",
 			get_efi_error_message(status));
 
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Located GOP handle buffer with %u handles\n",
-			graphics_service.handle_count);
-	#endif
+	LOG_DEBUG(L"Debug: Located GOP handle buffer with %u handles\n",
+		graphics_service.handle_count);
 
 	return EFI_SUCCESS;
 }
@@ -210,7 +203,7 @@ EFI_STATUS set_graphics_mode(IN EFI_GRAPHICS_OUTPUT_PROTOCOL* const protocol,
 	status = uefi_call_wrapper(protocol->SetMode, 2,
 		protocol, graphics_mode_num);
 	if(EFI_ERROR(status)) {
-		debug_print_line(L"Error: Error setting graphics mode: %s\n",
+		LOG_ERROR(L"Error: Error setting graphics mode: %s\n",
 			get_efi_error_message(status));
 
 		return status;
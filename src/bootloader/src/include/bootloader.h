@@ -19,19 +19,50 @@
 /** The path to the kernel executable binary on the bootable media. */
 #define KERNEL_EXECUTABLE_PATH L"\\kernel.elf"
 
+/**
+ * The highest address of the page reserved for the kernel's application
+ * processor startup trampoline. Processors start in real mode at the page
+ * named by the startup IPI, which must lie in conventional memory, below the
+ * extended BIOS data area.
+ */
+#define AP_TRAMPOLINE_MAX_ADDRESS 0x9FFFF
+
 /**
  * Whether to prompt, and wait for user input before rebooting in the case
  * of an unrecoverable error.
  */
 #define PROMPT_FOR_INPUT_BEFORE_REBOOT_ON_FATAL_ERROR 1
 
+/**
+ * @brief Kernel boot video mode info struct.
+ * Describes the active video mode and its framebuffer. The pixel format and
+ * pixel bitmask are passed through unchanged from the Graphics Output Protocol
+ * mode info so that the kernel can encode colours for the framebuffer's actual
+ * layout. The framebuffer size is the size in bytes of the whole framebuffer,
+ * which may be larger than the visible area.
+ */
 typedef struct s_boot_video_info {
 	VOID* framebuffer_pointer;
 	UINT32 horizontal_resolution;
 	UINT32 vertical_resolution;
 	UINT32 pixels_per_scanline;
+	EFI_GRAPHICS_PIXEL_FORMAT pixel_format;
+	EFI_PIXEL_BITMASK pixel_information;
+	UINTN framebuffer_size;
 } Kernel_Boot_Video_Mode_Info;
 
+/**
+ * @brief Kernel boot log info struct.
+ * Describes the bootloader's log ring, so that the kernel can replay it.
+ * `length` is the total number of bytes ever written to the ring, which holds
+ * the last `size` bytes of them.
+ */
+typedef struct s_boot_log_info {
+	CHAR8* buffer;
+	UINTN size;
+	UINTN length;
+} Kernel_Boot_Log_Info;
+
 /**
  * @brief Kernel boot info struct.
  * Contains information passed to the kernel at boot time.
@@ -40,12 +71,20 @@ typedef struct s_boot_video_info {
  * This definition uses the `EFI_MEMORY_DESCRIPTOR` and `UINTN` types so that it will
  * automatically use the correct types for the target architecture. The corresponding
  * definition within the kernel should have more architecture-specific types.
+ * `acpi_rsdp` points to the ACPI root system description pointer found in the
+ * firmware's configuration table, or is NULL if there is none.
+ * `ap_trampoline` is a page below `AP_TRAMPOLINE_MAX_ADDRESS` reserved for the
+ * kernel's application processor startup trampoline, or is NULL if none could
+ * be allocated.
  */
 typedef struct s_boot_info {
 	EFI_MEMORY_DESCRIPTOR* memory_map;
 	UINTN memory_map_size;
 	UINTN memory_map_descriptor_size;
 	Kernel_Boot_Video_Mode_Info video_mode_info;
+	Kernel_Boot_Log_Info log_info;
+	VOID* acpi_rsdp;
+	VOID* ap_trampoline;
 } Kernel_Boot_Info;
 
 /**
@@ -1,11 +1,46 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 
+#include <efi.h>
+#include <efilib.h>
+#include <stdarg.h>
+
+/**
+ * The size of the boot log ring, in bytes. This must be a power of two.
+ */
+#define BOOT_LOG_BUFFER_SIZE 0x10000
+
+/**
+ * Whether debug output is mirrored to the serial port, or the console if no
+ * serial device is present, as well as being recorded in the boot log.
+ * With this disabled, output is only recorded in the boot log, which the
+ * kernel replays, and boot time does not depend on the amount logged.
+ */
+#ifndef BOOT_LOG_SERIAL_MIRROR
+#define BOOT_LOG_SERIAL_MIRROR 1
+#endif
+
+/**
+ * @brief The boot log ring.
+ * Every line of debug output is recorded here, transcoded to UTF-8. Once the
+ * ring is full, the oldest output is overwritten. The ring is left in memory
+ * for the kernel to replay.
+ */
+extern CHAR8 boot_log_buffer[BOOT_LOG_BUFFER_SIZE];
+
+/**
+ * @brief The total number of bytes written to the boot log.
+ * This keeps counting once the ring wraps, so the write position in the ring
+ * is this modulo `BOOT_LOG_BUFFER_SIZE`.
+ */
+extern UINTN boot_log_length;
+
 /**
  * @brief Prints to the default debug output.
- * Prints a null terminated format string to a the default debug output device.
- * If the serial service has been initialised, this will be used by default,
- * otherwise the default GNU-EFI `Print` function will be used.
+ * Prints a null terminated format string to the boot log. If
+ * `BOOT_LOG_SERIAL_MIRROR` is enabled the line is also printed to the serial
+ * service if it has been initialised, otherwise with the default GNU-EFI
+ * `Print` function.
  * Accepts all standard format specifiers as used in `string.h` functions.
  * @param[in] fmt    The format line to print.
  * @param[in] ...    Arguments for the format line.
@@ -20,6 +55,30 @@
  */
 EFI_STATUS debug_print_line(IN CHAR16* fmt, ...);
 
+/**
+ * @brief Prints to the default debug output.
+ * Prints a format string with a variadic argument list. Refer to
+ * `debug_print_line`.
+ * @param[in] fmt     The format line to print.
+ * @param[in] args    Arguments for the format line.
+ * @return The program status.
+ * @retval EFI_SUCCESS    If the function executed successfully.
+ * @retval other          Any other value is an EFI error code.
+ */
+EFI_STATUS debug_vprint_line(IN CHAR16* fmt,
+	IN va_list args);
+
+/**
+ * @brief Flushes the default debug output.
+ * Serial output is buffered, and written to the device in large chunks. This
+ * writes any output still buffered. It must be called before exiting boot
+ * services, and before halting on an error, so that no output is lost.
+ * @return The program status.
+ * @retval EFI_SUCCESS    If the function executed successfully.
+ * @retval other          Any other value is an EFI error code.
+ */
+EFI_STATUS debug_flush(void);
+
 void debug_print_memory_map(
 	IN EFI_MEMORY_DESCRIPTOR* memory_map,
 	IN UINTN memory_map_size,
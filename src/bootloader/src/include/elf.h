@@ -116,6 +116,7 @@ typedef struct s_elf64_phdr {
 /**
  * @brief Prints ELF file information.
  * Prints information on the ELF file, as well as its program headers.
+ * This is only compiled in when `LOG_COMPILED_LEVEL` includes trace messages.
  * @param[in]   header_ptr A pointer to the ELF header buffer.
  * @param[in]   program_headers_ptr A pointer to the ELF program headers buffer.
  */
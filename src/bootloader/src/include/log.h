@@ -0,0 +1,103 @@
+/**
+ * @file log.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Levelled logging.
+ * Contains macros for logging at a given severity level. Levels more verbose
+ * than `LOG_COMPILED_LEVEL` are removed at compile time, with their arguments
+ * never evaluated. Levels that are compiled in are further filtered at runtime
+ * by `log_level`.
+ */
+
+#ifndef BOOTLOADER_LOG_H
+#define BOOTLOADER_LOG_H 1
+
+#include <efi.h>
+#include <efilib.h>
+
+/** Unrecoverable errors, and errors the user must see. */
+#define LOG_LEVEL_ERROR 0
+/** Recoverable problems. */
+#define LOG_LEVEL_WARN  1
+/** Boot milestones. */
+#define LOG_LEVEL_INFO  2
+/** The steps taken by each stage of the bootloader. */
+#define LOG_LEVEL_DEBUG 3
+/** Detailed dumps of data structures and individual operations. */
+#define LOG_LEVEL_TRACE 4
+
+/**
+ * The most verbose level compiled into the bootloader. This defaults to
+ * `LOG_LEVEL_TRACE` in DEBUG builds and `LOG_LEVEL_INFO` otherwise, and may be
+ * overridden from the build flags.
+ */
+#ifndef LOG_COMPILED_LEVEL
+	#ifdef DEBUG
+		#define LOG_COMPILED_LEVEL LOG_LEVEL_TRACE
+	#else
+		#define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+	#endif
+#endif
+
+/**
+ * @brief The runtime log level.
+ * Messages more verbose than this level are discarded. This defaults to
+ * `LOG_COMPILED_LEVEL`.
+ */
+extern UINTN log_level;
+
+/**
+ * @brief Prints a message at a given level.
+ * Prints a message to the default debug output if its level is enabled at
+ * runtime. This should not be called directly, the level macros should be
+ * used instead so that disabled levels are compiled out.
+ * @param[in] level    The message's level.
+ * @param[in] fmt      The format line to print.
+ * @param[in] ...      Arguments for the format line.
+ * @return The program status.
+ * @retval EFI_SUCCESS    If the function executed successfully, or the level
+ *                        is disabled.
+ * @retval other          Any other value is an EFI error code.
+ */
+EFI_STATUS log_print(IN UINTN const level,
+	IN CHAR16* fmt,
+	...);
+
+/**
+ * @brief Tests whether a level is enabled.
+ * Can be used to skip gathering data that is only logged.
+ */
+#define LOG_ENABLED(level) \
+	(((level) <= LOG_COMPILED_LEVEL) && ((level) <= log_level))
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_ERROR
+	#define LOG_ERROR(...) log_print(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+	#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_WARN
+	#define LOG_WARN(...) log_print(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+	#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_INFO
+	#define LOG_INFO(...) log_print(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+	#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_DEBUG
+	#define LOG_DEBUG(...) log_print(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+	#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+	#define LOG_TRACE(...) log_print(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+	#define LOG_TRACE(...) ((void)0)
+#endif
+
+#endif
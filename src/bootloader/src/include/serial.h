@@ -14,19 +14,36 @@
 
 /** The maximum string length able to be printed to the serial. */
 #define MAX_SERIAL_OUT_STRING_LENGTH 512
+/** The size of the serial output buffer, in bytes. */
+#define SERIAL_OUT_BUFFER_SIZE 4096
+/**
+ * The number of buffered lines after which the serial output buffer is
+ * flushed, so that output keeps up with a running bootloader.
+ */
+#define SERIAL_OUT_FLUSH_LINE_THRESHOLD 16
+/** The baud rate the serial device is configured with. */
+#define SERIAL_BAUD_RATE 115200
+/** The receive FIFO depth the serial device is configured with. */
+#define SERIAL_RECEIVE_FIFO_DEPTH 16
 
 /**
  * @brief The serial service.
  * Contains the variables necessary to use the UEFI serial service.
+ * Output is transcoded from UCS-2 to UTF-8 and accumulated in the output
+ * buffer, which is written to the device in as few calls as possible.
  */
 typedef struct s_uefi_serial_service {
 	EFI_SERIAL_IO_PROTOCOL* protocol;
+	CHAR8 output_buffer[SERIAL_OUT_BUFFER_SIZE];
+	UINTN output_length;
+	UINTN n_buffered_lines;
 } Uefi_Serial_Service;
 
 /**
  * @brief Configures an individual Serial IO protocol instance.
- * Configures an individual Serial IO protocol instance. Sets the baud rate and
- * other device-specific options.
+ * Configures an individual Serial IO protocol instance. Sets the baud rate,
+ * receive FIFO depth, and an 8N1 line format. If the device rejects these,
+ * the device's default attributes are used instead.
  * @param[in] protocol    The serial IO protocol instance to configure.
  * @return The program status.
  * @retval EFI_SUCCESS    If the function executed successfully.
@@ -44,20 +61,48 @@ EFI_STATUS configure_serial_protocol(IN EFI_SERIAL_IO_PROTOCOL* const protocol);
 EFI_STATUS init_serial_service(void);
 
 /**
- * @brief Prints to a serial protocol.
- * Prints a null terminated string to a particular serial protocol.
- * @param[in] protocol    The serial IO protocol instance to configure.
+ * @brief Transcodes a UCS-2 character to UTF-8.
+ * @param[in] c         The character to transcode.
+ * @param[out] output   The buffer to write the encoded bytes to. This must
+ *                      have room for at least three bytes.
+ * @return The number of bytes written.
+ * @note Unpaired surrogates cannot be encoded, and are written as `?`.
+ */
+UINTN encode_utf8(IN CHAR16 const c,
+	OUT CHAR8* output);
+
+/**
+ * @brief Prints to the serial service.
+ * Transcodes a null terminated string to UTF-8 and appends it to the serial
+ * service's output buffer. The buffer is flushed to the device when it fills,
+ * or once `SERIAL_OUT_FLUSH_LINE_THRESHOLD` lines have been buffered.
+ * @param[in,out] service The serial service to print to.
  * @param[in] line        The line to print.
  * @return The program status.
  * @retval EFI_SUCCESS            If the function executed successfully.
- * @retval EFI_INVALID_PARAMETER  If the supplied protocol is not properly
+ * @retval EFI_INVALID_PARAMETER  If the service's protocol is not properly
  *                                loaded or the supplied string is empty.
  * @retval EFI_BAD_BUFFER_SIZE    If the string is over the maximum length or
  *                                not properly null terminated.
  * @retval other                  Any other value is an EFI error code.
  * @warn If the string is not null terminated, this will result in an error.
  */
-EFI_STATUS print_to_serial_out(IN EFI_SERIAL_IO_PROTOCOL* const protocol,
+EFI_STATUS print_to_serial_out(IN Uefi_Serial_Service* const service,
 	IN CHAR16* line);
 
+/**
+ * @brief Flushes the serial service's output buffer.
+ * Writes all buffered output to the serial device. This must be called before
+ * exiting boot services, and before any fatal error handling, so that no
+ * buffered output is lost.
+ * @param[in,out] service The serial service to flush.
+ * @return The program status.
+ * @retval EFI_SUCCESS            If the function executed successfully.
+ * @retval EFI_INVALID_PARAMETER  If the service's protocol is not properly
+ *                                loaded.
+ * @retval EFI_DEVICE_ERROR       If the device stopped accepting output.
+ * @retval other                  Any other value is an EFI error code.
+ */
+EFI_STATUS flush_serial_out(IN Uefi_Serial_Service* const service);
+
 #endif
@@ -14,6 +14,7 @@
 #include <elf.h>
 #include <error.h>
 #include <loader.h>
+#include <log.h>
 #include <serial.h>
 
 /**
@@ -44,10 +45,8 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 	/** The number of bytes to zero fill. */
 	UINTN zero_fill_count = 0;
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Setting file pointer to segment "
-			"offset '0x%llx'\n", segment_file_offset);
-	#endif
+	LOG_TRACE(L"Trace: Setting file pointer to segment "
+		"offset '0x%llx'\n", segment_file_offset);
 
 	status = uefi_call_wrapper(kernel_img_file->SetPosition, 2,
 		kernel_img_file, segment_file_offset);
@@ -55,10 +54,8 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Allocating %lu pages at address '0x%llx'\n",
-			segment_page_count, segment_physical_address);
-	#endif
+	LOG_TRACE(L"Trace: Allocating %lu pages at address '0x%llx'\n",
+		segment_page_count, segment_physical_address);
 
 	status = uefi_call_wrapper(gBS->AllocatePages, 4,
 		AllocateAddress, EfiLoaderData, segment_page_count,
@@ -70,10 +67,8 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 	if(segment_file_size > 0) {
 		buffer_read_size = segment_file_size;
 
-		#ifdef DEBUG
-			debug_print_line(L"Debug: Allocating segment buffer with size '0x%llx'\n",
-				buffer_read_size);
-		#endif
+		LOG_TRACE(L"Trace: Allocating segment buffer with size '0x%llx'\n",
+			buffer_read_size);
 
 		status = uefi_call_wrapper(gBS->AllocatePool, 3,
 			EfiLoaderCode, buffer_read_size, (VOID**)&program_data);
@@ -81,10 +76,8 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 			return status;
 		}
 
-		#ifdef DEBUG
-			debug_print_line(L"Debug: Reading segment data with file size '0x%llx'\n",
-				buffer_read_size);
-		#endif
+		LOG_TRACE(L"Trace: Reading segment data with file size '0x%llx'\n",
+			buffer_read_size);
 
 		status = uefi_call_wrapper(kernel_img_file->Read, 3,
 			kernel_img_file, &buffer_read_size, (VOID*)program_data);
@@ -92,10 +85,8 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 			return status;
 		}
 
-		#ifdef DEBUG
-			debug_print_line(L"Debug: Copying segment to memory address '0x%llx'\n",
-				segment_physical_address);
-		#endif
+		LOG_TRACE(L"Trace: Copying segment to memory address '0x%llx'\n",
+			segment_physical_address);
 
 		status = uefi_call_wrapper(gBS->CopyMem, 3,
 			segment_physical_address, program_data, segment_file_size);
@@ -103,9 +94,7 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 			return status;
 		}
 
-		#ifdef DEBUG
-			debug_print_line(L"Debug: Freeing program section data buffer\n");
-		#endif
+		LOG_TRACE(L"Trace: Freeing program section data buffer\n");
 
 		status = uefi_call_wrapper(gBS->FreePool, 1, program_data);
 		if(check_for_fatal_error(status, L"Error freeing program section")) {
@@ -120,10 +109,8 @@ EFI_STATUS load_segment(IN EFI_FILE* const kernel_img_file,
 	zero_fill_count = segment_memory_size - segment_file_size;
 
 	if(zero_fill_count > 0) {
-		#ifdef DEBUG
-			debug_print_line(L"Debug: Zero-filling %llu bytes at address '0x%llx'\n",
-				zero_fill_count, zero_fill_start);
-		#endif
+		LOG_TRACE(L"Trace: Zero-filling %llu bytes at address '0x%llx'\n",
+			zero_fill_count, zero_fill_start);
 
 		status = uefi_call_wrapper(gBS->SetMem, 3,
 			zero_fill_start, zero_fill_count, 0);
@@ -161,16 +148,14 @@ EFI_STATUS load_program_segments(IN EFI_FILE* const kernel_img_file,
 
 	// Exit if there are no executable sections in the kernel image.
 	if(n_program_headers == 0) {
-		debug_print_line(
+		LOG_ERROR(
 			L"Fatal Error: No program segments to load in Kernel image\n"
 		);
 
 		return EFI_INVALID_PARAMETER;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Loading %u segments\n", n_program_headers);
-	#endif
+	LOG_DEBUG(L"Debug: Loading %u segments\n", n_program_headers);
 
 
 	if(file_class == ELF_FILE_CLASS_32) {
@@ -216,8 +201,8 @@ EFI_STATUS load_program_segments(IN EFI_FILE* const kernel_img_file,
 
 	// If we have found no loadable segments, raise an exception.
 	if(n_segments_loaded == 0) {
-		debug_print_line(L"Fatal Error: No loadable program segments ");
-		debug_print_line(L"found in Kernel image\n");
+		LOG_ERROR(L"Fatal Error: No loadable program segments "
+			L"found in Kernel image\n");
 
 		return EFI_NOT_FOUND;
 	}
@@ -246,9 +231,7 @@ EFI_STATUS load_kernel_image(IN EFI_FILE* const root_file_system,
 	/** The ELF file class. */
 	Elf_File_Class file_class = ELF_FILE_CLASS_NONE;
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Reading kernel image file\n");
-	#endif
+	LOG_DEBUG(L"Debug: Reading kernel image file\n");
 
 	status = uefi_call_wrapper(root_file_system->Open, 5,
 		root_file_system, &kernel_img_file, kernel_image_filename,
@@ -274,9 +257,7 @@ EFI_STATUS load_kernel_image(IN EFI_FILE* const root_file_system,
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: ELF header is valid\n");
-	#endif
+	LOG_DEBUG(L"Debug: ELF header is valid\n");
 
 	// Free identity buffer.
 	status = uefi_call_wrapper(gBS->FreePool, 1, elf_identity_buffer);
@@ -292,8 +273,10 @@ EFI_STATUS load_kernel_image(IN EFI_FILE* const root_file_system,
 		return status;
 	}
 
-	#ifdef DEBUG
-		print_elf_file_info(kernel_header, kernel_program_headers);
+	#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+		if(LOG_ENABLED(LOG_LEVEL_TRACE)) {
+			print_elf_file_info(kernel_header, kernel_program_headers);
+		}
 	#endif
 
 	// Set the kernel entry point to the address specified in the ELF header.
@@ -312,27 +295,21 @@ EFI_STATUS load_kernel_image(IN EFI_FILE* const root_file_system,
 	}
 
 	// Cleanup.
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Closing kernel binary\n");
-	#endif
+	LOG_DEBUG(L"Debug: Closing kernel binary\n");
 
 	status = uefi_call_wrapper(kernel_img_file->Close, 1, kernel_img_file);
 	if(check_for_fatal_error(status, L"Error closing kernel image")) {
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Freeing kernel header buffer\n");
-	#endif
+	LOG_DEBUG(L"Debug: Freeing kernel header buffer\n");
 
 	status = uefi_call_wrapper(gBS->FreePool, 1, (VOID*)kernel_header);
 	if(check_for_fatal_error(status, L"Error freeing kernel header buffer")) {
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Freeing kernel program header buffer\n");
-	#endif
+	LOG_DEBUG(L"Debug: Freeing kernel program header buffer\n");
 
 	status = uefi_call_wrapper(gBS->FreePool, 1, (VOID*)kernel_program_headers);
 	if(check_for_fatal_error(status, L"Error freeing kernel program headers buffer")) {
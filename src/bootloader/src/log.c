@@ -0,0 +1,44 @@
+/**
+ * @file log.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Levelled logging.
+ * Contains the implementation of levelled logging.
+ */
+
+#include <efi.h>
+#include <efilib.h>
+#include <stdarg.h>
+
+#include <debug.h>
+#include <log.h>
+
+/**
+ * Runtime log level.
+ * Refer to definition in log.h
+ */
+UINTN log_level = LOG_COMPILED_LEVEL;
+
+
+/**
+ * log_print
+ */
+EFI_STATUS log_print(IN UINTN const level,
+	IN CHAR16* fmt,
+	...)
+{
+	/** The program status. */
+	EFI_STATUS status;
+	/** The variadic argument list. */
+	va_list args;
+
+	if(level > log_level) {
+		return EFI_SUCCESS;
+	}
+
+	va_start(args, fmt);
+	status = debug_vprint_line(fmt, args);
+	va_end(args);
+
+	return status;
+}
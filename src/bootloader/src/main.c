@@ -18,6 +18,7 @@
 #include <error.h>
 #include <fs.h>
 #include <graphics.h>
+#include <log.h>
 #include <serial.h>
 #include <memory_map.h>
 
@@ -82,12 +83,16 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 	void (*kernel_entry)(Kernel_Boot_Info* boot_info);
 	/** Boot info struct, passed to the kernel. */
 	Kernel_Boot_Info boot_info = {0};
+	/** The address of the application processor startup trampoline page. */
+	EFI_PHYSICAL_ADDRESS ap_trampoline = AP_TRAMPOLINE_MAX_ADDRESS;
 	/** Input key type used to capture user input. */
 	EFI_INPUT_KEY input_key;
 
 	// Initialise service protocols to NULL, so that we can detect if they are
 	// properly initialised in service functions.
 	serial_service.protocol = NULL;
+	serial_service.output_length = 0;
+	serial_service.n_buffered_lines = 0;
 	file_system_service.protocol = NULL;
 
 	// Initialise the UEFI lib.
@@ -109,15 +114,16 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 	status = init_serial_service();
 	if(EFI_ERROR(status)) {
 		if(status == EFI_NOT_FOUND) {
-			#ifdef DEBUG
-				debug_print_line(L"Debug: No serial device found\n");
-			#endif
+			LOG_DEBUG(L"Debug: No serial device found\n");
 		} else {
-			debug_print_line(L"Fatal Error: Error initialising Serial IO service\n");
+			LOG_ERROR(L"Fatal Error: Error initialising Serial IO service\n");
 
 			#if PROMPT_FOR_INPUT_BEFORE_REBOOT_ON_FATAL_ERROR
-				debug_print_line(L"Press any key to reboot...");
+				LOG_ERROR(L"Press any key to reboot...");
+				debug_flush();
 				wait_for_input(&input_key);
+			#else
+				debug_flush();
 			#endif
 
 			return status;
@@ -128,15 +134,16 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 	status = init_graphics_output_service();
 	if(EFI_ERROR(status)) {
 		if(status == EFI_NOT_FOUND) {
-			#ifdef DEBUG
-				debug_print_line(L"Debug: No graphics device found\n");
-			#endif
+			LOG_DEBUG(L"Debug: No graphics device found\n");
 		} else {
-			debug_print_line(L"Fatal Error: Error initialising Graphics service\n");
+			LOG_ERROR(L"Fatal Error: Error initialising Graphics service\n");
 
 			#if PROMPT_FOR_INPUT_BEFORE_REBOOT_ON_FATAL_ERROR
-				debug_print_line(L"Press any key to reboot...");
+				LOG_ERROR(L"Press any key to reboot...");
+				debug_flush();
 				wait_for_input(&input_key);
+			#else
+				debug_flush();
 			#endif
 
 			return status;
@@ -153,7 +160,7 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 		&graphics_output_protocol, ImageHandle,
 		NULL, EFI_OPEN_PROTOCOL_BY_HANDLE_PROTOCOL);
 	if(EFI_ERROR(status)) {
-		debug_print_line(L"Error: Failed to open the graphics output protocol on "
+		LOG_ERROR(L"Error: Failed to open the graphics output protocol on "
 			L"the active console output device: %s\n", get_efi_error_message(status));
 	}
 
@@ -164,6 +171,7 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 			TARGET_SCREEN_HEIGHT, TARGET_PIXEL_FORMAT);
 		if(EFI_ERROR(status)) {
 			// Error has already been printed.
+			debug_flush();
 			return status;
 		}
 
@@ -175,6 +183,12 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 			graphics_output_protocol->Mode->Info->VerticalResolution;
 		boot_info.video_mode_info.pixels_per_scanline =
 			graphics_output_protocol->Mode->Info->PixelsPerScanLine;
+		boot_info.video_mode_info.pixel_format =
+			graphics_output_protocol->Mode->Info->PixelFormat;
+		boot_info.video_mode_info.pixel_information =
+			graphics_output_protocol->Mode->Info->PixelInformation;
+		boot_info.video_mode_info.framebuffer_size =
+			graphics_output_protocol->Mode->FrameBufferSize;
 
 		#if DRAW_TEST_SCREEN != 0
 			draw_test_screen(graphics_output_protocol);
@@ -186,6 +200,7 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 	status = init_file_system_service();
 	if(EFI_ERROR(status)) {
 		// Error has already been printed.
+		debug_flush();
 		return status;
 	}
 
@@ -195,54 +210,84 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Loading Kernel image\n");
-	#endif
+	LOG_DEBUG(L"Debug: Loading Kernel image\n");
 
 	status = load_kernel_image(root_file_system, KERNEL_EXECUTABLE_PATH,
 		&kernel_entry_point);
 	if(EFI_ERROR(status)) {
 		// In the case that loading the kernel image failed, the error message will
 		// have already been printed.
+		debug_flush();
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Set Kernel Entry Point to: '0x%llx'\n",
-			kernel_entry_point);
-	#endif
+	LOG_INFO(L"Info: Kernel loaded, entry point: '0x%llx'\n",
+		kernel_entry_point);
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Closing Graphics Output Service handles\n");
-	#endif
+	// Find the ACPI tables for the kernel, preferring the ACPI 2.0 RSDP, which
+	// locates the 64-bit XSDT.
+	status = LibGetSystemConfigurationTable(&Acpi20TableGuid,
+		&boot_info.acpi_rsdp);
+	if(EFI_ERROR(status)) {
+		status = LibGetSystemConfigurationTable(&AcpiTableGuid,
+			&boot_info.acpi_rsdp);
+	}
+
+	if(EFI_ERROR(status)) {
+		boot_info.acpi_rsdp = NULL;
+		LOG_WARN(L"Warning: No ACPI RSDP found\n");
+	} else {
+		LOG_DEBUG(L"Debug: ACPI RSDP at '0x%llx'\n", boot_info.acpi_rsdp);
+	}
+
+	// Reserve a page in low memory for the kernel to start the other processors
+	// from. This is allocated as code, so that the firmware's page tables leave
+	// it executable.
+	status = uefi_call_wrapper(gBS->AllocatePages, 4,
+		AllocateMaxAddress, EfiLoaderCode, 1, &ap_trampoline);
+	if(EFI_ERROR(status)) {
+		boot_info.ap_trampoline = NULL;
+		LOG_WARN(L"Warning: Unable to reserve AP trampoline page\n");
+	} else {
+		boot_info.ap_trampoline = (VOID*)ap_trampoline;
+		LOG_DEBUG(L"Debug: AP trampoline page at '0x%llx'\n", ap_trampoline);
+	}
+
+	LOG_DEBUG(L"Debug: Closing Graphics Output Service handles\n");
 
 	status = close_graphic_output_service();
 	if(check_for_fatal_error(status, L"Error closing Graphics Output service")) {
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Getting memory map and exiting boot services\n");
-	#endif
+	LOG_DEBUG(L"Debug: Getting memory map and exiting boot services\n");
 
-	#ifdef DEBUG
-		// Fetch the memory map for debug printing, then free the buffer before
+	#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+		// Fetch the memory map for trace printing, then free the buffer before
 		// re-fetching immediately prior to ExitBootServices.
-		status = get_memory_map((VOID**)&memory_map, &memory_map_size,
-			&memory_map_key, &descriptor_size, &descriptor_version);
-		if(EFI_ERROR(status)) {
-			// Error has already been printed.
-			return status;
-		}
-
-		debug_print_memory_map(memory_map, memory_map_size, descriptor_size);
-
-		status = uefi_call_wrapper(gBS->FreePool, 1, memory_map);
-		if(check_for_fatal_error(status, L"Error freeing memory map buffer")) {
-			return status;
+		if(LOG_ENABLED(LOG_LEVEL_TRACE)) {
+			status = get_memory_map((VOID**)&memory_map, &memory_map_size,
+				&memory_map_key, &descriptor_size, &descriptor_version);
+			if(EFI_ERROR(status)) {
+				// Error has already been printed.
+				debug_flush();
+				return status;
+			}
+
+			debug_print_memory_map(memory_map, memory_map_size, descriptor_size);
+
+			status = uefi_call_wrapper(gBS->FreePool, 1, memory_map);
+			if(check_for_fatal_error(status, L"Error freeing memory map buffer")) {
+				return status;
+			}
 		}
 	#endif
 
+	// Flush any buffered output while boot services are still available.
+	// This is done before fetching the memory map, since the serial device may
+	// allocate memory while writing.
+	debug_flush();
+
 	// Re-fetch the memory map immediately before ExitBootServices to ensure
 	// the map key is current. No allocations or frees may occur between this
 	// call and ExitBootServices.
@@ -250,6 +295,7 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 		&memory_map_key, &descriptor_size, &descriptor_version);
 	if(EFI_ERROR(status)) {
 		// Error has already been printed.
+		debug_flush();
 		return status;
 	}
 
@@ -263,6 +309,10 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle,
 	boot_info.memory_map = memory_map;
 	boot_info.memory_map_size = memory_map_size;
 	boot_info.memory_map_descriptor_size = descriptor_size;
+	// Nothing may be logged after this point, since it would not be replayed.
+	boot_info.log_info.buffer = boot_log_buffer;
+	boot_info.log_info.size = BOOT_LOG_BUFFER_SIZE;
+	boot_info.log_info.length = boot_log_length;
 
 	// Cast pointer to kernel entry.
 	kernel_entry = (void (*)(Kernel_Boot_Info*))kernel_entry_point;
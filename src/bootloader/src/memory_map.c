@@ -15,6 +15,7 @@
 #include <bootloader.h>
 #include <debug.h>
 #include <error.h>
+#include <log.h>
 #include <memory_map.h>
 
 /**
@@ -31,9 +32,7 @@ EFI_STATUS get_memory_map(OUT VOID** memory_map,
 	/** Input key type used to capture user input. */
 	EFI_INPUT_KEY input_key;
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Allocating memory map\n");
-	#endif
+	LOG_DEBUG(L"Debug: Allocating memory map\n");
 
 	status = uefi_call_wrapper(gBS->GetMemoryMap, 5,
 		memory_map_size, NULL, memory_map_key,
@@ -42,11 +41,11 @@ EFI_STATUS get_memory_map(OUT VOID** memory_map,
 		// This will always fail on the first attempt, this call will return the
 		// required buffer size.
 		if(status != EFI_BUFFER_TOO_SMALL) {
-			debug_print_line(L"Fatal Error: Error getting memory map size: %s\n",
+			LOG_ERROR(L"Fatal Error: Error getting memory map size: %s\n",
 				get_efi_error_message(status));
 
 			#if PROMPT_FOR_INPUT_BEFORE_REBOOT_ON_FATAL_ERROR
-				debug_print_line(L"Press any key to reboot...");
+				LOG_ERROR(L"Press any key to reboot...");
 				wait_for_input(&input_key);
 			#endif
 
@@ -54,19 +53,15 @@ EFI_STATUS get_memory_map(OUT VOID** memory_map,
 		}
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Memory map required size: %u\n", *memory_map_size);
-	#endif
+	LOG_TRACE(L"Trace: Memory map required size: %u\n", *memory_map_size);
 
 	// According to: https://stackoverflow.com/a/39674958/5931673
 	// Up to two new descriptors may be created in the process of allocating the
 	// new pool memory.
 	*memory_map_size += (2 * (*descriptor_size));
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Allocating memory map with size: %u\n",
-			*memory_map_size);
-	#endif
+	LOG_TRACE(L"Trace: Allocating memory map with size: %u\n",
+		*memory_map_size);
 
 	status = uefi_call_wrapper(gBS->AllocatePool, 3,
 		EfiLoaderData, *memory_map_size, (VOID**)memory_map);
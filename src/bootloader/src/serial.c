@@ -13,6 +13,7 @@
 #include <bootloader.h>
 #include <debug.h>
 #include <error.h>
+#include <log.h>
 #include <serial.h>
 
 
@@ -24,14 +25,21 @@ EFI_STATUS configure_serial_protocol(IN EFI_SERIAL_IO_PROTOCOL* const protocol)
 	/** The program status. */
 	EFI_STATUS status;
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Configuring serial IO protocol\n");
-	#endif
+	LOG_DEBUG(L"Debug: Configuring serial IO protocol\n");
 
 	status = uefi_call_wrapper(protocol->SetAttributes, 7,
-		protocol, 0, 0, 0, 0, 0, DefaultStopBits);
+		protocol, SERIAL_BAUD_RATE, SERIAL_RECEIVE_FIFO_DEPTH, 0, NoParity, 8,
+		OneStopBit);
 	if(EFI_ERROR(status)) {
-		debug_print_line(L"Error: Error configuring Serial Protocol: %s\n",
+		LOG_DEBUG(L"Debug: Serial device rejected attributes: %s, "
+			L"using defaults\n", get_efi_error_message(status));
+
+		status = uefi_call_wrapper(protocol->SetAttributes, 7,
+			protocol, 0, 0, 0, DefaultParity, 0, DefaultStopBits);
+	}
+
+	if(EFI_ERROR(status)) {
+		LOG_ERROR(L"Error: Error configuring Serial Protocol: %s\n",
 			get_efi_error_message(status));
 
 		return status;
@@ -49,22 +57,18 @@ EFI_STATUS init_serial_service(void)
 	/** The program status. */
 	EFI_STATUS status;
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Initialising Serial service\n");
-	#endif
+	LOG_DEBUG(L"Debug: Initialising Serial service\n");
 
 	status = uefi_call_wrapper(gBS->LocateProtocol, 3,
 		&gEfiSerialIoProtocolGuid, NULL, &serial_service.protocol);
 	if(EFI_ERROR(status)) {
-		debug_print_line(L"Error: Error locating Serial Protocol: %s\n",
+		LOG_ERROR(L"Error: Error locating Serial Protocol: %s\n",
 			get_efi_error_message(status));
 
 		return status;
 	}
 
-	#ifdef DEBUG
-		debug_print_line(L"Debug: Located Serial Protocol\n");
-	#endif
+	LOG_DEBUG(L"Debug: Located Serial Protocol\n");
 
 	status = configure_serial_protocol(serial_service.protocol);
 	if(EFI_ERROR(status)) {
@@ -75,22 +79,49 @@ EFI_STATUS init_serial_service(void)
 }
 
 
+/**
+ * encode_utf8
+ */
+UINTN encode_utf8(IN CHAR16 const c,
+	OUT CHAR8* output)
+{
+	if(c < 0x80) {
+		output[0] = (CHAR8)c;
+		return 1;
+	}
+
+	if(c < 0x800) {
+		output[0] = (CHAR8)(0xC0 | (c >> 6));
+		output[1] = (CHAR8)(0x80 | (c & 0x3F));
+		return 2;
+	}
+
+	if(c >= 0xD800 && c <= 0xDFFF) {
+		output[0] = '?';
+		return 1;
+	}
+
+	output[0] = (CHAR8)(0xE0 | (c >> 12));
+	output[1] = (CHAR8)(0x80 | ((c >> 6) & 0x3F));
+	output[2] = (CHAR8)(0x80 | (c & 0x3F));
+	return 3;
+}
+
+
 /**
  * print_to_serial_out
  */
-EFI_STATUS print_to_serial_out(IN EFI_SERIAL_IO_PROTOCOL* const protocol,
+EFI_STATUS print_to_serial_out(IN Uefi_Serial_Service* const service,
 	IN CHAR16* line)
 {
 	/** The program status. */
 	EFI_STATUS status;
-	/** The size of the buffer being printed. */
-	UINTN buffer_size = 0;
 	/** The length of the line to be printed. */
 	UINTN line_length = 0;
 
 	// If the supplied protocol has not been loaded properly or the supplied
 	// string is empty, raise an exception.
-	if(protocol == NULL ||
+	if(service->protocol == NULL ||
 		line == NULL) {
 		return EFI_INVALID_PARAMETER;
 	}
@@ -107,27 +138,72 @@ EFI_STATUS print_to_serial_out(IN EFI_SERIAL_IO_PROTOCOL* const protocol,
 		return EFI_INVALID_PARAMETER;
 	}
 
-	// Set the buffer size to be printed to the line length.
-	// This will be checked afterwards to determine if the full line was printed.
-	// Buffer size is double the line length to take into account the double
-	// width unicode characters.
-	buffer_size = line_length * 2;
+	for(UINTN i = 0; i < line_length; i++) {
+		// Make room for the longest possible encoding of a character.
+		if((service->output_length + 3) > SERIAL_OUT_BUFFER_SIZE) {
+			status = flush_serial_out(service);
+			if(EFI_ERROR(status)) {
+				return status;
+			}
+		}
+
+		service->output_length += encode_utf8(line[i],
+			&service->output_buffer[service->output_length]);
+
+		if(line[i] == L'\n') {
+			service->n_buffered_lines++;
+		}
+	}
 
-	status = uefi_call_wrapper(protocol->Write, 3,
-		protocol, &buffer_size, (VOID*)line);
-	if(EFI_ERROR(status)) {
-		// Fall back to using EFI built-in `debug_print_line` function in this case.
-		debug_print_line(L"Error: Error writing to serial protocol: %s\n",
-			get_efi_error_message(status));
+	if(service->n_buffered_lines >= SERIAL_OUT_FLUSH_LINE_THRESHOLD) {
+		return flush_serial_out(service);
+	}
 
-		return status;
+	return EFI_SUCCESS;
+}
+
+
+/**
+ * flush_serial_out
+ */
+EFI_STATUS flush_serial_out(IN Uefi_Serial_Service* const service)
+{
+	/** The program status. */
+	EFI_STATUS status = EFI_SUCCESS;
+	/** The number of bytes written so far. */
+	UINTN n_written = 0;
+	/** The size of the chunk being written. */
+	UINTN buffer_size = 0;
+
+	if(service->protocol == NULL) {
+		return EFI_INVALID_PARAMETER;
 	}
 
-	// Check if the actual printed length is equal to the expected length.
-	if(buffer_size != (line_length * 2)) {
-		debug_print_line(L"Error: Full string not printed to serial protocol\n");
-		return EFI_DEVICE_ERROR;
+	// The device may accept only part of the buffer before timing out, in which
+	// case the remainder is written with further calls.
+	while(n_written < service->output_length) {
+		buffer_size = service->output_length - n_written;
+
+		status = uefi_call_wrapper(service->protocol->Write, 3,
+			service->protocol, &buffer_size,
+			(VOID*)&service->output_buffer[n_written]);
+		if(EFI_ERROR(status) && status != EFI_TIMEOUT) {
+			break;
+		}
+
+		if(buffer_size == 0) {
+			status = EFI_DEVICE_ERROR;
+			break;
+		}
+
+		n_written += buffer_size;
+		status = EFI_SUCCESS;
 	}
 
-	return EFI_SUCCESS;
+	// The buffer is discarded even on error, so that a failing device cannot
+	// stall every subsequent print.
+	service->output_length = 0;
+	service->n_buffered_lines = 0;
+
+	return status;
 }
@@ -0,0 +1,125 @@
+/**
+ * @file acpi.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief ACPI functionality.
+ * Contains the implementation of ACPI table discovery.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <acpi.h>
+#include <string.h>
+
+/** The root table, either the XSDT or RSDT. NULL until initialised. */
+static const Acpi_Sdt_Header* root_table = NULL;
+/** The size of each entry in the root table, 8 for the XSDT, 4 for the RSDT. */
+static size_t root_entry_size = 0;
+
+/**
+ * @brief Tests whether a block of ACPI data has a valid checksum.
+ * @param[in] data The data.
+ * @param[in] length The length of the data.
+ * @return Whether the bytes of the data sum to zero.
+ */
+static bool checksum_valid(const void* data,
+	const size_t length);
+
+
+/**
+ * checksum_valid
+ */
+static bool checksum_valid(const void* data,
+	const size_t length)
+{
+	/** The bytes of the data. */
+	const uint8_t* bytes = data;
+	/** The sum of the bytes. */
+	uint8_t sum = 0;
+
+	for(size_t i = 0; i < length; i++) {
+		sum += bytes[i];
+	}
+
+	return sum == 0;
+}
+
+
+/**
+ * acpi_initialize
+ */
+bool acpi_initialize(const void* rsdp)
+{
+	/** The RSDP. */
+	const Acpi_Rsdp* pointer = rsdp;
+	/** The root table. */
+	const Acpi_Sdt_Header* table;
+
+	if(pointer == NULL ||
+		memcmp(pointer->signature, ACPI_RSDP_SIGNATURE, sizeof(pointer->signature)) != 0 ||
+		!checksum_valid(pointer, offsetof(Acpi_Rsdp, length))) {
+		return false;
+	}
+
+	if(pointer->revision >= 2 && pointer->xsdt_address != 0 &&
+		checksum_valid(pointer, pointer->length)) {
+		table = (const Acpi_Sdt_Header*)(uintptr_t)pointer->xsdt_address;
+		root_entry_size = sizeof(uint64_t);
+	} else {
+		table = (const Acpi_Sdt_Header*)(uintptr_t)pointer->rsdt_address;
+		root_entry_size = sizeof(uint32_t);
+	}
+
+	if(!checksum_valid(table, table->length)) {
+		return false;
+	}
+
+	root_table = table;
+
+	return true;
+}
+
+
+/**
+ * acpi_find_table
+ */
+const Acpi_Sdt_Header* acpi_find_table(const char* signature,
+	const size_t index)
+{
+	/** The root table's entries. */
+	const uint8_t* entries;
+	/** The number of entries in the root table. */
+	size_t n_entries;
+	/** The number of matching tables skipped so far. */
+	size_t n_skipped = 0;
+
+	if(root_table == NULL) {
+		return NULL;
+	}
+
+	entries = (const uint8_t*)(root_table + 1);
+	n_entries = (root_table->length - sizeof(Acpi_Sdt_Header)) / root_entry_size;
+
+	for(size_t i = 0; i < n_entries; i++) {
+		/** The address of the current table. Entries may be unaligned. */
+		uint64_t address = 0;
+		/** The current table. */
+		const Acpi_Sdt_Header* table;
+
+		memcpy(&address, entries + (i * root_entry_size), root_entry_size);
+		table = (const Acpi_Sdt_Header*)(uintptr_t)address;
+
+		if(table == NULL || memcmp(table->signature, signature, 4) != 0) {
+			continue;
+		}
+
+		if(n_skipped++ < index) {
+			continue;
+		}
+
+		return checksum_valid(table, table->length) ? table : NULL;
+	}
+
+	return NULL;
+}
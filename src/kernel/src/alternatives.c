@@ -0,0 +1,116 @@
+/**
+ * @file alternatives.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Boot-time code patching.
+ * Contains the implementation of static call patching.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <alternatives.h>
+#include <cpu.h>
+
+/** The start of the alternatives section. Defined in kernel.ld. */
+extern const Alternative_Call alternatives_start[];
+/** The end of the alternatives section. Defined in kernel.ld. */
+extern const Alternative_Call alternatives_end[];
+
+/**
+ * @brief Tests whether an alternative is the best applicable to its trampoline.
+ * @param[in] alternative The alternative.
+ * @return Whether the processor supports the alternative, and no other
+ * supported alternative for the same trampoline has a higher priority.
+ */
+static bool is_best_alternative(const Alternative_Call* alternative);
+
+/**
+ * @brief Patches a static call trampoline to jump to a new target.
+ * @param[in] trampoline The trampoline.
+ * @param[in] target The new target.
+ * @return Whether the trampoline was patched. This fails if the trampoline
+ * does not hold a `jmp rel32`.
+ */
+static bool patch_trampoline(const void* trampoline,
+	const void* target);
+
+
+/**
+ * is_best_alternative
+ */
+static bool is_best_alternative(const Alternative_Call* alternative)
+{
+	if(!cpu_has_feature(alternative->feature)) {
+		return false;
+	}
+
+	for(const Alternative_Call* other = alternatives_start;
+		other < alternatives_end; other++) {
+		if(other->trampoline == alternative->trampoline &&
+			other->priority > alternative->priority &&
+			cpu_has_feature(other->feature)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * patch_trampoline
+ */
+static bool patch_trampoline(const void* trampoline,
+	const void* target)
+{
+	/** The trampoline's instruction bytes. */
+	volatile uint8_t* code = (volatile uint8_t*)trampoline;
+	/** The jump's displacement, relative to the end of the instruction. */
+	const int64_t displacement = (intptr_t)target - ((intptr_t)trampoline + 5);
+
+	if(code[0] != STATIC_CALL_JMP_OPCODE) {
+		return false;
+	}
+
+	if(displacement < INT32_MIN || displacement > INT32_MAX) {
+		return false;
+	}
+
+	*(volatile int32_t*)(code + 1) = (int32_t)displacement;
+
+	return true;
+}
+
+
+/**
+ * alternatives_apply
+ */
+size_t alternatives_apply(void)
+{
+	/** The original value of CR0. */
+	const uint64_t cr0 = read_cr0();
+	/** CPUID output registers. */
+	uint32_t eax, ebx, ecx, edx;
+	/** The number of trampolines patched. */
+	size_t n_patched = 0;
+
+	// The kernel's code may be mapped read-only.
+	write_cr0(cr0 & ~CR0_WP);
+
+	for(const Alternative_Call* alternative = alternatives_start;
+		alternative < alternatives_end; alternative++) {
+		if(is_best_alternative(alternative) &&
+			patch_trampoline(alternative->trampoline, alternative->target)) {
+			n_patched++;
+		}
+	}
+
+	write_cr0(cr0);
+
+	// A serialising instruction ensures no stale copy of the patched code is
+	// executed.
+	cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+
+	return n_patched;
+}
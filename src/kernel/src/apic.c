@@ -0,0 +1,344 @@
+/**
+ * @file apic.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Local APIC functionality.
+ * Contains the implementation of local APIC initialisation and IPIs.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <apic.h>
+#include <clock.h>
+#include <cpu.h>
+#include <paging.h>
+
+/** APIC base MSR: The local APIC is in x2APIC mode. */
+#define APIC_BASE_X2APIC_ENABLE      (1ULL << 10)
+/** APIC base MSR: The local APIC is enabled. */
+#define APIC_BASE_ENABLE             (1ULL << 11)
+/** APIC base MSR: The mask of the xAPIC registers' physical address. */
+#define APIC_BASE_ADDRESS_MASK       0x000FFFFFFFFFF000ULL
+
+/** The offset of the xAPIC ID register. */
+#define APIC_REGISTER_ID             0x20
+/** The offset of the end of interrupt register. */
+#define APIC_REGISTER_EOI            0xB0
+/** The offset of the spurious interrupt vector register. */
+#define APIC_REGISTER_SVR            0xF0
+/** The offset of the low half of the interrupt command register. */
+#define APIC_REGISTER_ICR_LOW        0x300
+/** The offset of the high half of the interrupt command register. */
+#define APIC_REGISTER_ICR_HIGH       0x310
+/** The offset of the timer local vector table register. */
+#define APIC_REGISTER_LVT_TIMER      0x320
+/** The offset of the timer initial count register. */
+#define APIC_REGISTER_TIMER_INITIAL  0x380
+/** The offset of the timer current count register. */
+#define APIC_REGISTER_TIMER_CURRENT  0x390
+/** The offset of the timer divide configuration register. */
+#define APIC_REGISTER_TIMER_DIVIDE   0x3E0
+/** The size of the xAPIC register block. */
+#define APIC_REGISTERS_SIZE          0x1000
+
+/**
+ * The first x2APIC MSR. Each xAPIC register at offset `n` is the MSR
+ * `APIC_X2APIC_MSR_BASE + (n >> 4)`.
+ */
+#define APIC_X2APIC_MSR_BASE         0x800
+
+/** CPUID leaf: Extended topology enumeration. */
+#define CPUID_LEAF_EXTENDED_TOPOLOGY  0xB
+/** The shift of the initial APIC ID in CPUID leaf 1's EBX. */
+#define CPUID_1_EBX_APIC_ID_SHIFT     24
+
+/** Spurious interrupt vector register: The local APIC is software enabled. */
+#define APIC_SVR_ENABLE              (1U << 8)
+
+/** Local vector table: The interrupt is masked. */
+#define APIC_LVT_MASKED              (1U << 16)
+/** Timer local vector table: Periodic mode. */
+#define APIC_LVT_TIMER_PERIODIC      (1U << 17)
+/** Timer divide configuration: Divide the bus clock by 16. */
+#define APIC_TIMER_DIVIDE_16         0x3
+/** The length of the timer calibration in microseconds. */
+#define APIC_TIMER_CALIBRATION_US    10000
+
+/** ICR delivery mode: Fixed. */
+#define APIC_ICR_FIXED               0x000
+/** ICR delivery mode: INIT. */
+#define APIC_ICR_INIT                0x500
+/** ICR delivery mode: Startup. */
+#define APIC_ICR_STARTUP             0x600
+/** ICR: The xAPIC has not yet accepted the last IPI. */
+#define APIC_ICR_DELIVERY_PENDING    (1U << 12)
+/** ICR: Level assert. Required for INIT. */
+#define APIC_ICR_ASSERT              (1U << 14)
+/** ICR destination shorthand: Every CPU but the sender. */
+#define APIC_ICR_ALL_EXCLUDING_SELF  (3U << 18)
+/** The shift of the APIC ID in the xAPIC ID register. */
+#define APIC_XAPIC_ID_SHIFT          24
+/** The shift of the destination in the xAPIC's high ICR register. */
+#define APIC_ICR_XAPIC_DEST_SHIFT    24
+
+/** Whether the x2APIC interface is in use. */
+static bool x2apic = false;
+/** The xAPIC registers. NULL if the x2APIC interface is in use. */
+static volatile uint32_t* apic_registers = NULL;
+/** The number of timer ticks per millisecond. Zero until calibrated. */
+static uint64_t timer_ticks_per_ms = 0;
+
+/**
+ * @brief Reads a local APIC register.
+ * @param[in] offset The xAPIC offset of the register.
+ * @return The value of the register.
+ */
+static inline uint32_t apic_read(const uint32_t offset);
+
+/**
+ * @brief Writes a local APIC register.
+ * @param[in] offset The xAPIC offset of the register.
+ * @param[in] value The value to write.
+ */
+static inline void apic_write(const uint32_t offset,
+	const uint32_t value);
+
+/**
+ * @brief Sends an IPI.
+ * In xAPIC mode this waits for the previous IPI to be accepted first, since
+ * the ICR cannot be written while delivery is pending.
+ * @param[in] destination The APIC ID of the target. Ignored with a
+ * destination shorthand.
+ * @param[in] command The low half of the ICR.
+ */
+static void send_ipi(const uint32_t destination,
+	const uint32_t command);
+
+
+/**
+ * apic_read
+ */
+static inline uint32_t apic_read(const uint32_t offset)
+{
+	if(x2apic) {
+		return (uint32_t)read_msr(APIC_X2APIC_MSR_BASE + (offset >> 4));
+	}
+
+	return apic_registers[offset / sizeof(uint32_t)];
+}
+
+
+/**
+ * apic_write
+ */
+static inline void apic_write(const uint32_t offset,
+	const uint32_t value)
+{
+	if(x2apic) {
+		write_msr(APIC_X2APIC_MSR_BASE + (offset >> 4), value);
+		return;
+	}
+
+	apic_registers[offset / sizeof(uint32_t)] = value;
+}
+
+
+/**
+ * send_ipi
+ */
+static void send_ipi(const uint32_t destination,
+	const uint32_t command)
+{
+	if(x2apic) {
+		// The x2APIC ICR is a single 64-bit MSR, written atomically.
+		write_msr(APIC_X2APIC_MSR_BASE + (APIC_REGISTER_ICR_LOW >> 4),
+			((uint64_t)destination << 32) | command);
+		return;
+	}
+
+	while(apic_read(APIC_REGISTER_ICR_LOW) & APIC_ICR_DELIVERY_PENDING) {
+		cpu_relax();
+	}
+
+	// Writing the low half sends the IPI, so the destination is written first.
+	apic_write(APIC_REGISTER_ICR_HIGH, destination << APIC_ICR_XAPIC_DEST_SHIFT);
+	apic_write(APIC_REGISTER_ICR_LOW, command);
+}
+
+
+/**
+ * apic_initialize
+ */
+bool apic_initialize(void)
+{
+	/** The value of the APIC base MSR. */
+	const uint64_t apic_base = read_msr(MSR_IA32_APIC_BASE);
+	/** The address of the xAPIC registers. */
+	uintptr_t base;
+	/** The memory type the registers are mapped with. */
+	Memory_Type type;
+
+	// The firmware may have already switched to x2APIC mode, which can only
+	// be left by disabling the local APIC.
+	x2apic = cpu_features.x2apic || (apic_base & APIC_BASE_X2APIC_ENABLE);
+
+	if(!x2apic) {
+		base = (uintptr_t)(apic_base & APIC_BASE_ADDRESS_MASK);
+
+		if(paging_get_memory_type(base, &type) != PAGING_SUCCESS) {
+			return false;
+		}
+
+		if(type != MEMORY_TYPE_UNCACHEABLE && type != MEMORY_TYPE_UNCACHED_MINUS &&
+			paging_set_memory_type(base, APIC_REGISTERS_SIZE,
+				MEMORY_TYPE_UNCACHEABLE) != PAGING_SUCCESS) {
+			return false;
+		}
+
+		apic_registers = (volatile uint32_t*)base;
+	}
+
+	apic_enable();
+
+	return true;
+}
+
+
+/**
+ * apic_enable
+ */
+void apic_enable(void)
+{
+	/** The value of the APIC base MSR. */
+	uint64_t apic_base = read_msr(MSR_IA32_APIC_BASE) | APIC_BASE_ENABLE;
+
+	// x2APIC mode can only be entered from xAPIC mode, once enabled.
+	write_msr(MSR_IA32_APIC_BASE, apic_base);
+	if(x2apic && !(apic_base & APIC_BASE_X2APIC_ENABLE)) {
+		apic_base |= APIC_BASE_X2APIC_ENABLE;
+		write_msr(MSR_IA32_APIC_BASE, apic_base);
+	}
+
+	apic_write(APIC_REGISTER_SVR, APIC_SVR_ENABLE | APIC_SPURIOUS_VECTOR);
+}
+
+
+/**
+ * apic_get_id
+ */
+uint32_t apic_get_id(void)
+{
+	if(x2apic) {
+		return apic_read(APIC_REGISTER_ID);
+	}
+
+	return apic_read(APIC_REGISTER_ID) >> APIC_XAPIC_ID_SHIFT;
+}
+
+
+/**
+ * apic_get_initial_id
+ */
+uint32_t apic_get_initial_id(void)
+{
+	/** The highest standard CPUID leaf. */
+	uint32_t max_leaf;
+	/** Unused CPUID output. */
+	uint32_t unused;
+	/** The CPUID register holding the APIC ID. */
+	uint32_t apic_id;
+
+	cpuid(0, 0, &max_leaf, &unused, &unused, &unused);
+
+	if(max_leaf >= CPUID_LEAF_EXTENDED_TOPOLOGY) {
+		cpuid(CPUID_LEAF_EXTENDED_TOPOLOGY, 0, &unused, &unused, &unused, &apic_id);
+		return apic_id;
+	}
+
+	cpuid(1, 0, &unused, &apic_id, &unused, &unused);
+
+	return apic_id >> CPUID_1_EBX_APIC_ID_SHIFT;
+}
+
+
+/**
+ * apic_send_end_of_interrupt
+ */
+void apic_send_end_of_interrupt(void)
+{
+	apic_write(APIC_REGISTER_EOI, 0);
+}
+
+
+/**
+ * apic_send_ipi
+ */
+void apic_send_ipi(const uint32_t apic_id,
+	const uint8_t vector)
+{
+	send_ipi(apic_id, APIC_ICR_FIXED | vector);
+}
+
+
+/**
+ * apic_timer_calibrate
+ */
+bool apic_timer_calibrate(void)
+{
+	/** The number of ticks counted during the calibration. */
+	uint32_t ticks;
+
+	apic_write(APIC_REGISTER_TIMER_DIVIDE, APIC_TIMER_DIVIDE_16);
+	apic_write(APIC_REGISTER_LVT_TIMER, APIC_LVT_MASKED);
+	apic_write(APIC_REGISTER_TIMER_INITIAL, UINT32_MAX);
+
+	clock_delay_us(APIC_TIMER_CALIBRATION_US);
+
+	ticks = UINT32_MAX - apic_read(APIC_REGISTER_TIMER_CURRENT);
+	apic_write(APIC_REGISTER_TIMER_INITIAL, 0);
+
+	timer_ticks_per_ms = ((uint64_t)ticks * 1000) / APIC_TIMER_CALIBRATION_US;
+
+	return timer_ticks_per_ms != 0;
+}
+
+
+/**
+ * apic_timer_start
+ */
+bool apic_timer_start(const uint8_t vector,
+	const uint32_t period_us)
+{
+	/** The timer period in ticks. */
+	const uint64_t period = (timer_ticks_per_ms * period_us) / 1000;
+
+	if(period == 0 || period > UINT32_MAX) {
+		return false;
+	}
+
+	apic_write(APIC_REGISTER_TIMER_DIVIDE, APIC_TIMER_DIVIDE_16);
+	apic_write(APIC_REGISTER_LVT_TIMER, APIC_LVT_TIMER_PERIODIC | vector);
+	apic_write(APIC_REGISTER_TIMER_INITIAL, (uint32_t)period);
+
+	return true;
+}
+
+
+/**
+ * apic_broadcast_init
+ */
+void apic_broadcast_init(void)
+{
+	send_ipi(0, APIC_ICR_INIT | APIC_ICR_ASSERT | APIC_ICR_ALL_EXCLUDING_SELF);
+}
+
+
+/**
+ * apic_broadcast_startup
+ */
+void apic_broadcast_startup(const uint8_t page)
+{
+	send_ipi(0, APIC_ICR_STARTUP | APIC_ICR_ASSERT |
+		APIC_ICR_ALL_EXCLUDING_SELF | page);
+}
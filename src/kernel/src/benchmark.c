@@ -0,0 +1,116 @@
+/**
+ * @file benchmark.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Kernel microbenchmarks.
+ * Contains the implementation of the benchmark registry, and result reporting.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <clock.h>
+#include <cpu.h>
+#include <log.h>
+#include <port_io.h>
+#include <printf.h>
+
+/** The size of the buffer a result line is formatted into. */
+#define BENCHMARK_LINE_SIZE          384
+
+/** The start of the benchmarks section. Defined in kernel.ld. */
+extern const Benchmark benchmarks_start[];
+/** The end of the benchmarks section. Defined in kernel.ld. */
+extern const Benchmark benchmarks_end[];
+
+
+/**
+ * benchmark_report
+ */
+void benchmark_report(const Benchmark_Result* result)
+{
+	/** The formatted result line. */
+	char line[BENCHMARK_LINE_SIZE];
+	/** The length of the line so far. */
+	size_t length = 0;
+	/** The time taken by the benchmark in nanoseconds. */
+	const uint64_t ns = clock_cycles_to_ns(result->cycles);
+	/** The number of operations, never zero. */
+	const uint64_t operations = result->operations ? result->operations : 1;
+
+	length += ksnprintf(line + length, BENCHMARK_LINE_SIZE - length,
+		"BENCH suite=%s name=%s variant=%s size=%lu ops=%lu cycles=%lu ns=%lu "
+		"cycles_per_op=%lu ns_per_op=%lu", result->suite, result->name,
+		result->variant ? result->variant : "default", result->size,
+		result->operations, result->cycles, ns, result->cycles / operations,
+		ns / operations);
+
+	if(result->bytes > 0) {
+		length += ksnprintf(line + length, BENCHMARK_LINE_SIZE - length,
+			" bytes=%lu bytes_per_s=%lu", result->bytes,
+			(uint64_t)(((unsigned __int128)result->bytes * 1000000000) / (ns + 1)));
+	}
+
+	for(size_t i = 0; i < BENCHMARK_MAX_COUNTERS; i++) {
+		if(result->counters[i].name != NULL) {
+			length += ksnprintf(line + length, BENCHMARK_LINE_SIZE - length,
+				" %s=%lu", result->counters[i].name, result->counters[i].value);
+		}
+	}
+
+	length += ksnprintf(line + length, BENCHMARK_LINE_SIZE - length, "\n");
+
+	// Written directly, since a result may be longer than `kprintf` allows.
+	log_output(line, length);
+}
+
+
+/**
+ * benchmark_skip
+ */
+void benchmark_skip(const char* suite,
+	const char* reason)
+{
+	kprintf("BENCH_SKIP suite=%s reason=%s\n", suite, reason);
+}
+
+
+/**
+ * benchmark_run_all
+ */
+uint64_t benchmark_run_all(void)
+{
+	/** The number of registered benchmarks. */
+	const uint64_t n_benchmarks = benchmarks_end - benchmarks_start;
+
+	kprintf("BENCH_BEGIN count=%lu cpu=%s tsc_hz=%lu invariant_tsc=%u\n",
+		n_benchmarks, cpu_features.vendor, kernel_clock.tsc_frequency,
+		kernel_clock.invariant_tsc);
+
+	for(const Benchmark* benchmark = benchmarks_start;
+		benchmark < benchmarks_end; benchmark++) {
+		/** The timestamp at the start of the benchmark. */
+		const uint64_t start = read_timestamp_counter();
+
+		benchmark->run();
+
+		kprintf("BENCH_DONE suite=%s ns=%lu\n", benchmark->name,
+			clock_cycles_to_ns(read_timestamp_counter() - start));
+		kflush();
+	}
+
+	kprintf("BENCH_END count=%lu\n", n_benchmarks);
+
+	return n_benchmarks;
+}
+
+
+/**
+ * benchmark_exit_emulator
+ */
+void benchmark_exit_emulator(void)
+{
+	kflush();
+
+	outb(BENCHMARK_EXIT_PORT, 0);
+}
@@ -0,0 +1,408 @@
+/**
+ * @file clock.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Clock functionality.
+ * Contains the implementation of TSC calibration, and the kernel clock.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <acpi.h>
+#include <clock.h>
+#include <cpu.h>
+#include <paging.h>
+#include <port_io.h>
+#include <spinlock.h>
+
+/** The frequency of the PIT's input clock in Hz. */
+#define PIT_FREQUENCY                1193182
+/** The PIT channel 2 data port. */
+#define PIT_CHANNEL_2_PORT           0x42
+/** The PIT mode/command port. */
+#define PIT_COMMAND_PORT             0x43
+/**
+ * The PIT command selecting channel 2, low then high byte access, mode 0
+ * (interrupt on terminal count), and a binary count.
+ */
+#define PIT_COMMAND_CHANNEL_2_MODE_0 0xB0
+/** The system control port, controlling the PIT channel 2 gate. */
+#define SYSTEM_CONTROL_PORT          0x61
+/** System control port: PIT channel 2 gate. */
+#define SYSTEM_CONTROL_PIT_GATE      (1U << 0)
+/** System control port: PC speaker enabled. */
+#define SYSTEM_CONTROL_SPEAKER       (1U << 1)
+/** System control port: PIT channel 2 output. */
+#define SYSTEM_CONTROL_PIT_OUTPUT    (1U << 5)
+
+/** The offset of the HPET general capabilities register. */
+#define HPET_CAPABILITIES            0x00
+/** The offset of the HPET general configuration register. */
+#define HPET_CONFIGURATION           0x10
+/** The offset of the HPET main counter. */
+#define HPET_MAIN_COUNTER            0xF0
+/** The size of the HPET register block. */
+#define HPET_REGISTERS_SIZE          0x400
+/** HPET capabilities: The main counter is 64 bits wide. */
+#define HPET_CAPABILITIES_64_BIT     (1ULL << 13)
+/** HPET configuration: The main counter is running. */
+#define HPET_CONFIGURATION_ENABLE    (1ULL << 0)
+/** The longest valid HPET period in femtoseconds, 100ns. */
+#define HPET_MAX_PERIOD              100000000ULL
+/** The number of femtoseconds in a second. */
+#define FEMTOSECONDS_PER_SECOND      1000000000000000ULL
+/** The number of nanoseconds in a second. */
+#define NANOSECONDS_PER_SECOND       1000000000ULL
+/**
+ * The TSC cycles after which a calibration run is abandoned, in case the
+ * reference timer is not counting. Ten times the expected run length at the
+ * fallback frequency.
+ */
+#define CALIBRATION_TIMEOUT_CYCLES \
+	((CLOCK_FALLBACK_FREQUENCY / 1000) * CLOCK_CALIBRATION_MS * 10)
+
+/**
+ * The kernel clock.
+ * Refer to definition in clock.h
+ */
+Clock kernel_clock = {
+	.reference = CLOCK_REFERENCE_NONE,
+	.tsc_frequency = CLOCK_FALLBACK_FREQUENCY,
+	.mult = (NANOSECONDS_PER_SECOND << CLOCK_SHIFT) / CLOCK_FALLBACK_FREQUENCY,
+	.spread = 0,
+	.boot_timestamp = 0,
+	.tsc_warp = 0,
+	.invariant_tsc = false,
+	.calibrated = false,
+	.tsc_sync_checked = false
+};
+
+/** The HPET's registers. NULL if there is no usable HPET. */
+static volatile uint64_t* hpet_registers = NULL;
+/** The HPET's counter period in femtoseconds. */
+static uint64_t hpet_period = 0;
+/** Whether the HPET's main counter is 64 bits wide. */
+static bool hpet_64_bit = false;
+
+/** The lock ordering TSC readings during the synchronisation check. */
+static Spinlock tsc_sync_lock = SPINLOCK_INITIALIZER;
+/** The last TSC reading taken during the synchronisation check. */
+static uint64_t tsc_sync_last = 0;
+/** The number of CPUs which have started the synchronisation check. */
+static uint32_t tsc_sync_arrived = 0;
+/** The number of CPUs which have finished the synchronisation check. */
+static uint32_t tsc_sync_departed = 0;
+
+/**
+ * @brief Finds and enables the HPET.
+ * Locates the HPET through its ACPI table, ensures its registers are mapped
+ * uncacheable, and starts its main counter.
+ * @return Whether the HPET can be used for calibration.
+ */
+static bool hpet_initialize(void);
+
+/**
+ * @brief Reads the HPET's main counter.
+ * @return The value of the main counter.
+ */
+static inline uint64_t hpet_read_counter(void);
+
+/**
+ * @brief Measures the TSC frequency against the HPET.
+ * @return The TSC frequency in Hz, or zero if it could not be measured.
+ */
+static uint64_t calibrate_hpet(void);
+
+/**
+ * @brief Measures the TSC frequency against the PIT.
+ * Counts TSC cycles while PIT channel 2 counts down `CLOCK_CALIBRATION_MS`.
+ * @return The TSC frequency in Hz, or zero if it could not be measured.
+ */
+static uint64_t calibrate_pit(void);
+
+/**
+ * @brief Calibrates the TSC against a reference timer.
+ * Runs `CLOCK_CALIBRATION_RUNS` measurements with interrupts disabled, and
+ * records the median.
+ * @param[in] reference The reference timer to calibrate against.
+ * @return Whether every measurement succeeded.
+ */
+static bool calibrate(const Clock_Reference reference);
+
+
+/**
+ * hpet_initialize
+ */
+static bool hpet_initialize(void)
+{
+	/** The HPET's ACPI table. */
+	const Acpi_Hpet* table =
+		(const Acpi_Hpet*)acpi_find_table(ACPI_HPET_SIGNATURE, 0);
+	/** The address of the HPET's registers. */
+	uintptr_t base;
+	/** The memory type the registers are mapped with. */
+	Memory_Type type;
+	/** The HPET's capabilities. */
+	uint64_t capabilities;
+
+	// Only memory mapped HPETs, address space zero, exist in practice.
+	if(table == NULL || table->base_address.address_space != 0 ||
+		table->base_address.address == 0) {
+		return false;
+	}
+
+	base = (uintptr_t)table->base_address.address;
+
+	// The registers are read in place, so they must be mapped, and a cached
+	// mapping would return stale counter values.
+	if(paging_get_memory_type(base, &type) != PAGING_SUCCESS) {
+		return false;
+	}
+
+	if(type != MEMORY_TYPE_UNCACHEABLE && type != MEMORY_TYPE_UNCACHED_MINUS &&
+		paging_set_memory_type(base, HPET_REGISTERS_SIZE,
+			MEMORY_TYPE_UNCACHEABLE) != PAGING_SUCCESS) {
+		return false;
+	}
+
+	hpet_registers = (volatile uint64_t*)base;
+
+	capabilities = hpet_registers[HPET_CAPABILITIES / sizeof(uint64_t)];
+	hpet_period = capabilities >> 32;
+	hpet_64_bit = (capabilities & HPET_CAPABILITIES_64_BIT) != 0;
+
+	if(hpet_period == 0 || hpet_period > HPET_MAX_PERIOD) {
+		hpet_registers = NULL;
+		return false;
+	}
+
+	hpet_registers[HPET_CONFIGURATION / sizeof(uint64_t)] |=
+		HPET_CONFIGURATION_ENABLE;
+
+	return true;
+}
+
+
+/**
+ * hpet_read_counter
+ */
+static inline uint64_t hpet_read_counter(void)
+{
+	return hpet_registers[HPET_MAIN_COUNTER / sizeof(uint64_t)];
+}
+
+
+/**
+ * calibrate_hpet
+ */
+static uint64_t calibrate_hpet(void)
+{
+	/** The number of HPET ticks in a calibration run. */
+	const uint64_t target_ticks = ((FEMTOSECONDS_PER_SECOND / 1000) *
+		CLOCK_CALIBRATION_MS) / hpet_period;
+	/** The mask of the counter's valid bits. */
+	const uint64_t counter_mask = hpet_64_bit ? UINT64_MAX : UINT32_MAX;
+	/** The HPET counter and TSC at the start of the run. */
+	uint64_t start_counter, start_tsc;
+	/** The HPET ticks elapsed. */
+	uint64_t ticks;
+	/** The TSC cycles elapsed. */
+	uint64_t cycles;
+
+	start_counter = hpet_read_counter();
+	start_tsc = read_timestamp_counter();
+
+	do {
+		ticks = (hpet_read_counter() - start_counter) & counter_mask;
+		cycles = read_timestamp_counter() - start_tsc;
+
+		if(cycles > CALIBRATION_TIMEOUT_CYCLES) {
+			return 0;
+		}
+	} while(ticks < target_ticks);
+
+	return (uint64_t)(((unsigned __int128)cycles * FEMTOSECONDS_PER_SECOND) /
+		((unsigned __int128)ticks * hpet_period));
+}
+
+
+/**
+ * calibrate_pit
+ */
+static uint64_t calibrate_pit(void)
+{
+	/** The PIT count for a calibration run. */
+	const uint16_t count = (PIT_FREQUENCY * CLOCK_CALIBRATION_MS) / 1000;
+	/** The TSC at the start of the run. */
+	uint64_t start_tsc;
+	/** The TSC cycles elapsed. */
+	uint64_t cycles;
+	/** The number of times the PIT output was polled. */
+	size_t n_polls = 0;
+
+	// Enable the channel 2 gate, with the speaker disconnected.
+	outb(SYSTEM_CONTROL_PORT,
+		(inb(SYSTEM_CONTROL_PORT) & ~SYSTEM_CONTROL_SPEAKER) | SYSTEM_CONTROL_PIT_GATE);
+
+	// In mode 0 the count starts once its high byte is written, and the output
+	// is raised when it reaches zero.
+	outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL_2_MODE_0);
+	outb(PIT_CHANNEL_2_PORT, count & 0xFF);
+	outb(PIT_CHANNEL_2_PORT, count >> 8);
+
+	start_tsc = read_timestamp_counter();
+	while((inb(SYSTEM_CONTROL_PORT) & SYSTEM_CONTROL_PIT_OUTPUT) == 0) {
+		n_polls++;
+
+		if((read_timestamp_counter() - start_tsc) > CALIBRATION_TIMEOUT_CYCLES) {
+			return 0;
+		}
+	}
+	cycles = read_timestamp_counter() - start_tsc;
+
+	// If the output was already high the PIT is missing, or not counting.
+	if(n_polls == 0) {
+		return 0;
+	}
+
+	return (cycles * 1000) / CLOCK_CALIBRATION_MS;
+}
+
+
+/**
+ * calibrate
+ */
+static bool calibrate(const Clock_Reference reference)
+{
+	/** The frequency measured by each run, in ascending order. */
+	uint64_t frequencies[CLOCK_CALIBRATION_RUNS];
+
+	for(size_t i = 0; i < CLOCK_CALIBRATION_RUNS; i++) {
+		/** The interrupt state to restore after the run. */
+		const uint64_t flags = save_and_disable_interrupts();
+		/** The frequency measured by this run. */
+		const uint64_t frequency = (reference == CLOCK_REFERENCE_HPET) ?
+			calibrate_hpet() : calibrate_pit();
+		/** The position to insert this run's frequency at. */
+		size_t position = i;
+
+		restore_interrupts(flags);
+
+		if(frequency == 0) {
+			return false;
+		}
+
+		for(; position > 0 && frequencies[position - 1] > frequency; position--) {
+			frequencies[position] = frequencies[position - 1];
+		}
+		frequencies[position] = frequency;
+	}
+
+	kernel_clock.reference = reference;
+	kernel_clock.tsc_frequency = frequencies[CLOCK_CALIBRATION_RUNS / 2];
+	kernel_clock.spread = frequencies[CLOCK_CALIBRATION_RUNS - 1] - frequencies[0];
+
+	return true;
+}
+
+
+/**
+ * clock_initialize
+ */
+bool clock_initialize(void)
+{
+	kernel_clock.invariant_tsc = cpu_features.invariant_tsc;
+
+	kernel_clock.calibrated = (hpet_initialize() && calibrate(CLOCK_REFERENCE_HPET)) ||
+		calibrate(CLOCK_REFERENCE_PIT);
+
+	if(!kernel_clock.calibrated) {
+		kernel_clock.reference = CLOCK_REFERENCE_NONE;
+		kernel_clock.tsc_frequency = CLOCK_FALLBACK_FREQUENCY;
+		kernel_clock.spread = 0;
+	}
+
+	kernel_clock.mult = (NANOSECONDS_PER_SECOND << CLOCK_SHIFT) /
+		kernel_clock.tsc_frequency;
+	kernel_clock.boot_timestamp = read_timestamp_counter();
+
+	return kernel_clock.calibrated;
+}
+
+
+/**
+ * clock_get_reference_name
+ */
+const char* clock_get_reference_name(const Clock_Reference reference)
+{
+	switch(reference) {
+		case CLOCK_REFERENCE_PIT:
+			return "PIT";
+		case CLOCK_REFERENCE_HPET:
+			return "HPET";
+		default:
+			return "none";
+	}
+}
+
+
+/**
+ * clock_ns_to_cycles
+ */
+uint64_t clock_ns_to_cycles(const uint64_t ns)
+{
+	return (uint64_t)(((unsigned __int128)ns * kernel_clock.tsc_frequency) /
+		NANOSECONDS_PER_SECOND);
+}
+
+
+/**
+ * clock_check_tsc_sync
+ */
+void clock_check_tsc_sync(const uint32_t n_cpus)
+{
+	/** The current TSC reading. */
+	uint64_t now;
+
+	// Every CPU starts together, so that their readings interleave.
+	__atomic_fetch_add(&tsc_sync_arrived, 1, __ATOMIC_ACQ_REL);
+	while(__atomic_load_n(&tsc_sync_arrived, __ATOMIC_ACQUIRE) < n_cpus) {
+		cpu_relax();
+	}
+
+	for(size_t i = 0; i < CLOCK_TSC_SYNC_ITERATIONS; i++) {
+		spinlock_acquire(&tsc_sync_lock);
+
+		now = read_timestamp_counter_ordered();
+		if(now < tsc_sync_last && (tsc_sync_last - now) > kernel_clock.tsc_warp) {
+			kernel_clock.tsc_warp = tsc_sync_last - now;
+		}
+		tsc_sync_last = now;
+
+		spinlock_release(&tsc_sync_lock);
+	}
+
+	__atomic_fetch_add(&tsc_sync_departed, 1, __ATOMIC_ACQ_REL);
+	while(__atomic_load_n(&tsc_sync_departed, __ATOMIC_ACQUIRE) < n_cpus) {
+		cpu_relax();
+	}
+
+	kernel_clock.tsc_sync_checked = true;
+}
+
+
+/**
+ * clock_delay_us
+ */
+void clock_delay_us(const uint64_t us)
+{
+	/** The TSC at the start of the delay. */
+	const uint64_t start = read_timestamp_counter();
+	/** The number of cycles to wait. */
+	const uint64_t cycles = clock_ns_to_cycles(us * 1000);
+
+	while((read_timestamp_counter() - start) < cycles) {
+		cpu_relax();
+	}
+}
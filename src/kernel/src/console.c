@@ -0,0 +1,553 @@
+/**
+ * @file console.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Framebuffer text console.
+ * Contains the implementation of the framebuffer text console.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <console.h>
+#include <cpu.h>
+#include <font.h>
+#include <graphics.h>
+#include <printf.h>
+#include <raster.h>
+#include <renderer.h>
+#include <simd.h>
+
+/** The default colour attribute, light grey on black. */
+#define CONSOLE_DEFAULT_ATTRIBUTE           0x07
+/** The number of lines written by the benchmark. */
+#define CONSOLE_BENCHMARK_LINES             1024
+/** The size of the benchmark's line buffer. */
+#define CONSOLE_BENCHMARK_LINE_BUFFER_SIZE  96
+
+/**
+ * Console instance.
+ * Refer to definition in console.h
+ */
+Console console;
+
+/**
+ * @brief The console palette.
+ * The canonical colours of the VGA text mode colour codes.
+ */
+static const uint32_t console_palette[16] = {
+	CANONICAL_COLOUR(0x00, 0x00, 0x00),
+	CANONICAL_COLOUR(0x00, 0x00, 0xAA),
+	CANONICAL_COLOUR(0x00, 0xAA, 0x00),
+	CANONICAL_COLOUR(0x00, 0xAA, 0xAA),
+	CANONICAL_COLOUR(0xAA, 0x00, 0x00),
+	CANONICAL_COLOUR(0xAA, 0x00, 0xAA),
+	CANONICAL_COLOUR(0xAA, 0x55, 0x00),
+	CANONICAL_COLOUR(0xAA, 0xAA, 0xAA),
+	CANONICAL_COLOUR(0x55, 0x55, 0x55),
+	CANONICAL_COLOUR(0x55, 0x55, 0xFF),
+	CANONICAL_COLOUR(0x55, 0xFF, 0x55),
+	CANONICAL_COLOUR(0x55, 0xFF, 0xFF),
+	CANONICAL_COLOUR(0xFF, 0x55, 0x55),
+	CANONICAL_COLOUR(0xFF, 0x55, 0xFF),
+	CANONICAL_COLOUR(0xFF, 0xFF, 0x55),
+	CANONICAL_COLOUR(0xFF, 0xFF, 0xFF)
+};
+
+/**
+ * @brief Gets the glyph cache entry for a colour attribute.
+ * Expands the glyph rows for the attribute into the least recently used entry
+ * if it is not already cached.
+ * @param[in,out] con The console.
+ * @param[in] attribute The colour attribute.
+ * @return The glyph cache entry.
+ */
+static const Console_Glyph_Cache_Entry* get_glyph_cache_entry(Console* con,
+	const uint8_t attribute);
+
+/**
+ * @brief Gets the cell at a screen position.
+ * @param[in,out] con The console.
+ * @param[in] x The column.
+ * @param[in] y The row, counted from the top of the screen.
+ * @return The cell.
+ */
+static inline Console_Cell* get_cell(Console* con,
+	const uint32_t x,
+	const uint32_t y);
+
+/**
+ * @brief Extends the dirty span of a row to cover a range of columns.
+ * @param[in,out] con The console.
+ * @param[in] y The row.
+ * @param[in] start The first column.
+ * @param[in] end The column after the last column.
+ */
+static void mark_cells_dirty(Console* con,
+	const uint32_t y,
+	const uint32_t start,
+	const uint32_t end);
+
+/**
+ * @brief Scrolls the console up by one line.
+ * Recycles the top row of the cell ring as a blank bottom row. The back buffer
+ * is not moved until the next flush.
+ * @param[in,out] con The console.
+ */
+static void scroll_line(Console* con);
+
+/**
+ * @brief Moves the cursor to the start of the next line.
+ * Scrolls the console if the cursor is on the last row.
+ * @param[in,out] con The console.
+ */
+static void new_line(Console* con);
+
+/**
+ * @brief Renders a span of cells into the back buffer.
+ * Renders the cells and marks the region they cover dirty.
+ * @param[in,out] con The console.
+ * @param[in] y The row.
+ * @param[in] start The first column.
+ * @param[in] end The column after the last column.
+ */
+static void render_cells(Console* con,
+	const uint32_t y,
+	const uint32_t start,
+	const uint32_t end);
+
+/**
+ * @brief Runs the console benchmark.
+ * Measures the cost of writing lines of text to the console, including the
+ * flushes they trigger, and of flushing a full screen of scrolled text. The
+ * console is cleared afterwards.
+ */
+static void console_run_benchmark(void);
+
+
+/**
+ * get_glyph_cache_entry
+ */
+static const Console_Glyph_Cache_Entry* get_glyph_cache_entry(Console* con,
+	const uint8_t attribute)
+{
+	/** The entry to expand the attribute into on a miss. */
+	Console_Glyph_Cache_Entry* victim = &con->glyph_cache[0];
+	/** The foreground colour. */
+	uint32_t foreground = 0;
+	/** The background colour. */
+	uint32_t background = 0;
+
+	con->cache_clock++;
+
+	for(size_t i = 0; i < CONSOLE_GLYPH_CACHE_SIZE; i++) {
+		/** The entry being checked. */
+		Console_Glyph_Cache_Entry* entry = &con->glyph_cache[i];
+
+		if(entry->valid && entry->attribute == attribute) {
+			entry->last_used = con->cache_clock;
+			return entry;
+		}
+
+		if(!entry->valid) {
+			victim = entry;
+		} else if(victim->valid && entry->last_used < victim->last_used) {
+			victim = entry;
+		}
+	}
+
+	foreground = console_palette[attribute & 0x0F];
+	background = console_palette[attribute >> 4];
+
+	for(uint32_t bits = 0; bits < 256; bits++) {
+		for(uint32_t x = 0; x < FONT_GLYPH_WIDTH; x++) {
+			victim->row_pixels[bits][x] = (bits & (0x80 >> x)) ? foreground : background;
+		}
+	}
+
+	victim->attribute = attribute;
+	victim->last_used = con->cache_clock;
+	victim->valid = true;
+
+	return victim;
+}
+
+
+/**
+ * get_cell
+ */
+static inline Console_Cell* get_cell(Console* con,
+	const uint32_t x,
+	const uint32_t y)
+{
+	/** The index of the row in the cell ring. */
+	uint32_t ring_row = con->top_row + y;
+
+	if(ring_row >= con->rows) {
+		ring_row -= con->rows;
+	}
+
+	return &con->cells[ring_row][x];
+}
+
+
+/**
+ * mark_cells_dirty
+ */
+static void mark_cells_dirty(Console* con,
+	const uint32_t y,
+	const uint32_t start,
+	const uint32_t end)
+{
+	/** The row's dirty span. */
+	Console_Dirty_Span* span = &con->dirty_spans[y];
+
+	if(span->start == span->end) {
+		span->start = start;
+		span->end = end;
+		return;
+	}
+
+	if(start < span->start) {
+		span->start = start;
+	}
+
+	if(end > span->end) {
+		span->end = end;
+	}
+}
+
+
+/**
+ * scroll_line
+ */
+static void scroll_line(Console* con)
+{
+	/** The row leaving the top of the screen, reused as the bottom row. */
+	Console_Cell* row = con->cells[con->top_row];
+
+	for(uint32_t x = 0; x < con->columns; x++) {
+		row[x].character = ' ';
+		row[x].attribute = con->attribute;
+	}
+
+	con->top_row++;
+	if(con->top_row == con->rows) {
+		con->top_row = 0;
+	}
+
+	// Dirty spans are kept in screen coordinates, so they move with the text.
+	for(uint32_t y = 1; y < con->rows; y++) {
+		con->dirty_spans[y - 1] = con->dirty_spans[y];
+	}
+
+	con->dirty_spans[con->rows - 1].start = 0;
+	con->dirty_spans[con->rows - 1].end = con->columns;
+
+	if(con->pending_scroll < con->rows) {
+		con->pending_scroll++;
+	}
+
+	con->n_scrolls++;
+}
+
+
+/**
+ * new_line
+ */
+static void new_line(Console* con)
+{
+	con->cursor_x = 0;
+
+	if((con->cursor_y + 1) < con->rows) {
+		con->cursor_y++;
+	} else {
+		scroll_line(con);
+	}
+}
+
+
+/**
+ * render_cells
+ */
+static void render_cells(Console* con,
+	const uint32_t y,
+	const uint32_t start,
+	const uint32_t end)
+{
+	/** The renderer being drawn with. */
+	Renderer* r = con->renderer;
+	/** The glyph cache entry for the current attribute. */
+	const Console_Glyph_Cache_Entry* entry = NULL;
+	/** The back buffer pixel at the top-left of the first cell. */
+	uint32_t* cell_origin = r->back_buffer +
+		((size_t)y * FONT_GLYPH_HEIGHT * r->stride) + (start * FONT_GLYPH_WIDTH);
+
+	for(uint32_t x = start; x < end; x++) {
+		/** The cell being rendered. */
+		const Console_Cell* cell = get_cell(con, x, y);
+		/** The cell's glyph bitmap. */
+		const uint8_t* glyph = font_get_glyph(cell->character);
+		/** The back buffer pixel being drawn. */
+		uint32_t* dest = cell_origin;
+
+		// Adjacent cells almost always share an attribute.
+		if(entry == NULL || entry->attribute != cell->attribute) {
+			entry = get_glyph_cache_entry(con, cell->attribute);
+		}
+
+		// Cells are 32 bytes wide, and back buffer rows are cache line aligned,
+		// so every glyph row is two aligned vector stores.
+		for(uint32_t row = 0; row < FONT_GLYPH_HEIGHT; row++) {
+			/** The expanded glyph row. */
+			const uint32_t* pixels = entry->row_pixels[glyph[row]];
+
+			((v4u32*)dest)[0] = ((const v4u32*)pixels)[0];
+			((v4u32*)dest)[1] = ((const v4u32*)pixels)[1];
+			dest += r->stride;
+		}
+
+		cell_origin += FONT_GLYPH_WIDTH;
+	}
+
+	renderer_mark_dirty(r, start * FONT_GLYPH_WIDTH, y * FONT_GLYPH_HEIGHT,
+		(end - start) * FONT_GLYPH_WIDTH, FONT_GLYPH_HEIGHT);
+}
+
+
+/**
+ * console_initialize
+ */
+bool console_initialize(Console* con,
+	Renderer* r)
+{
+	if(r->back_buffer == NULL) {
+		return false;
+	}
+
+	con->renderer = r;
+	con->columns = r->width / FONT_GLYPH_WIDTH;
+	con->rows = r->height / FONT_GLYPH_HEIGHT;
+	con->attribute = CONSOLE_DEFAULT_ATTRIBUTE;
+	con->n_flushes = 0;
+	con->n_scrolls = 0;
+	con->cache_clock = 0;
+
+	for(size_t i = 0; i < CONSOLE_GLYPH_CACHE_SIZE; i++) {
+		con->glyph_cache[i].valid = false;
+	}
+
+	console_clear(con);
+	console_flush(con);
+
+	return true;
+}
+
+
+/**
+ * console_set_colour
+ */
+void console_set_colour(Console* con,
+	const uint8_t attribute)
+{
+	con->attribute = attribute;
+}
+
+
+/**
+ * console_clear
+ */
+void console_clear(Console* con)
+{
+	for(uint32_t y = 0; y < con->rows; y++) {
+		for(uint32_t x = 0; x < con->columns; x++) {
+			con->cells[y][x].character = ' ';
+			con->cells[y][x].attribute = con->attribute;
+		}
+
+		con->dirty_spans[y].start = 0;
+		con->dirty_spans[y].end = con->columns;
+	}
+
+	con->cursor_x = 0;
+	con->cursor_y = 0;
+	con->top_row = 0;
+	// Every row is re-rendered, so there is nothing to move.
+	con->pending_scroll = 0;
+}
+
+
+/**
+ * console_putchar
+ */
+void console_putchar(Console* con,
+	const char c)
+{
+	/** The cell being written. */
+	Console_Cell* cell = NULL;
+
+	switch(c) {
+		case '\n':
+			new_line(con);
+			return;
+		case '\r':
+			con->cursor_x = 0;
+			return;
+		case '\b':
+			if(con->cursor_x > 0) {
+				con->cursor_x--;
+			}
+			return;
+		case '\t':
+			do {
+				console_putchar(con, ' ');
+			} while((con->cursor_x % CONSOLE_TAB_WIDTH) != 0);
+			return;
+		default:
+			break;
+	}
+
+	if(con->cursor_x >= con->columns) {
+		new_line(con);
+	}
+
+	cell = get_cell(con, con->cursor_x, con->cursor_y);
+	cell->character = c;
+	cell->attribute = con->attribute;
+
+	mark_cells_dirty(con, con->cursor_y, con->cursor_x, con->cursor_x + 1);
+	con->cursor_x++;
+}
+
+
+/**
+ * console_write
+ */
+void console_write(Console* con,
+	const char* str)
+{
+	while(*str) {
+		console_putchar(con, *str++);
+	}
+
+	if((read_timestamp_counter() - con->last_flush) >= CONSOLE_FLUSH_INTERVAL_CYCLES) {
+		console_flush(con);
+	}
+}
+
+
+/**
+ * console_flush
+ */
+void console_flush(Console* con)
+{
+	/** The renderer being drawn with. */
+	Renderer* r = con->renderer;
+
+	// A scroll of the whole screen or more leaves every row dirty, so only a
+	// partial scroll needs the surviving text moved.
+	if(con->pending_scroll > 0 && con->pending_scroll < con->rows) {
+		raster_scroll(r->back_buffer, r->stride,
+			con->columns * FONT_GLYPH_WIDTH, con->rows * FONT_GLYPH_HEIGHT,
+			con->pending_scroll * FONT_GLYPH_HEIGHT, 0);
+		renderer_mark_dirty(r, 0, 0, con->columns * FONT_GLYPH_WIDTH,
+			con->rows * FONT_GLYPH_HEIGHT);
+	}
+
+	con->pending_scroll = 0;
+
+	for(uint32_t y = 0; y < con->rows; y++) {
+		/** The row's dirty span. */
+		Console_Dirty_Span* span = &con->dirty_spans[y];
+
+		if(span->start != span->end) {
+			render_cells(con, y, span->start, span->end);
+			span->start = 0;
+			span->end = 0;
+		}
+	}
+
+	renderer_flush(r);
+
+	con->last_flush = read_timestamp_counter();
+	con->n_flushes++;
+}
+
+
+/**
+ * console_run_benchmark
+ */
+static void console_run_benchmark(void)
+{
+	/** The console being measured. */
+	Console* con = &console;
+	/** The line of text written by the benchmark. */
+	char line[CONSOLE_BENCHMARK_LINE_BUFFER_SIZE];
+	/** The timestamp at the start of a benchmark pass. */
+	uint64_t start = 0;
+	/** The number of cycles taken writing lines. */
+	uint64_t write_cycles = 0;
+	/** The number of flushes triggered by writing lines. */
+	uint64_t write_flushes = 0;
+	/** The number of cycles taken by a flush after scrolling half the screen. */
+	uint64_t scroll_flush_cycles = 0;
+	/** The number of cycles taken by a flush after scrolling a full screen. */
+	uint64_t full_flush_cycles = 0;
+
+	if(con->renderer == NULL) {
+		benchmark_skip("console", "no-console");
+		return;
+	}
+
+	console_flush(con);
+
+	// Writing lines, at a rate the flush interval batches.
+	write_flushes = con->n_flushes;
+	start = read_timestamp_counter();
+	for(uint32_t i = 0; i < CONSOLE_BENCHMARK_LINES; i++) {
+		ksnprintf(line, CONSOLE_BENCHMARK_LINE_BUFFER_SIZE,
+			"Console benchmark line %u: The quick brown fox jumps over the lazy dog.\n", i);
+		console_write(con, line);
+	}
+	console_flush(con);
+	write_cycles = read_timestamp_counter() - start;
+	write_flushes = con->n_flushes - write_flushes;
+
+	// Flushing after scrolling half the screen, which moves the surviving text.
+	for(uint32_t i = 0; i < (con->rows / 2); i++) {
+		console_putchar(con, '\n');
+	}
+	start = read_timestamp_counter();
+	console_flush(con);
+	scroll_flush_cycles = read_timestamp_counter() - start;
+
+	// Flushing after scrolling a full screen, which re-renders every cell.
+	for(uint32_t i = 0; i < con->rows; i++) {
+		console_putchar(con, '\n');
+	}
+	start = read_timestamp_counter();
+	console_flush(con);
+	full_flush_cycles = read_timestamp_counter() - start;
+
+	console_clear(con);
+	console_flush(con);
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "console", .name = "write", .variant = NULL, .size = 0,
+		.operations = CONSOLE_BENCHMARK_LINES, .cycles = write_cycles, .bytes = 0,
+		.counters = {{"flushes", write_flushes}}
+	});
+	benchmark_report(&(Benchmark_Result){
+		.suite = "console", .name = "flush", .variant = "half_screen_scroll",
+		.size = 0, .operations = 1, .cycles = scroll_flush_cycles, .bytes = 0,
+		.counters = {{"cells", (uint64_t)con->columns * con->rows}}
+	});
+	benchmark_report(&(Benchmark_Result){
+		.suite = "console", .name = "flush", .variant = "full_screen_scroll",
+		.size = 0, .operations = 1, .cycles = full_flush_cycles, .bytes = 0,
+		.counters = {{"cells", (uint64_t)con->columns * con->rows}}
+	});
+}
+
+BENCHMARK(console, console_run_benchmark);
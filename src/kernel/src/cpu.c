@@ -0,0 +1,187 @@
+/**
+ * @file cpu.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief CPU functionality.
+ * Contains the implementation of processor feature detection, and SIMD state
+ * initialisation.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cpu.h>
+
+/**
+ * Processor features.
+ * Refer to definition in cpu.h
+ */
+Cpu_Features cpu_features;
+
+/**
+ * XSAVE state component mask.
+ * Refer to definition in cpu.h
+ */
+uint64_t cpu_xsave_mask = 0;
+
+/**
+ * @brief Enables XSAVE and the supported extended state components.
+ * Programs XCR0 with every SSE, AVX and AVX-512 state component that is
+ * supported, and fits in the interrupt entry stubs' save area.
+ * @param[in] avx_supported Whether the processor supports AVX.
+ * @param[in] avx512f_supported Whether the processor supports AVX-512.
+ */
+static void enable_extended_state(const bool avx_supported,
+	const bool avx512f_supported);
+
+
+/**
+ * enable_extended_state
+ */
+static void enable_extended_state(const bool avx_supported,
+	const bool avx512f_supported)
+{
+	/** CPUID output registers. */
+	uint32_t eax, ebx, ecx, edx;
+	/** The state components the processor supports. */
+	uint64_t supported_state;
+	/** The state components to enable. */
+	uint64_t xcr0 = XCR0_X87 | XCR0_SSE;
+
+	write_cr4(read_cr4() | CR4_OSXSAVE);
+
+	cpuid(CPUID_LEAF_XSAVE, 0, &eax, &ebx, &ecx, &edx);
+	supported_state = ((uint64_t)edx << 32) | eax;
+
+	if(avx_supported && (supported_state & XCR0_AVX)) {
+		xcr0 |= XCR0_AVX;
+
+		if(avx512f_supported && (supported_state & XCR0_AVX512) == XCR0_AVX512) {
+			xcr0 |= XCR0_AVX512;
+		}
+	}
+
+	write_xcr(0, xcr0);
+
+	// EBX reports the size of the save area for the components now enabled.
+	cpuid(CPUID_LEAF_XSAVE, 0, &eax, &ebx, &ecx, &edx);
+	if(ebx > CPU_XSAVE_AREA_MAX_SIZE) {
+		xcr0 &= ~XCR0_AVX512;
+		write_xcr(0, xcr0);
+
+		cpuid(CPUID_LEAF_XSAVE, 0, &eax, &ebx, &ecx, &edx);
+	}
+
+	cpu_features.xcr0 = xcr0;
+	cpu_features.xsave_area_size = ebx;
+	cpu_xsave_mask = xcr0;
+}
+
+
+/**
+ * cpu_initialize
+ */
+void cpu_initialize(void)
+{
+	/** CPUID output registers. */
+	uint32_t eax, ebx, ecx, edx;
+	/** CPUID leaf 1 ECX. */
+	uint32_t leaf_1_ecx = 0;
+	/** CPUID leaf 7 EBX. */
+	uint32_t leaf_7_ebx = 0;
+
+	cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+	cpu_features.max_leaf = eax;
+
+	// The vendor string is held in EBX, EDX, ECX in that order.
+	for(size_t i = 0; i < 4; i++) {
+		cpu_features.vendor[i] = (char)(ebx >> (i * 8));
+		cpu_features.vendor[i + 4] = (char)(edx >> (i * 8));
+		cpu_features.vendor[i + 8] = (char)(ecx >> (i * 8));
+	}
+	cpu_features.vendor[12] = '\0';
+
+	cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+	leaf_1_ecx = ecx;
+	// The extended family is only added to the base family 0xF.
+	cpu_features.family = (eax >> 8) & 0xF;
+	if(cpu_features.family == 0xF) {
+		cpu_features.family += (eax >> 20) & 0xFF;
+	}
+
+	cpu_features.sse3 = (ecx & CPUID_1_ECX_SSE3) != 0;
+	cpu_features.ssse3 = (ecx & CPUID_1_ECX_SSSE3) != 0;
+	cpu_features.sse4_1 = (ecx & CPUID_1_ECX_SSE4_1) != 0;
+	cpu_features.sse4_2 = (ecx & CPUID_1_ECX_SSE4_2) != 0;
+	cpu_features.xsave = (ecx & CPUID_1_ECX_XSAVE) != 0;
+	cpu_features.pat = (edx & CPUID_1_EDX_PAT) != 0;
+	cpu_features.x2apic = (ecx & CPUID_1_ECX_X2APIC) != 0;
+	cpu_features.monitor = (ecx & CPUID_1_ECX_MONITOR) != 0;
+	cpu_features.pcid = (ecx & CPUID_1_ECX_PCID) != 0;
+
+	if(cpu_features.max_leaf >= 7) {
+		cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+		leaf_7_ebx = ebx;
+		cpu_features.erms = (ebx & CPUID_7_EBX_ERMS) != 0;
+		cpu_features.fsrm = (edx & CPUID_7_EDX_FSRM) != 0;
+	}
+
+	cpuid(CPUID_LEAF_EXTENDED, 0, &eax, &ebx, &ecx, &edx);
+	cpu_features.max_extended_leaf = eax;
+
+	cpu_features.page_1gb = false;
+	if(cpu_features.max_extended_leaf >= CPUID_LEAF_EXTENDED_FEATURES) {
+		cpuid(CPUID_LEAF_EXTENDED_FEATURES, 0, &eax, &ebx, &ecx, &edx);
+		cpu_features.page_1gb = (edx & CPUID_EXTENDED_EDX_PAGE_1GB) != 0;
+	}
+
+	cpu_features.invariant_tsc = false;
+	if(cpu_features.max_extended_leaf >= CPUID_LEAF_POWER) {
+		cpuid(CPUID_LEAF_POWER, 0, &eax, &ebx, &ecx, &edx);
+		cpu_features.invariant_tsc = (edx & CPUID_POWER_EDX_INVARIANT_TSC) != 0;
+	}
+
+	cpu_features.physical_address_bits = CPU_DEFAULT_PHYSICAL_ADDRESS_BITS;
+	if(cpu_features.max_extended_leaf >= CPUID_LEAF_ADDRESS_SIZES) {
+		cpuid(CPUID_LEAF_ADDRESS_SIZES, 0, &eax, &ebx, &ecx, &edx);
+		cpu_features.physical_address_bits = eax & 0xFF;
+	}
+
+	cpu_features.xcr0 = 0;
+	cpu_features.xsave_area_size = 0;
+
+	// Without XSAVE only the SSE state, which the entry point has enabled, can
+	// be used.
+	if(cpu_features.xsave && cpu_features.max_leaf >= CPUID_LEAF_XSAVE) {
+		enable_extended_state((leaf_1_ecx & CPUID_1_ECX_AVX) != 0,
+			(leaf_7_ebx & CPUID_7_EBX_AVX512F) != 0);
+	}
+
+	cpu_features.avx = (leaf_1_ecx & CPUID_1_ECX_AVX) &&
+		(cpu_features.xcr0 & XCR0_AVX);
+	cpu_features.avx2 = cpu_features.avx && (leaf_7_ebx & CPUID_7_EBX_AVX2);
+	cpu_features.avx512f = (leaf_7_ebx & CPUID_7_EBX_AVX512F) &&
+		((cpu_features.xcr0 & XCR0_AVX512) == XCR0_AVX512);
+}
+
+
+/**
+ * cpu_has_feature
+ */
+bool cpu_has_feature(const uint32_t feature)
+{
+	switch(feature) {
+		case CPU_FEATURE_BASELINE:
+			return true;
+		case CPU_FEATURE_AVX2:
+			return cpu_features.avx2;
+		case CPU_FEATURE_AVX512F:
+			return cpu_features.avx512f;
+		case CPU_FEATURE_ERMS:
+			return cpu_features.erms;
+		case CPU_FEATURE_FSRM:
+			return cpu_features.fsrm;
+		default:
+			return false;
+	}
+}
@@ -0,0 +1,120 @@
+/**
+ * @file gdt.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Global descriptor table.
+ * Contains the implementation of the kernel's GDT, and each CPU's TSS.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cpu.h>
+#include <gdt.h>
+#include <smp.h>
+
+/** The flat 64-bit kernel code segment descriptor. */
+#define GDT_KERNEL_CODE_DESCRIPTOR  0x00AF9A000000FFFFULL
+/** The flat kernel data segment descriptor. */
+#define GDT_KERNEL_DATA_DESCRIPTOR  0x00CF92000000FFFFULL
+/** TSS descriptor type: Present, available 64-bit TSS. */
+#define GDT_TSS_TYPE_AVAILABLE      0x89ULL
+/** The number of entries in the GDT. */
+#define GDT_ENTRY_COUNT             (GDT_TSS_FIRST_ENTRY + (SMP_MAX_CPUS * 2))
+
+/**
+ * @brief A 64-bit task state segment.
+ * Only the interrupt stack table is used. The I/O permission bitmap is
+ * disabled by placing it beyond the segment limit.
+ */
+typedef struct s_tss {
+	uint32_t reserved_0;
+	uint64_t rsp[3];
+	uint64_t reserved_1;
+	uint64_t ist[7];
+	uint64_t reserved_2;
+	uint16_t reserved_3;
+	uint16_t io_map_base;
+} __attribute__((packed)) Tss;
+
+/**
+ * @brief The GDT descriptor loaded by `lgdt`.
+ */
+typedef struct s_gdt_descriptor {
+	uint16_t limit;
+	uint64_t base;
+} __attribute__((packed)) Gdt_Descriptor;
+
+/** The global descriptor table. */
+static uint64_t gdt[GDT_ENTRY_COUNT] __attribute__((aligned(16)));
+/** The task state segment of each CPU. */
+static Tss tss[SMP_MAX_CPUS] __attribute__((aligned(16)));
+/** The double fault stack of each CPU. */
+static uint8_t double_fault_stacks[SMP_MAX_CPUS][GDT_DOUBLE_FAULT_STACK_SIZE]
+	__attribute__((aligned(16)));
+
+
+/**
+ * gdt_initialize
+ */
+void gdt_initialize(void)
+{
+	gdt[0] = 0;
+	gdt[GDT_KERNEL_CODE_SELECTOR / sizeof(uint64_t)] = GDT_KERNEL_CODE_DESCRIPTOR;
+	gdt[GDT_KERNEL_DATA_SELECTOR / sizeof(uint64_t)] = GDT_KERNEL_DATA_DESCRIPTOR;
+
+	for(size_t i = 0; i < SMP_MAX_CPUS; i++) {
+		/** The address of this CPU's TSS. */
+		const uint64_t base = (uint64_t)(uintptr_t)&tss[i];
+		/** The limit of this CPU's TSS. */
+		const uint64_t limit = sizeof(Tss) - 1;
+		/** The index of this CPU's TSS descriptor. */
+		const size_t entry = GDT_TSS_FIRST_ENTRY + (i * 2);
+
+		tss[i].ist[GDT_DOUBLE_FAULT_IST - 1] =
+			(uint64_t)(uintptr_t)&double_fault_stacks[i][GDT_DOUBLE_FAULT_STACK_SIZE];
+		tss[i].io_map_base = sizeof(Tss);
+
+		// A 64-bit TSS descriptor takes two entries, the second holding the
+		// upper half of the base.
+		gdt[entry] = (limit & 0xFFFF) | ((base & 0xFFFFFF) << 16) |
+			(GDT_TSS_TYPE_AVAILABLE << 40) | (((limit >> 16) & 0xF) << 48) |
+			(((base >> 24) & 0xFF) << 56);
+		gdt[entry + 1] = base >> 32;
+	}
+}
+
+
+/**
+ * gdt_load
+ */
+void gdt_load(const size_t cpu_index)
+{
+	/** The GDT descriptor. */
+	Gdt_Descriptor descriptor;
+
+	descriptor.limit = sizeof(gdt) - 1;
+	descriptor.base = (uint64_t)(uintptr_t)gdt;
+	load_gdt(&descriptor);
+
+	// CS can only be reloaded through a far transfer.
+	asm volatile(
+		"pushq %[code]\n\t"
+		"leaq 1f(%%rip), %%rax\n\t"
+		"pushq %%rax\n\t"
+		"lretq\n"
+		"1:\n\t"
+		"movl %[data], %%eax\n\t"
+		"movw %%ax, %%ds\n\t"
+		"movw %%ax, %%es\n\t"
+		"movw %%ax, %%ss\n\t"
+		"xorl %%eax, %%eax\n\t"
+		"movw %%ax, %%fs\n\t"
+		"movw %%ax, %%gs"
+		:
+		: [code] "i"(GDT_KERNEL_CODE_SELECTOR),
+			[data] "i"(GDT_KERNEL_DATA_SELECTOR)
+		: "rax", "memory");
+
+	load_task_register((uint16_t)((GDT_TSS_FIRST_ENTRY + (cpu_index * 2)) *
+		sizeof(uint64_t)));
+}
@@ -1,46 +1,502 @@
+/**
+ * @file graphics.c
+ * @author ajxs
+ * @date Aug 2022
+ * @brief Functionality for working with the framebuffer.
+ * Contains functionality for working with the framebuffer.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <benchmark.h>
+#include <boot.h>
+#include <cpu.h>
 #include <graphics.h>
+#include <paging.h>
+#include <printf.h>
+#include <simd.h>
+
+/** The number of full-screen fills timed for each memory type. */
+#define MEMORY_TYPE_BENCHMARK_ITERATIONS    8
+
+/**
+ * Framebuffer instance.
+ * Refer to definition in graphics.h
+ */
+Framebuffer framebuffer;
+
+/**
+ * @brief Channel layout for bitmask pixel formats.
+ * The shift and width of each colour channel, derived from the pixel bitmask
+ * once at initialisation.
+ */
+static struct {
+	uint8_t red_shift;
+	uint8_t red_width;
+	uint8_t green_shift;
+	uint8_t green_width;
+	uint8_t blue_shift;
+	uint8_t blue_width;
+} bitmask_layout;
+
+/**
+ * @brief Gets the size of a bitmask framebuffer's pixels.
+ * Derived from the highest bit set in any of the pixel's masks.
+ * @param[in] bitmask The pixel bitmask.
+ * @return The number of bytes in each pixel, or zero if every mask is empty.
+ */
+static uint32_t get_bitmask_bytes_per_pixel(const Pixel_Bitmask* bitmask);
+
+/**
+ * @brief Gets the shift and width of a contiguous channel mask.
+ * @param[in] mask The channel mask.
+ * @param[out] shift The position of the lowest set bit.
+ * @param[out] width The number of bits in the channel, clamped to 8.
+ */
+static void get_mask_layout(uint32_t mask,
+	uint8_t* shift,
+	uint8_t* width);
+
+/**
+ * @brief Encodes a canonical colour for RGBX framebuffers.
+ * Swaps the red and blue channels.
+ */
+static inline uint32_t encode_colour_rgbx(const uint32_t colour);
+
+/**
+ * @brief Encodes a canonical colour for BGRX framebuffers.
+ * The canonical layout is the BGRX layout, so this is the identity.
+ */
+static inline uint32_t encode_colour_bgrx(const uint32_t colour);
+
+/**
+ * @brief Encodes a canonical colour for bitmask framebuffers.
+ * Scales each channel to its mask width and shifts it into position.
+ */
+static inline uint32_t encode_colour_bitmask(const uint32_t colour);
+
+/**
+ * @brief Encodes four canonical colours for RGBX framebuffers.
+ */
+static inline v4u32 encode_vector_rgbx(const v4u32 colour);
+
+/**
+ * @brief Encodes four canonical colours for BGRX framebuffers.
+ */
+static inline v4u32 encode_vector_bgrx(const v4u32 colour);
+
+/**
+ * @brief Encodes four canonical colours for bitmask framebuffers.
+ */
+static inline v4u32 encode_vector_bitmask(const v4u32 colour);
+
+/**
+ * @brief Fills a span of pixels with a native colour.
+ * Filling does not depend on the pixel format once the colour is encoded, so
+ * this is shared by every 32-bit format.
+ */
+static void fill_span_32bpp(uint32_t* dest,
+	const uint32_t count,
+	const uint32_t colour);
+
+/**
+ * @brief Runs the framebuffer memory type benchmark.
+ * Fills the screen with the framebuffer mapped as uncacheable, and then as
+ * write-combining, and reports the fill bandwidth of each. The framebuffer is
+ * left mapped as write-combining.
+ */
+static void graphics_run_memory_type_benchmark(void);
+
+
+/**
+ * get_bitmask_bytes_per_pixel
+ */
+static uint32_t get_bitmask_bytes_per_pixel(const Pixel_Bitmask* bitmask)
+{
+	/** Every bit used by the pixel. */
+	const uint32_t mask = bitmask->red_mask | bitmask->green_mask |
+		bitmask->blue_mask | bitmask->reserved_mask;
+
+	if(mask == 0) {
+		return 0;
+	}
+
+	return ((32 - __builtin_clz(mask)) + 7) / 8;
+}
+
+
+/**
+ * get_mask_layout
+ */
+static void get_mask_layout(uint32_t mask,
+	uint8_t* shift,
+	uint8_t* width)
+{
+	*shift = 0;
+	*width = 0;
+
+	if(mask == 0) {
+		return;
+	}
+
+	while((mask & 1) == 0) {
+		mask >>= 1;
+		(*shift)++;
+	}
+
+	while(mask & 1) {
+		mask >>= 1;
+		(*width)++;
+	}
+
+	if(*width > 8) {
+		// Only the top 8 bits of a wider channel are written.
+		*shift += *width - 8;
+		*width = 8;
+	}
+}
+
+
+/**
+ * encode_colour_rgbx
+ */
+static inline uint32_t encode_colour_rgbx(const uint32_t colour)
+{
+	return ((colour & 0xFF) << 16) | (colour & 0xFF00) | ((colour >> 16) & 0xFF);
+}
+
+
+/**
+ * encode_colour_bgrx
+ */
+static inline uint32_t encode_colour_bgrx(const uint32_t colour)
+{
+	return colour & 0x00FFFFFF;
+}
+
+
+/**
+ * encode_colour_bitmask
+ */
+static inline uint32_t encode_colour_bitmask(const uint32_t colour)
+{
+	/** The red channel, scaled to the mask width. */
+	const uint32_t r = ((colour >> 16) & 0xFF) >> (8 - bitmask_layout.red_width);
+	/** The green channel, scaled to the mask width. */
+	const uint32_t g = ((colour >> 8) & 0xFF) >> (8 - bitmask_layout.green_width);
+	/** The blue channel, scaled to the mask width. */
+	const uint32_t b = (colour & 0xFF) >> (8 - bitmask_layout.blue_width);
+
+	return (r << bitmask_layout.red_shift) |
+		(g << bitmask_layout.green_shift) |
+		(b << bitmask_layout.blue_shift);
+}
+
+
+/**
+ * encode_vector_rgbx
+ */
+static inline v4u32 encode_vector_rgbx(const v4u32 colour)
+{
+	return ((colour & 0xFF) << 16) | (colour & 0xFF00) | ((colour >> 16) & 0xFF);
+}
+
+
+/**
+ * encode_vector_bgrx
+ */
+static inline v4u32 encode_vector_bgrx(const v4u32 colour)
+{
+	return colour & 0x00FFFFFF;
+}
+
+
+/**
+ * encode_vector_bitmask
+ */
+static inline v4u32 encode_vector_bitmask(const v4u32 colour)
+{
+	/** The red channel, scaled to the mask width. */
+	const v4u32 r = ((colour >> 16) & 0xFF) >> (8 - bitmask_layout.red_width);
+	/** The green channel, scaled to the mask width. */
+	const v4u32 g = ((colour >> 8) & 0xFF) >> (8 - bitmask_layout.green_width);
+	/** The blue channel, scaled to the mask width. */
+	const v4u32 b = (colour & 0xFF) >> (8 - bitmask_layout.blue_width);
+
+	return (r << bitmask_layout.red_shift) |
+		(g << bitmask_layout.green_shift) |
+		(b << bitmask_layout.blue_shift);
+}
+
+
+/**
+ * Defines the colour encoding and span blit routines for a pixel format.
+ * The encoder is inlined into the blit loops, so each format gets its own loops
+ * with no format branching inside them. The streaming variant aligns the
+ * destination to 16 bytes, then encodes and streams four pixels at a time.
+ */
+#define DEFINE_PIXEL_FORMAT_ROUTINES(format_name)                           \
+	static uint32_t encode_##format_name(const uint32_t colour)               \
+	{                                                                         \
+		return encode_colour_##format_name(colour);                             \
+	}                                                                         \
+                                                                            \
+	static void blit_span_##format_name(uint32_t* dest,                       \
+		const uint32_t* src,                                                    \
+		const uint32_t count)                                                   \
+	{                                                                         \
+		for(uint32_t i = 0; i < count; i++) {                                   \
+			dest[i] = encode_colour_##format_name(src[i]);                        \
+		}                                                                       \
+	}                                                                         \
+                                                                            \
+	static void stream_span_##format_name(uint32_t* dest,                     \
+		const uint32_t* src,                                                    \
+		const uint32_t count)                                                   \
+	{                                                                         \
+		uint32_t i = 0;                                                         \
+                                                                            \
+		while((i < count) && ((uintptr_t)(dest + i) & 0xF)) {                  \
+			dest[i] = encode_colour_##format_name(src[i]);                        \
+			i++;                                                                  \
+		}                                                                       \
+                                                                            \
+		for(; (i + 4) <= count; i += 4) {                                       \
+			stream_store_v4u32(dest + i,                                          \
+				encode_vector_##format_name(load_v4u32(src + i)));                  \
+		}                                                                       \
+                                                                            \
+		for(; i < count; i++) {                                                 \
+			dest[i] = encode_colour_##format_name(src[i]);                        \
+		}                                                                       \
+	}
+
+DEFINE_PIXEL_FORMAT_ROUTINES(rgbx)
+DEFINE_PIXEL_FORMAT_ROUTINES(bgrx)
+DEFINE_PIXEL_FORMAT_ROUTINES(bitmask)
+
+
+/**
+ * fill_span_32bpp
+ */
+static void fill_span_32bpp(uint32_t* dest,
+	const uint32_t count,
+	const uint32_t colour)
+{
+	for(uint32_t i = 0; i < count; i++) {
+		dest[i] = colour;
+	}
+}
+
+
+/**
+ * graphics_initialize
+ */
+bool graphics_initialize(const Kernel_Boot_Video_Mode_Info* video_mode_info)
+{
+	framebuffer.base = video_mode_info->framebuffer_pointer;
+	framebuffer.width = video_mode_info->horizontal_resolution;
+	framebuffer.height = video_mode_info->vertical_resolution;
+	framebuffer.pixels_per_scanline = video_mode_info->pixels_per_scanline;
+	framebuffer.size = video_mode_info->framebuffer_size;
+	framebuffer.format = video_mode_info->pixel_format;
+	framebuffer.fill_span = fill_span_32bpp;
+	framebuffer.encode_colour = NULL;
+
+	if(framebuffer.base == NULL) {
+		return false;
+	}
+
+	switch(framebuffer.format) {
+		case PIXEL_FORMAT_RGBX_8BPC:
+			framebuffer.blit_span = blit_span_rgbx;
+			framebuffer.stream_span = stream_span_rgbx;
+			framebuffer.encode_colour = encode_rgbx;
+			break;
+		case PIXEL_FORMAT_BGRX_8BPC:
+			framebuffer.blit_span = blit_span_bgrx;
+			framebuffer.stream_span = stream_span_bgrx;
+			framebuffer.encode_colour = encode_bgrx;
+			break;
+		case PIXEL_FORMAT_BITMASK:
+			// The span functions step a 32-bit pixel at a time, so modes whose
+			// masks span fewer than 25 bits, being 16 or 24bpp, are not supported.
+			if(get_bitmask_bytes_per_pixel(&video_mode_info->pixel_information) !=
+				sizeof(uint32_t)) {
+				framebuffer.base = NULL;
+				return false;
+			}
+
+			get_mask_layout(video_mode_info->pixel_information.red_mask,
+				&bitmask_layout.red_shift, &bitmask_layout.red_width);
+			get_mask_layout(video_mode_info->pixel_information.green_mask,
+				&bitmask_layout.green_shift, &bitmask_layout.green_width);
+			get_mask_layout(video_mode_info->pixel_information.blue_mask,
+				&bitmask_layout.blue_shift, &bitmask_layout.blue_width);
+
+			framebuffer.blit_span = blit_span_bitmask;
+			framebuffer.stream_span = stream_span_bitmask;
+			framebuffer.encode_colour = encode_bitmask;
+			break;
+		default:
+			// BLT-only modes have no linear framebuffer.
+			framebuffer.base = NULL;
+			return false;
+	}
+
+	// If the firmware did not report the framebuffer size, derive it from the
+	// mode geometry.
+	if(framebuffer.size == 0) {
+		framebuffer.size = (uint64_t)framebuffer.pixels_per_scanline *
+			framebuffer.height * sizeof(uint32_t);
+	}
+
+	return true;
+}
+
+
+/**
+ * graphics_set_memory_type
+ */
+Paging_Status graphics_set_memory_type(const Framebuffer* fb,
+	const Memory_Type type)
+{
+	return paging_set_memory_type((uintptr_t)fb->base, fb->size, type);
+}
+
+
+/**
+ * graphics_run_memory_type_benchmark
+ */
+static void graphics_run_memory_type_benchmark(void)
+{
+	/** The framebuffer being measured. */
+	const Framebuffer* fb = &framebuffer;
+	/** The memory types compared by the benchmark. */
+	const Memory_Type types[] = {
+		MEMORY_TYPE_UNCACHEABLE,
+		MEMORY_TYPE_WRITE_COMBINING
+	};
+	/** The number of bytes written by one full-screen fill. */
+	const uint64_t bytes_per_fill = (uint64_t)fb->width * fb->height * sizeof(uint32_t);
+
+	if(fb->base == NULL) {
+		benchmark_skip("framebuffer", "no-framebuffer");
+		return;
+	}
+
+	if(!pat_initialize()) {
+		benchmark_skip("framebuffer", "no-pat");
+		return;
+	}
+
+	for(size_t t = 0; t < (sizeof(types) / sizeof(types[0])); t++) {
+		/** The status of changing the memory type. */
+		Paging_Status status;
+		/** The number of framebuffer pages not mapped with the tested type. */
+		size_t n_mismatched = 0;
+		/** The timestamp at the start of the benchmark pass. */
+		uint64_t start = 0;
+		/** The number of cycles taken by the benchmark pass. */
+		uint64_t cycles = 0;
+
+		status = graphics_set_memory_type(fb, types[t]);
+		if(status != PAGING_SUCCESS) {
+			kprintf("Framebuffer benchmark: Unable to map framebuffer as %s: %d\n",
+				get_memory_type_name(types[t]), status);
+			continue;
+		}
+
+		paging_verify_memory_type((uintptr_t)fb->base, fb->size, types[t],
+			&n_mismatched);
+
+		start = read_timestamp_counter();
+		for(uint32_t i = 0; i < MEMORY_TYPE_BENCHMARK_ITERATIONS; i++) {
+			draw_rect(fb, 0, 0, fb->width, fb->height,
+				fb->encode_colour(CANONICAL_COLOUR(i * 32, 0, 255 - (i * 32))));
+		}
+		cycles = read_timestamp_counter() - start;
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "framebuffer", .name = "fill",
+			.variant = get_memory_type_name(types[t]), .size = bytes_per_fill,
+			.operations = MEMORY_TYPE_BENCHMARK_ITERATIONS, .cycles = cycles,
+			.bytes = bytes_per_fill * MEMORY_TYPE_BENCHMARK_ITERATIONS,
+			.counters = {{"pages_mismapped", n_mismatched}}
+		});
+	}
+}
+
+BENCHMARK(framebuffer, graphics_run_memory_type_benchmark);
+
 
 /**
  * draw_rect
  */
-void draw_rect(uint32_t* framebuffer_pointer,
-	const uint32_t pixels_per_scanline,
+void draw_rect(const Framebuffer* fb,
 	const uint16_t _x,
 	const uint16_t _y,
 	const uint16_t width,
 	const uint16_t height,
 	const uint32_t color)
 {
-	/** Pointer to the current pixel in the buffer. */
-	uint32_t* at;
+	/** Pointer to the start of the current row in the buffer. */
+	uint32_t* at = fb->base + _x + ((size_t)_y * fb->pixels_per_scanline);
 
-	uint16_t row = 0;
-	uint16_t col = 0;
-	for(row = 0; row < height; row++) {
-		for(col = 0; col < width; col++) {
-			at = framebuffer_pointer + _x + col;
-			at += ((_y + row) * pixels_per_scanline);
-
-			*at = color;
-		}
+	for(uint16_t row = 0; row < height; row++) {
+		fb->fill_span(at, width, color);
+		at += fb->pixels_per_scanline;
 	}
 }
 
-void draw_pixel(uint32_t* framebuffer_pointer,
-	const uint32_t pixels_per_scanline,
+
+/**
+ * draw_pixel
+ */
+void draw_pixel(const Framebuffer* fb,
 	const uint16_t _x,
 	const uint16_t _y,
 	const uint32_t color)
 {
 	/** Pointer to the current pixel in the buffer. */
-	uint32_t* at = framebuffer_pointer + _x + (_y * pixels_per_scanline);
+	uint32_t* at = fb->base + _x + ((size_t)_y * fb->pixels_per_scanline);
 	*at = color;
 }
 
+
+/**
+ * blit_rect
+ */
+void blit_rect(const Framebuffer* fb,
+	const uint16_t _x,
+	const uint16_t _y,
+	const uint16_t width,
+	const uint16_t height,
+	const uint32_t* src,
+	const uint32_t src_stride)
+{
+	/** Pointer to the start of the current row in the buffer. */
+	uint32_t* at = fb->base + _x + ((size_t)_y * fb->pixels_per_scanline);
+
+	for(uint16_t row = 0; row < height; row++) {
+		fb->blit_span(at, src, width);
+		at += fb->pixels_per_scanline;
+		src += src_stride;
+	}
+}
+
+
+/**
+ * convert_rgb_to_32bit_colour
+ */
 uint32_t convert_rgb_to_32bit_colour(const uint8_t r,
 	const uint8_t g,
 	const uint8_t b)
 {
-	return (r << 16) | (g << 8) | b;
+	if(framebuffer.encode_colour == NULL) {
+		return 0;
+	}
+
+	return framebuffer.encode_colour(CANONICAL_COLOUR(r, g, b));
 }
@@ -0,0 +1,229 @@
+/**
+ * @file acpi.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief ACPI functionality.
+ * Contains definitions for locating the ACPI system description tables, found
+ * through the RSDP passed to the kernel by the bootloader. The tables are
+ * read in place, relying on the firmware's identity mapping.
+ */
+
+#ifndef ACPI_H
+#define ACPI_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** The signature of the root system description pointer. */
+#define ACPI_RSDP_SIGNATURE       "RSD PTR "
+/** The signature of the HPET description table. */
+#define ACPI_HPET_SIGNATURE       "HPET"
+/** The signature of the multiple APIC description table. */
+#define ACPI_MADT_SIGNATURE       "APIC"
+/** The signature of the system resource affinity table. */
+#define ACPI_SRAT_SIGNATURE       "SRAT"
+/** The signature of the system locality information table. */
+#define ACPI_SLIT_SIGNATURE       "SLIT"
+
+/** MADT entry type: A processor's local APIC. */
+#define ACPI_MADT_TYPE_LOCAL_APIC      0
+/** MADT entry type: A processor's local x2APIC. */
+#define ACPI_MADT_TYPE_LOCAL_X2APIC    9
+/** MADT local APIC flags: The processor is enabled. */
+#define ACPI_MADT_LOCAL_APIC_ENABLED   (1U << 0)
+
+/** SRAT entry type: A processor's local APIC affinity. */
+#define ACPI_SRAT_TYPE_PROCESSOR_AFFINITY  0
+/** SRAT entry type: A memory range's affinity. */
+#define ACPI_SRAT_TYPE_MEMORY_AFFINITY     1
+/** SRAT entry type: A processor's local x2APIC affinity. */
+#define ACPI_SRAT_TYPE_X2APIC_AFFINITY     2
+/** SRAT affinity flags: The entry is enabled. */
+#define ACPI_SRAT_ENABLED                  (1U << 0)
+
+/**
+ * @brief The root system description pointer.
+ * The fields from `length` onwards are only present from ACPI 2.0, when
+ * `revision` is at least 2.
+ */
+typedef struct s_acpi_rsdp {
+	char signature[8];
+	uint8_t checksum;
+	char oem_id[6];
+	uint8_t revision;
+	uint32_t rsdt_address;
+	uint32_t length;
+	uint64_t xsdt_address;
+	uint8_t extended_checksum;
+	uint8_t reserved[3];
+} __attribute__((packed)) Acpi_Rsdp;
+
+/**
+ * @brief The header common to every system description table.
+ */
+typedef struct s_acpi_sdt_header {
+	char signature[4];
+	uint32_t length;
+	uint8_t revision;
+	uint8_t checksum;
+	char oem_id[6];
+	char oem_table_id[8];
+	uint32_t oem_revision;
+	uint32_t creator_id;
+	uint32_t creator_revision;
+} __attribute__((packed)) Acpi_Sdt_Header;
+
+/**
+ * @brief An ACPI generic address structure.
+ */
+typedef struct s_acpi_generic_address {
+	uint8_t address_space;
+	uint8_t register_bit_width;
+	uint8_t register_bit_offset;
+	uint8_t access_size;
+	uint64_t address;
+} __attribute__((packed)) Acpi_Generic_Address;
+
+/**
+ * @brief The HPET description table.
+ */
+typedef struct s_acpi_hpet {
+	Acpi_Sdt_Header header;
+	uint32_t event_timer_block_id;
+	Acpi_Generic_Address base_address;
+	uint8_t hpet_number;
+	uint16_t minimum_tick;
+	uint8_t page_protection;
+} __attribute__((packed)) Acpi_Hpet;
+
+/**
+ * @brief The multiple APIC description table.
+ * Followed by a list of variable length entries, each starting with an
+ * `Acpi_Madt_Entry` header, up to the length of the table.
+ */
+typedef struct s_acpi_madt {
+	Acpi_Sdt_Header header;
+	uint32_t local_apic_address;
+	uint32_t flags;
+} __attribute__((packed)) Acpi_Madt;
+
+/**
+ * @brief The header of each MADT entry.
+ */
+typedef struct s_acpi_madt_entry {
+	uint8_t type;
+	uint8_t length;
+} __attribute__((packed)) Acpi_Madt_Entry;
+
+/**
+ * @brief A MADT processor local APIC entry.
+ */
+typedef struct s_acpi_madt_local_apic {
+	Acpi_Madt_Entry entry;
+	uint8_t processor_uid;
+	uint8_t apic_id;
+	uint32_t flags;
+} __attribute__((packed)) Acpi_Madt_Local_Apic;
+
+/**
+ * @brief A MADT processor local x2APIC entry.
+ * Used by firmware for processors with APIC IDs above 254.
+ */
+typedef struct s_acpi_madt_local_x2apic {
+	Acpi_Madt_Entry entry;
+	uint16_t reserved;
+	uint32_t x2apic_id;
+	uint32_t flags;
+	uint32_t processor_uid;
+} __attribute__((packed)) Acpi_Madt_Local_X2apic;
+
+/**
+ * @brief The system resource affinity table.
+ * Followed by a list of variable length entries, each starting with an
+ * `Acpi_Srat_Entry` header, up to the length of the table.
+ */
+typedef struct s_acpi_srat {
+	Acpi_Sdt_Header header;
+	uint32_t reserved_1;
+	uint64_t reserved_2;
+} __attribute__((packed)) Acpi_Srat;
+
+/**
+ * @brief The header of each SRAT entry.
+ */
+typedef struct s_acpi_srat_entry {
+	uint8_t type;
+	uint8_t length;
+} __attribute__((packed)) Acpi_Srat_Entry;
+
+/**
+ * @brief A SRAT processor local APIC affinity entry.
+ * The upper bytes of the proximity domain are only used from SRAT revision 2.
+ */
+typedef struct s_acpi_srat_processor_affinity {
+	Acpi_Srat_Entry entry;
+	uint8_t proximity_domain_low;
+	uint8_t apic_id;
+	uint32_t flags;
+	uint8_t local_sapic_eid;
+	uint8_t proximity_domain_high[3];
+	uint32_t clock_domain;
+} __attribute__((packed)) Acpi_Srat_Processor_Affinity;
+
+/**
+ * @brief A SRAT memory affinity entry.
+ */
+typedef struct s_acpi_srat_memory_affinity {
+	Acpi_Srat_Entry entry;
+	uint32_t proximity_domain;
+	uint16_t reserved_1;
+	uint64_t base_address;
+	uint64_t length;
+	uint32_t reserved_2;
+	uint32_t flags;
+	uint64_t reserved_3;
+} __attribute__((packed)) Acpi_Srat_Memory_Affinity;
+
+/**
+ * @brief A SRAT processor local x2APIC affinity entry.
+ */
+typedef struct s_acpi_srat_x2apic_affinity {
+	Acpi_Srat_Entry entry;
+	uint16_t reserved_1;
+	uint32_t proximity_domain;
+	uint32_t x2apic_id;
+	uint32_t flags;
+	uint32_t clock_domain;
+	uint32_t reserved_2;
+} __attribute__((packed)) Acpi_Srat_X2apic_Affinity;
+
+/**
+ * @brief The system locality information table.
+ * Followed by a matrix of `n_localities` by `n_localities` one byte relative
+ * distances, indexed by proximity domain, row by row.
+ */
+typedef struct s_acpi_slit {
+	Acpi_Sdt_Header header;
+	uint64_t n_localities;
+} __attribute__((packed)) Acpi_Slit;
+
+/**
+ * @brief Initialises ACPI table discovery.
+ * Validates the RSDP, and the root table it points to, preferring the XSDT.
+ * @param[in] rsdp The RSDP passed by the bootloader. May be NULL.
+ * @return Whether the tables were found and valid.
+ */
+bool acpi_initialize(const void* rsdp);
+
+/**
+ * @brief Finds a system description table.
+ * @param[in] signature The four character signature of the table.
+ * @param[in] index The index of the table among those with the signature.
+ * @return The table, or NULL if there is no such table, or its checksum is
+ * invalid.
+ */
+const Acpi_Sdt_Header* acpi_find_table(const char* signature,
+	const size_t index);
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file alternatives.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Boot-time code patching.
+ * Contains definitions for static calls, whose target is patched once at boot
+ * to the best variant for the processor.
+ * A static call is made through a trampoline: an eight byte slot in `.text`
+ * holding a `jmp rel32` to the current target. Callers call the trampoline
+ * directly, so once it is patched a call costs a direct call and a direct
+ * jump, both perfectly predicted, rather than an indirect branch through a
+ * function pointer.
+ * The candidate targets of each trampoline are recorded by
+ * `ALTERNATIVE_CALL` in the `.alternatives` section, which
+ * `alternatives_apply` walks to choose between them.
+ */
+
+#ifndef ALTERNATIVES_H
+#define ALTERNATIVES_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The size of a static call trampoline. */
+#define STATIC_CALL_TRAMPOLINE_SIZE 8
+/** The opcode of `jmp rel32`. */
+#define STATIC_CALL_JMP_OPCODE      0xE9
+
+/**
+ * @brief An alternative target for a static call.
+ * The target is applied if the processor has `feature`. Where several
+ * alternatives for one trampoline apply, the one with the highest `priority`
+ * is used.
+ */
+typedef struct s_alternative_call {
+	const void* trampoline;
+	const void* target;
+	uint32_t feature;
+	uint32_t priority;
+} Alternative_Call;
+
+/**
+ * @brief Defines a static call trampoline.
+ * Defines the function `name` as a trampoline to `default_target`, which is
+ * used until, and unless, an alternative is applied. The default target must
+ * be a global symbol. The trampoline must also be declared with the target's
+ * prototype so that it can be called.
+ */
+#define STATIC_CALL_TRAMPOLINE(name, default_target)                     \
+	asm(".pushsection .text\n\t"                                           \
+		".balign 8\n\t"                                                      \
+		".global " #name "\n\t"                                              \
+		".type " #name ", @function\n"                                       \
+		#name ":\n\t"                                                        \
+		".byte 0xE9\n\t"                                                     \
+		".long " #default_target " - (. + 4)\n\t"                            \
+		".byte 0xCC, 0xCC, 0xCC\n\t"                                         \
+		".size " #name ", 8\n\t"                                             \
+		".popsection")
+
+/**
+ * @brief Records an alternative target for a static call.
+ * @param name The static call trampoline.
+ * @param feature The `CPU_FEATURE_*` the target requires.
+ * @param priority The priority of the target over other alternatives.
+ * @param target The alternative target.
+ */
+#define ALTERNATIVE_CALL(name, feature, priority, target)                \
+	static const Alternative_Call alternative_##name##_##priority         \
+		__attribute__((section(".alternatives"), used, aligned(8))) = {      \
+		(const void*)(name), (const void*)(target), (feature), (priority)    \
+	}
+
+/**
+ * @brief Applies the alternatives.
+ * Patches every static call trampoline to its best alternative supported by
+ * the processor. Must be called once, after `cpu_initialize`, and before
+ * interrupts are enabled or any other processor is started.
+ * @return The number of trampolines patched.
+ */
+size_t alternatives_apply(void);
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file apic.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Local APIC functionality.
+ * Contains definitions for the local APIC of each CPU, used to send
+ * inter-processor interrupts. The x2APIC interface is used when the processor
+ * supports it, otherwise the memory mapped xAPIC interface. Every CPU uses
+ * the same interface as the boot CPU.
+ */
+
+#ifndef APIC_H
+#define APIC_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** The vector the local APIC delivers spurious interrupts to. */
+#define APIC_SPURIOUS_VECTOR         0xFF
+
+/**
+ * @brief Initialises the boot CPU's local APIC.
+ * Selects the x2APIC interface if the processor supports it, otherwise maps
+ * the xAPIC registers uncacheable, then enables the local APIC. External
+ * interrupts continue to be delivered through the PICs.
+ * @return Whether the local APIC was initialised.
+ */
+bool apic_initialize(void);
+
+/**
+ * @brief Enables the current CPU's local APIC.
+ * Enables the local APIC in the interface selected by `apic_initialize`, and
+ * sets its spurious interrupt vector. Called by each CPU as it starts.
+ */
+void apic_enable(void);
+
+/**
+ * @brief Gets the APIC ID of the current CPU.
+ * @return The current CPU's APIC ID.
+ */
+uint32_t apic_get_id(void);
+
+/**
+ * @brief Gets the initial APIC ID of the current CPU through CPUID.
+ * Unlike `apic_get_id`, this does not touch the local APIC, so it may be used
+ * before the local APIC is enabled.
+ * @return The current CPU's initial APIC ID.
+ */
+uint32_t apic_get_initial_id(void);
+
+/**
+ * @brief Signals the end of an interrupt delivered by the local APIC.
+ */
+void apic_send_end_of_interrupt(void);
+
+/**
+ * @brief Sends a fixed interrupt to another CPU.
+ * @param[in] apic_id The APIC ID of the target CPU.
+ * @param[in] vector The vector to deliver.
+ */
+void apic_send_ipi(const uint32_t apic_id,
+	const uint8_t vector);
+
+/**
+ * @brief Calibrates the local APIC timer against the TSC.
+ * Every CPU's timer is assumed to run at the same rate as the boot CPU's.
+ * Must be called on the boot CPU, after `clock_initialize`.
+ * @return Whether the timer could be calibrated.
+ */
+bool apic_timer_calibrate(void);
+
+/**
+ * @brief Starts the current CPU's local APIC timer in periodic mode.
+ * @param[in] vector The vector the timer interrupt is delivered to.
+ * @param[in] period_us The timer period in microseconds.
+ * @return Whether the timer was started. This fails if the timer has not been
+ * calibrated.
+ */
+bool apic_timer_start(const uint8_t vector,
+	const uint32_t period_us);
+
+/**
+ * @brief Sends an INIT IPI to every CPU but the current one.
+ * Resets every other CPU to its wait-for-SIPI state.
+ */
+void apic_broadcast_init(void);
+
+/**
+ * @brief Sends a startup IPI to every CPU but the current one.
+ * @param[in] page The physical page number the CPUs start executing at, in
+ * real mode. The page must be below 1MiB.
+ */
+void apic_broadcast_startup(const uint8_t page);
+
+#endif
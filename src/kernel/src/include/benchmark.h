@@ -0,0 +1,112 @@
+/**
+ * @file benchmark.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Kernel microbenchmarks.
+ * Contains definitions for the benchmark registry, and the machine-readable
+ * result format. Each module registers its benchmarks with `BENCHMARK`, which
+ * records them in the `.benchmarks` section. When the kernel is built with
+ * `BENCHMARK_MODE`, `benchmark_run_all` runs every registered benchmark once
+ * the kernel is initialised.
+ * Results are written through `kprintf` as single lines of space separated
+ * `key=value` fields, beginning with `BENCH `, so they can be picked out of
+ * the rest of the serial output.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H 1
+
+#include <stdint.h>
+
+/**
+ * Whether the kernel runs its benchmarks at boot, then exits the emulator.
+ * Set by the makefile's `BENCHMARK_MODE` variable.
+ */
+#ifndef BENCHMARK_MODE
+	#define BENCHMARK_MODE             0
+#endif
+
+/** The maximum number of extra counters reported with a result. */
+#define BENCHMARK_MAX_COUNTERS       2
+/**
+ * The I/O port of QEMU's `isa-debug-exit` device. Writing to it exits the
+ * emulator. Without the device the write is ignored.
+ */
+#define BENCHMARK_EXIT_PORT          0xF4
+
+/**
+ * @brief A registered benchmark.
+ */
+typedef struct s_benchmark {
+	const char* name;
+	void (*run)(void);
+} Benchmark;
+
+/**
+ * @brief An extra counter reported with a benchmark result.
+ */
+typedef struct s_benchmark_counter {
+	const char* name;
+	uint64_t value;
+} Benchmark_Counter;
+
+/**
+ * @brief A benchmark result.
+ * `size` is the size of each operation, in the unit natural to the benchmark,
+ * or zero if operations have no size. `bytes` is the total number of bytes
+ * processed, or zero if the benchmark does not measure throughput. Unused
+ * counters have a NULL name.
+ */
+typedef struct s_benchmark_result {
+	const char* suite;
+	const char* name;
+	const char* variant;
+	uint64_t size;
+	uint64_t operations;
+	uint64_t cycles;
+	uint64_t bytes;
+	Benchmark_Counter counters[BENCHMARK_MAX_COUNTERS];
+} Benchmark_Result;
+
+/**
+ * @brief Registers a benchmark.
+ * @param name The name of the benchmark, an identifier.
+ * @param function The function running the benchmark.
+ */
+#define BENCHMARK(name, function)                                        \
+	static const Benchmark benchmark_##name                               \
+		__attribute__((section(".benchmarks"), used, aligned(8))) = {        \
+		#name, (function)                                                    \
+	}
+
+/**
+ * @brief Reports a benchmark result.
+ * Writes the result as a `BENCH` line, with the time in nanoseconds, and the
+ * per operation cost and throughput derived from it.
+ * @param[in] result The result.
+ */
+void benchmark_report(const Benchmark_Result* result);
+
+/**
+ * @brief Reports a benchmark as skipped.
+ * @param[in] suite The suite being skipped.
+ * @param[in] reason Why the suite was skipped. Must not contain spaces.
+ */
+void benchmark_skip(const char* suite,
+	const char* reason);
+
+/**
+ * @brief Runs every registered benchmark.
+ * Writes `BENCH_BEGIN` and `BENCH_END` lines around the results.
+ * @return The number of benchmarks run.
+ */
+uint64_t benchmark_run_all(void);
+
+/**
+ * @brief Exits the emulator.
+ * Flushes all output, then writes to `BENCHMARK_EXIT_PORT`. This returns if
+ * there is no exit device.
+ */
+void benchmark_exit_emulator(void);
+
+#endif
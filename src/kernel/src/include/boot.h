@@ -11,9 +11,35 @@
 
 #include <stdint.h>
 
+/**
+ * @brief Memory region type.
+ * Mirrors the UEFI `EFI_MEMORY_TYPE` enumeration passed through by the
+ * bootloader in each memory region descriptor.
+ */
+typedef enum e_memory_region_type {
+	MEMORY_REGION_RESERVED = 0,
+	MEMORY_REGION_LOADER_CODE = 1,
+	MEMORY_REGION_LOADER_DATA = 2,
+	MEMORY_REGION_BOOT_SERVICES_CODE = 3,
+	MEMORY_REGION_BOOT_SERVICES_DATA = 4,
+	MEMORY_REGION_RUNTIME_SERVICES_CODE = 5,
+	MEMORY_REGION_RUNTIME_SERVICES_DATA = 6,
+	MEMORY_REGION_CONVENTIONAL = 7,
+	MEMORY_REGION_UNUSABLE = 8,
+	MEMORY_REGION_ACPI_RECLAIM = 9,
+	MEMORY_REGION_ACPI_NVS = 10,
+	MEMORY_REGION_MMIO = 11,
+	MEMORY_REGION_MMIO_PORT_SPACE = 12,
+	MEMORY_REGION_PAL_CODE = 13,
+	MEMORY_REGION_PERSISTENT = 14
+} Memory_Region_Type;
+
 /**
  * @brief Memory region descriptor.
  * Describes a region of memory. This is passed to the kernel by the bootloader.
+ * `type` is a `Memory_Region_Type`, and `count` the region's size in 4KiB
+ * pages. The firmware may append fields, so descriptors must be stepped through
+ * by `Boot_Info.mmap_descriptor_size`, not by the size of this structure.
  */
 typedef struct s_memory_region_desc {
 	uint32_t type;
@@ -24,22 +50,70 @@ typedef struct s_memory_region_desc {
 	uint64_t attributes;
 } Memory_Map_Descriptor;
 
+/**
+ * @brief Framebuffer pixel format.
+ * Mirrors the UEFI `EFI_GRAPHICS_PIXEL_FORMAT` enumeration passed through by
+ * the bootloader.
+ */
+typedef enum e_pixel_format {
+	PIXEL_FORMAT_RGBX_8BPC = 0,
+	PIXEL_FORMAT_BGRX_8BPC = 1,
+	PIXEL_FORMAT_BITMASK = 2,
+	PIXEL_FORMAT_BLT_ONLY = 3
+} Pixel_Format;
+
+/**
+ * @brief Framebuffer pixel bitmask.
+ * Mirrors the UEFI `EFI_PIXEL_BITMASK` struct. Only valid when the pixel
+ * format is `PIXEL_FORMAT_BITMASK`.
+ */
+typedef struct s_pixel_bitmask {
+	uint32_t red_mask;
+	uint32_t green_mask;
+	uint32_t blue_mask;
+	uint32_t reserved_mask;
+} Pixel_Bitmask;
+
+/**
+ * @brief Boot video mode info struct.
+ * Describes the video mode and framebuffer set by the bootloader.
+ */
 typedef struct s_boot_video_info {
 	uint32_t* framebuffer_pointer;
 	uint32_t horizontal_resolution;
 	uint32_t vertical_resolution;
 	uint32_t pixels_per_scanline;
+	Pixel_Format pixel_format;
+	Pixel_Bitmask pixel_information;
+	uint64_t framebuffer_size;
 } Kernel_Boot_Video_Mode_Info;
 
+/**
+ * @brief Boot log info struct.
+ * Describes the bootloader's log ring. `length` is the total number of bytes
+ * ever written to the ring, which holds the last `size` bytes of them.
+ */
+typedef struct s_boot_log_info {
+	char* buffer;
+	uint64_t size;
+	uint64_t length;
+} Boot_Log_Info;
+
 /**
  * @brief Boot info struct.
  * Contains information passed to the kernel at boot time by the bootloader.
+ * `acpi_rsdp` is NULL if the firmware provided no ACPI tables.
+ * `ap_trampoline` is a page in low memory reserved for starting the
+ * application processors, or NULL if the bootloader could not reserve one.
  */
 typedef struct s_boot_info {
 	Memory_Map_Descriptor* memory_map;
 	uint64_t mmap_size;
 	uint64_t mmap_descriptor_size;
 	Kernel_Boot_Video_Mode_Info video_mode_info;
+	Boot_Log_Info log_info;
+	void* acpi_rsdp;
+	void* ap_trampoline;
 } Boot_Info;
 
 #endif
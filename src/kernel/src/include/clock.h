@@ -0,0 +1,132 @@
+/**
+ * @file clock.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Clock functionality.
+ * Contains definitions for the kernel's high-resolution clock. The clock reads
+ * the timestamp counter, whose frequency is calibrated at boot against the
+ * HPET, if ACPI describes one, or otherwise the PIT. Timestamps are converted
+ * to nanoseconds with a fixed-point multiply and shift, so reading the clock
+ * costs a `rdtsc` and a multiply.
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <cpu.h>
+
+/** The number of calibration runs. The median frequency is used. */
+#define CLOCK_CALIBRATION_RUNS       5
+/** The length of each calibration run in milliseconds. */
+#define CLOCK_CALIBRATION_MS         10
+/** The shift applied after multiplying cycles by `Clock.mult`. */
+#define CLOCK_SHIFT                  32
+/**
+ * The TSC frequency assumed if calibration fails. This is deliberately higher
+ * than any real TSC, so that delays err on the long side.
+ */
+#define CLOCK_FALLBACK_FREQUENCY     5000000000ULL
+/** The number of TSC readings each CPU takes when checking synchronisation. */
+#define CLOCK_TSC_SYNC_ITERATIONS    1000
+
+/**
+ * @brief The reference timer the TSC was calibrated against.
+ */
+typedef enum e_clock_reference {
+	CLOCK_REFERENCE_NONE,
+	CLOCK_REFERENCE_PIT,
+	CLOCK_REFERENCE_HPET
+} Clock_Reference;
+
+/**
+ * @brief The kernel clock.
+ * `mult` converts cycles to nanoseconds: `ns = (cycles * mult) >> CLOCK_SHIFT`.
+ * `spread` is the difference between the highest and lowest frequency measured
+ * across the calibration runs, as an indication of the calibration's accuracy.
+ * `tsc_warp` is the largest backwards step in cycles seen between TSC readings
+ * on different CPUs by `clock_check_tsc_sync`. If it is non-zero, timestamps
+ * taken on different CPUs cannot be compared.
+ */
+typedef struct s_clock {
+	Clock_Reference reference;
+	uint64_t tsc_frequency;
+	uint64_t mult;
+	uint64_t spread;
+	uint64_t boot_timestamp;
+	uint64_t tsc_warp;
+	bool invariant_tsc;
+	bool calibrated;
+	bool tsc_sync_checked;
+} Clock;
+
+/**
+ * @brief The kernel clock.
+ * Populated by `clock_initialize`.
+ */
+extern Clock kernel_clock;
+
+/**
+ * @brief Initialises the kernel clock.
+ * Calibrates the TSC against the HPET, if ACPI describes one, falling back to
+ * the PIT. Must be called after `acpi_initialize`. Interrupts are disabled
+ * during each calibration run.
+ * @return Whether the TSC was calibrated. If not, the clock assumes
+ * `CLOCK_FALLBACK_FREQUENCY`.
+ */
+bool clock_initialize(void);
+
+/**
+ * @brief Gets a readable name for a clock reference.
+ * @param[in] reference The clock reference.
+ * @return The name of the clock reference.
+ */
+const char* clock_get_reference_name(const Clock_Reference reference);
+
+/**
+ * @brief Converts a number of TSC cycles to nanoseconds.
+ * @param[in] cycles The number of cycles.
+ * @return The number of nanoseconds.
+ */
+static inline uint64_t clock_cycles_to_ns(const uint64_t cycles)
+{
+	return (uint64_t)(((unsigned __int128)cycles * kernel_clock.mult) >>
+		CLOCK_SHIFT);
+}
+
+/**
+ * @brief Gets the time since the clock was initialised.
+ * @return The time since the clock was initialised, in nanoseconds.
+ */
+static inline uint64_t clock_now_ns(void)
+{
+	return clock_cycles_to_ns(read_timestamp_counter() -
+		kernel_clock.boot_timestamp);
+}
+
+/**
+ * @brief Converts a number of nanoseconds to TSC cycles.
+ * @param[in] ns The number of nanoseconds.
+ * @return The number of cycles.
+ */
+uint64_t clock_ns_to_cycles(const uint64_t ns);
+
+/**
+ * @brief Checks that the TSCs of every CPU are synchronised.
+ * Called together by every online CPU, once. Each CPU in turn reads its TSC
+ * under a shared lock, and compares it with the previous reading, taken by
+ * whichever CPU held the lock last. Any reading lower than the one before it
+ * is a warp, which is recorded in `kernel_clock.tsc_warp`. Returns once every
+ * CPU has finished.
+ * @param[in] n_cpus The number of CPUs taking part.
+ */
+void clock_check_tsc_sync(const uint32_t n_cpus);
+
+/**
+ * @brief Spins for a number of microseconds.
+ * @param[in] us The number of microseconds to wait.
+ */
+void clock_delay_us(const uint64_t us);
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file console.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Framebuffer text console.
+ * Contains functionality for drawing a scrolling text console to the
+ * framebuffer through the renderer.
+ * Text is written into a grid of character cells, which is only rendered into
+ * the back buffer, and flushed to the framebuffer, in batches. This keeps the
+ * cost of writing a line of text to a few stores, however fast lines arrive.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <font.h>
+#include <renderer.h>
+
+/** The maximum number of columns supported. */
+#define CONSOLE_MAX_COLUMNS           (RENDERER_MAX_WIDTH / FONT_GLYPH_WIDTH)
+/** The maximum number of rows supported. */
+#define CONSOLE_MAX_ROWS              (RENDERER_MAX_HEIGHT / FONT_GLYPH_HEIGHT)
+/** The number of colour attributes the glyph cache holds at once. */
+#define CONSOLE_GLYPH_CACHE_SIZE      4
+/** The number of columns between tab stops. */
+#define CONSOLE_TAB_WIDTH             8
+/**
+ * The minimum number of TSC cycles between the flushes triggered by writing
+ * to the console. Writes in between only update the cell grid, and are
+ * flushed together.
+ */
+#define CONSOLE_FLUSH_INTERVAL_CYCLES 0x2000000
+
+/**
+ * @brief A character cell.
+ * The attribute uses the VGA text mode encoding of a foreground colour in the
+ * low nibble and a background colour in the high nibble.
+ * Refer to: `create_vga_color_entry` in vga.h
+ */
+typedef struct s_console_cell {
+	char character;
+	uint8_t attribute;
+} Console_Cell;
+
+/**
+ * @brief The columns of a row written since it was last rendered.
+ * The span covers columns `start` up to, but not including, `end`. A row with
+ * an empty span is clean.
+ */
+typedef struct s_console_dirty_span {
+	uint16_t start;
+	uint16_t end;
+} Console_Dirty_Span;
+
+/**
+ * @brief A glyph cache entry.
+ * Holds every possible glyph row expanded into canonical pixels for one colour
+ * attribute. Each row of a glyph is drawn by copying the expansion of its
+ * bitmap byte, so no per-pixel work is done when rendering text.
+ */
+typedef struct s_console_glyph_cache_entry {
+	uint32_t row_pixels[256][FONT_GLYPH_WIDTH] __attribute__((aligned(32)));
+	uint64_t last_used;
+	uint8_t attribute;
+	bool valid;
+} Console_Glyph_Cache_Entry;
+
+/**
+ * @brief Console state.
+ * The cell grid is a ring of rows. Scrolling advances `top_row`, the index of
+ * the ring row shown at the top of the screen, rather than moving any cells.
+ * Scrolls are counted in `pending_scroll`, and applied to the back buffer with
+ * a single block move when the console is next flushed.
+ */
+typedef struct s_console {
+	Renderer* renderer;
+	uint32_t columns;
+	uint32_t rows;
+	uint32_t cursor_x;
+	uint32_t cursor_y;
+	uint8_t attribute;
+	uint32_t top_row;
+	uint32_t pending_scroll;
+	uint64_t last_flush;
+	uint64_t n_flushes;
+	uint64_t n_scrolls;
+	uint64_t cache_clock;
+	Console_Cell cells[CONSOLE_MAX_ROWS][CONSOLE_MAX_COLUMNS];
+	Console_Dirty_Span dirty_spans[CONSOLE_MAX_ROWS];
+	Console_Glyph_Cache_Entry glyph_cache[CONSOLE_GLYPH_CACHE_SIZE];
+} Console;
+
+/**
+ * @brief The system console.
+ * Populated by `console_initialize`.
+ */
+extern Console console;
+
+/**
+ * @brief Initialises the console.
+ * Sets up a console covering the whole of the renderer's screen, and clears it.
+ * @param[in,out] con The console to initialise.
+ * @param[in] r The renderer to draw the console with.
+ * @return A boolean indicating whether the console was initialised. This fails
+ * if the renderer has no back buffer.
+ */
+bool console_initialize(Console* con,
+	Renderer* r);
+
+/**
+ * @brief Sets the console colour.
+ * Sets the colour attribute used for subsequently written text.
+ * @param[in,out] con The console.
+ * @param[in] attribute The colour attribute, as created by
+ * `create_vga_color_entry`.
+ */
+void console_set_colour(Console* con,
+	const uint8_t attribute);
+
+/**
+ * @brief Clears the console.
+ * Clears every cell to the current colour, and moves the cursor to the top-left.
+ * @param[in,out] con The console.
+ */
+void console_clear(Console* con);
+
+/**
+ * @brief Writes a character to the console.
+ * Writes a character at the cursor, handling newlines, carriage returns, tabs
+ * and backspaces. This only updates the cell grid; the character is drawn by
+ * the next flush.
+ * @param[in,out] con The console.
+ * @param[in] c The character to write.
+ */
+void console_putchar(Console* con,
+	const char c);
+
+/**
+ * @brief Writes a string to the console.
+ * Writes every character of a string, then flushes the console if at least
+ * `CONSOLE_FLUSH_INTERVAL_CYCLES` have passed since the last flush.
+ * @param[in,out] con The console.
+ * @param[in] str The null-terminated string to write.
+ */
+void console_write(Console* con,
+	const char* str);
+
+/**
+ * @brief Flushes the console to the framebuffer.
+ * Applies any pending scroll to the back buffer, renders every dirty cell, and
+ * flushes the damaged regions to the framebuffer.
+ * @param[in,out] con The console.
+ */
+void console_flush(Console* con);
+
+#endif
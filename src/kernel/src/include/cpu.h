@@ -0,0 +1,514 @@
+/**
+ * @file cpu.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief CPU functionality.
+ * Contains definitions for working with processor-specific instructions, and
+ * the processor features detected at boot.
+ */
+
+#ifndef CPU_H
+#define CPU_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Control register 0: Monitor coprocessor bit. */
+#define CR0_MP                   (1ULL << 1)
+/** Control register 0: x87 emulation bit. */
+#define CR0_EM                   (1ULL << 2)
+/** Control register 0: Task switched bit. */
+#define CR0_TS                   (1ULL << 3)
+/** Control register 0: Write protect bit. */
+#define CR0_WP                   (1ULL << 16)
+/** Control register 4: Page global enable bit. */
+#define CR4_PGE                  (1ULL << 7)
+/** Control register 4: FXSAVE and SSE enable bit. */
+#define CR4_OSFXSR               (1ULL << 9)
+/** Control register 4: Unmasked SIMD floating point exception enable bit. */
+#define CR4_OSXMMEXCPT           (1ULL << 10)
+/** Control register 4: Process-context identifiers enable bit. */
+#define CR4_PCIDE                (1ULL << 17)
+/** Control register 4: XSAVE and extended state enable bit. */
+#define CR4_OSXSAVE              (1ULL << 18)
+
+/** RFLAGS: Interrupt enable flag. */
+#define RFLAGS_IF                (1ULL << 9)
+
+/** The local APIC base address MSR. */
+#define MSR_IA32_APIC_BASE       0x1B
+/** The page attribute table MSR. */
+#define MSR_IA32_PAT             0x277
+/** The extended feature enable MSR. */
+#define MSR_IA32_EFER            0xC0000080
+/** The GS segment base MSR. */
+#define MSR_IA32_GS_BASE         0xC0000101
+
+/** CPUID leaf 1 EDX: Page attribute table support. */
+#define CPUID_1_EDX_PAT          (1U << 16)
+/** CPUID leaf 1 ECX: SSE3 support. */
+#define CPUID_1_ECX_SSE3         (1U << 0)
+/** CPUID leaf 1 ECX: MONITOR/MWAIT support. */
+#define CPUID_1_ECX_MONITOR      (1U << 3)
+/** CPUID leaf 1 ECX: SSSE3 support. */
+#define CPUID_1_ECX_SSSE3        (1U << 9)
+/** CPUID leaf 1 ECX: Process-context identifier support. */
+#define CPUID_1_ECX_PCID         (1U << 17)
+/** CPUID leaf 1 ECX: SSE4.1 support. */
+#define CPUID_1_ECX_SSE4_1       (1U << 19)
+/** CPUID leaf 1 ECX: SSE4.2 support. */
+#define CPUID_1_ECX_SSE4_2       (1U << 20)
+/** CPUID leaf 1 ECX: x2APIC support. */
+#define CPUID_1_ECX_X2APIC       (1U << 21)
+/** CPUID leaf 1 ECX: XSAVE support. */
+#define CPUID_1_ECX_XSAVE        (1U << 26)
+/** CPUID leaf 1 ECX: XSAVE enabled by the operating system. */
+#define CPUID_1_ECX_OSXSAVE      (1U << 27)
+/** CPUID leaf 1 ECX: AVX support. */
+#define CPUID_1_ECX_AVX          (1U << 28)
+/** CPUID leaf 7 EBX: AVX2 support. */
+#define CPUID_7_EBX_AVX2         (1U << 5)
+/** CPUID leaf 7 EBX: Enhanced REP MOVSB/STOSB support. */
+#define CPUID_7_EBX_ERMS         (1U << 9)
+/** CPUID leaf 7 EBX: AVX-512 foundation support. */
+#define CPUID_7_EBX_AVX512F      (1U << 16)
+/** CPUID leaf 7 EDX: Fast short REP MOVSB support. */
+#define CPUID_7_EDX_FSRM         (1U << 4)
+/** The CPUID leaf enumerating the XSAVE state components. */
+#define CPUID_LEAF_XSAVE         0xD
+/** The CPUID leaf reporting the highest extended leaf. */
+#define CPUID_LEAF_EXTENDED      0x80000000
+/** The CPUID leaf enumerating extended processor features. */
+#define CPUID_LEAF_EXTENDED_FEATURES 0x80000001
+/** CPUID leaf 0x80000001 EDX: 1GiB page support. */
+#define CPUID_EXTENDED_EDX_PAGE_1GB  (1U << 26)
+/** The CPUID leaf enumerating advanced power management features. */
+#define CPUID_LEAF_POWER         0x80000007
+/** CPUID leaf 0x80000007 EDX: The TSC runs at a constant rate in every state. */
+#define CPUID_POWER_EDX_INVARIANT_TSC (1U << 8)
+/** The CPUID leaf reporting the physical and linear address sizes. */
+#define CPUID_LEAF_ADDRESS_SIZES 0x80000008
+/** The physical address width assumed without the address sizes leaf. */
+#define CPU_DEFAULT_PHYSICAL_ADDRESS_BITS 36
+
+/** XCR0: x87 state enabled. This is always set. */
+#define XCR0_X87                 (1ULL << 0)
+/** XCR0: SSE state enabled. */
+#define XCR0_SSE                 (1ULL << 1)
+/** XCR0: AVX state enabled. */
+#define XCR0_AVX                 (1ULL << 2)
+/** XCR0: AVX-512 opmask state enabled. */
+#define XCR0_OPMASK              (1ULL << 5)
+/** XCR0: AVX-512 upper halves of ZMM0-15 state enabled. */
+#define XCR0_ZMM_HI256           (1ULL << 6)
+/** XCR0: AVX-512 ZMM16-31 state enabled. */
+#define XCR0_HI16_ZMM            (1ULL << 7)
+/** XCR0: Every AVX-512 state component. These are enabled together. */
+#define XCR0_AVX512              (XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM)
+
+/** Always present. Used for the baseline alternative. */
+#define CPU_FEATURE_BASELINE     0
+/** AVX2, with its state enabled. */
+#define CPU_FEATURE_AVX2         1
+/** AVX-512 foundation, with its state enabled. */
+#define CPU_FEATURE_AVX512F      2
+/** Enhanced REP MOVSB/STOSB. */
+#define CPU_FEATURE_ERMS         3
+/** Fast short REP MOVSB. */
+#define CPU_FEATURE_FSRM         4
+
+/**
+ * The size of the XSAVE area reserved by the interrupt entry stubs. State
+ * components needing a larger area are not enabled. This must match
+ * `CPU_XSAVE_AREA_SIZE` in interrupt_stubs.S.
+ */
+#define CPU_XSAVE_AREA_MAX_SIZE  0xC00
+
+/**
+ * @brief The processor features detected at boot.
+ * Populated by `cpu_initialize`. Each SIMD feature is only set if the
+ * processor supports it, and its state has been enabled, so that it can be
+ * used as soon as it is set.
+ */
+typedef struct s_cpu_features {
+	char vendor[13];
+	uint32_t family;
+	uint32_t max_leaf;
+	uint32_t max_extended_leaf;
+	bool sse3;
+	bool ssse3;
+	bool sse4_1;
+	bool sse4_2;
+	bool xsave;
+	bool avx;
+	bool avx2;
+	bool avx512f;
+	bool erms;
+	bool fsrm;
+	bool pat;
+	bool x2apic;
+	bool monitor;
+	bool pcid;
+	bool page_1gb;
+	bool invariant_tsc;
+	uint32_t physical_address_bits;
+	uint64_t xcr0;
+	uint32_t xsave_area_size;
+} Cpu_Features;
+
+/**
+ * @brief The processor features.
+ * Populated by `cpu_initialize`, before `kernel_main` is entered.
+ */
+extern Cpu_Features cpu_features;
+
+/**
+ * @brief The state components saved by the interrupt entry stubs with XSAVE.
+ * Zero if XSAVE is not enabled, in which case FXSAVE is used instead.
+ */
+extern uint64_t cpu_xsave_mask;
+
+/**
+ * @brief Initialises the processor's SIMD state, and detects its features.
+ * Enables XSAVE, and every SSE, AVX and AVX-512 state component that the
+ * processor supports, then records the processor's features in
+ * `cpu_features`. Called from the kernel entry point, once SSE has been
+ * enabled, and before `kernel_main`.
+ */
+void cpu_initialize(void);
+
+/**
+ * @brief Tests whether the processor has a feature.
+ * @param[in] feature The `CPU_FEATURE_*` to test.
+ * @return Whether the processor has the feature. Unknown features are
+ * reported as absent.
+ */
+bool cpu_has_feature(const uint32_t feature);
+
+/**
+ * @brief Executes the CPUID instruction.
+ * @param[in] leaf The CPUID leaf.
+ * @param[in] subleaf The CPUID subleaf.
+ * @param[out] eax The returned EAX value.
+ * @param[out] ebx The returned EBX value.
+ * @param[out] ecx The returned ECX value.
+ * @param[out] edx The returned EDX value.
+ */
+static inline void cpuid(const uint32_t leaf,
+	const uint32_t subleaf,
+	uint32_t* eax,
+	uint32_t* ebx,
+	uint32_t* ecx,
+	uint32_t* edx)
+{
+	asm volatile("cpuid"
+		: "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+		: "a"(leaf), "c"(subleaf));
+}
+
+/**
+ * @brief Reads an extended control register.
+ * @param[in] xcr The extended control register to read.
+ * @return The value of the register.
+ * @warning Faults unless CR4.OSXSAVE is set.
+ */
+static inline uint64_t read_xcr(const uint32_t xcr)
+{
+	/** The low 32 bits of the register. */
+	uint32_t low;
+	/** The high 32 bits of the register. */
+	uint32_t high;
+
+	asm volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(xcr));
+
+	return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief Writes an extended control register.
+ * @param[in] xcr The extended control register to write.
+ * @param[in] value The value to write.
+ * @warning Faults unless CR4.OSXSAVE is set.
+ */
+static inline void write_xcr(const uint32_t xcr,
+	const uint64_t value)
+{
+	asm volatile("xsetbv"
+		: : "c"(xcr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+/**
+ * @brief Reads a model specific register.
+ * @param[in] msr The MSR to read.
+ * @return The value of the MSR.
+ */
+static inline uint64_t read_msr(const uint32_t msr)
+{
+	/** The low 32 bits of the MSR. */
+	uint32_t low;
+	/** The high 32 bits of the MSR. */
+	uint32_t high;
+
+	asm volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+
+	return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief Writes a model specific register.
+ * @param[in] msr The MSR to write.
+ * @param[in] value The value to write.
+ */
+static inline void write_msr(const uint32_t msr,
+	const uint64_t value)
+{
+	asm volatile("wrmsr"
+		: : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+/**
+ * @brief Reads control register 0.
+ */
+static inline uint64_t read_cr0(void)
+{
+	/** The register value. */
+	uint64_t value;
+	asm volatile("mov %%cr0, %0" : "=r"(value));
+	return value;
+}
+
+/**
+ * @brief Writes control register 0.
+ */
+static inline void write_cr0(const uint64_t value)
+{
+	asm volatile("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief Reads control register 3.
+ */
+static inline uint64_t read_cr3(void)
+{
+	/** The register value. */
+	uint64_t value;
+	asm volatile("mov %%cr3, %0" : "=r"(value));
+	return value;
+}
+
+/**
+ * @brief Writes control register 3.
+ */
+static inline void write_cr3(const uint64_t value)
+{
+	asm volatile("mov %0, %%cr3" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief Reads control register 4.
+ */
+static inline uint64_t read_cr4(void)
+{
+	/** The register value. */
+	uint64_t value;
+	asm volatile("mov %%cr4, %0" : "=r"(value));
+	return value;
+}
+
+/**
+ * @brief Writes control register 4.
+ */
+static inline void write_cr4(const uint64_t value)
+{
+	asm volatile("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+/**
+ * @brief Invalidates the TLB entries for a page.
+ * @param[in] address An address within the page.
+ */
+static inline void invalidate_page(const uintptr_t address)
+{
+	asm volatile("invlpg (%0)" : : "r"(address) : "memory");
+}
+
+/**
+ * @brief Writes back and invalidates all caches.
+ */
+static inline void write_back_invalidate_caches(void)
+{
+	asm volatile("wbinvd" : : : "memory");
+}
+
+/**
+ * @brief Reads the timestamp counter.
+ * Reads the processor's timestamp counter.
+ * @return The current value of the timestamp counter.
+ */
+static inline uint64_t read_timestamp_counter(void)
+{
+	/** The low 32 bits of the counter. */
+	uint32_t low;
+	/** The high 32 bits of the counter. */
+	uint32_t high;
+
+	asm volatile("rdtsc" : "=a"(low), "=d"(high));
+
+	return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief Reads the timestamp counter, once earlier instructions complete.
+ * Unlike `read_timestamp_counter`, the read cannot be executed ahead of
+ * earlier loads, so readings on different CPUs ordered by a lock are ordered
+ * in time too.
+ * @return The current value of the timestamp counter.
+ */
+static inline uint64_t read_timestamp_counter_ordered(void)
+{
+	/** The low 32 bits of the counter. */
+	uint32_t low;
+	/** The high 32 bits of the counter. */
+	uint32_t high;
+
+	asm volatile("lfence\n\trdtsc" : "=a"(low), "=d"(high) : : "memory");
+
+	return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * @brief Reads the code segment selector.
+ * @return The selector of the active code segment.
+ */
+static inline uint16_t read_cs(void)
+{
+	/** The selector value. */
+	uint16_t value;
+	asm volatile("mov %%cs, %0" : "=r"(value));
+	return value;
+}
+
+/**
+ * @brief Loads the interrupt descriptor table register.
+ * @param[in] descriptor A pointer to the 10 byte IDT descriptor.
+ */
+static inline void load_idt(const void* descriptor)
+{
+	asm volatile("lidt (%0)" : : "r"(descriptor) : "memory");
+}
+
+/**
+ * @brief Loads the global descriptor table register.
+ * The segment registers keep their cached descriptors until reloaded.
+ * @param[in] descriptor A pointer to the 10 byte GDT descriptor.
+ */
+static inline void load_gdt(const void* descriptor)
+{
+	asm volatile("lgdt (%0)" : : "r"(descriptor) : "memory");
+}
+
+/**
+ * @brief Loads the task register.
+ * @param[in] selector The selector of an available TSS descriptor, which is
+ * marked busy.
+ */
+static inline void load_task_register(const uint16_t selector)
+{
+	asm volatile("ltr %0" : : "r"(selector) : "memory");
+}
+
+/**
+ * @brief Sets the base of the GS segment.
+ * @param[in] base The new GS base.
+ */
+static inline void write_gs_base(const uint64_t base)
+{
+	write_msr(MSR_IA32_GS_BASE, base);
+}
+
+/**
+ * @brief Enables maskable interrupts.
+ */
+static inline void enable_interrupts(void)
+{
+	asm volatile("sti" : : : "memory");
+}
+
+/**
+ * @brief Disables maskable interrupts.
+ */
+static inline void disable_interrupts(void)
+{
+	asm volatile("cli" : : : "memory");
+}
+
+/**
+ * @brief Disables maskable interrupts, returning the previous flags.
+ * @return The value of RFLAGS before interrupts were disabled, to be passed to
+ * `restore_interrupts`.
+ */
+static inline uint64_t save_and_disable_interrupts(void)
+{
+	/** The saved flags. */
+	uint64_t flags;
+	asm volatile("pushfq\n\tpopq %0\n\tcli" : "=r"(flags) : : "memory");
+	return flags;
+}
+
+/**
+ * @brief Restores the interrupt flag saved by `save_and_disable_interrupts`.
+ * @param[in] flags The saved flags.
+ */
+static inline void restore_interrupts(const uint64_t flags)
+{
+	if(flags & RFLAGS_IF) {
+		enable_interrupts();
+	}
+}
+
+/**
+ * @brief Halts the processor until the next interrupt.
+ */
+static inline void halt(void)
+{
+	asm volatile("hlt" : : : "memory");
+}
+
+/**
+ * @brief Enables maskable interrupts, then halts until the next interrupt.
+ * An interrupt cannot be taken between the two instructions, so an interrupt
+ * which became pending while interrupts were disabled wakes the processor.
+ */
+static inline void enable_interrupts_and_halt(void)
+{
+	asm volatile("sti\n\thlt" : : : "memory");
+}
+
+/**
+ * @brief Arms address monitoring for `mwait`.
+ * @param[in] address An address within the line to monitor.
+ */
+static inline void monitor(const void* address)
+{
+	asm volatile("monitor" : : "a"(address), "c"(0), "d"(0) : "memory");
+}
+
+/**
+ * @brief Enables maskable interrupts, then waits for a write to the line
+ * armed by `monitor`, or an interrupt.
+ * As with `enable_interrupts_and_halt`, a pending interrupt ends the wait.
+ */
+static inline void enable_interrupts_and_mwait(void)
+{
+	asm volatile("sti\n\tmwait" : : "a"(0), "c"(0) : "memory");
+}
+
+/**
+ * @brief Hints to the processor that it is in a spin-wait loop.
+ */
+static inline void cpu_relax(void)
+{
+	asm volatile("pause" : : : "memory");
+}
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file font.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Console font.
+ * Contains the bitmap font used by the framebuffer console.
+ */
+
+#ifndef FONT_H
+#define FONT_H 1
+
+#include <stdint.h>
+
+/** The width of a glyph in pixels. */
+#define FONT_GLYPH_WIDTH          8
+/** The height of a glyph in pixels. */
+#define FONT_GLYPH_HEIGHT         16
+/** The first character with a glyph in the font. */
+#define FONT_FIRST_CHARACTER      0x20
+/** The last character with a glyph in the font. */
+#define FONT_LAST_CHARACTER       0x7E
+/** The character drawn in place of those not in the font. */
+#define FONT_REPLACEMENT_CHARACTER '?'
+/** The number of glyphs in the font. */
+#define FONT_GLYPH_COUNT          (FONT_LAST_CHARACTER - FONT_FIRST_CHARACTER + 1)
+
+/**
+ * @brief The font's glyph bitmaps.
+ * Each glyph is stored pre-rasterised as one byte per row, with the most
+ * significant bit being the leftmost pixel. Glyphs are indexed from
+ * `FONT_FIRST_CHARACTER`.
+ */
+extern const uint8_t font_glyphs[FONT_GLYPH_COUNT][FONT_GLYPH_HEIGHT];
+
+/**
+ * @brief Gets the bitmap of a character's glyph.
+ * @param[in] c The character.
+ * @return The glyph's bitmap. Characters not in the font are drawn with the
+ * replacement character's glyph.
+ */
+static inline const uint8_t* font_get_glyph(const char c)
+{
+	/** The character's code point. */
+	const uint8_t code = (uint8_t)c;
+
+	if(code < FONT_FIRST_CHARACTER || code > FONT_LAST_CHARACTER) {
+		return font_glyphs[FONT_REPLACEMENT_CHARACTER - FONT_FIRST_CHARACTER];
+	}
+
+	return font_glyphs[code - FONT_FIRST_CHARACTER];
+}
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file gdt.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Global descriptor table.
+ * Contains definitions for the kernel's GDT, which replaces the GDT left by
+ * the firmware. It holds flat 64-bit code and data segments shared by every
+ * CPU, and a TSS for each CPU. Each TSS provides a separate stack for double
+ * faults, so that a stack overflow into a guard page is reported rather than
+ * escalating to a triple fault.
+ */
+
+#ifndef GDT_H
+#define GDT_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The kernel code segment selector. */
+#define GDT_KERNEL_CODE_SELECTOR    0x08
+/** The kernel data segment selector. */
+#define GDT_KERNEL_DATA_SELECTOR    0x10
+/** The index of the first TSS descriptor. Each takes two entries. */
+#define GDT_TSS_FIRST_ENTRY         3
+/** The interrupt stack table entry used for double faults. */
+#define GDT_DOUBLE_FAULT_IST        1
+/** The size of each CPU's double fault stack. */
+#define GDT_DOUBLE_FAULT_STACK_SIZE 0x2000
+
+/**
+ * @brief Initialises the GDT.
+ * Builds the shared segments, and the TSS of every possible CPU. Must be
+ * called once, on the boot CPU, before `gdt_load`.
+ */
+void gdt_initialize(void);
+
+/**
+ * @brief Loads the GDT on the current CPU.
+ * Loads the GDT, reloads every segment register, and loads the CPU's TSS. FS
+ * and GS are loaded with the null selector, which may clear their bases, so
+ * the GS base must be set afterwards.
+ * @param[in] cpu_index The index of the current CPU, selecting its TSS.
+ */
+void gdt_load(const size_t cpu_index);
+
+#endif
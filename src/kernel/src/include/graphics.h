@@ -9,22 +9,99 @@
 #ifndef GRAPHICS_H
 #define GRAPHICS_H 1
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <boot.h>
+#include <paging.h>
+
+/** Packs RGB components into a colour in the canonical `0x00RRGGBB` layout. */
+#define CANONICAL_COLOUR(r, g, b) \
+	(((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+/**
+ * @brief Pixel span blit function.
+ * Copies a span of pixels in the canonical `0x00RRGGBB` layout into the
+ * framebuffer, encoding each pixel into the framebuffer's native layout.
+ * The `stream_span` variant writes with 16-byte non-temporal stores. Its caller
+ * must issue a store fence once all streaming spans have been written.
+ */
+typedef void (*Blit_Span_Function)(uint32_t* dest,
+	const uint32_t* src,
+	const uint32_t count);
+
+/**
+ * @brief Pixel span fill function.
+ * Fills a span of framebuffer pixels with an already encoded native colour.
+ */
+typedef void (*Fill_Span_Function)(uint32_t* dest,
+	const uint32_t count,
+	const uint32_t colour);
+
+/**
+ * @brief Colour encoding function.
+ * Encodes a canonical `0x00RRGGBB` colour into the framebuffer's native layout.
+ */
+typedef uint32_t (*Encode_Colour_Function)(const uint32_t colour);
+
+/**
+ * @brief Framebuffer state.
+ * Describes the framebuffer, and holds the span routines specialised for its
+ * pixel format. These are selected once in `graphics_initialize` so that no
+ * per-pixel format branching is needed when drawing.
+ */
+typedef struct s_framebuffer {
+	uint32_t* base;
+	uint32_t width;
+	uint32_t height;
+	uint32_t pixels_per_scanline;
+	uint64_t size;
+	Pixel_Format format;
+	Blit_Span_Function blit_span;
+	Blit_Span_Function stream_span;
+	Fill_Span_Function fill_span;
+	Encode_Colour_Function encode_colour;
+} Framebuffer;
+
+/**
+ * @brief The system framebuffer.
+ * Populated by `graphics_initialize` from the boot video mode info.
+ */
+extern Framebuffer framebuffer;
+
+/**
+ * @brief Initialises the framebuffer.
+ * Reads the video mode information passed by the bootloader and selects the
+ * span routines specialised for the framebuffer's pixel format.
+ * @param[in] video_mode_info The boot video mode info.
+ * @return A boolean indicating whether a usable framebuffer was found.
+ * A `PIXEL_FORMAT_BLT_ONLY` mode has no linear framebuffer and is not usable.
+ * Neither is a `PIXEL_FORMAT_BITMASK` mode whose pixels are not 32 bits.
+ */
+bool graphics_initialize(const Kernel_Boot_Video_Mode_Info* video_mode_info);
+
+/**
+ * @brief Sets the memory type of the framebuffer.
+ * Changes the memory type of the pages mapping the whole framebuffer, as
+ * reported by the boot video mode info's framebuffer size.
+ * @param[in] fb The framebuffer.
+ * @param[in] type The memory type to set.
+ * @return The status of the operation.
+ */
+Paging_Status graphics_set_memory_type(const Framebuffer* fb,
+	const Memory_Type type);
 
 /**
  * @brief Draws a rectangle onto the framebuffer.
  * Draws a rectangle onto the video frame buffer.
- * @param[in] framebuffer_pointer A pointer to the video framebuffer.
- * @param[in] pixels_per_scanline The number of pixels per scanline. Also known as 'pitch'.
- * In some more exotic video modes this may be different to the visible screen width.
+ * @param[in] fb The framebuffer to draw to.
  * @param[in] _x The x coordinate to draw the rect to.
  * @param[in] _y The y coordinate to draw the rect to.
  * @param[in] width The width of the rectangle to draw.
  * @param[in] height The height of the rectangle to draw.
- * @param[in] color The color to draw.
+ * @param[in] color The color to draw, encoded in the framebuffer's native
+ * layout by `convert_rgb_to_32bit_colour`.
  */
-void draw_rect(uint32_t* framebuffer_pointer,
-	const uint32_t pixels_per_scanline,
+void draw_rect(const Framebuffer* fb,
 	const uint16_t _x,
 	const uint16_t _y,
 	const uint16_t width,
@@ -33,26 +110,46 @@ void draw_rect(uint32_t* framebuffer_pointer,
 
 /**
  * @brief Paints a pixel of a certain colour onto the framebuffer.
- * @param[in] framebuffer_pointer A pointer to the video framebuffer.
- * @param[in] pixels_per_scanline The number of pixels per scanline. Also known as 'pitch'.
- * In some more exotic video modes this may be different to the visible screen width.
+ * @param[in] fb The framebuffer to draw to.
  * @param[in] _x The x coordinate to pixel.
  * @param[in] _y The y coordinate to pixel.
- * @param[in] color The color to draw.
+ * @param[in] color The color to draw, encoded in the framebuffer's native
+ * layout by `convert_rgb_to_32bit_colour`.
  */
-void draw_pixel(uint32_t* framebuffer_pointer,
-	const uint32_t pixels_per_scanline,
+void draw_pixel(const Framebuffer* fb,
 	const uint16_t _x,
 	const uint16_t _y,
 	const uint32_t color);
 
+/**
+ * @brief Copies a block of canonical pixels onto the framebuffer.
+ * Copies a rectangle of pixels in the canonical `0x00RRGGBB` layout onto the
+ * framebuffer, converting to the framebuffer's native layout.
+ * @param[in] fb The framebuffer to draw to.
+ * @param[in] _x The x coordinate to copy the block to.
+ * @param[in] _y The y coordinate to copy the block to.
+ * @param[in] width The width of the block.
+ * @param[in] height The height of the block.
+ * @param[in] src A pointer to the first source pixel.
+ * @param[in] src_stride The number of pixels between source rows.
+ */
+void blit_rect(const Framebuffer* fb,
+	const uint16_t _x,
+	const uint16_t _y,
+	const uint16_t width,
+	const uint16_t height,
+	const uint32_t* src,
+	const uint32_t src_stride);
+
 /**
   * @brief Converts an RGB colour to a 32-bit colour suitable for using with
   * a framebuffer using the UEFI Graphics Output Protocol.
+  * The colour is encoded in the native layout of the framebuffer's pixel format.
   * @param[in] r The red component.
   * @param[in] g The green component.
   * @param[in] b The blue component.
-  * @return The colour encoded as a 32-bit integer.
+  * @return The colour encoded as a 32-bit integer, or zero if there is no
+  * usable framebuffer.
   */
 uint32_t convert_rgb_to_32bit_colour(const uint8_t r,
 	const uint8_t g,
@@ -0,0 +1,101 @@
+/**
+ * @file interrupts.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Interrupt handling.
+ * Contains definitions for the interrupt descriptor table, and for dispatching
+ * CPU exceptions and device IRQs to their handlers.
+ */
+
+#ifndef INTERRUPTS_H
+#define INTERRUPTS_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** The number of CPU exception vectors. */
+#define INTERRUPT_EXCEPTION_COUNT    32
+/** The vector of the double fault exception. */
+#define INTERRUPT_DOUBLE_FAULT       8
+/**
+ * The first vector following the remapped PIC IRQs. Vectors from here are
+ * delivered by the local APIC.
+ */
+#define INTERRUPT_FIRST_APIC_VECTOR  48
+/**
+ * The number of vectors with entry stubs, which is every vector. This must
+ * match `INTERRUPT_STUB_COUNT` in interrupt_stubs.S.
+ */
+#define INTERRUPT_VECTOR_COUNT       256
+/** The size of each entry stub. This must match interrupt_stubs.S. */
+#define INTERRUPT_STUB_SIZE          16
+
+/**
+ * @brief An interrupt stack frame.
+ * The vector and error code are pushed by the entry stub, with a zero error
+ * code for vectors which do not push one. The rest is pushed by the CPU.
+ */
+typedef struct s_interrupt_frame {
+	uint64_t vector;
+	uint64_t error_code;
+	uint64_t rip;
+	uint64_t cs;
+	uint64_t rflags;
+	uint64_t rsp;
+	uint64_t ss;
+} Interrupt_Frame;
+
+/**
+ * @brief An IRQ handler.
+ * IRQ handlers run with interrupts disabled, and the IRQ is acknowledged once
+ * they return. The same signature is used for local APIC vector handlers.
+ */
+typedef void (*Irq_Handler)(Interrupt_Frame* frame);
+
+/**
+ * @brief Initialises interrupt handling.
+ * Loads an IDT covering every vector, and remaps and masks the PICs.
+ * Double faults are taken on the CPU's double fault stack, so the GDT must
+ * already be loaded. Interrupts are left disabled.
+ */
+void interrupts_initialize(void);
+
+/**
+ * @brief Loads the IDT on the current CPU.
+ * Used by secondary CPUs, once `interrupts_initialize` has built the IDT on
+ * the boot CPU.
+ */
+void interrupts_load(void);
+
+/**
+ * @brief Registers an IRQ handler.
+ * Installs the handler for an IRQ line, and unmasks the line.
+ * @param[in] irq The IRQ line.
+ * @param[in] handler The handler.
+ * @return Whether the handler was installed. This fails if the IRQ line is
+ * out of range.
+ */
+bool interrupts_register_irq_handler(const uint8_t irq,
+	Irq_Handler handler);
+
+/**
+ * @brief Registers a local APIC vector handler.
+ * The vector is acknowledged at the local APIC once the handler returns. The
+ * handler is shared by every CPU.
+ * @param[in] vector The vector, from `INTERRUPT_FIRST_APIC_VECTOR`.
+ * @param[in] handler The handler.
+ * @return Whether the handler was installed. This fails if the vector is out
+ * of range, or is the APIC's spurious vector.
+ */
+bool interrupts_register_vector_handler(const uint8_t vector,
+	Irq_Handler handler);
+
+/**
+ * @brief Dispatches an interrupt.
+ * Called from the common entry stub with the frame of the interrupt.
+ * Unhandled exceptions are reported over the UART, and halt the kernel.
+ * @param[in,out] frame The interrupt frame.
+ */
+void interrupt_dispatch(Interrupt_Frame* frame);
+
+#endif
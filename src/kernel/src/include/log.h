@@ -0,0 +1,154 @@
+/**
+ * @file log.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Kernel logging.
+ * Contains the kernel's levelled logging. Each CPU writes timestamped records
+ * into its own lock-free ring, which costs the writer only a reservation and a
+ * copy. Records are formatted and written to the registered sinks in batches
+ * by `log_drain`, away from the code that logged them.
+ * Levels more verbose than `LOG_COMPILED_LEVEL` are removed at compile time,
+ * and the rest are filtered at runtime by `log_level`.
+ */
+
+#ifndef LOG_H
+#define LOG_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Unrecoverable errors. */
+#define LOG_LEVEL_ERROR           0
+/** Recoverable problems. */
+#define LOG_LEVEL_WARN            1
+/** Boot milestones. */
+#define LOG_LEVEL_INFO            2
+/** The steps taken by each subsystem. */
+#define LOG_LEVEL_DEBUG           3
+/** Detailed dumps of data structures and individual operations. */
+#define LOG_LEVEL_TRACE           4
+
+/**
+ * The most verbose level compiled into the kernel. May be overridden from the
+ * build flags.
+ */
+#ifndef LOG_COMPILED_LEVEL
+	#define LOG_COMPILED_LEVEL      LOG_LEVEL_DEBUG
+#endif
+
+/** The maximum number of CPUs with a log ring. */
+#define LOG_MAX_CPUS              16
+/** The size of each CPU's log ring. This must be a power of two. */
+#define LOG_RING_SIZE             0x10000
+/** The maximum length of a formatted log message. */
+#define LOG_MAX_MESSAGE_LENGTH    256
+/** The maximum number of sinks. */
+#define LOG_MAX_SINKS             4
+/** The size of the batches records are written to the sinks in. */
+#define LOG_DRAIN_BATCH_SIZE      0x1000
+
+/**
+ * @brief A log sink.
+ * Receives batches of formatted records, and any `kprintf` output, up to
+ * `max_level`. The text passed to `write` is null terminated.
+ */
+typedef struct s_log_sink {
+	const char* name;
+	void (*write)(const char* text, const size_t length);
+	uint8_t max_level;
+} Log_Sink;
+
+/**
+ * @brief The runtime log level.
+ * Records more verbose than this level are discarded by the writer.
+ */
+extern uint8_t log_level;
+
+/**
+ * @brief Registers a log sink.
+ * @param[in] sink The sink. It must remain valid while the kernel runs.
+ * @return Whether the sink was registered. This fails once `LOG_MAX_SINKS`
+ * sinks are registered.
+ */
+bool log_register_sink(const Log_Sink* sink);
+
+/**
+ * @brief Writes a record to the current CPU's log ring.
+ * Safe to call from any context, including interrupt handlers. Never blocks,
+ * and never writes to the sinks: once the ring is half full, an idle CPU is
+ * woken to drain it. If the ring is full the record is dropped, and counted.
+ * @param[in] level The record's level.
+ * @param[in] message The message. It need not be null terminated.
+ * @param[in] length The length of the message, which is truncated to
+ * `LOG_MAX_MESSAGE_LENGTH`.
+ */
+void log_write(const uint8_t level,
+	const char* message,
+	size_t length);
+
+/**
+ * @brief Formats a record into the current CPU's log ring.
+ * This should not be called directly, the level macros should be used
+ * instead so that disabled levels are compiled out.
+ * @param[in] level The record's level.
+ * @param[in] format The format string.
+ */
+void log_printf(const uint8_t level,
+	const char* format,
+	...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Drains every CPU's log ring to the sinks.
+ * If another CPU is already draining, this returns immediately.
+ * @return Whether the rings were drained.
+ */
+bool log_drain(void);
+
+/**
+ * @brief Writes text directly to the sinks.
+ * Drains the log rings first, so that output is kept in order.
+ * @param[in] text The null terminated text.
+ * @param[in] length The length of the text.
+ */
+void log_output(const char* text,
+	const size_t length);
+
+/**
+ * @brief Tests whether a level is enabled.
+ * Can be used to skip gathering data that is only logged.
+ */
+#define LOG_ENABLED(level) \
+	(((level) <= LOG_COMPILED_LEVEL) && ((level) <= log_level))
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_ERROR
+	#define LOG_ERROR(...) log_printf(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+	#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_WARN
+	#define LOG_WARN(...) log_printf(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+	#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_INFO
+	#define LOG_INFO(...) log_printf(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+	#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_DEBUG
+	#define LOG_DEBUG(...) log_printf(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+	#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+	#define LOG_TRACE(...) log_printf(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+	#define LOG_TRACE(...) ((void)0)
+#endif
+
+#endif
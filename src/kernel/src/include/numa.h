@@ -0,0 +1,102 @@
+/**
+ * @file numa.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief NUMA topology.
+ * Contains definitions for the system's NUMA topology, read from the ACPI
+ * SRAT and SLIT. Each proximity domain the SRAT lists is given a node index,
+ * in the order the domains first appear. Without a SRAT, the system is treated
+ * as a single node holding every CPU and all memory.
+ * Distances follow the SLIT's convention, where a node's distance to itself is
+ * `NUMA_LOCAL_DISTANCE`. Without a SLIT, every other node is assumed to be
+ * `NUMA_REMOTE_DISTANCE` away.
+ */
+
+#ifndef NUMA_H
+#define NUMA_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** The maximum number of nodes. Further proximity domains join node 0. */
+#define NUMA_MAX_NODES               8
+/** The maximum number of memory ranges read from the SRAT. */
+#define NUMA_MAX_MEMORY_RANGES       64
+/** The maximum number of processor affinity entries read from the SRAT. */
+#define NUMA_MAX_CPUS                256
+/** The distance from a node to itself. */
+#define NUMA_LOCAL_DISTANCE          10
+/** The distance assumed between different nodes without a SLIT. */
+#define NUMA_REMOTE_DISTANCE         20
+
+/**
+ * @brief A range of memory on one node.
+ * `end` is the address past the end of the range.
+ */
+typedef struct s_numa_memory_range {
+	uintptr_t start;
+	uintptr_t end;
+	uint32_t node;
+} Numa_Memory_Range;
+
+/**
+ * @brief A processor's node.
+ */
+typedef struct s_numa_cpu {
+	uint32_t apic_id;
+	uint32_t node;
+} Numa_Cpu;
+
+/**
+ * @brief The NUMA topology.
+ * `proximity_domains` holds the SRAT proximity domain of each node.
+ * `fallback` lists, for each node, every node in order of increasing
+ * distance, starting with the node itself. `memory_ranges` is sorted by
+ * address.
+ */
+typedef struct s_numa {
+	uint32_t n_nodes;
+	uint32_t n_memory_ranges;
+	uint32_t n_cpus;
+	bool srat_found;
+	bool slit_found;
+	uint32_t proximity_domains[NUMA_MAX_NODES];
+	uint8_t distances[NUMA_MAX_NODES][NUMA_MAX_NODES];
+	uint32_t fallback[NUMA_MAX_NODES][NUMA_MAX_NODES];
+	Numa_Memory_Range memory_ranges[NUMA_MAX_MEMORY_RANGES];
+	Numa_Cpu cpus[NUMA_MAX_CPUS];
+} Numa;
+
+/**
+ * @brief The NUMA topology.
+ * Populated by `numa_initialize`.
+ */
+extern Numa numa;
+
+/**
+ * @brief Reads the NUMA topology from the SRAT and SLIT.
+ * Also sets the boot CPU's node. Must be called after `acpi_initialize`, and
+ * before `page_allocator_initialize`.
+ * @return Whether a SRAT was found.
+ */
+bool numa_initialize(void);
+
+/**
+ * @brief Gets the node of a CPU.
+ * @param[in] apic_id The CPU's APIC ID.
+ * @return The CPU's node, or 0 if the SRAT does not list it.
+ */
+uint32_t numa_get_cpu_node(const uint32_t apic_id);
+
+/**
+ * @brief Gets the node of an address.
+ * @param[in] address The physical address.
+ * @param[out] end The address past the end of the run of memory on the same
+ * node, which ends where the next SRAT range begins if the address is in none.
+ * @return The address's node, or 0 if the SRAT does not list it.
+ */
+uint32_t numa_get_memory_node(const uintptr_t address,
+	uintptr_t* end);
+
+#endif
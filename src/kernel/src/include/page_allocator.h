@@ -0,0 +1,178 @@
+/**
+ * @file page_allocator.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Physical page allocator.
+ * Contains definitions for the kernel's physical page frame allocator. Free
+ * memory is taken from the boot memory map and managed by a buddy allocator,
+ * in blocks of 2^order pages. Each NUMA node has its own zone, with its own
+ * free lists and lock. Allocations are served from the allocating CPU's node,
+ * falling back to the other nodes in order of distance once it runs out.
+ * Each CPU keeps a cache of free order 0 and order 9 (2MiB) pages from its
+ * node, which it refills from and drains to its zone in batches, so that the
+ * common path never takes a zone's lock. Blocks freed to a remote node bypass
+ * the cache and return to their own zone.
+ * The allocator keeps no per-page metadata: a free block's header is stored in
+ * the block itself, so initialisation takes time linear in the number of
+ * memory regions rather than the number of pages.
+ * Pages which must be zeroed can be taken from each node's pool of pre-zeroed
+ * pages, which the node's idle CPUs fill in the background with non-temporal stores, keeping
+ * the zeroing off the allocating CPU's critical path and out of its cache.
+ * Physical memory is assumed to be identity mapped.
+ */
+
+#ifndef PAGE_ALLOCATOR_H
+#define PAGE_ALLOCATOR_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <boot.h>
+#include <numa.h>
+
+/**
+ * The number of block orders. The largest block is 2^31 pages, so that every
+ * region is covered by a handful of blocks.
+ */
+#define PAGE_ALLOCATOR_ORDERS            32
+/** The order of a 2MiB block. */
+#define PAGE_ALLOCATOR_LARGE_ORDER       9
+/** The maximum number of separate regions of free memory. */
+#define PAGE_ALLOCATOR_MAX_REGIONS       128
+/** Memory below this address is left to the firmware and the trampoline. */
+#define PAGE_ALLOCATOR_MIN_ADDRESS       0x100000
+/** The capacity of each CPU's order 0 page cache. */
+#define PAGE_ALLOCATOR_CACHE_SIZE        64
+/** The number of order 0 pages moved at once to or from a CPU's cache. */
+#define PAGE_ALLOCATOR_CACHE_BATCH       32
+/** The capacity of each CPU's 2MiB page cache. */
+#define PAGE_ALLOCATOR_LARGE_CACHE_SIZE  8
+/** The number of 2MiB pages moved at once to or from a CPU's cache. */
+#define PAGE_ALLOCATOR_LARGE_CACHE_BATCH 4
+/** The number of order 0 pages kept in the zeroed page pool. */
+#define PAGE_ALLOCATOR_ZERO_POOL_SIZE    256
+/** The number of 2MiB pages kept in the zeroed page pool. */
+#define PAGE_ALLOCATOR_ZERO_POOL_LARGE_SIZE 2
+/** The number of bytes zeroed by each unit of background work. */
+#define PAGE_ALLOCATOR_ZERO_CHUNK        0x10000
+
+/**
+ * @brief The page allocator state.
+ * `total_pages` is the number of pages managed. `free_pages` is the number of
+ * those free in the buddy allocator, not counting those held in the per-CPU
+ * caches. `node_pages` is the number of pages managed on each node.
+ * `initialize_ns` is the time `page_allocator_initialize` took.
+ */
+typedef struct s_page_allocator {
+	uint64_t total_pages;
+	uint64_t free_pages;
+	uint64_t node_pages[NUMA_MAX_NODES];
+	uint64_t initialize_ns;
+	uint32_t n_regions;
+} Page_Allocator;
+
+/**
+ * @brief The zeroed page pool statistics.
+ * `hits` and `misses` count the zeroed allocations served from the pool, and
+ * those zeroed synchronously because the pool was empty. The bytes and cycles
+ * spent zeroing are counted separately for both.
+ */
+typedef struct s_page_allocator_zero_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t background_bytes;
+	uint64_t background_cycles;
+	uint64_t sync_bytes;
+	uint64_t sync_cycles;
+} Page_Allocator_Zero_Stats;
+
+/**
+ * @brief The page allocator state.
+ * Populated by `page_allocator_initialize`.
+ */
+extern Page_Allocator page_allocator;
+
+/**
+ * @brief Initialises the page allocator from the boot memory map.
+ * Only conventional memory above `PAGE_ALLOCATOR_MIN_ADDRESS` is used. Memory
+ * used by the bootloader and the kernel, and boot services memory, which
+ * still holds the firmware's page tables, are left reserved. Memory is split
+ * into zones by the node `numa_get_memory_node` reports for it.
+ * Must be called after `smp_initialize_boot_cpu` and `numa_initialize`.
+ * @param[in] boot_info The boot info.
+ * @return Whether any free memory was found.
+ */
+bool page_allocator_initialize(const Boot_Info* boot_info);
+
+/**
+ * @brief Allocates a block of pages.
+ * The block is taken from the current CPU's node if it has one free, and from
+ * the nearest node which does otherwise.
+ * May be called from interrupt handlers.
+ * @param[in] order The block's order. The block is 2^order pages, aligned to
+ * its size.
+ * @return The physical address of the block, or zero if there is no free block
+ * large enough.
+ */
+uintptr_t page_allocator_alloc(const uint32_t order);
+
+/**
+ * @brief Allocates a block of pages from a specific node.
+ * Bypasses the per-CPU caches, and never falls back to another node. The
+ * block is freed with `page_allocator_free`, or `page_allocator_free_node`.
+ * May be called from interrupt handlers.
+ * @param[in] order The block's order.
+ * @param[in] node The node.
+ * @return The physical address of the block, or zero if the node has no free
+ * block large enough.
+ */
+uintptr_t page_allocator_alloc_node(const uint32_t order,
+	const uint32_t node);
+
+/**
+ * @brief Frees a block of pages.
+ * May be called from interrupt handlers.
+ * @param[in] address The physical address of the block.
+ * @param[in] order The order the block was allocated with.
+ */
+void page_allocator_free(const uintptr_t address,
+	const uint32_t order);
+
+/**
+ * @brief Frees a block of pages straight to its node's zone.
+ * Bypasses the per-CPU caches, as `page_allocator_alloc_node` does, so that
+ * the cost of freeing does not depend on which node the block came from.
+ * May be called from interrupt handlers.
+ * @param[in] address The physical address of the block.
+ * @param[in] order The order the block was allocated with.
+ */
+void page_allocator_free_node(const uintptr_t address,
+	const uint32_t order);
+
+/**
+ * @brief Allocates a zeroed block of pages.
+ * Order 0 and 2MiB blocks are taken from the zeroed page pool while it holds
+ * any, otherwise the block is zeroed synchronously. Idle CPUs are woken to
+ * refill the pool once it runs low.
+ * May be called from interrupt handlers.
+ * @param[in] order The block's order.
+ * @return The physical address of the block, or zero if there is no free block
+ * large enough.
+ */
+uintptr_t page_allocator_alloc_zeroed(const uint32_t order);
+
+/**
+ * @brief Does a unit of background work filling the zeroed page pool.
+ * Zeroes one order 0 page, or `PAGE_ALLOCATOR_ZERO_CHUNK` bytes of a 2MiB page,
+ * with non-temporal stores. Registered with `scheduler_set_idle_work`.
+ * @return Whether the pool needs more pages.
+ */
+bool page_allocator_zero_idle(void);
+
+/**
+ * @brief Gets the zeroed page pool statistics.
+ * @param[out] stats The statistics.
+ */
+void page_allocator_get_zero_stats(Page_Allocator_Zero_Stats* stats);
+
+#endif
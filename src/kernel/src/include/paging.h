@@ -0,0 +1,299 @@
+/**
+ * @file paging.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Paging functionality.
+ * Contains functionality for building the kernel's page tables, for changing
+ * the attributes of existing mappings in the active page tables, and for
+ * programming the page attribute table.
+ * The kernel's address space identity maps the physical address space, so
+ * that physical addresses can still be used directly, and maps all physical
+ * RAM again at `PAGING_DIRECT_MAP_BASE`. The kernel runs from the identity
+ * map, where it was loaded. Both the identity map and the direct map use 1GiB
+ * pages where the processor supports them, and 2MiB pages otherwise.
+ */
+
+#ifndef PAGING_H
+#define PAGING_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <boot.h>
+#include <tlb.h>
+
+#define PAGE_SIZE                 0x1000ULL
+#define LARGE_PAGE_SIZE           0x200000ULL
+#define HUGE_PAGE_SIZE            0x40000000ULL
+
+#define PAGE_PRESENT              (1ULL << 0)
+#define PAGE_WRITABLE             (1ULL << 1)
+#define PAGE_USER                 (1ULL << 2)
+#define PAGE_WRITE_THROUGH        (1ULL << 3)
+#define PAGE_CACHE_DISABLE        (1ULL << 4)
+#define PAGE_ACCESSED             (1ULL << 5)
+#define PAGE_DIRTY                (1ULL << 6)
+#define PAGE_LARGE                (1ULL << 7)
+#define PAGE_GLOBAL               (1ULL << 8)
+/** The PAT bit of a 4KiB page table entry. */
+#define PAGE_PAT_SMALL            (1ULL << 7)
+/** The PAT bit of a 2MiB or 1GiB page table entry. */
+#define PAGE_PAT_LARGE            (1ULL << 12)
+#define PAGE_NO_EXECUTE           (1ULL << 63)
+
+/** The mask of the physical address within a page table entry. */
+#define PAGE_ADDRESS_MASK         0x000FFFFFFFFFF000ULL
+
+/** The virtual address physical memory is mapped at in the direct map. */
+#define PAGING_DIRECT_MAP_BASE    0xFFFF800000000000ULL
+/** The largest physical address space identity mapped, or direct mapped. */
+#define PAGING_MAX_MAPPED_SIZE    (1ULL << 46)
+/**
+ * The largest physical address space identity mapped without 1GiB pages,
+ * which keeps the number of page tables needed small.
+ */
+#define PAGING_MAX_IDENTITY_SIZE_2MB  (1ULL << 36)
+/** The number of process-context identifiers. */
+#define PAGING_PCID_COUNT         4096
+/** CR3: Keep the TLB entries tagged with the PCID being loaded. */
+#define PAGING_CR3_NO_FLUSH       (1ULL << 63)
+
+/**
+ * @brief Memory types.
+ * The memory types selectable through the page attribute table. The value of
+ * each is the PAT index programmed with that type by `pat_initialize`.
+ */
+typedef enum e_memory_type {
+	MEMORY_TYPE_WRITE_BACK = 0,
+	MEMORY_TYPE_WRITE_THROUGH = 1,
+	MEMORY_TYPE_UNCACHED_MINUS = 2,
+	MEMORY_TYPE_UNCACHEABLE = 3,
+	MEMORY_TYPE_WRITE_COMBINING = 4,
+	MEMORY_TYPE_WRITE_PROTECTED = 5
+} Memory_Type;
+
+/**
+ * @brief Paging operation status.
+ */
+typedef enum e_paging_status {
+	PAGING_SUCCESS,
+	PAGING_NOT_MAPPED,
+	PAGING_UNSUPPORTED,
+	PAGING_OUT_OF_TABLES
+} Paging_Status;
+
+/**
+ * @brief An address space.
+ * `root` is the physical address of the top level page table. `pcid` tags the
+ * space's TLB entries, if PCIDs are enabled.
+ */
+typedef struct s_address_space {
+	uintptr_t root;
+	uint16_t pcid;
+} Address_Space;
+
+/**
+ * @brief The kernel's paging state.
+ * `page_size` is the size of the pages used by the identity map and the
+ * direct map. `n_tables` is the number of page table pages allocated for the
+ * kernel's address space, of which `n_direct_map_tables` were for the direct
+ * map. `build_ns` is the time taken to build the address space.
+ * `n_address_spaces` is the number of address spaces created with
+ * `paging_create_address_space` which are yet to be destroyed.
+ */
+typedef struct s_paging {
+	uint64_t identity_map_size;
+	uint64_t direct_map_size;
+	uint64_t page_size;
+	uint64_t n_tables;
+	uint64_t n_direct_map_tables;
+	uint64_t build_ns;
+	uint32_t n_address_spaces;
+	bool pcid;
+} Paging;
+
+/**
+ * @brief The kernel's paging state.
+ * Populated by `paging_initialize`.
+ */
+extern Paging kernel_paging;
+
+/**
+ * @brief The kernel's address space.
+ * Populated by `paging_initialize`.
+ */
+extern Address_Space kernel_address_space;
+
+/**
+ * @brief Builds the kernel's address space, and switches to it.
+ * Page tables are allocated from the page allocator, except the top level
+ * table, which is in the kernel image so that the secondary CPUs can load it
+ * from 32-bit code. Pages of the kernel image unmapped in the firmware's page
+ * tables, such as stack guards, are left unmapped. Enables global pages, and
+ * PCIDs if the processor supports them. Secondary CPUs started afterwards use
+ * the same address space and CR4.
+ * Must be called after `page_allocator_initialize`, and before changing the
+ * attributes of any mapping which must be kept.
+ * @param[in] boot_info The boot info, whose memory map sizes the direct map.
+ * @return The status of the operation.
+ * @retval PAGING_SUCCESS        The kernel's address space is active.
+ * @retval PAGING_OUT_OF_TABLES  No pages were left for the page tables. The
+ *                               firmware's page tables remain active, unless
+ *                               none were left to split the pages holding the
+ *                               kernel image's guard pages, in which case the
+ *                               kernel's address space is active with some of
+ *                               them still mapped.
+ */
+Paging_Status paging_initialize(const Boot_Info* boot_info);
+
+/**
+ * @brief Creates an address space sharing every kernel mapping.
+ * Assigns the space the next PCID. Once every PCID has been assigned, they are
+ * reused, and the TLB of every CPU is flushed. Must not be called from
+ * interrupt handlers.
+ * @param[out] space The address space.
+ * @return The status of the operation.
+ */
+Paging_Status paging_create_address_space(Address_Space* space);
+
+/**
+ * @brief Destroys an address space created by `paging_create_address_space`.
+ * The space must not be active on any CPU.
+ * @param[in] space The address space.
+ */
+void paging_destroy_address_space(const Address_Space* space);
+
+/**
+ * @brief Switches the current CPU to an address space.
+ * With PCIDs enabled, the TLB entries of both spaces are kept.
+ * @param[in] space The address space.
+ */
+void paging_switch_address_space(const Address_Space* space);
+
+/**
+ * @brief Gets the direct map address of physical memory.
+ * Only valid once `paging_initialize` has succeeded.
+ * @param[in] physical The physical address.
+ * @return The virtual address in the direct map.
+ */
+static inline void* paging_physical_to_virtual(const uintptr_t physical)
+{
+	return (void*)(PAGING_DIRECT_MAP_BASE + physical);
+}
+
+/**
+ * @brief Programs the page attribute table.
+ * Programs the PAT so that indexes 0-3 keep their power-on types, which are
+ * the types the firmware's page tables assume, and index 4 selects
+ * write-combining. Refer to the `Memory_Type` enum for the full layout.
+ * This must run on every CPU.
+ * @return Whether the processor supports the PAT.
+ */
+bool pat_initialize(void);
+
+/**
+ * @brief Gets a readable name for a memory type.
+ * @param[in] type The memory type.
+ * @return The name of the memory type.
+ */
+const char* get_memory_type_name(const Memory_Type type);
+
+/**
+ * @brief Sets the memory type of a range of mapped memory.
+ * Changes the memory type of every page mapping the given range in the active
+ * page tables. Large pages only partially covered by the range are split.
+ * Ranges in the identity map have their alias in the direct map changed too.
+ * Caches are flushed on the current CPU, and the TLB on every CPU, once the
+ * change is made.
+ * @param[in] address The virtual address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @param[in] type The memory type to set.
+ * @return The status of the operation.
+ * @retval PAGING_SUCCESS        The memory type was set.
+ * @retval PAGING_NOT_MAPPED     Part of the range is not mapped.
+ * @retval PAGING_UNSUPPORTED    The PAT has not been initialised.
+ * @retval PAGING_OUT_OF_TABLES  No page table pages were left to split a
+ *                               large page.
+ */
+Paging_Status paging_set_memory_type(const uintptr_t address,
+	const size_t size,
+	const Memory_Type type);
+
+/**
+ * @brief Unmaps a range of memory.
+ * Marks every page mapping the given range not present in the active page
+ * tables, so that any access faults. Used for stack guard pages. Large pages
+ * only partially covered by the range are split. Ranges in the identity map
+ * are unmapped from the direct map too. The range is invalidated in the TLB of
+ * every CPU.
+ * @param[in] address The virtual address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @return The status of the operation.
+ * @retval PAGING_SUCCESS        The range was unmapped.
+ * @retval PAGING_NOT_MAPPED     Part of the range was already not mapped.
+ * @retval PAGING_OUT_OF_TABLES  No page table pages were left to split a
+ *                               large page.
+ */
+Paging_Status paging_unmap(const uintptr_t address,
+	const size_t size);
+
+/**
+ * @brief Unmaps a range of memory, adding it to a TLB shootdown batch.
+ * As `paging_unmap`, except that the TLB is not flushed. The memory must not
+ * be reused until the batch is finished with `tlb_batch_finish`.
+ * @param[in] address The virtual address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @param[in,out] batch The batch to add the range to.
+ * @return The status of the operation.
+ */
+Paging_Status paging_unmap_batched(const uintptr_t address,
+	const size_t size,
+	Tlb_Batch* batch);
+
+/**
+ * @brief Maps a range of physical memory into the kernel's address space.
+ * Uses 4KiB pages, mapped writable. The range must not already be mapped, so
+ * that no TLB entries need to be invalidated.
+ * @param[in] virtual_address The virtual address of the start of the range.
+ * @param[in] physical_address The physical address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @return The status of the operation.
+ * @retval PAGING_SUCCESS        The range was mapped.
+ * @retval PAGING_UNSUPPORTED    The kernel's address space is not active.
+ * @retval PAGING_OUT_OF_TABLES  No memory was free for the page tables.
+ */
+Paging_Status paging_map(const uintptr_t virtual_address,
+	const uintptr_t physical_address,
+	const size_t size);
+
+/**
+ * @brief Gets the memory type of a mapped address.
+ * @param[in] address The virtual address to look up.
+ * @param[out] type The memory type the address is mapped with.
+ * @return The status of the operation.
+ */
+Paging_Status paging_get_memory_type(const uintptr_t address,
+	Memory_Type* type);
+
+/**
+ * @brief Verifies the memory type of a range of mapped memory.
+ * Walks the active page tables and counts the pages in the range which are not
+ * mapped with the expected type.
+ * @param[in] address The virtual address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @param[in] type The expected memory type.
+ * @param[out] n_mismatched The number of 4KiB pages not mapped with the
+ * expected type, including unmapped pages.
+ */
+void paging_verify_memory_type(const uintptr_t address,
+	const size_t size,
+	const Memory_Type type,
+	size_t* n_mismatched);
+
+/**
+ * @brief Flushes the TLB.
+ * Flushes all TLB entries on the current CPU, including global entries.
+ */
+void paging_flush_tlb(void);
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file pci.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief PCI functionality.
+ * Contains definitions for accessing PCI configuration space through the
+ * legacy configuration mechanism #1 IO ports, and for finding devices.
+ */
+
+#ifndef PCI_H
+#define PCI_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PCI_CONFIG_VENDOR_ID          0x00
+#define PCI_CONFIG_DEVICE_ID          0x02
+#define PCI_CONFIG_COMMAND            0x04
+#define PCI_CONFIG_HEADER_TYPE        0x0E
+#define PCI_CONFIG_BAR0               0x10
+#define PCI_CONFIG_INTERRUPT_LINE     0x3C
+
+/** Command register: Respond to IO space accesses. */
+#define PCI_COMMAND_IO_SPACE          (1 << 0)
+/** Command register: Respond to memory space accesses. */
+#define PCI_COMMAND_MEMORY_SPACE      (1 << 1)
+/** Command register: Allow the device to master the bus, for DMA. */
+#define PCI_COMMAND_BUS_MASTER        (1 << 2)
+
+/** BAR: The BAR is in IO space. */
+#define PCI_BAR_IO_SPACE              (1 << 0)
+/** The mask of the address of an IO space BAR. */
+#define PCI_BAR_IO_ADDRESS_MASK       0xFFFFFFFC
+
+/** The vendor ID read from an empty slot. */
+#define PCI_VENDOR_ID_NONE            0xFFFF
+/** The interrupt line of a device not connected to an interrupt. */
+#define PCI_INTERRUPT_LINE_NONE       0xFF
+
+/**
+ * @brief A PCI function's address.
+ */
+typedef struct s_pci_device {
+	uint8_t bus;
+	uint8_t device;
+	uint8_t function;
+} Pci_Device;
+
+/**
+ * @brief Reads a double word from a function's configuration space.
+ * @param[in] dev The function.
+ * @param[in] offset The offset of the register. Must be 4 byte aligned.
+ * @return The value of the register.
+ */
+uint32_t pci_config_read32(const Pci_Device* dev,
+	const uint8_t offset);
+
+/**
+ * @brief Reads a word from a function's configuration space.
+ * @param[in] dev The function.
+ * @param[in] offset The offset of the register. Must be 2 byte aligned.
+ * @return The value of the register.
+ */
+uint16_t pci_config_read16(const Pci_Device* dev,
+	const uint8_t offset);
+
+/**
+ * @brief Reads a byte from a function's configuration space.
+ * @param[in] dev The function.
+ * @param[in] offset The offset of the register.
+ * @return The value of the register.
+ */
+uint8_t pci_config_read8(const Pci_Device* dev,
+	const uint8_t offset);
+
+/**
+ * @brief Writes a word to a function's configuration space.
+ * @param[in] dev The function.
+ * @param[in] offset The offset of the register. Must be 2 byte aligned.
+ * @param[in] value The value to write.
+ */
+void pci_config_write16(const Pci_Device* dev,
+	const uint8_t offset,
+	const uint16_t value);
+
+/**
+ * @brief Finds a PCI function by its vendor and device ID.
+ * Scans every bus for functions with the given IDs.
+ * @param[in] vendor_id The vendor ID.
+ * @param[in] device_id The device ID.
+ * @param[in] index The number of matching functions to skip, for finding
+ * each of several identical devices.
+ * @param[out] dev The address of the function found.
+ * @return Whether a matching function was found.
+ */
+bool pci_find_device(const uint16_t vendor_id,
+	const uint16_t device_id,
+	const size_t index,
+	Pci_Device* dev);
+
+#endif
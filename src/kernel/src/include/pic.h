@@ -0,0 +1,55 @@
+/**
+ * @file pic.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief 8259 PIC functionality.
+ * Contains definitions for the legacy 8259 programmable interrupt controller
+ * pair, through which ISA device interrupts such as the UART's are delivered.
+ */
+
+#ifndef PIC_H
+#define PIC_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** The interrupt vector that IRQ 0 is remapped to. */
+#define PIC_IRQ_BASE_VECTOR    0x20
+/** The number of IRQ lines across both PICs. */
+#define PIC_IRQ_COUNT          16
+/** The IRQ line the slave PIC is cascaded through. */
+#define PIC_CASCADE_IRQ        2
+
+/**
+ * @brief Initialises the PICs.
+ * Remaps both PICs so that their IRQs are delivered at `PIC_IRQ_BASE_VECTOR`
+ * rather than over the CPU exception vectors, and masks every IRQ.
+ */
+void pic_initialize(void);
+
+/**
+ * @brief Masks or unmasks an IRQ line.
+ * @param[in] irq The IRQ line.
+ * @param[in] masked Whether the IRQ line should be masked.
+ */
+void pic_set_irq_masked(const uint8_t irq,
+	const bool masked);
+
+/**
+ * @brief Checks whether an IRQ is spurious.
+ * IRQ 7 and 15 are raised spuriously when an IRQ is withdrawn before it is
+ * acknowledged. Spurious IRQs must not be handled or acknowledged, except for
+ * acknowledging a spurious slave IRQ on the master PIC, which this does.
+ * @param[in] irq The IRQ being delivered.
+ * @return Whether the IRQ is spurious.
+ */
+bool pic_is_spurious_irq(const uint8_t irq);
+
+/**
+ * @brief Acknowledges an IRQ.
+ * Signals the end of the interrupt to the PIC, or PICs, delivering it.
+ * @param[in] irq The IRQ to acknowledge.
+ */
+void pic_send_end_of_interrupt(const uint8_t irq);
+
+#endif
@@ -27,4 +27,36 @@ uint8_t inb(uint16_t port);
  */
 void outb(uint16_t port, uint8_t val);
 
+/**
+ * @brief Reads a word from an IO port.
+ * Reads a word from a specified IO port.
+ * @param port[in]    The port to read the word from.
+ * @return            The word read from the port.
+ */
+uint16_t inw(uint16_t port);
+
+/**
+ * @brief Writes a word to an IO port.
+ * Writes a word to a specified IO port.
+ * @param port[in]    The port to write the word to.
+ * @param val[in]     The word to write.
+ */
+void outw(uint16_t port, uint16_t val);
+
+/**
+ * @brief Reads a double word from an IO port.
+ * Reads a double word from a specified IO port.
+ * @param port[in]    The port to read the double word from.
+ * @return            The double word read from the port.
+ */
+uint32_t inl(uint16_t port);
+
+/**
+ * @brief Writes a double word to an IO port.
+ * Writes a double word to a specified IO port.
+ * @param port[in]    The port to write the double word to.
+ * @param val[in]     The double word to write.
+ */
+void outl(uint16_t port, uint32_t val);
+
 #endif
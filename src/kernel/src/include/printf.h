@@ -0,0 +1,72 @@
+/**
+ * @file printf.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Formatted output functionality.
+ * Contains a freestanding formatter for kernel output. The formatter never
+ * allocates, and writes only into the buffer it is given.
+ * Supports the `d`, `i`, `u`, `x`, `X`, `p`, `s`, `c` and `%` conversions, with
+ * the `-` and `0` flags, a field width, and the `l`, `ll` and `z` length
+ * modifiers.
+ */
+
+#ifndef PRINTF_H
+#define PRINTF_H 1
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/** The size of the buffer used by `kprintf`. */
+#define KPRINTF_BUFFER_SIZE 256
+
+/**
+ * @brief Formats a string into a buffer.
+ * Formats a string into a buffer. The output is always null terminated if the
+ * buffer size is non-zero, and is truncated if the buffer is too small.
+ * @param[out] buffer The buffer to format into.
+ * @param[in] buffer_size The size of the buffer.
+ * @param[in] format The format string.
+ * @param[in] args The format arguments.
+ * @return The number of characters written, excluding the null terminator.
+ */
+size_t kvsnprintf(char* buffer,
+	const size_t buffer_size,
+	const char* format,
+	va_list args);
+
+/**
+ * @brief Formats a string into a buffer.
+ * Refer to `kvsnprintf`.
+ */
+size_t ksnprintf(char* buffer,
+	const size_t buffer_size,
+	const char* format,
+	...) __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Prints a formatted string to the kernel output.
+ * Formats a string of up to `KPRINTF_BUFFER_SIZE` characters, and writes it
+ * directly to the log sinks, after any log records still to be drained.
+ * @param[in] format The format string.
+ */
+void kprintf(const char* format,
+	...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Exports binary data.
+ * Writes data to the virtio data console if there is one, otherwise the UART
+ * data port, keeping it separate from the kernel log.
+ * @param[in] data The data to write.
+ * @param[in] length The length of the data.
+ */
+void kexport(const void* data,
+	const size_t length);
+
+/**
+ * @brief Flushes the kernel output.
+ * Drains the kernel log, and waits for all log and exported data output to be
+ * transmitted.
+ */
+void kflush(void);
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file raster.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief 2D raster primitives.
+ * Contains vectorised raster primitives operating on 32-bit pixel surfaces in
+ * normal memory, such as the renderer's back buffer. Each primitive has a
+ * scalar reference implementation, an SSE2 implementation, which is the
+ * x86-64 baseline, and an AVX2 implementation. The fastest variant supported
+ * by the processor is selected at boot.
+ * Unless otherwise noted pixels are in the canonical `0x00RRGGBB` layout, and
+ * strides are measured in pixels.
+ */
+
+#ifndef RASTER_H
+#define RASTER_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Fills a rectangle with a colour.
+ */
+typedef void (*Raster_Fill_Function)(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t colour);
+
+/**
+ * @brief Copies a rectangle between non-overlapping surfaces.
+ */
+typedef void (*Raster_Copy_Function)(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t* src,
+	const size_t src_stride,
+	const uint32_t width,
+	const uint32_t height);
+
+/**
+ * @brief Tiles a pattern across a rectangle.
+ * The pattern is tiled so that the rectangle's top-left pixel takes the
+ * pattern pixel at (`origin_x`, `origin_y`).
+ */
+typedef void (*Raster_Pattern_Function)(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t* pattern,
+	const uint32_t pattern_width,
+	const uint32_t pattern_height,
+	const uint32_t origin_x,
+	const uint32_t origin_y);
+
+/**
+ * @brief Alpha blends a rectangle over another.
+ * Composites source pixels in the `0xAARRGGBB` layout over the destination,
+ * using the source alpha. Each channel is computed exactly as
+ * `(s * a + d * (255 - a)) / 255`, rounded to nearest.
+ */
+typedef void (*Raster_Blend_Function)(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t* src,
+	const size_t src_stride,
+	const uint32_t width,
+	const uint32_t height);
+
+/**
+ * @brief Converts a span of pixels between RGBX and BGRX layouts.
+ * Swaps the red and blue channels of each pixel. The conversion is its own
+ * inverse.
+ */
+typedef void (*Raster_Convert_Function)(uint32_t* dest,
+	const uint32_t* src,
+	const size_t count);
+
+/**
+ * @brief Draws the XOR test texture into a rectangle.
+ * Refer to: https://lodev.org/cgtutor/xortexture.html
+ * The `frame` parameter offsets the texture vertically to animate it.
+ */
+typedef void (*Raster_Test_Texture_Function)(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t frame);
+
+/**
+ * @brief A set of raster primitive implementations.
+ */
+typedef struct s_raster_operations {
+	const char* name;
+	Raster_Fill_Function fill;
+	Raster_Copy_Function copy;
+	Raster_Pattern_Function pattern;
+	Raster_Blend_Function blend;
+	Raster_Convert_Function convert;
+	Raster_Test_Texture_Function test_texture;
+} Raster_Operations;
+
+/** The scalar reference implementations. */
+extern const Raster_Operations raster_scalar_operations;
+/** The SSE2 implementations. */
+extern const Raster_Operations raster_sse2_operations;
+/** The AVX2 implementations. */
+extern const Raster_Operations raster_avx2_operations;
+
+/**
+ * @brief The selected raster implementations.
+ * Populated by `raster_initialize`. No primitive may be called through this
+ * before then.
+ */
+extern Raster_Operations raster;
+
+/**
+ * @brief Initialises the raster library.
+ * Selects the fastest implementation supported by the processor.
+ */
+void raster_initialize(void);
+
+/**
+ * @brief Scrolls a rectangle vertically.
+ * Moves the contents of a rectangle up by `rows` rows, and fills the rows
+ * exposed at the bottom with a colour.
+ * @param[in,out] buffer The top-left pixel of the rectangle.
+ * @param[in] stride The stride of the surface.
+ * @param[in] width The width of the rectangle.
+ * @param[in] height The height of the rectangle.
+ * @param[in] rows The number of rows to scroll by.
+ * @param[in] colour The colour to fill the exposed rows with.
+ */
+void raster_scroll(uint32_t* buffer,
+	const size_t stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t rows,
+	const uint32_t colour);
+
+/**
+ * @brief Tests the raster implementations against the scalar reference.
+ * Runs every primitive of every implementation supported by the processor
+ * over unaligned rectangles of awkward sizes, and compares the result with
+ * that of the scalar reference. Failures are reported over the UART.
+ * @return Whether every implementation matched the reference.
+ */
+bool raster_self_test(void);
+
+#endif
@@ -0,0 +1,290 @@
+/**
+ * @file raster_template.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Vectorised raster primitive template.
+ * Contains the vectorised raster primitives, written once with GCC vector
+ * extensions and instantiated for each vector width. The including file
+ * defines `RASTER_VECTOR_LANES`, the number of 32-bit pixels per vector, then
+ * includes this file once.
+ * Every primitive handles unaligned edges and tails with scalar loops.
+ */
+
+#ifndef RASTER_VECTOR_LANES
+#error "RASTER_VECTOR_LANES must be defined before including raster_template.h"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** A vector of 32-bit pixels. */
+typedef uint32_t vector_u32 __attribute__((vector_size(RASTER_VECTOR_LANES * 4)));
+/** A vector of 32-bit pixels, with no alignment requirement. */
+typedef uint32_t vector_u32_unaligned
+	__attribute__((vector_size(RASTER_VECTOR_LANES * 4), aligned(4)));
+/** A vector of 16-bit lanes, covering the same pixels as `vector_u32`. */
+typedef uint16_t vector_u16 __attribute__((vector_size(RASTER_VECTOR_LANES * 4)));
+
+/** Loads a vector of pixels from unaligned memory. */
+#define LOAD(ptr)            (*(const vector_u32_unaligned*)(ptr))
+/** Stores a vector of pixels to unaligned memory. */
+#define STORE(ptr, value)    (*(vector_u32_unaligned*)(ptr) = (value))
+
+
+/**
+ * raster_fill
+ */
+static void raster_fill(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t colour)
+{
+	/** The colour broadcast to every lane. */
+	const vector_u32 value = (vector_u32){0} + colour;
+
+	for(uint32_t y = 0; y < height; y++) {
+		/** The current row. */
+		uint32_t* row = dest + (y * dest_stride);
+		/** The current column. */
+		uint32_t x = 0;
+
+		for(; (x + RASTER_VECTOR_LANES) <= width; x += RASTER_VECTOR_LANES) {
+			STORE(row + x, value);
+		}
+
+		for(; x < width; x++) {
+			row[x] = colour;
+		}
+	}
+}
+
+
+/**
+ * raster_copy
+ */
+static void raster_copy(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t* src,
+	const size_t src_stride,
+	const uint32_t width,
+	const uint32_t height)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		/** The current destination row. */
+		uint32_t* dest_row = dest + (y * dest_stride);
+		/** The current source row. */
+		const uint32_t* src_row = src + (y * src_stride);
+		/** The current column. */
+		uint32_t x = 0;
+
+		// Unrolled so that several loads are in flight before their stores.
+		for(; (x + (RASTER_VECTOR_LANES * 4)) <= width; x += RASTER_VECTOR_LANES * 4) {
+			/** The vectors being copied. */
+			const vector_u32 a = LOAD(src_row + x);
+			const vector_u32 b = LOAD(src_row + x + RASTER_VECTOR_LANES);
+			const vector_u32 c = LOAD(src_row + x + (RASTER_VECTOR_LANES * 2));
+			const vector_u32 d = LOAD(src_row + x + (RASTER_VECTOR_LANES * 3));
+
+			STORE(dest_row + x, a);
+			STORE(dest_row + x + RASTER_VECTOR_LANES, b);
+			STORE(dest_row + x + (RASTER_VECTOR_LANES * 2), c);
+			STORE(dest_row + x + (RASTER_VECTOR_LANES * 3), d);
+		}
+
+		for(; (x + RASTER_VECTOR_LANES) <= width; x += RASTER_VECTOR_LANES) {
+			STORE(dest_row + x, LOAD(src_row + x));
+		}
+
+		for(; x < width; x++) {
+			dest_row[x] = src_row[x];
+		}
+	}
+}
+
+
+/**
+ * raster_pattern
+ */
+static void raster_pattern(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t* pattern,
+	const uint32_t pattern_width,
+	const uint32_t pattern_height,
+	const uint32_t origin_x,
+	const uint32_t origin_y)
+{
+	/**
+	 * The period the pattern row repeats with, rounded up to a whole number of
+	 * pattern widths no smaller than a vector. Once this many pixels of a row
+	 * are written, every following vector is a copy of the one this many
+	 * pixels before it.
+	 */
+	const uint32_t period = pattern_width *
+		((RASTER_VECTOR_LANES + pattern_width - 1) / pattern_width);
+
+	for(uint32_t y = 0; y < height; y++) {
+		/** The current row. */
+		uint32_t* row = dest + (y * dest_stride);
+		/** The pattern row tiled across this row. */
+		const uint32_t* pattern_row = pattern +
+			(((y + origin_y) % pattern_height) * pattern_width);
+		/** The number of pixels seeded from the pattern. */
+		const uint32_t seed = (period < width) ? period : width;
+		/** The current column. */
+		uint32_t x = 0;
+
+		for(; x < seed; x++) {
+			row[x] = pattern_row[(x + origin_x) % pattern_width];
+		}
+
+		for(; (x + RASTER_VECTOR_LANES) <= width; x += RASTER_VECTOR_LANES) {
+			STORE(row + x, LOAD(row + x - period));
+		}
+
+		for(; x < width; x++) {
+			row[x] = row[x - period];
+		}
+	}
+}
+
+
+/**
+ * blend_pixel
+ */
+static inline uint32_t blend_pixel(const uint32_t dest,
+	const uint32_t src)
+{
+	/** The source alpha. */
+	const uint32_t a = src >> 24;
+	/** The blended pixel. */
+	uint32_t result = 0;
+
+	for(unsigned int shift = 0; shift < 24; shift += 8) {
+		/** The weighted sum of the channel. */
+		const uint32_t t = (((src >> shift) & 0xFF) * a) +
+			(((dest >> shift) & 0xFF) * (255 - a)) + 128;
+
+		result |= (((t + (t >> 8)) >> 8) & 0xFF) << shift;
+	}
+
+	return result;
+}
+
+
+/**
+ * raster_blend
+ */
+static void raster_blend(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t* src,
+	const size_t src_stride,
+	const uint32_t width,
+	const uint32_t height)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		/** The current destination row. */
+		uint32_t* dest_row = dest + (y * dest_stride);
+		/** The current source row. */
+		const uint32_t* src_row = src + (y * src_stride);
+		/** The current column. */
+		uint32_t x = 0;
+
+		// Each pixel's red and blue channels, and its green and alpha channels,
+		// are blended as pairs of 16-bit lanes, leaving room for the products.
+		for(; (x + RASTER_VECTOR_LANES) <= width; x += RASTER_VECTOR_LANES) {
+			/** The source pixels. */
+			const vector_u32 s = LOAD(src_row + x);
+			/** The destination pixels. */
+			const vector_u32 d = LOAD(dest_row + x);
+			/** Each pixel's alpha, in both of its 16-bit lanes. */
+			const vector_u16 a = (vector_u16)((s >> 24) | (s >> 24 << 16));
+			/** The weighted sums of the red and blue channels. */
+			vector_u16 rb = ((vector_u16)(s & 0x00FF00FF) * a) +
+				((vector_u16)(d & 0x00FF00FF) * (255 - a)) + 128;
+			/** The weighted sums of the green and alpha channels. */
+			vector_u16 ga = ((vector_u16)((s >> 8) & 0x00FF00FF) * a) +
+				((vector_u16)((d >> 8) & 0x00FF00FF) * (255 - a)) + 128;
+
+			rb = (rb + (rb >> 8)) >> 8;
+			ga = (ga + (ga >> 8)) >> 8;
+
+			// The blended alpha channel is discarded.
+			STORE(dest_row + x, ((vector_u32)rb | ((vector_u32)ga << 8)) & 0x00FFFFFF);
+		}
+
+		for(; x < width; x++) {
+			dest_row[x] = blend_pixel(dest_row[x], src_row[x]);
+		}
+	}
+}
+
+
+/**
+ * raster_convert
+ */
+static void raster_convert(uint32_t* dest,
+	const uint32_t* src,
+	const size_t count)
+{
+	/** The current pixel. */
+	size_t i = 0;
+
+	for(; (i + RASTER_VECTOR_LANES) <= count; i += RASTER_VECTOR_LANES) {
+		/** The pixels being converted. */
+		const vector_u32 v = LOAD(src + i);
+
+		STORE(dest + i, ((v & 0xFF) << 16) | (v & 0xFF00FF00) | ((v >> 16) & 0xFF));
+	}
+
+	for(; i < count; i++) {
+		dest[i] = ((src[i] & 0xFF) << 16) | (src[i] & 0xFF00FF00) |
+			((src[i] >> 16) & 0xFF);
+	}
+}
+
+
+/**
+ * raster_test_texture
+ */
+static void raster_test_texture(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t frame)
+{
+	/** The lane offsets of a vector of pixels. */
+	vector_u32 lane_offsets;
+
+	for(uint32_t i = 0; i < RASTER_VECTOR_LANES; i++) {
+		lane_offsets[i] = i;
+	}
+
+	for(uint32_t y = 0; y < height; y++) {
+		/** The current row. */
+		uint32_t* row = dest + (y * dest_stride);
+		/** The texture row coordinate. */
+		const uint32_t v = y + frame;
+		/** The current column. */
+		uint32_t x = 0;
+
+		for(; (x + RASTER_VECTOR_LANES) <= width; x += RASTER_VECTOR_LANES) {
+			/** The texture value of each pixel. */
+			const vector_u32 c = ((lane_offsets + x) ^ v) & 0xFF;
+
+			STORE(row + x, ((255 - (c & 127)) << 16) | (c << 8) | (c & 127));
+		}
+
+		for(; x < width; x++) {
+			/** The texture value of this pixel. */
+			const uint32_t c = (x ^ v) & 0xFF;
+
+			row[x] = ((255 - (c & 127)) << 16) | (c << 8) | (c & 127);
+		}
+	}
+}
+
+#undef LOAD
+#undef STORE
@@ -0,0 +1,130 @@
+/**
+ * @file renderer.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Back-buffered framebuffer renderer.
+ * Contains functionality for drawing into a cacheable back buffer in normal
+ * RAM, and flushing only the damaged regions of it to the framebuffer.
+ * The framebuffer itself is uncached or write-combining memory, so it is never
+ * read, and is only written with wide streaming stores.
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <graphics.h>
+
+/** The maximum back buffer width supported. */
+#define RENDERER_MAX_WIDTH          1024
+/** The maximum back buffer height supported. */
+#define RENDERER_MAX_HEIGHT         768
+/**
+ * The maximum number of dirty rectangles tracked before rectangles are
+ * merged together.
+ */
+#define RENDERER_MAX_DIRTY_RECTS    32
+
+/**
+ * @brief A rectangle in screen coordinates.
+ */
+typedef struct s_rect {
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+} Rect;
+
+/**
+ * @brief Renderer state.
+ * The back buffer holds pixels in the canonical `0x00RRGGBB` layout. They are
+ * converted to the framebuffer's native layout when flushed.
+ */
+typedef struct s_renderer {
+	const Framebuffer* fb;
+	uint32_t* back_buffer;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	Rect dirty_rects[RENDERER_MAX_DIRTY_RECTS];
+	size_t n_dirty_rects;
+} Renderer;
+
+/**
+ * @brief The system renderer.
+ * Populated by `renderer_initialize`.
+ */
+extern Renderer renderer;
+
+/**
+ * @brief Initialises the renderer.
+ * Sets up the back buffer for the given framebuffer.
+ * @param[in] fb The framebuffer to render to.
+ * @return A boolean indicating whether the renderer was initialised. This
+ * fails if the framebuffer is larger than the maximum back buffer size.
+ */
+bool renderer_initialize(const Framebuffer* fb);
+
+/**
+ * @brief Marks a region of the back buffer as dirty.
+ * Adds a region to the set flushed by the next call to `renderer_flush`. The
+ * region is clipped to the screen. Overlapping regions are coalesced, and if
+ * the dirty rectangle list is full the region is merged with the rectangle
+ * whose area grows the least.
+ * @param[in,out] r The renderer.
+ * @param[in] x The x coordinate of the region.
+ * @param[in] y The y coordinate of the region.
+ * @param[in] width The width of the region.
+ * @param[in] height The height of the region.
+ */
+void renderer_mark_dirty(Renderer* r,
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t width,
+	const uint32_t height);
+
+/**
+ * @brief Fills a rectangle in the back buffer.
+ * Fills a rectangle in the back buffer and marks it dirty.
+ * @param[in,out] r The renderer.
+ * @param[in] x The x coordinate of the rectangle.
+ * @param[in] y The y coordinate of the rectangle.
+ * @param[in] width The width of the rectangle.
+ * @param[in] height The height of the rectangle.
+ * @param[in] colour The canonical colour to fill with.
+ */
+void renderer_fill_rect(Renderer* r,
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t colour);
+
+/**
+ * @brief Writes a pixel into the back buffer.
+ * Writes a single pixel. This does not mark the pixel dirty, callers drawing
+ * many pixels should mark the bounding region once when finished.
+ * @param[in,out] r The renderer.
+ * @param[in] x The x coordinate of the pixel.
+ * @param[in] y The y coordinate of the pixel.
+ * @param[in] colour The canonical colour of the pixel.
+ */
+static inline void renderer_put_pixel(Renderer* r,
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t colour)
+{
+	r->back_buffer[((size_t)y * r->stride) + x] = colour;
+}
+
+/**
+ * @brief Flushes the dirty regions to the framebuffer.
+ * Copies every dirty region of the back buffer to the framebuffer using
+ * streaming stores, then clears the dirty list.
+ * @param[in,out] r The renderer.
+ */
+void renderer_flush(Renderer* r);
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * @file scheduler.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Task scheduler.
+ * Contains definitions for the kernel's work-stealing task scheduler. Each CPU
+ * owns a Chase-Lev deque of tasks: it pushes and pops tasks at the bottom of
+ * its own deque without locking, while idle CPUs steal from the top of other
+ * CPUs' deques. No lock is shared between CPUs.
+ * Tasks run to completion. Their storage belongs to the caller, who must keep
+ * it alive until the task's group has been waited on, so tasks are usually
+ * kept on the stack of the function which spawns and waits for them. A CPU
+ * waiting on a group runs other tasks meanwhile, rather than blocking.
+ * Idle CPUs sleep with `mwait` on their wake flag where supported, otherwise
+ * with `hlt`, and are woken with an IPI when work is spawned.
+ * Tasks must not be spawned from interrupt handlers.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Whether the local APIC timer asks long-running tasks to yield. Scheduling
+ * stays cooperative: tasks are never switched out, since they have no stacks
+ * of their own. The timer only sets a flag which tasks check with
+ * `scheduler_should_yield` at safe points.
+ */
+#ifndef SCHEDULER_YIELD_TIMER
+	#define SCHEDULER_YIELD_TIMER      0
+#endif
+
+/** The capacity of each CPU's deque. This must be a power of two. */
+#define SCHEDULER_DEQUE_SIZE         1024
+/** The period of the yield timer in microseconds. */
+#define SCHEDULER_TIMESLICE_US       10000
+/** The vector of the IPI which wakes an idle CPU. */
+#define SCHEDULER_WAKE_VECTOR        0xF0
+/** The vector of the yield timer. */
+#define SCHEDULER_TIMER_VECTOR       0xF1
+
+/**
+ * @brief A task function.
+ * @param[in,out] argument The task's argument.
+ */
+typedef void (*Task_Function)(void* argument);
+
+/**
+ * @brief A group of tasks which can be waited on together.
+ * The low 32 bits of `state` count the group's pending tasks. The upper 32
+ * bits hold one more than the index of the CPU waiting on the group, or zero,
+ * so that the last task to complete can wake it without touching the group
+ * again. Must be zero initialised before use. Only one CPU may wait on a group
+ * at a time.
+ */
+typedef struct s_task_group {
+	uint64_t state;
+} Task_Group;
+
+/**
+ * @brief A task.
+ */
+typedef struct s_task {
+	Task_Function function;
+	void* argument;
+	Task_Group* group;
+} Task;
+
+/**
+ * @brief A parallel loop body.
+ * Called with consecutive, non-overlapping ranges of the loop.
+ * @param[in] begin The first index of the range.
+ * @param[in] end The index past the end of the range.
+ * @param[in,out] argument The loop's argument.
+ */
+typedef void (*Parallel_For_Function)(const size_t begin,
+	const size_t end,
+	void* argument);
+
+/**
+ * @brief Work done each time an idle CPU wakes.
+ */
+typedef void (*Scheduler_Idle_Hook)(void);
+
+/**
+ * @brief Background work done by CPUs with no tasks to run.
+ * Each call should do a small unit of work, so that tasks spawned meanwhile
+ * are not delayed.
+ * @return Whether more work remains. The CPU sleeps once none does.
+ */
+typedef bool (*Scheduler_Idle_Work)(void);
+
+/**
+ * @brief The scheduler statistics for one CPU.
+ */
+typedef struct s_scheduler_stats {
+	uint64_t tasks_run;
+	uint64_t steals;
+	uint64_t wakeups;
+} Scheduler_Stats;
+
+/**
+ * @brief Initialises the scheduler.
+ * Installs the wake IPI handler, and calibrates the yield timer if
+ * `SCHEDULER_YIELD_TIMER` is set. Must be called on the boot CPU after
+ * `apic_initialize`, and before the secondary CPUs are started.
+ */
+void scheduler_initialize(void);
+
+/**
+ * @brief Sets the background work done by idle CPUs.
+ * Idle CPUs call it before sleeping, checking for tasks between calls.
+ * @param[in] work The work function. May be NULL.
+ */
+void scheduler_set_idle_work(Scheduler_Idle_Work work);
+
+/**
+ * @brief Wakes one idle CPU, if there is one.
+ * Used to have background work done. May be called from interrupt handlers.
+ */
+void scheduler_wake_idle_cpu(void);
+
+/**
+ * @brief Runs the scheduler on the current CPU.
+ * Runs tasks from this CPU's deque, steals from other CPUs when it is empty,
+ * does background work when there are no tasks anywhere, and sleeps once
+ * there is none left either. Interrupts are enabled. This
+ * never returns.
+ * @param[in] idle_hook Called each time the CPU wakes from sleep, before it
+ * looks for tasks. May be NULL.
+ */
+void scheduler_run(Scheduler_Idle_Hook idle_hook) __attribute__((noreturn));
+
+/**
+ * @brief Spawns a task.
+ * Pushes the task onto the current CPU's deque, adding it to its group, and
+ * wakes an idle CPU to steal it. If the deque is full, the task runs at once.
+ * @param[in] task The task. Must stay alive until its group is waited on.
+ * @param[in] function The task function.
+ * @param[in] argument The task's argument.
+ * @param[in,out] group The group the task is added to.
+ */
+void scheduler_spawn(Task* task,
+	Task_Function function,
+	void* argument,
+	Task_Group* group);
+
+/**
+ * @brief Waits for every task in a group to complete.
+ * Runs other tasks while waiting, so that waiting never blocks a CPU. Once
+ * there are none left to run, the CPU sleeps until the group's last task
+ * completes, or more work is spawned. Must not be called on a group another
+ * CPU is waiting on. The group may be reused once this returns.
+ * @param[in] group The group to wait on.
+ */
+void scheduler_wait(Task_Group* group);
+
+/**
+ * @brief Runs a loop in parallel across every CPU.
+ * The range is split in halves until each part is no larger than the grain
+ * size. One half is spawned, where idle CPUs can steal it, while the other
+ * is split further, so that work spreads across CPUs in a logarithmic number
+ * of steps. Returns once the whole range has been processed.
+ * @param[in] begin The first index of the loop.
+ * @param[in] end The index past the end of the loop.
+ * @param[in] grain The largest range passed to a single call of the body.
+ * Zero is treated as one.
+ * @param[in] function The loop body.
+ * @param[in,out] argument The loop's argument.
+ */
+void scheduler_parallel_for(const size_t begin,
+	const size_t end,
+	const size_t grain,
+	Parallel_For_Function function,
+	void* argument);
+
+/**
+ * @brief Tests whether the current task should yield.
+ * Set by the yield timer once per timeslice. Always false without
+ * `SCHEDULER_YIELD_TIMER`. Tasks must check this themselves, since they are
+ * never interrupted to run others.
+ * @return Whether the current task's timeslice has expired.
+ */
+bool scheduler_should_yield(void);
+
+/**
+ * @brief Yields the current CPU to other tasks.
+ * Runs one other task, if there is one, and starts a new timeslice.
+ */
+void scheduler_yield(void);
+
+/**
+ * @brief Gets the scheduler statistics for a CPU.
+ * @param[in] cpu_index The CPU's index.
+ * @return The CPU's statistics.
+ */
+const Scheduler_Stats* scheduler_get_stats(const uint32_t cpu_index);
+
+#endif
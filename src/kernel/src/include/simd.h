@@ -0,0 +1,53 @@
+/**
+ * @file simd.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief SIMD functionality.
+ * Contains vector types and streaming store helpers. GCC vector extensions are
+ * used rather than the intrinsics headers, since those depend on the hosted
+ * C library.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H 1
+
+#include <stdint.h>
+
+/** A 128-bit vector of four 32-bit lanes. */
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+/** A 128-bit vector of four 32-bit lanes, with no alignment requirement. */
+typedef uint32_t v4u32_unaligned __attribute__((vector_size(16), aligned(4)));
+
+/**
+ * @brief Loads a vector from unaligned memory.
+ * @param[in] src The address to load from.
+ * @return The loaded vector.
+ */
+static inline v4u32 load_v4u32(const uint32_t* src)
+{
+	return *(const v4u32_unaligned*)src;
+}
+
+/**
+ * @brief Stores a vector with a non-temporal hint.
+ * Stores a vector to memory, bypassing the cache. The destination must be
+ * 16-byte aligned.
+ * @param[out] dest The address to store to.
+ * @param[in] value The vector to store.
+ */
+static inline void stream_store_v4u32(uint32_t* dest,
+	const v4u32 value)
+{
+	asm volatile("movntdq %1, %0" : "=m"(*(v4u32*)dest) : "x"(value));
+}
+
+/**
+ * @brief Orders non-temporal stores.
+ * Ensures all prior non-temporal stores are globally visible.
+ */
+static inline void store_fence(void)
+{
+	asm volatile("sfence" : : : "memory");
+}
+
+#endif
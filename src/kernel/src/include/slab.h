@@ -0,0 +1,172 @@
+/**
+ * @file slab.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Slab allocator.
+ * Contains definitions for the kernel heap. Small objects are allocated from
+ * object caches, each of which carves 4KiB slabs from the page allocator into
+ * objects of one size. `kmalloc` serves requests from a set of caches, one per
+ * size class, while hot structures can have a cache of their own, with
+ * objects aligned to a cache line.
+ * Each CPU holds a pair of magazines, stacks of free objects, for each cache.
+ * Allocations pop from the loaded magazine, and frees push to it, so the
+ * common path touches no shared state. When the loaded magazine runs empty or
+ * full, it is swapped with the previous one, and only when both are empty or
+ * full is the cache's lock taken, to move a whole magazine of objects to or
+ * from the slabs.
+ * Requests too large for any size class are allocated whole from the page
+ * allocator.
+ */
+
+#ifndef SLAB_H
+#define SLAB_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <smp.h>
+#include <spinlock.h>
+
+/** Whether to count allocations, frees, and magazine exchanges. */
+#ifndef SLAB_STATISTICS
+	#define SLAB_STATISTICS            0
+#endif
+
+/** The number of objects each magazine holds. */
+#define SLAB_MAGAZINE_SIZE           32
+/** The largest request served by a `kmalloc` size class. */
+#define SLAB_MAX_CLASS_SIZE          1024
+/** The number of `kmalloc` size classes. */
+#define SLAB_N_CLASSES               12
+/** The number of completely free slabs a cache keeps, rather than freeing. */
+#define SLAB_MAX_EMPTY_SLABS         1
+
+/**
+ * @brief A slab.
+ * Stored at the start of the slab's page. The objects follow it.
+ */
+typedef struct s_slab {
+	struct s_slab_cache* cache;
+	struct s_slab* next;
+	struct s_slab* prev;
+	void* free;
+	uint32_t in_use;
+	uint32_t order;
+} Slab;
+
+/**
+ * @brief A magazine of free objects.
+ */
+typedef struct s_slab_magazine {
+	uint32_t count;
+	void* objects[SLAB_MAGAZINE_SIZE];
+} Slab_Magazine;
+
+/**
+ * @brief An object cache's statistics.
+ * `refills` and `flushes` count magazines moved from and to the slabs.
+ */
+typedef struct s_slab_stats {
+	uint64_t allocations;
+	uint64_t frees;
+	uint64_t refills;
+	uint64_t flushes;
+} Slab_Stats;
+
+/**
+ * @brief A CPU's magazines for one object cache.
+ * `loaded` and `previous` each point to one of `magazines`.
+ */
+typedef struct s_slab_cpu {
+	Slab_Magazine* loaded;
+	Slab_Magazine* previous;
+	Slab_Magazine magazines[2];
+	#if SLAB_STATISTICS
+		Slab_Stats stats;
+	#endif
+} __attribute__((aligned(64))) Slab_Cpu;
+
+/**
+ * @brief An object cache.
+ * `partial` lists the slabs with free objects. `n_empty` is the number of
+ * those with no objects in use.
+ */
+typedef struct s_slab_cache {
+	const char* name;
+	uint32_t object_size;
+	uint32_t offset;
+	uint32_t objects_per_slab;
+	uint32_t n_empty;
+	uint64_t n_slabs;
+	Spinlock lock;
+	Slab* partial;
+	Slab_Cpu cpus[SMP_MAX_CPUS];
+} Slab_Cache;
+
+/**
+ * @brief Initialises the `kmalloc` size classes.
+ * Must be called after `page_allocator_initialize`.
+ */
+void slab_initialize(void);
+
+/**
+ * @brief Initialises an object cache.
+ * @param[out] cache The cache.
+ * @param[in] name The cache's name.
+ * @param[in] object_size The size of each object.
+ * @param[in] align The alignment of each object, a power of two. Hot
+ * structures shared between CPUs should be aligned to a cache line.
+ * @return Whether the cache was initialised. This fails if an object and its
+ * alignment do not fit in a slab.
+ */
+bool slab_cache_initialize(Slab_Cache* cache,
+	const char* name,
+	const size_t object_size,
+	const size_t align);
+
+/**
+ * @brief Allocates an object from a cache.
+ * May be called from interrupt handlers.
+ * @param[in,out] cache The cache.
+ * @return The object, or NULL if no memory is free.
+ */
+void* slab_cache_alloc(Slab_Cache* cache);
+
+/**
+ * @brief Frees an object to its cache.
+ * May be called from interrupt handlers, and on any CPU.
+ * @param[in,out] cache The cache the object was allocated from.
+ * @param[in] object The object.
+ */
+void slab_cache_free(Slab_Cache* cache,
+	void* object);
+
+/**
+ * @brief Gets an object cache's statistics, summed across every CPU.
+ * Always zero unless `SLAB_STATISTICS` is set.
+ * @param[in] cache The cache.
+ * @param[out] stats The statistics.
+ */
+void slab_cache_get_stats(const Slab_Cache* cache,
+	Slab_Stats* stats);
+
+/**
+ * @brief Allocates memory from the kernel heap.
+ * Requests of up to `SLAB_MAX_CLASS_SIZE` bytes are served by the smallest
+ * size class which fits, aligned to 16 bytes. Larger requests are allocated
+ * whole from the page allocator, aligned to a cache line.
+ * May be called from interrupt handlers.
+ * @param[in] size The size in bytes.
+ * @return The memory, or NULL if `size` is zero, larger than the page
+ * allocator's largest block, or no memory is free.
+ */
+void* kmalloc(const size_t size);
+
+/**
+ * @brief Frees memory allocated by `kmalloc`.
+ * May be called from interrupt handlers, and on any CPU.
+ * @param[in] pointer The memory. May be NULL.
+ */
+void kfree(void* pointer);
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file smp.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Multiprocessor functionality.
+ * Contains definitions for starting the secondary CPUs, and for each CPU's
+ * local data. The CPUs are found through the ACPI MADT. They are started
+ * together with a single broadcast INIT-SIPI-SIPI sequence, rather than one
+ * at a time, so that bring-up takes roughly the same time for any number of
+ * CPUs. Each started CPU takes a ticket to claim a stack, then finds its own
+ * index by its APIC ID.
+ * Each CPU's GS base points to its `Cpu_Local`, so that the current CPU's
+ * data is reached with a single GS-relative load.
+ */
+
+#ifndef SMP_H
+#define SMP_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** The maximum number of CPUs supported. */
+#define SMP_MAX_CPUS                 64
+/** The size of each secondary CPU's stack. */
+#define SMP_STACK_SIZE               0x4000
+/** How long to wait for the secondary CPUs to come online, in milliseconds. */
+#define SMP_STARTUP_TIMEOUT_MS       1000
+
+/**
+ * @brief A CPU's local data.
+ * Reached through the CPU's GS base. `self` must be the first member, so that
+ * the structure's address can be read from `%gs:0`. Each is aligned to a cache
+ * line so that CPUs do not contend on each other's data.
+ */
+typedef struct s_cpu_local {
+	struct s_cpu_local* self;
+	uint32_t index;
+	uint32_t apic_id;
+	uint32_t node;
+	uintptr_t stack_top;
+	bool online;
+} __attribute__((aligned(64))) Cpu_Local;
+
+/**
+ * @brief The multiprocessor state.
+ * `n_cpus` is the number of CPUs found, and `n_online` the number online,
+ * both including the boot CPU. `startup_ns` is the time from sending the INIT
+ * IPI until every secondary CPU was online.
+ */
+typedef struct s_smp {
+	uint32_t n_cpus;
+	uint32_t n_online;
+	uint64_t startup_ns;
+} Smp;
+
+/** The local data of each CPU, indexed by CPU index. */
+extern Cpu_Local cpu_locals[SMP_MAX_CPUS];
+
+/** The multiprocessor state. */
+extern Smp smp;
+
+/**
+ * @brief Initialises the boot CPU.
+ * Loads the kernel's GDT and the boot CPU's TSS, points its GS base at its
+ * local data, and unmaps the guard page below the boot stack. Must be called
+ * before anything else that uses per-CPU data.
+ */
+void smp_initialize_boot_cpu(void);
+
+/**
+ * @brief Starts the secondary CPUs.
+ * Finds the CPUs through the MADT, copies the startup trampoline to the low
+ * memory page reserved by the bootloader, and starts every secondary CPU,
+ * waiting until they are online or `SMP_STARTUP_TIMEOUT_MS` passes. Once
+ * online, the secondary CPUs check that their TSC is synchronised with the
+ * boot CPU's, then run the scheduler. Must be called after
+ * `clock_initialize`, `interrupts_initialize`, `apic_initialize` and
+ * `scheduler_initialize`.
+ * @param[in] trampoline The trampoline page passed by the bootloader. May be
+ * NULL, in which case only the boot CPU is used.
+ * @return Whether every CPU listed in the MADT came online.
+ */
+bool smp_initialize(void* trampoline);
+
+/**
+ * @brief Gets the current CPU's local data.
+ * @return The current CPU's local data.
+ */
+static inline Cpu_Local* smp_get_cpu_local(void)
+{
+	/** The current CPU's local data. */
+	Cpu_Local* local;
+	asm volatile("movq %%gs:0, %0" : "=r"(local));
+	return local;
+}
+
+/**
+ * @brief Gets the current CPU's index.
+ * @return The index of the current CPU. The boot CPU is index 0.
+ */
+static inline uint32_t smp_get_cpu_index(void)
+{
+	/** The current CPU's index. */
+	uint32_t index;
+	asm volatile("movl %%gs:%c1, %0"
+		: "=r"(index)
+		: "i"(offsetof(Cpu_Local, index)));
+	return index;
+}
+
+/**
+ * @brief Gets the current CPU's NUMA node.
+ * @return The index of the node the current CPU is on.
+ */
+static inline uint32_t smp_get_cpu_node(void)
+{
+	/** The current CPU's node. */
+	uint32_t node;
+	asm volatile("movl %%gs:%c1, %0"
+		: "=r"(node)
+		: "i"(offsetof(Cpu_Local, node)));
+	return node;
+}
+
+#endif
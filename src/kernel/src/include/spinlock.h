@@ -0,0 +1,89 @@
+/**
+ * @file spinlock.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Spinlocks.
+ * Contains a test-and-test-and-set spinlock. Waiters spin on a plain load, so
+ * that the lock's cache line is only written when it is likely to be free.
+ * Locks taken from interrupt handlers must be taken with interrupts disabled
+ * everywhere else, through the `_irqsave` variants.
+ */
+
+#ifndef SPINLOCK_H
+#define SPINLOCK_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <cpu.h>
+
+/** The initial value of an unlocked spinlock. */
+#define SPINLOCK_INITIALIZER { 0 }
+
+/**
+ * @brief A spinlock.
+ */
+typedef struct s_spinlock {
+	uint32_t locked;
+} Spinlock;
+
+/**
+ * @brief Takes a spinlock, if it is free.
+ * @param[in,out] lock The lock.
+ * @return Whether the lock was taken.
+ */
+static inline bool spinlock_try_acquire(Spinlock* lock)
+{
+	return __atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+/**
+ * @brief Takes a spinlock, waiting until it is free.
+ * @param[in,out] lock The lock.
+ */
+static inline void spinlock_acquire(Spinlock* lock)
+{
+	while(!spinlock_try_acquire(lock)) {
+		while(__atomic_load_n(&lock->locked, __ATOMIC_RELAXED)) {
+			cpu_relax();
+		}
+	}
+}
+
+/**
+ * @brief Releases a spinlock.
+ * @param[in,out] lock The lock.
+ */
+static inline void spinlock_release(Spinlock* lock)
+{
+	__atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Disables interrupts, then takes a spinlock.
+ * @param[in,out] lock The lock.
+ * @return The saved interrupt flag, to be passed to
+ * `spinlock_release_irqrestore`.
+ */
+static inline uint64_t spinlock_acquire_irqsave(Spinlock* lock)
+{
+	/** The saved interrupt flag. */
+	const uint64_t flags = save_and_disable_interrupts();
+
+	spinlock_acquire(lock);
+
+	return flags;
+}
+
+/**
+ * @brief Releases a spinlock, then restores the interrupt flag.
+ * @param[in,out] lock The lock.
+ * @param[in] flags The interrupt flag saved by `spinlock_acquire_irqsave`.
+ */
+static inline void spinlock_release_irqrestore(Spinlock* lock,
+	const uint64_t flags)
+{
+	spinlock_release(lock);
+	restore_interrupts(flags);
+}
+
+#endif
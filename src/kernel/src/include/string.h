@@ -3,14 +3,157 @@
  * @author ajxs
  * @date Aug 2019
  * @brief String functionality.
- * Contains definitions for string functions.
+ * Contains definitions for string and memory functions. The memory functions
+ * have several implementations: a scalar reference, SSE2 and AVX2 variants,
+ * and a `rep movsb`/`rep stosb` variant. The fastest vector variant supported
+ * by the processor is patched in as a static call by `alternatives_apply`,
+ * and on processors with enhanced string instructions `string_initialize`
+ * enables the `rep` variant from `STRING_REP_THRESHOLD` bytes. Until then the
+ * SSE2 variant, which is part of the x86-64 baseline, is used for every size.
  */
 
 #ifndef STRING_H
 #define STRING_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * The size from which copies and fills use `rep movsb`/`rep stosb` on
+ * processors with enhanced string instructions.
+ */
+#define STRING_REP_THRESHOLD          0x800
+/**
+ * The size from which fills use non-temporal stores, bypassing the cache.
+ * Fills this large would evict most of the cache, and are unlikely to be read
+ * back soon.
+ */
+#define STRING_NON_TEMPORAL_THRESHOLD 0x100000
+
+/**
+ * @brief Copies between non-overlapping buffers.
+ */
+typedef void* (*String_Copy_Function)(void* dest,
+	const void* src,
+	size_t n);
+
+/**
+ * @brief Fills a buffer with a byte.
+ */
+typedef void* (*String_Set_Function)(void* dest,
+	int c,
+	size_t n);
+
+/**
+ * @brief A set of memory function implementations.
+ * Used to test and benchmark each implementation. The memory functions
+ * themselves call the selected implementation directly.
+ */
+typedef struct s_string_operations {
+	const char* name;
+	String_Copy_Function copy;
+	String_Set_Function set;
+} String_Operations;
+
+/** The scalar reference implementations. */
+extern const String_Operations string_scalar_operations;
+/** The SSE2 implementations. */
+extern const String_Operations string_sse2_operations;
+/** The AVX2 implementations. */
+extern const String_Operations string_avx2_operations;
+/** The `rep movsb`/`rep stosb` implementations. */
+extern const String_Operations string_rep_operations;
+
+/**
+ * @brief The selected vector memory function implementations.
+ * Set by `string_initialize`. This matches the static calls patched by
+ * `alternatives_apply`.
+ */
+extern const String_Operations* string_operations;
+
+/** The SSE2 copy. */
+void* string_sse2_copy(void* dest,
+	const void* src,
+	size_t n);
+
+/** The SSE2 fill. */
+void* string_sse2_set(void* dest,
+	int c,
+	size_t n);
+
+/** The AVX2 copy. */
+void* string_avx2_copy(void* dest,
+	const void* src,
+	size_t n);
+
+/** The AVX2 fill. */
+void* string_avx2_set(void* dest,
+	int c,
+	size_t n);
+
+/** The `rep movsb` copy. */
+void* string_rep_copy(void* dest,
+	const void* src,
+	size_t n);
+
+/** The `rep stosb` fill. */
+void* string_rep_set(void* dest,
+	int c,
+	size_t n);
+
+/**
+ * @brief Initialises the string library.
+ * Records the fastest memory function implementations supported by the
+ * processor, and enables the `rep` implementations for large sizes where they
+ * are faster. Must be called after `alternatives_apply`.
+ */
+void string_initialize(void);
+
+/**
+ * @brief Copies between non-overlapping buffers.
+ * @param[out] dest The destination buffer.
+ * @param[in] src The source buffer.
+ * @param[in] n The number of bytes to copy.
+ * @return The destination buffer.
+ */
+void* memcpy(void* dest,
+	const void* src,
+	size_t n);
+
+/**
+ * @brief Copies between buffers which may overlap.
+ * @param[out] dest The destination buffer.
+ * @param[in] src The source buffer.
+ * @param[in] n The number of bytes to copy.
+ * @return The destination buffer.
+ */
+void* memmove(void* dest,
+	const void* src,
+	size_t n);
+
+/**
+ * @brief Fills a buffer with a byte.
+ * @param[out] dest The buffer to fill.
+ * @param[in] c The byte to fill the buffer with.
+ * @param[in] n The number of bytes to fill.
+ * @return The destination buffer.
+ */
+void* memset(void* dest,
+	int c,
+	size_t n);
+
+/**
+ * @brief Compares two buffers.
+ * @param[in] a The first buffer.
+ * @param[in] b The second buffer.
+ * @param[in] n The number of bytes to compare.
+ * @return Zero if the buffers are equal, otherwise the difference between the
+ * first pair of differing bytes.
+ */
+int memcmp(const void* a,
+	const void* b,
+	size_t n);
+
 /**
  * @brief Gets the size of a string.
  * Returns the number of chars making up a constant string.
@@ -19,4 +162,16 @@
  */
 size_t strlen(const char* str);
 
+/**
+ * @brief Tests the memory function implementations.
+ * Runs every implementation supported by the processor over a sweep of sizes
+ * and source and destination alignments, checking the result and that no byte
+ * outside the destination is written. Failures are reported through `kprintf`.
+ * The test buffers are allocated from the page allocator, so this must be
+ * called after `page_allocator_initialize`.
+ * @return Whether every implementation passed. False if the test buffers
+ * could not be allocated.
+ */
+bool string_self_test(void);
+
 #endif
@@ -0,0 +1,259 @@
+/**
+ * @file string_template.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Vectorised memory function template.
+ * Contains the vectorised memory functions, written once with GCC vector
+ * extensions and instantiated for each vector width. The including file
+ * defines `STRING_VECTOR_SIZE`, the size of a vector in bytes, and
+ * `STRING_FUNCTION(name)`, which names each function for the variant, then
+ * includes this file once.
+ * Buffers no larger than two vectors are handled with overlapping loads and
+ * stores, rather than loops. Larger buffers store their first vector
+ * unaligned, continue with aligned stores, and finish with an unaligned store
+ * of their last vector.
+ */
+
+#ifndef STRING_VECTOR_SIZE
+#error "STRING_VECTOR_SIZE must be defined before including string_template.h"
+#endif
+
+#ifndef STRING_FUNCTION
+#error "STRING_FUNCTION must be defined before including string_template.h"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <simd.h>
+#include <string.h>
+
+/** A vector of bytes. */
+typedef uint8_t vector_u8
+	__attribute__((vector_size(STRING_VECTOR_SIZE), may_alias));
+/** A vector of bytes, with no alignment requirement. */
+typedef uint8_t vector_u8_unaligned
+	__attribute__((vector_size(STRING_VECTOR_SIZE), aligned(1), may_alias));
+/** A 128-bit vector of bytes, with no alignment requirement. */
+typedef uint8_t vector_u8x16_unaligned
+	__attribute__((vector_size(16), aligned(1), may_alias));
+/** A 64-bit word, with no alignment requirement. */
+typedef uint64_t word_u64_unaligned __attribute__((aligned(1), may_alias));
+/** A 32-bit word, with no alignment requirement. */
+typedef uint32_t word_u32_unaligned __attribute__((aligned(1), may_alias));
+
+/** Loads a vector from unaligned memory. */
+#define LOAD(ptr)            (*(const vector_u8_unaligned*)(ptr))
+/** Stores a vector to unaligned memory. */
+#define STORE(ptr, value)    (*(vector_u8_unaligned*)(ptr) = (value))
+
+#if STRING_VECTOR_SIZE == 32
+/** Stores a vector to aligned memory, with a non-temporal hint. */
+#define STREAM(ptr, value) \
+	asm volatile("vmovntdq %1, %0" : "=m"(*(vector_u8*)(ptr)) : "x"(value))
+#else
+/** Stores a vector to aligned memory, with a non-temporal hint. */
+#define STREAM(ptr, value) \
+	asm volatile("movntdq %1, %0" : "=m"(*(vector_u8*)(ptr)) : "x"(value))
+#endif
+
+
+/**
+ * copy_small
+ */
+static inline void copy_small(uint8_t* dest,
+	const uint8_t* src,
+	const size_t n)
+{
+	#if STRING_VECTOR_SIZE > 16
+		if(n >= 16) {
+			/** The first and last 16 bytes, which may overlap. */
+			const vector_u8x16_unaligned head = *(const vector_u8x16_unaligned*)src;
+			const vector_u8x16_unaligned tail =
+				*(const vector_u8x16_unaligned*)(src + n - 16);
+
+			*(vector_u8x16_unaligned*)dest = head;
+			*(vector_u8x16_unaligned*)(dest + n - 16) = tail;
+			return;
+		}
+	#endif
+
+	if(n >= 8) {
+		/** The first and last 8 bytes, which may overlap. */
+		const uint64_t head = *(const word_u64_unaligned*)src;
+		const uint64_t tail = *(const word_u64_unaligned*)(src + n - 8);
+
+		*(word_u64_unaligned*)dest = head;
+		*(word_u64_unaligned*)(dest + n - 8) = tail;
+	} else if(n >= 4) {
+		/** The first and last 4 bytes, which may overlap. */
+		const uint32_t head = *(const word_u32_unaligned*)src;
+		const uint32_t tail = *(const word_u32_unaligned*)(src + n - 4);
+
+		*(word_u32_unaligned*)dest = head;
+		*(word_u32_unaligned*)(dest + n - 4) = tail;
+	} else if(n > 0) {
+		// Covers each length from 1 to 3 bytes without a loop.
+		dest[0] = src[0];
+		dest[n / 2] = src[n / 2];
+		dest[n - 1] = src[n - 1];
+	}
+}
+
+
+/**
+ * STRING_FUNCTION(copy)
+ */
+void* STRING_FUNCTION(copy)(void* dest,
+	const void* src,
+	size_t n)
+{
+	/** The next destination byte. */
+	uint8_t* d = dest;
+	/** The next source byte. */
+	const uint8_t* s = src;
+	/** The position of the last destination vector. */
+	uint8_t* last_dest;
+	/** The last source vector. */
+	vector_u8 last;
+	/** The number of bytes before the destination is aligned. */
+	size_t skew;
+
+	if(n < STRING_VECTOR_SIZE) {
+		copy_small(d, s, n);
+		return dest;
+	}
+
+	last_dest = d + n - STRING_VECTOR_SIZE;
+	last = LOAD(s + n - STRING_VECTOR_SIZE);
+
+	STORE(d, LOAD(s));
+	if(n <= (STRING_VECTOR_SIZE * 2)) {
+		STORE(last_dest, last);
+		return dest;
+	}
+
+	skew = STRING_VECTOR_SIZE - ((uintptr_t)d & (STRING_VECTOR_SIZE - 1));
+	d += skew;
+	s += skew;
+	n -= skew;
+
+	// Unrolled so that several loads are in flight before their stores.
+	for(; n > (STRING_VECTOR_SIZE * 4); n -= STRING_VECTOR_SIZE * 4) {
+		/** The vectors being copied. */
+		const vector_u8 a = LOAD(s);
+		const vector_u8 b = LOAD(s + STRING_VECTOR_SIZE);
+		const vector_u8 c = LOAD(s + (STRING_VECTOR_SIZE * 2));
+		const vector_u8 e = LOAD(s + (STRING_VECTOR_SIZE * 3));
+
+		*(vector_u8*)d = a;
+		*(vector_u8*)(d + STRING_VECTOR_SIZE) = b;
+		*(vector_u8*)(d + (STRING_VECTOR_SIZE * 2)) = c;
+		*(vector_u8*)(d + (STRING_VECTOR_SIZE * 3)) = e;
+
+		d += STRING_VECTOR_SIZE * 4;
+		s += STRING_VECTOR_SIZE * 4;
+	}
+
+	for(; n > STRING_VECTOR_SIZE; n -= STRING_VECTOR_SIZE) {
+		*(vector_u8*)d = LOAD(s);
+
+		d += STRING_VECTOR_SIZE;
+		s += STRING_VECTOR_SIZE;
+	}
+
+	STORE(last_dest, last);
+
+	return dest;
+}
+
+
+/**
+ * STRING_FUNCTION(set)
+ */
+void* STRING_FUNCTION(set)(void* dest,
+	int c,
+	size_t n)
+{
+	/** The next destination byte. */
+	uint8_t* d = dest;
+	/** The fill byte broadcast to every lane. */
+	const vector_u8 value = (vector_u8){0} + (uint8_t)c;
+	/** The fill byte broadcast to every byte of a word. */
+	const uint64_t word = (uint8_t)c * 0x0101010101010101ULL;
+	/** The position of the last destination vector. */
+	uint8_t* last_dest;
+	/** The number of bytes before the destination is aligned. */
+	size_t skew;
+
+	if(n < STRING_VECTOR_SIZE) {
+		#if STRING_VECTOR_SIZE > 16
+			if(n >= 16) {
+				*(word_u64_unaligned*)d = word;
+				*(word_u64_unaligned*)(d + 8) = word;
+				*(word_u64_unaligned*)(d + n - 16) = word;
+				*(word_u64_unaligned*)(d + n - 8) = word;
+				return dest;
+			}
+		#endif
+
+		if(n >= 8) {
+			*(word_u64_unaligned*)d = word;
+			*(word_u64_unaligned*)(d + n - 8) = word;
+		} else if(n >= 4) {
+			*(word_u32_unaligned*)d = (uint32_t)word;
+			*(word_u32_unaligned*)(d + n - 4) = (uint32_t)word;
+		} else if(n > 0) {
+			d[0] = (uint8_t)c;
+			d[n / 2] = (uint8_t)c;
+			d[n - 1] = (uint8_t)c;
+		}
+
+		return dest;
+	}
+
+	last_dest = d + n - STRING_VECTOR_SIZE;
+
+	STORE(d, value);
+	if(n <= (STRING_VECTOR_SIZE * 2)) {
+		STORE(last_dest, value);
+		return dest;
+	}
+
+	skew = STRING_VECTOR_SIZE - ((uintptr_t)d & (STRING_VECTOR_SIZE - 1));
+	d += skew;
+	n -= skew;
+
+	if(n >= STRING_NON_TEMPORAL_THRESHOLD) {
+		for(; n > STRING_VECTOR_SIZE; n -= STRING_VECTOR_SIZE) {
+			STREAM(d, value);
+			d += STRING_VECTOR_SIZE;
+		}
+
+		// The streamed stores must be ordered before the final ordinary store,
+		// and before whatever the caller does with the buffer.
+		store_fence();
+	} else {
+		for(; n > (STRING_VECTOR_SIZE * 4); n -= STRING_VECTOR_SIZE * 4) {
+			*(vector_u8*)d = value;
+			*(vector_u8*)(d + STRING_VECTOR_SIZE) = value;
+			*(vector_u8*)(d + (STRING_VECTOR_SIZE * 2)) = value;
+			*(vector_u8*)(d + (STRING_VECTOR_SIZE * 3)) = value;
+
+			d += STRING_VECTOR_SIZE * 4;
+		}
+
+		for(; n > STRING_VECTOR_SIZE; n -= STRING_VECTOR_SIZE) {
+			*(vector_u8*)d = value;
+			d += STRING_VECTOR_SIZE;
+		}
+	}
+
+	STORE(last_dest, value);
+
+	return dest;
+}
+
+#undef LOAD
+#undef STORE
+#undef STREAM
+#undef STRING_FUNCTION
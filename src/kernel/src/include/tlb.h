@@ -0,0 +1,134 @@
+/**
+ * @file tlb.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief TLB shootdown.
+ * Contains definitions for invalidating TLB entries across CPUs. Callers
+ * collect the ranges they change in a batch, which coalesces adjacent and
+ * overlapping ranges, and falls back to a full flush once it covers more than
+ * `TLB_FULL_FLUSH_PAGES` pages. Finishing a batch flushes the current CPU,
+ * appends the batch to the queue of every other online CPU, and sends each of
+ * them a single IPI, then waits for them to acknowledge it.
+ * Idle CPUs are in lazy mode: they are neither interrupted nor waited for.
+ * Their queue is processed when they leave lazy mode, before they run any
+ * task. An idle CPU also leaves lazy mode for as long as it runs an interrupt
+ * handler, so that handlers never see stale entries.
+ */
+
+#ifndef TLB_H
+#define TLB_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** The vector of the TLB shootdown IPI. */
+#define TLB_SHOOTDOWN_VECTOR         0xF2
+/** The number of separate ranges a batch or a CPU's queue holds. */
+#define TLB_MAX_RANGES               8
+/**
+ * The number of pages above which the whole TLB is flushed, rather than each
+ * page invalidated in turn.
+ */
+#define TLB_FULL_FLUSH_PAGES         32
+
+/**
+ * @brief A range of pages to invalidate.
+ * `end` is the address past the last page.
+ */
+typedef struct s_tlb_range {
+	uintptr_t start;
+	uintptr_t end;
+} Tlb_Range;
+
+/**
+ * @brief A batch of TLB invalidations.
+ * Must be zero initialised before use.
+ */
+typedef struct s_tlb_batch {
+	uint32_t n_ranges;
+	bool flush_all;
+	Tlb_Range ranges[TLB_MAX_RANGES];
+} Tlb_Batch;
+
+/**
+ * @brief TLB shootdown statistics, summed across every CPU.
+ * `shootdowns` is the number of batches finished, `ipis` the number of IPIs
+ * sent for them, and `lazy_skips` the number of idle CPUs left to flush when
+ * they wake. `full_flushes` and `page_flushes` count the flushes performed.
+ */
+typedef struct s_tlb_stats {
+	uint64_t shootdowns;
+	uint64_t ipis;
+	uint64_t lazy_skips;
+	uint64_t full_flushes;
+	uint64_t page_flushes;
+} Tlb_Stats;
+
+/**
+ * @brief Registers the shootdown IPI handler.
+ * Must be called before `smp_initialize`.
+ */
+void tlb_initialize(void);
+
+/**
+ * @brief Adds a range to a batch.
+ * @param[in,out] batch The batch.
+ * @param[in] address The start of the range.
+ * @param[in] size The size of the range in bytes.
+ */
+void tlb_batch_add(Tlb_Batch* batch,
+	const uintptr_t address,
+	const size_t size);
+
+/**
+ * @brief Flushes a batch on every CPU.
+ * Returns once every CPU not in lazy mode has flushed it. The batch is left
+ * empty. Must not be called from interrupt handlers.
+ * @param[in,out] batch The batch.
+ */
+void tlb_batch_finish(Tlb_Batch* batch);
+
+/**
+ * @brief Invalidates a single range on every CPU.
+ * @param[in] address The start of the range.
+ * @param[in] size The size of the range in bytes.
+ */
+void tlb_invalidate(const uintptr_t address,
+	const size_t size);
+
+/**
+ * @brief Puts the current CPU in lazy mode.
+ * Called by the scheduler with interrupts disabled, before the CPU sleeps.
+ */
+void tlb_enter_lazy(void);
+
+/**
+ * @brief Takes the current CPU out of lazy mode.
+ * Processes any invalidations queued while the CPU was idle. Called by the
+ * scheduler before the CPU runs any task.
+ */
+void tlb_exit_lazy(void);
+
+/**
+ * @brief Takes the current CPU out of lazy mode for an interrupt handler.
+ * Called on interrupt entry, with interrupts disabled.
+ * @return Whether the CPU was in lazy mode, to be passed to
+ * `tlb_interrupt_exit`.
+ */
+bool tlb_interrupt_enter(void);
+
+/**
+ * @brief Returns the current CPU to lazy mode after an interrupt handler.
+ * Called on interrupt exit, with interrupts disabled.
+ * @param[in] lazy The value returned by `tlb_interrupt_enter`.
+ */
+void tlb_interrupt_exit(const bool lazy);
+
+/**
+ * @brief Gets the shootdown statistics.
+ * @param[out] stats The statistics.
+ */
+void tlb_get_stats(Tlb_Stats* stats);
+
+#endif
@@ -4,19 +4,198 @@
  * @date Aug 2019
  * @brief UART functionality.
  * Contains definitions for serial IO.
+ * The kernel has a log port, which kernel output is written to, and an
+ * optional data port for exporting bulk data without interleaving it with the
+ * log. Both are configured from build options.
  */
 
 #ifndef UART_H
 #define UART_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <spinlock.h>
+
+/** The size of each port's transmit ring. This must be a power of two. */
+#define UART_TRANSMIT_RING_SIZE    0x4000
+/** The depth of the UART's transmit FIFO. */
+#define UART_FIFO_DEPTH            16
+/** The maximum number of ports which can be initialised. */
+#define UART_MAX_PORTS             4
+
+#define UART_PORT_COM1             0x3F8
+#define UART_PORT_COM2             0x2F8
+#define UART_PORT_COM3             0x3E8
+#define UART_PORT_COM4             0x2E8
+
+/** The UART's input clock divided by 16: The baud rate at divisor 1. */
+#define UART_MAX_BAUD_RATE         115200
+
+/**
+ * The IO port base of the log port.
+ */
+#ifndef UART_LOG_PORT_BASE
+	#define UART_LOG_PORT_BASE       UART_PORT_COM1
+#endif
+
+/**
+ * The baud rate divisor of the log port. A divisor of 1 gives 115200 baud.
+ */
+#ifndef UART_LOG_DIVISOR
+	#define UART_LOG_DIVISOR         1
+#endif
+
+/**
+ * The IO port base of the data port, or 0 if there is no data port.
+ */
+#ifndef UART_DATA_PORT_BASE
+	#define UART_DATA_PORT_BASE      0
+#endif
+
+/**
+ * The baud rate divisor of the data port.
+ */
+#ifndef UART_DATA_DIVISOR
+	#define UART_DATA_DIVISOR        1
+#endif
+
+/**
+ * The receive FIFO trigger level of every port.
+ * Refer to: `Uart_Fifo_Trigger`.
+ */
+#ifndef UART_FIFO_TRIGGER
+	#define UART_FIFO_TRIGGER        UART_FIFO_TRIGGER_14
+#endif
+
+/**
+ * @brief Receive FIFO trigger levels.
+ * The number of received bytes at which the receive interrupt is raised. Each
+ * value is the level's encoding in the FIFO control register.
+ */
+typedef enum e_uart_fifo_trigger {
+	UART_FIFO_TRIGGER_1 = 0x00,
+	UART_FIFO_TRIGGER_4 = 0x40,
+	UART_FIFO_TRIGGER_8 = 0x80,
+	UART_FIFO_TRIGGER_14 = 0xC0
+} Uart_Fifo_Trigger;
+
+/**
+ * @brief UART port configuration.
+ */
+typedef struct s_uart_config {
+	uint16_t base;
+	uint16_t divisor;
+	Uart_Fifo_Trigger fifo_trigger;
+	uint8_t irq;
+} Uart_Config;
+
+/**
+ * @brief A UART port.
+ * Output is queued in the port's transmit ring. `head` and `tail` count the
+ * bytes ever written to, and read from, the ring. `head` is only advanced by
+ * writers, and `tail` only by the ring's consumer. `lock` guards both, along
+ * with the transmitter, since writers and the interrupt handler may run on
+ * different CPUs.
+ */
+typedef struct s_uart_port {
+	Spinlock lock;
+	Uart_Config config;
+	bool initialized;
+	bool interrupt_driven;
+	bool transmitter_active;
+	uint32_t head;
+	uint32_t tail;
+	char buffer[UART_TRANSMIT_RING_SIZE];
+} Uart_Port;
+
+/**
+ * @brief The log port.
+ * Kernel output is written here. Populated by `uart_initialize`.
+ */
+extern Uart_Port uart_log_port;
 
 /**
- * @brief Initialises the UART.
- * Initialises the system UART for output.
+ * @brief The data port.
+ * Populated by `uart_initialize`, if `UART_DATA_PORT_BASE` is set.
+ */
+extern Uart_Port uart_data_port;
+
+/**
+ * @brief Initialises the UARTs.
+ * Initialises the log port, and the data port if one is configured, from the
+ * build options. Output is transmitted by polling until
+ * `uart_enable_interrupts` is called.
  */
 void uart_initialize(void);
 
+/**
+ * @brief Enables interrupt-driven transmission.
+ * Enables interrupt-driven transmission on every initialised port.
+ * Must be called after `interrupts_initialize`.
+ * @return Whether interrupts were enabled on every port.
+ */
+bool uart_enable_interrupts(void);
+
+/**
+ * @brief Gets the standard IRQ line of a port.
+ * @param[in] base The port's IO port base.
+ * @return The port's IRQ line.
+ */
+uint8_t uart_get_default_irq(const uint16_t base);
+
+/**
+ * @brief Initialises a UART port.
+ * Programs the port's line settings and FIFO, after checking that a UART is
+ * present at its base.
+ * @param[out] port The port to initialise.
+ * @param[in] config The port's configuration.
+ * @return Whether the port was initialised. This fails if no UART responds
+ * at the port's base, if the divisor is zero, or if `UART_MAX_PORTS` ports
+ * have already been initialised.
+ */
+bool uart_port_initialize(Uart_Port* port,
+	const Uart_Config* config);
+
+/**
+ * @brief Enables interrupt-driven transmission on a port.
+ * Installs the port's IRQ handler, after which queued output is transmitted
+ * from the transmitter empty interrupt whenever interrupts are enabled.
+ * @param[in,out] port The port.
+ * @return Whether the IRQ handler was installed.
+ */
+bool uart_port_enable_interrupts(Uart_Port* port);
+
+/**
+ * @brief Queues data for transmission by a port.
+ * This only waits for the UART if the transmit ring is full, in which case
+ * the writer transmits from the ring itself. The port's lock is released
+ * while waiting, so other writers' output may be queued between parts of a
+ * write larger than the free space. May be called from any CPU.
+ * @param[in,out] port The port.
+ * @param[in] data The data to write.
+ * @param[in] length The length of the data.
+ */
+void uart_port_write(Uart_Port* port,
+	const void* data,
+	const size_t length);
+
+/**
+ * @brief Queues a string for transmission by a port.
+ * Refer to `uart_port_write`.
+ * @param[in,out] port The port.
+ * @param[in] str The null-terminated string to write.
+ */
+void uart_port_puts(Uart_Port* port,
+	const char* str);
+
+/**
+ * @brief Flushes a port.
+ * Waits for all output queued on a port to be transmitted.
+ * @param[in,out] port The port.
+ */
+void uart_port_flush(Uart_Port* port);
+
 /**
  * @brief Checks whether the UART receive buffer is empty.
  * This function checks whether the UART receive buffer is empty.
@@ -40,16 +219,23 @@ bool uart_is_transmit_buffer_empty(void);
 
 /**
  * @brief UART putchar.
- * Writes a character to the UART.
+ * Queues a character for transmission by the log port.
  * @param a[in]    The char to write.
  */
 void uart_putchar(char a);
 
 /**
  * @brief UART puts.
- * Writes a string to the UART.
+ * Queues a string for transmission by the log port.
+ * Refer to `uart_port_puts`.
  * @param str[in]    The string to write to the UART.
  */
 void uart_puts(const char* str);
 
+/**
+ * @brief Flushes the UART.
+ * Waits for all output queued on the log port to be transmitted.
+ */
+void uart_flush(void);
+
 #endif
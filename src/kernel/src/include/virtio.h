@@ -0,0 +1,166 @@
+/**
+ * @file virtio.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Virtio functionality.
+ * Contains definitions for virtqueues, and for the legacy virtio PCI
+ * transport, through which a device's registers are accessed in IO space.
+ * Refer to: Virtual I/O Device (VIRTIO) Version 1.1, Section 4.1.4.8.
+ */
+
+#ifndef VIRTIO_H
+#define VIRTIO_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pci.h>
+
+/** The PCI vendor ID of virtio devices. */
+#define VIRTIO_PCI_VENDOR_ID                0x1AF4
+
+#define VIRTIO_LEGACY_DEVICE_FEATURES       0x00
+#define VIRTIO_LEGACY_DRIVER_FEATURES       0x04
+#define VIRTIO_LEGACY_QUEUE_ADDRESS         0x08
+#define VIRTIO_LEGACY_QUEUE_SIZE            0x0C
+#define VIRTIO_LEGACY_QUEUE_SELECT          0x0E
+#define VIRTIO_LEGACY_QUEUE_NOTIFY          0x10
+#define VIRTIO_LEGACY_DEVICE_STATUS         0x12
+#define VIRTIO_LEGACY_ISR_STATUS            0x13
+
+#define VIRTIO_STATUS_ACKNOWLEDGE           0x01
+#define VIRTIO_STATUS_DRIVER                0x02
+#define VIRTIO_STATUS_DRIVER_OK             0x04
+#define VIRTIO_STATUS_FAILED                0x80
+
+/** ISR status: A virtqueue has used buffers. */
+#define VIRTIO_ISR_QUEUE                    0x01
+
+/** Descriptor flag: The buffer continues in the next descriptor. */
+#define VIRTQ_DESC_F_NEXT                   1
+/** Descriptor flag: The buffer is written by the device. */
+#define VIRTQ_DESC_F_WRITE                  2
+/** Available ring flag: The device need not interrupt on used buffers. */
+#define VIRTQ_AVAIL_F_NO_INTERRUPT          1
+/** Used ring flag: The driver need not notify on available buffers. */
+#define VIRTQ_USED_F_NO_NOTIFY              1
+
+/** The legacy transport's virtqueue alignment, and page size. */
+#define VIRTQUEUE_ALIGNMENT                 0x1000
+/** The largest virtqueue supported. */
+#define VIRTQUEUE_MAX_SIZE                  256
+/**
+ * The memory needed for the largest virtqueue in the legacy layout: The
+ * descriptor table and available ring, aligned, then the used ring.
+ */
+#define VIRTQUEUE_MEMORY_SIZE               0x3000
+
+/**
+ * @brief A virtqueue descriptor.
+ */
+typedef struct s_virtq_desc {
+	uint64_t address;
+	uint32_t length;
+	uint16_t flags;
+	uint16_t next;
+} __attribute__((packed)) Virtq_Desc;
+
+/**
+ * @brief A virtqueue's available ring.
+ */
+typedef struct s_virtq_avail {
+	uint16_t flags;
+	uint16_t index;
+	uint16_t ring[];
+} __attribute__((packed)) Virtq_Avail;
+
+/**
+ * @brief A virtqueue used ring element.
+ */
+typedef struct s_virtq_used_element {
+	uint32_t id;
+	uint32_t length;
+} __attribute__((packed)) Virtq_Used_Element;
+
+/**
+ * @brief A virtqueue's used ring.
+ */
+typedef struct s_virtq_used {
+	uint16_t flags;
+	uint16_t index;
+	Virtq_Used_Element ring[];
+} __attribute__((packed)) Virtq_Used;
+
+/**
+ * @brief A virtqueue.
+ * Buffers are made available to the device in batches: `virtqueue_submit`
+ * only adds a buffer to the available ring, and the device is not told
+ * about it until the queue is notified by `virtqueue_notify`.
+ */
+typedef struct s_virtqueue {
+	uint16_t io_base;
+	uint16_t queue_index;
+	uint16_t size;
+	uint16_t last_used_index;
+	uint16_t n_unnotified;
+	uint64_t n_notifications;
+	volatile Virtq_Desc* descriptors;
+	volatile Virtq_Avail* available;
+	volatile Virtq_Used* used;
+} Virtqueue;
+
+/**
+ * @brief Resets a legacy virtio device, and acknowledges it.
+ * Enables the device's IO space and bus mastering, resets it, and sets the
+ * acknowledge and driver status bits.
+ * @param[in] dev The device's PCI function.
+ * @param[out] io_base The base of the device's registers.
+ * @return Whether the device was reset. This fails if its first BAR is not
+ * in IO space, as it is for devices without the legacy interface.
+ */
+bool virtio_legacy_reset_device(const Pci_Device* dev,
+	uint16_t* io_base);
+
+/**
+ * @brief Sets up a virtqueue on a legacy virtio device.
+ * @param[out] queue The virtqueue.
+ * @param[in] io_base The base of the device's registers.
+ * @param[in] queue_index The index of the device's virtqueue.
+ * @param[in] memory `VIRTQUEUE_MEMORY_SIZE` bytes of memory for the queue,
+ * aligned to `VIRTQUEUE_ALIGNMENT`, at an identity mapped address.
+ * @return Whether the queue was set up. This fails if the device does not
+ * have the queue, or if it is larger than `VIRTQUEUE_MAX_SIZE`.
+ */
+bool virtqueue_initialize(Virtqueue* queue,
+	const uint16_t io_base,
+	const uint16_t queue_index,
+	void* memory);
+
+/**
+ * @brief Makes a descriptor chain available to the device.
+ * The device is not notified.
+ * @param[in,out] queue The virtqueue.
+ * @param[in] descriptor The index of the chain's head descriptor.
+ */
+void virtqueue_submit(Virtqueue* queue,
+	const uint16_t descriptor);
+
+/**
+ * @brief Notifies the device of the buffers submitted since the last
+ * notification.
+ * The notification is skipped if nothing was submitted, or if the device has
+ * asked not to be notified.
+ * @param[in,out] queue The virtqueue.
+ */
+void virtqueue_notify(Virtqueue* queue);
+
+/**
+ * @brief Takes a buffer from the used ring.
+ * @param[in,out] queue The virtqueue.
+ * @param[out] descriptor The index of the used chain's head descriptor.
+ * @return Whether a used buffer was taken.
+ */
+bool virtqueue_take_used(Virtqueue* queue,
+	uint16_t* descriptor);
+
+#endif
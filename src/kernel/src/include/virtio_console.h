@@ -0,0 +1,140 @@
+/**
+ * @file virtio_console.h
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Virtio console functionality.
+ * Contains definitions for the virtio console driver, used as a high
+ * bandwidth channel for the kernel log and for exporting data. Each console
+ * device carries one channel: the first device found is used for the log, and
+ * the second for data export.
+ * Under QEMU these are attached with `-device virtio-serial` and a
+ * `virtconsole` on its bus. Refer to the `emu-virtio` target in src/makefile.
+ */
+
+#ifndef VIRTIO_CONSOLE_H
+#define VIRTIO_CONSOLE_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pci.h>
+#include <spinlock.h>
+#include <virtio.h>
+
+/** The device ID of a transitional virtio console. */
+#define VIRTIO_CONSOLE_DEVICE_ID            0x1003
+/** The index of the port 0 transmit queue. */
+#define VIRTIO_CONSOLE_TRANSMIT_QUEUE       1
+
+/** The number of transmit buffers. */
+#define VIRTIO_CONSOLE_BUFFER_COUNT         16
+/** The size of each transmit buffer. */
+#define VIRTIO_CONSOLE_BUFFER_SIZE          0x1000
+/**
+ * The number of submitted buffers after which the device is notified.
+ * Notifying the device is a VM exit under a hypervisor, so is batched.
+ */
+#define VIRTIO_CONSOLE_NOTIFY_BATCH         4
+/**
+ * The number of TSC cycles after the last submission after which a partly
+ * filled buffer is submitted, and the device notified, by the next write.
+ * Writes closer together than this are batched into the same buffer. The
+ * last buffer of a burst is submitted by `virtio_console_submit_pending`.
+ */
+#define VIRTIO_CONSOLE_SUBMIT_INTERVAL_CYCLES 0x1000000
+
+/** Marks that no transmit buffer is being filled. */
+#define VIRTIO_CONSOLE_NO_BUFFER            0xFFFF
+
+/**
+ * @brief A virtio console.
+ * Transmit buffer `i` is always described by descriptor `i`. Writes are
+ * copied into the current buffer, which is submitted once full. Completed
+ * buffers are reclaimed onto the free list, by polling when a writer needs
+ * one, and from the device's interrupt once interrupts are enabled. `lock`
+ * guards the queue and the buffers, since the interrupt may be handled on a
+ * different CPU from the writer.
+ */
+typedef struct s_virtio_console {
+	Spinlock lock;
+	Pci_Device pci_device;
+	uint16_t io_base;
+	uint8_t irq;
+	bool initialized;
+	bool interrupt_driven;
+	Virtqueue transmit_queue;
+	uint16_t free_buffers[VIRTIO_CONSOLE_BUFFER_COUNT];
+	uint16_t n_free_buffers;
+	uint16_t current_buffer;
+	uint32_t current_length;
+	uint64_t last_submit;
+	uint8_t queue_memory[VIRTQUEUE_MEMORY_SIZE]
+		__attribute__((aligned(VIRTQUEUE_ALIGNMENT)));
+	uint8_t buffers[VIRTIO_CONSOLE_BUFFER_COUNT][VIRTIO_CONSOLE_BUFFER_SIZE]
+		__attribute__((aligned(VIRTQUEUE_ALIGNMENT)));
+} Virtio_Console;
+
+/**
+ * @brief The log console.
+ * Populated by `virtio_console_initialize`, if a console device is present.
+ */
+extern Virtio_Console virtio_log_console;
+
+/**
+ * @brief The data export console.
+ * Populated by `virtio_console_initialize`, if a second console device is
+ * present.
+ */
+extern Virtio_Console virtio_data_console;
+
+/**
+ * @brief Initialises a virtio console.
+ * Finds a console device, and sets up its transmit queue.
+ * @param[out] con The console.
+ * @param[in] index The index of the console device among those present.
+ * @return Whether the console was initialised. This fails if there is no such
+ * device, or if it has no legacy interface.
+ */
+bool virtio_console_initialize(Virtio_Console* con,
+	const size_t index);
+
+/**
+ * @brief Enables interrupt completion on a console.
+ * Installs the device's IRQ handler, after which completed buffers are
+ * reclaimed as the device finishes them rather than when a writer runs out.
+ * Must be called after `interrupts_initialize`.
+ * @param[in,out] con The console.
+ * @return Whether the IRQ handler was installed.
+ */
+bool virtio_console_enable_interrupts(Virtio_Console* con);
+
+/**
+ * @brief Writes data to a console.
+ * This only waits for the device if every transmit buffer is in flight.
+ * May be called from any CPU.
+ * @param[in,out] con The console.
+ * @param[in] data The data to write.
+ * @param[in] length The length of the data.
+ */
+void virtio_console_write(Virtio_Console* con,
+	const void* data,
+	const size_t length);
+
+/**
+ * @brief Submits a console's partly filled buffer.
+ * Notifies the device of any buffers it has not been told of, without waiting
+ * for it. Called when the CPU goes idle, so that the end of a burst of writes
+ * is sent without waiting for another write.
+ * @param[in,out] con The console.
+ */
+void virtio_console_submit_pending(Virtio_Console* con);
+
+/**
+ * @brief Flushes a console.
+ * Submits the partly filled buffer, notifies the device, and waits for it to
+ * complete every buffer.
+ * @param[in,out] con The console.
+ */
+void virtio_console_flush(Virtio_Console* con);
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * @file interrupts.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Interrupt handling.
+ * Contains the implementation of the IDT and interrupt dispatch.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <apic.h>
+#include <cpu.h>
+#include <gdt.h>
+#include <interrupts.h>
+#include <pic.h>
+#include <printf.h>
+#include <smp.h>
+#include <tlb.h>
+
+/** The number of entries in the IDT. */
+#define IDT_ENTRY_COUNT               256
+/** IDT entry type: Present, ring 0, 64-bit interrupt gate. */
+#define IDT_TYPE_INTERRUPT_GATE       0x8E
+
+/**
+ * @brief An IDT entry.
+ */
+typedef struct s_idt_entry {
+	uint16_t offset_low;
+	uint16_t selector;
+	uint8_t ist;
+	uint8_t type_attributes;
+	uint16_t offset_middle;
+	uint32_t offset_high;
+	uint32_t reserved;
+} __attribute__((packed)) Idt_Entry;
+
+/**
+ * @brief The IDT descriptor loaded by `lidt`.
+ */
+typedef struct s_idt_descriptor {
+	uint16_t limit;
+	uint64_t base;
+} __attribute__((packed)) Idt_Descriptor;
+
+/** The entry stubs, defined in interrupt_stubs.S. */
+extern char interrupt_stubs[];
+
+/** The interrupt descriptor table. */
+static Idt_Entry idt[IDT_ENTRY_COUNT] __attribute__((aligned(16)));
+/** The IDT descriptor, loaded on every CPU. */
+static Idt_Descriptor idt_descriptor;
+/** The installed IRQ handlers. */
+static Irq_Handler irq_handlers[PIC_IRQ_COUNT];
+/** The installed local APIC vector handlers. */
+static Irq_Handler vector_handlers[IDT_ENTRY_COUNT - INTERRUPT_FIRST_APIC_VECTOR];
+
+
+/**
+ * interrupts_initialize
+ */
+void interrupts_initialize(void)
+{
+	/** The code segment the stubs run in. */
+	uint16_t code_selector = read_cs();
+	/** The address of the current entry stub. */
+	uintptr_t stub;
+
+	disable_interrupts();
+
+	for(size_t i = 0; i < INTERRUPT_VECTOR_COUNT; i++) {
+		stub = (uintptr_t)interrupt_stubs + (i * INTERRUPT_STUB_SIZE);
+
+		idt[i].offset_low = stub & 0xFFFF;
+		idt[i].selector = code_selector;
+		idt[i].ist = (i == INTERRUPT_DOUBLE_FAULT) ? GDT_DOUBLE_FAULT_IST : 0;
+		idt[i].type_attributes = IDT_TYPE_INTERRUPT_GATE;
+		idt[i].offset_middle = (stub >> 16) & 0xFFFF;
+		idt[i].offset_high = stub >> 32;
+		idt[i].reserved = 0;
+	}
+
+	idt_descriptor.limit = sizeof(idt) - 1;
+	idt_descriptor.base = (uint64_t)idt;
+	load_idt(&idt_descriptor);
+
+	pic_initialize();
+}
+
+
+/**
+ * interrupts_load
+ */
+void interrupts_load(void)
+{
+	load_idt(&idt_descriptor);
+}
+
+
+/**
+ * interrupts_register_irq_handler
+ */
+bool interrupts_register_irq_handler(const uint8_t irq,
+	Irq_Handler handler)
+{
+	if(irq >= PIC_IRQ_COUNT) {
+		return false;
+	}
+
+	irq_handlers[irq] = handler;
+	pic_set_irq_masked(irq, false);
+
+	return true;
+}
+
+
+/**
+ * interrupts_register_vector_handler
+ */
+bool interrupts_register_vector_handler(const uint8_t vector,
+	Irq_Handler handler)
+{
+	if(vector < INTERRUPT_FIRST_APIC_VECTOR || vector == APIC_SPURIOUS_VECTOR) {
+		return false;
+	}
+
+	vector_handlers[vector - INTERRUPT_FIRST_APIC_VECTOR] = handler;
+
+	return true;
+}
+
+
+/**
+ * interrupt_dispatch
+ */
+void interrupt_dispatch(Interrupt_Frame* frame)
+{
+	/** The IRQ line being delivered. */
+	uint8_t irq;
+	/** Whether the CPU was in lazy TLB mode when interrupted. */
+	bool lazy;
+
+	if(frame->vector < INTERRUPT_EXCEPTION_COUNT) {
+		kprintf("Kernel: Unhandled exception %lu on CPU %u, error code 0x%lx, "
+			"at 0x%lx\n", frame->vector, smp_get_cpu_index(), frame->error_code,
+			frame->rip);
+		kflush();
+
+		while(1) {
+			disable_interrupts();
+			halt();
+		}
+	}
+
+	if(frame->vector >= INTERRUPT_FIRST_APIC_VECTOR) {
+		// Spurious interrupts are not acknowledged.
+		if(frame->vector == APIC_SPURIOUS_VECTOR) {
+			return;
+		}
+
+		lazy = tlb_interrupt_enter();
+		if(vector_handlers[frame->vector - INTERRUPT_FIRST_APIC_VECTOR]) {
+			vector_handlers[frame->vector - INTERRUPT_FIRST_APIC_VECTOR](frame);
+		}
+		tlb_interrupt_exit(lazy);
+
+		apic_send_end_of_interrupt();
+		return;
+	}
+
+	irq = frame->vector - PIC_IRQ_BASE_VECTOR;
+	if(pic_is_spurious_irq(irq)) {
+		return;
+	}
+
+	lazy = tlb_interrupt_enter();
+	if(irq_handlers[irq]) {
+		irq_handlers[irq](frame);
+	}
+	tlb_interrupt_exit(lazy);
+
+	pic_send_end_of_interrupt(irq);
+}
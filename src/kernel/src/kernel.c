@@ -9,12 +9,40 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <acpi.h>
+#include <alternatives.h>
+#include <apic.h>
+#include <benchmark.h>
 #include <boot.h>
+#include <clock.h>
+#include <console.h>
+#include <cpu.h>
 #include <graphics.h>
+#include <interrupts.h>
+#include <log.h>
+#include <numa.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <printf.h>
+#include <raster.h>
+#include <renderer.h>
+#include <scheduler.h>
+#include <slab.h>
+#include <smp.h>
+#include <string.h>
+#include <tlb.h>
 #include <uart.h>
+#include <virtio_console.h>
 
-/** Whether to draw a test pattern to video output. */
-#define DRAW_TEST_SCREEN 1
+/** Whether to draw a test pattern to video output, instead of the console. */
+#define DRAW_TEST_SCREEN 0
+/** Whether to test the memory functions at boot. */
+#define RUN_STRING_SELF_TEST 0
+/** Whether to test the raster primitives against the scalar reference at boot. */
+#define RUN_RASTER_SELF_TEST 0
+
+/** The size of the chunks the bootloader log is replayed in. */
+#define BOOT_LOG_REPLAY_CHUNK_SIZE      128
 
 #define TEST_SCREEN_COL_NUM             4
 #define TEST_SCREEN_ROW_NUM             3
@@ -22,15 +50,77 @@
 #define TEST_SCREEN_PRIMARY_COLOUR      0x00FF40FF
 #define TEST_SCREEN_SECONDARY_COLOUR    0x00FF00CF
 
+#if DRAW_TEST_SCREEN
 /**
  * @brief Draws a test screen to the framebuffer.
  * Paints the XOR test texture to the screen.
  * Refer to: https://lodev.org/cgtutor/xortexture.html
- * @param[in] boot_info The boot information passed to the kernel. This contains
- * a pointer to the framebuffer, and the associated video mode information
- * needed to draw the test screen.
+ * @param[in,out] r The renderer to draw the test screen with.
+ */
+static void draw_test_screen(Renderer* r);
+#endif
+
+/**
+ * @brief Maps the framebuffer as write-combining.
+ * Programs the PAT and remaps the framebuffer as write-combining, reporting the
+ * memory type the firmware left it mapped with, and verifying that every page
+ * of the framebuffer was remapped.
+ * @param[in] fb The framebuffer to remap.
+ * @param[in] firmware_type The memory type the framebuffer was mapped with in
+ * the firmware's page tables, captured before they were replaced.
+ */
+static void map_framebuffer_write_combining(const Framebuffer* fb,
+	const Memory_Type firmware_type);
+
+/**
+ * @brief Replays the bootloader's log.
+ * Prints the contents of the bootloader's log ring through the kernel's own
+ * output sinks.
+ * @param[in] log_info The boot log info.
+ */
+static void replay_boot_log(const Boot_Log_Info* log_info);
+
+/**
+ * @brief Writes log output to the serial log.
+ * Writes to the virtio log console once the log has switched to it, otherwise
+ * the UART.
+ * @param[in] text The null terminated text.
+ * @param[in] length The length of the text.
+ */
+static void serial_log_sink_write(const char* text,
+	const size_t length);
+
+/**
+ * @brief Writes log output to the framebuffer console.
+ * @param[in] text The null terminated text.
+ * @param[in] length The length of the text.
  */
-static void draw_test_screen(Boot_Info* boot_info);
+static void console_log_sink_write(const char* text,
+	const size_t length);
+
+/** The serial log sink. */
+static const Log_Sink serial_log_sink = {
+	"serial",
+	serial_log_sink_write,
+	LOG_LEVEL_TRACE
+};
+
+/** The framebuffer console log sink. */
+static const Log_Sink console_log_sink = {
+	"console",
+	console_log_sink_write,
+	LOG_LEVEL_INFO
+};
+
+/** Whether the serial log has switched to the virtio log console. */
+static bool serial_log_on_virtio = false;
+
+/**
+ * @brief The boot CPU's idle hook.
+ * Records logged from interrupt handlers are drained whenever the boot CPU is
+ * woken, and the virtio consoles' partly filled buffers are submitted.
+ */
+static void kernel_idle(void);
 
 /**
  * @brief The kernel main program.
@@ -39,30 +129,128 @@ static void draw_test_screen(Boot_Info* boot_info);
 void kernel_main(Boot_Info* boot_info);
 
 
+#if DRAW_TEST_SCREEN
 /**
  * draw_test_screen
  */
-static void draw_test_screen(Boot_Info* boot_info)
+static void draw_test_screen(Renderer* r)
+{
+	raster.test_texture(r->back_buffer, r->stride, r->width, r->height, 0);
+
+	renderer_mark_dirty(r, 0, 0, r->width, r->height);
+	renderer_flush(r);
+}
+#endif
+
+
+/**
+ * serial_log_sink_write
+ */
+static void serial_log_sink_write(const char* text,
+	const size_t length)
+{
+	if(__atomic_load_n(&serial_log_on_virtio, __ATOMIC_ACQUIRE)) {
+		virtio_console_write(&virtio_log_console, text, length);
+	} else {
+		uart_port_write(&uart_log_port, text, length);
+	}
+}
+
+
+/**
+ * console_log_sink_write
+ */
+static void console_log_sink_write(const char* text,
+	const size_t length)
+{
+	(void)length;
+
+	if(console.renderer) {
+		console_write(&console, text);
+	}
+}
+
+
+/**
+ * kernel_idle
+ */
+static void kernel_idle(void)
 {
-	uint8_t c = 0;
-	uint32_t colour = 0;
-	uint16_t x = 0;
-	uint16_t y = 0;
-
-	for(y = 0; y < boot_info->video_mode_info.vertical_resolution; y++) {
-		for(x = 0; x < boot_info->video_mode_info.horizontal_resolution; x++) {
-			c = (x ^ y) % 256;
-			colour = convert_rgb_to_32bit_colour(255 - (c % 128), c, c % 128);
-
-			draw_pixel(
-				boot_info->video_mode_info.framebuffer_pointer,
-				boot_info->video_mode_info.pixels_per_scanline,
-				x,
-				y,
-				colour
-			);
+	if(log_drain() && console.renderer) {
+		console_flush(&console);
+	}
+
+	virtio_console_submit_pending(&virtio_log_console);
+	virtio_console_submit_pending(&virtio_data_console);
+}
+
+
+/**
+ * map_framebuffer_write_combining
+ */
+static void map_framebuffer_write_combining(const Framebuffer* fb,
+	const Memory_Type firmware_type)
+{
+	/** The status of remapping the framebuffer. */
+	Paging_Status status;
+	/** The number of framebuffer pages not mapped as write-combining. */
+	size_t n_mismatched = 0;
+
+	if(!pat_initialize()) {
+		LOG_WARN("Kernel: PAT unsupported, framebuffer left as mapped by firmware.\n");
+		return;
+	}
+
+	status = graphics_set_memory_type(fb, MEMORY_TYPE_WRITE_COMBINING);
+	if(status != PAGING_SUCCESS) {
+		LOG_ERROR("Kernel: Error mapping framebuffer as WC: %d\n", status);
+		return;
+	}
+
+	paging_verify_memory_type((uintptr_t)fb->base, fb->size,
+		MEMORY_TYPE_WRITE_COMBINING, &n_mismatched);
+
+	LOG_INFO("Kernel: Framebuffer at %p, 0x%lx bytes, mapped %s -> WC, "
+		"%lu pages mismapped\n", (void*)fb->base, fb->size,
+		get_memory_type_name(firmware_type), n_mismatched);
+}
+
+
+/**
+ * replay_boot_log
+ */
+static void replay_boot_log(const Boot_Log_Info* log_info)
+{
+	/** The position of the oldest byte still held in the ring. */
+	uint64_t position = 0;
+	/** The chunk of the log being printed. */
+	char chunk[BOOT_LOG_REPLAY_CHUNK_SIZE];
+	/** The length of the chunk being printed. */
+	size_t chunk_length = 0;
+
+	if(log_info->buffer == NULL || log_info->size == 0) {
+		return;
+	}
+
+	if(log_info->length > log_info->size) {
+		position = log_info->length - log_info->size;
+	}
+
+	kprintf("Kernel: Replaying bootloader log, %lu bytes, %lu lost:\n",
+		log_info->length - position, position);
+
+	for(; position < log_info->length; position++) {
+		chunk[chunk_length++] = log_info->buffer[position % log_info->size];
+
+		if(chunk_length == (BOOT_LOG_REPLAY_CHUNK_SIZE - 1)) {
+			chunk[chunk_length] = '\0';
+			kprintf("%s", chunk);
+			chunk_length = 0;
 		}
 	}
+
+	chunk[chunk_length] = '\0';
+	kprintf("%s", chunk);
 }
 
 
@@ -71,13 +259,210 @@ static void draw_test_screen(Boot_Info* boot_info)
  */
 void kernel_main(Boot_Info* boot_info)
 {
+	/** The number of static calls patched to an alternative. */
+	size_t n_patched;
+	/** The status of building the kernel's page tables. */
+	Paging_Status paging_status;
+	/** The memory type the firmware mapped the framebuffer with. */
+	Memory_Type framebuffer_firmware_type = MEMORY_TYPE_UNCACHEABLE;
+
+	// The boot CPU's descriptor tables and local data come before anything
+	// else, since logging reads the current CPU's index through GS.
+	smp_initialize_boot_cpu();
+
+	n_patched = alternatives_apply();
+
+	// Static calls are patched, and the memory functions selected, first, since
+	// the compiler may emit calls to the memory functions anywhere.
+	string_initialize();
+
 	// Initialise the UART.
 	uart_initialize();
-	uart_puts("Kernel: Initialised.\n");
+	log_register_sink(&serial_log_sink);
+	LOG_INFO("Kernel: Initialised.\n");
+	LOG_INFO("Kernel: CPU %s, SSE4.2 %s, AVX %s, AVX2 %s, AVX-512 %s, "
+		"XCR0 0x%lx, XSAVE area %u bytes.\n", cpu_features.vendor,
+		cpu_features.sse4_2 ? "yes" : "no", cpu_features.avx ? "yes" : "no",
+		cpu_features.avx2 ? "yes" : "no", cpu_features.avx512f ? "yes" : "no",
+		cpu_features.xcr0, cpu_features.xsave_area_size);
+
+	interrupts_initialize();
+	if(!uart_enable_interrupts()) {
+		LOG_ERROR("Kernel: Error enabling UART interrupts.\n");
+	}
+	enable_interrupts();
+
+	LOG_INFO("Kernel: UART log port 0x%x at %u baud.\n",
+		uart_log_port.config.base, UART_MAX_BAUD_RATE / uart_log_port.config.divisor);
+	if(uart_data_port.initialized) {
+		LOG_INFO("Kernel: UART data port 0x%x at %u baud.\n",
+			uart_data_port.config.base,
+			UART_MAX_BAUD_RATE / uart_data_port.config.divisor);
+	}
+
+	LOG_INFO("Kernel: Using %s memory functions, %lu static calls patched.\n",
+		string_operations->name, n_patched);
 
-	#if DRAW_TEST_SCREEN
-		draw_test_screen(boot_info);
+	if(!acpi_initialize(boot_info->acpi_rsdp)) {
+		LOG_WARN("Kernel: No valid ACPI tables found.\n");
+	}
+
+	// The memory topology is needed before the page allocator builds its zones.
+	if(numa_initialize()) {
+		LOG_INFO("Kernel: %u NUMA nodes, %u memory ranges, SLIT %s.\n",
+			numa.n_nodes, numa.n_memory_ranges, numa.slit_found ? "found" : "not found");
+	} else {
+		LOG_INFO("Kernel: No SRAT found, assuming a single NUMA node.\n");
+	}
+
+	if(clock_initialize()) {
+		LOG_INFO("Kernel: TSC %lu Hz, calibrated against the %s, spread %lu Hz, "
+			"invariant %s.\n", kernel_clock.tsc_frequency,
+			clock_get_reference_name(kernel_clock.reference), kernel_clock.spread,
+			kernel_clock.invariant_tsc ? "yes" : "no");
+	} else {
+		LOG_ERROR("Kernel: Error calibrating the TSC, assuming %lu Hz.\n",
+			kernel_clock.tsc_frequency);
+	}
+
+	if(!kernel_clock.invariant_tsc) {
+		LOG_WARN("Kernel: The TSC is not invariant, clock readings may drift.\n");
+	}
+
+	if(page_allocator_initialize(boot_info)) {
+		LOG_INFO("Kernel: %lu MiB free in %u regions, allocator initialised in "
+			"%lu us.\n", (uint64_t)((page_allocator.total_pages * PAGE_SIZE) >> 20),
+			page_allocator.n_regions, page_allocator.initialize_ns / 1000);
+		for(uint32_t node = 0; node < numa.n_nodes && numa.n_nodes > 1; node++) {
+			LOG_INFO("Kernel: Node %u: %lu MiB.\n", node,
+				(uint64_t)((page_allocator.node_pages[node] * PAGE_SIZE) >> 20));
+		}
+
+		slab_initialize();
+
+		// Idle CPUs keep a pool of zeroed pages filled from here on.
+		scheduler_set_idle_work(page_allocator_zero_idle);
+
+		// The framebuffer's memory type is read from the firmware's page tables
+		// while they are still active, since the kernel's own replace them.
+		paging_get_memory_type(
+			(uintptr_t)boot_info->video_mode_info.framebuffer_pointer,
+			&framebuffer_firmware_type);
+
+		// The kernel's page tables are built before the secondary CPUs start, so
+		// that they load them, and the CR4 paging features, from the trampoline.
+		paging_status = paging_initialize(boot_info);
+		if(paging_status == PAGING_SUCCESS) {
+			LOG_INFO("Kernel: Identity map %lu GiB, direct map %lu GiB, with %s "
+				"pages, %lu page tables, %lu for the direct map, built in %lu us, "
+				"PCID %s.\n", kernel_paging.identity_map_size >> 30,
+				kernel_paging.direct_map_size >> 30,
+				kernel_paging.page_size == HUGE_PAGE_SIZE ? "1GiB" : "2MiB",
+				kernel_paging.n_tables, kernel_paging.n_direct_map_tables,
+				kernel_paging.build_ns / 1000, kernel_paging.pcid ? "on" : "off");
+		} else {
+			LOG_ERROR("Kernel: Error building the kernel page tables: %d\n",
+				paging_status);
+		}
+	} else {
+		LOG_ERROR("Kernel: No free memory found in the boot memory map.\n");
+	}
+
+	if(!apic_initialize()) {
+		LOG_WARN("Kernel: Error initialising the local APIC, using the boot CPU "
+			"only.\n");
+	} else {
+		scheduler_initialize();
+		tlb_initialize();
+
+		if(!smp_initialize(boot_info->ap_trampoline)) {
+			LOG_WARN("Kernel: Not every CPU came online.\n");
+		}
+	}
+
+	LOG_INFO("Kernel: %u of %u CPUs online in %lu us.\n", smp.n_online,
+		smp.n_cpus, smp.startup_ns / 1000);
+	if(kernel_clock.tsc_sync_checked) {
+		if(kernel_clock.tsc_warp == 0) {
+			LOG_INFO("Kernel: TSCs synchronised across CPUs.\n");
+		} else {
+			LOG_WARN("Kernel: TSCs warp by up to %lu cycles across CPUs.\n",
+				kernel_clock.tsc_warp);
+		}
+	}
+
+	#if RUN_STRING_SELF_TEST
+		string_self_test();
+	#endif
+
+	if(virtio_console_initialize(&virtio_log_console, 0)) {
+		/** The notice left on the UART before the log switches. */
+		static const char notice[] =
+			"Kernel: Kernel log continues on the virtio console.\n";
+
+		virtio_console_enable_interrupts(&virtio_log_console);
+
+		// Records logged so far are drained to the UART, then the notice written
+		// after them under the output lock, before the serial sink switches to
+		// the virtio log console.
+		log_output(notice, sizeof(notice) - 1);
+		__atomic_store_n(&serial_log_on_virtio, true, __ATOMIC_RELEASE);
+
+		LOG_INFO("Kernel: Virtio log console at %02x:%02x.%x, IRQ %u.\n",
+			virtio_log_console.pci_device.bus, virtio_log_console.pci_device.device,
+			virtio_log_console.pci_device.function, virtio_log_console.irq);
+	}
+
+	if(virtio_console_initialize(&virtio_data_console, 1)) {
+		virtio_console_enable_interrupts(&virtio_data_console);
+		LOG_INFO("Kernel: Virtio data console at %02x:%02x.%x, IRQ %u.\n",
+			virtio_data_console.pci_device.bus, virtio_data_console.pci_device.device,
+			virtio_data_console.pci_device.function, virtio_data_console.irq);
+	}
+
+	raster_initialize();
+	LOG_INFO("Kernel: Using %s raster primitives.\n", raster.name);
+
+	#if RUN_RASTER_SELF_TEST
+		raster_self_test();
 	#endif
 
-	while(1);
+	if(!graphics_initialize(&boot_info->video_mode_info)) {
+		LOG_WARN("Kernel: No usable framebuffer.\n");
+	} else {
+		map_framebuffer_write_combining(&framebuffer, framebuffer_firmware_type);
+
+		if(!renderer_initialize(&framebuffer)) {
+			LOG_WARN("Kernel: Framebuffer too large for the renderer.\n");
+		}
+	}
+
+	if(renderer.back_buffer) {
+		#if DRAW_TEST_SCREEN
+			draw_test_screen(&renderer);
+		#else
+			if(console_initialize(&console, &renderer)) {
+				log_register_sink(&console_log_sink);
+				LOG_INFO("Kernel: Console %ux%u.\n", console.columns, console.rows);
+			}
+		#endif
+	}
+
+	replay_boot_log(&boot_info->log_info);
+
+	kflush();
+
+	// In benchmark mode the kernel runs every registered benchmark, then exits
+	// the emulator so that the runner can collect the results.
+	#if BENCHMARK_MODE
+		benchmark_run_all();
+		benchmark_exit_emulator();
+	#endif
+
+	// Output is written to the console in batches, so flush whatever remains.
+	if(console.renderer) {
+		console_flush(&console);
+	}
+
+	scheduler_run(kernel_idle);
 }
@@ -0,0 +1,449 @@
+/**
+ * @file log.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Kernel logging.
+ * Contains the implementation of the kernel log.
+ * Each ring holds variable length records, aligned to `LOG_RECORD_ALIGNMENT`.
+ * Writers reserve space by advancing the ring's head with a compare and swap,
+ * so a writer interrupted by another on the same CPU is safe, and publish the
+ * record by setting its committed flag. A record which would cross the end of
+ * the ring is preceded by a padding record filling the rest of the ring. The
+ * drain reads records from the tail up to the first uncommitted one. Before
+ * releasing a record's space it clears the committed flag at every aligned
+ * slot the record covered, since a later record's header may land on any of
+ * them, and must not read as committed before its writer publishes it.
+ * Writers never drain. A writer which finds its ring half full wakes an idle
+ * CPU instead, which drains the rings from the scheduler's idle hook.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cpu.h>
+#include <log.h>
+#include <printf.h>
+#include <scheduler.h>
+#include <smp.h>
+#include <string.h>
+
+/** The alignment of each record, which is also the size of its header. */
+#define LOG_RECORD_ALIGNMENT      16
+/** The level of a padding record. */
+#define LOG_RECORD_PADDING        0xFF
+
+/**
+ * @brief A log record header.
+ * The message follows the header. `size` includes the header, and padding.
+ */
+typedef struct s_log_record_header {
+	uint32_t size;
+	uint16_t length;
+	uint8_t level;
+	uint8_t committed;
+	uint64_t timestamp;
+} Log_Record_Header;
+
+/**
+ * @brief A CPU's log ring.
+ * `head` and `tail` count the bytes ever reserved in, and released from, the
+ * ring. They are kept on separate cache lines, since the head is written by
+ * the CPU that owns the ring and the tail by the CPU draining it.
+ */
+typedef struct s_log_ring {
+	uint64_t head __attribute__((aligned(64)));
+	uint64_t n_dropped;
+	uint64_t tail __attribute__((aligned(64)));
+	uint64_t n_dropped_reported;
+	uint8_t buffer[LOG_RING_SIZE] __attribute__((aligned(64)));
+} Log_Ring;
+
+/**
+ * Runtime log level.
+ * Refer to definition in log.h
+ */
+uint8_t log_level = LOG_COMPILED_LEVEL;
+
+/** The log rings. */
+static Log_Ring log_rings[LOG_MAX_CPUS];
+/** The registered sinks. */
+static const Log_Sink* sinks[LOG_MAX_SINKS];
+/** The number of registered sinks. */
+static size_t n_sinks = 0;
+/** Whether a CPU is writing to the sinks. */
+static uint8_t output_lock = 0;
+/** Whether an idle CPU has been woken to drain a filling ring. */
+static bool drain_requested = false;
+/** The batch of formatted records being drained. */
+static char drain_batch[LOG_DRAIN_BATCH_SIZE];
+/** The length of the drain batch. */
+static size_t drain_batch_length = 0;
+/** The most verbose level of the records in the drain batch. */
+static uint8_t drain_batch_level = LOG_LEVEL_ERROR;
+
+/** The names of each level, as printed by the drain. */
+static const char* const level_names[] = {
+	"ERROR",
+	"WARN",
+	"INFO",
+	"DEBUG",
+	"TRACE"
+};
+
+/**
+ * @brief Gets the index of the current CPU's log ring.
+ * CPUs beyond `LOG_MAX_CPUS` share rings, which is safe since reservation is
+ * atomic.
+ * @return The index of the current CPU's log ring.
+ */
+static inline uint32_t log_get_cpu_index(void);
+
+/**
+ * @brief Takes the output lock, with interrupts disabled.
+ * @param[in] wait Whether to wait for the lock if it is taken.
+ * @param[out] flags The saved interrupt flag, to be restored on release.
+ * @return Whether the lock was taken.
+ */
+static bool output_lock_acquire(const bool wait,
+	uint64_t* flags);
+
+/**
+ * @brief Releases the output lock.
+ * @param[in] flags The interrupt flag saved when the lock was taken.
+ */
+static void output_lock_release(const uint64_t flags);
+
+/**
+ * @brief Writes the drain batch to the sinks, and empties it.
+ * Must be called with the output lock held.
+ */
+static void flush_drain_batch(void);
+
+/**
+ * @brief Appends a formatted record to the drain batch.
+ * Must be called with the output lock held.
+ * @param[in] cpu The CPU which wrote the record.
+ * @param[in] header The record.
+ */
+static void append_record_to_batch(const uint32_t cpu,
+	const Log_Record_Header* header);
+
+
+/**
+ * log_get_cpu_index
+ */
+static inline uint32_t log_get_cpu_index(void)
+{
+	return smp_get_cpu_index() % LOG_MAX_CPUS;
+}
+
+
+/**
+ * output_lock_acquire
+ */
+static bool output_lock_acquire(const bool wait,
+	uint64_t* flags)
+{
+	*flags = save_and_disable_interrupts();
+
+	while(__atomic_exchange_n(&output_lock, 1, __ATOMIC_ACQUIRE)) {
+		if(!wait) {
+			restore_interrupts(*flags);
+			return false;
+		}
+
+		cpu_relax();
+	}
+
+	return true;
+}
+
+
+/**
+ * output_lock_release
+ */
+static void output_lock_release(const uint64_t flags)
+{
+	__atomic_store_n(&output_lock, 0, __ATOMIC_RELEASE);
+	restore_interrupts(flags);
+}
+
+
+/**
+ * log_register_sink
+ */
+bool log_register_sink(const Log_Sink* sink)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(n_sinks == LOG_MAX_SINKS) {
+		return false;
+	}
+
+	output_lock_acquire(true, &flags);
+	sinks[n_sinks++] = sink;
+	output_lock_release(flags);
+
+	return true;
+}
+
+
+/**
+ * log_write
+ */
+void log_write(const uint8_t level,
+	const char* message,
+	size_t length)
+{
+	/** The current CPU's ring. */
+	Log_Ring* ring = &log_rings[log_get_cpu_index()];
+	/** The head of the ring when the record was reserved. */
+	uint64_t head;
+	/** The size of the record. */
+	uint32_t size;
+	/** The size of the padding record needed before this one. */
+	uint32_t padding;
+	/** The offset of the record within the ring. */
+	size_t offset;
+	/** The record. */
+	Log_Record_Header* header;
+
+	if(level > log_level) {
+		return;
+	}
+
+	if(length > LOG_MAX_MESSAGE_LENGTH) {
+		length = LOG_MAX_MESSAGE_LENGTH;
+	}
+
+	size = (sizeof(Log_Record_Header) + length + LOG_RECORD_ALIGNMENT - 1) &
+		~(LOG_RECORD_ALIGNMENT - 1);
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	do {
+		offset = head & (LOG_RING_SIZE - 1);
+		padding = (offset + size > LOG_RING_SIZE) ? LOG_RING_SIZE - offset : 0;
+
+		if((head + padding + size) -
+			__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > LOG_RING_SIZE) {
+			__atomic_fetch_add(&ring->n_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	} while(!__atomic_compare_exchange_n(&ring->head, &head,
+		head + padding + size, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	if(padding) {
+		header = (Log_Record_Header*)&ring->buffer[offset];
+		header->size = padding;
+		header->length = 0;
+		header->level = LOG_RECORD_PADDING;
+		__atomic_store_n(&header->committed, 1, __ATOMIC_RELEASE);
+
+		offset = 0;
+	}
+
+	header = (Log_Record_Header*)&ring->buffer[offset];
+	header->size = size;
+	header->length = length;
+	header->level = level;
+	header->timestamp = read_timestamp_counter();
+
+	memcpy(header + 1, message, length);
+
+	__atomic_store_n(&header->committed, 1, __ATOMIC_RELEASE);
+
+	// Once the ring is half full, an idle CPU is woken to drain it, rather
+	// than risk dropping records before the next drain. The writer never
+	// drains itself, since it may be an interrupt handler.
+	if((head + padding + size) - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED) >
+		(LOG_RING_SIZE / 2) &&
+		!__atomic_exchange_n(&drain_requested, true, __ATOMIC_RELAXED)) {
+		scheduler_wake_idle_cpu();
+	}
+}
+
+
+/**
+ * log_printf
+ */
+void log_printf(const uint8_t level,
+	const char* format,
+	...)
+{
+	/** The variadic argument list. */
+	va_list args;
+	/** The formatted message. */
+	char message[LOG_MAX_MESSAGE_LENGTH + 1];
+	/** The length of the formatted message. */
+	size_t length;
+
+	if(level > log_level) {
+		return;
+	}
+
+	va_start(args, format);
+	length = kvsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	log_write(level, message, length);
+}
+
+
+/**
+ * flush_drain_batch
+ */
+static void flush_drain_batch(void)
+{
+	if(drain_batch_length == 0) {
+		return;
+	}
+
+	drain_batch[drain_batch_length] = '\0';
+
+	for(size_t i = 0; i < n_sinks; i++) {
+		if(drain_batch_level <= sinks[i]->max_level) {
+			sinks[i]->write(drain_batch, drain_batch_length);
+		}
+	}
+
+	drain_batch_length = 0;
+	drain_batch_level = LOG_LEVEL_ERROR;
+}
+
+
+/**
+ * append_record_to_batch
+ */
+static void append_record_to_batch(const uint32_t cpu,
+	const Log_Record_Header* header)
+{
+	/** The record's message. */
+	const char* message = (const char*)(header + 1);
+	/** The size of the formatted record, without the message. */
+	size_t prefix_length;
+
+	// A batch only holds records of one level, so that each sink can be given
+	// only the levels it wants.
+	if(drain_batch_length > 0 && header->level != drain_batch_level) {
+		flush_drain_batch();
+	}
+
+	// Leave room for the prefix, the message, a newline, and the terminator.
+	if(drain_batch_length + 48 + header->length + 2 > LOG_DRAIN_BATCH_SIZE) {
+		flush_drain_batch();
+	}
+
+	drain_batch_level = header->level;
+
+	prefix_length = ksnprintf(drain_batch + drain_batch_length,
+		LOG_DRAIN_BATCH_SIZE - drain_batch_length, "[%016lx] %u %s: ",
+		header->timestamp, cpu, level_names[header->level]);
+	drain_batch_length += prefix_length;
+
+	memcpy(drain_batch + drain_batch_length, message, header->length);
+	drain_batch_length += header->length;
+
+	if(header->length == 0 || message[header->length - 1] != '\n') {
+		drain_batch[drain_batch_length++] = '\n';
+	}
+}
+
+
+/**
+ * log_drain
+ */
+bool log_drain(void)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+	/** The current ring. */
+	Log_Ring* ring;
+	/** The current record. */
+	Log_Record_Header* header;
+	/** The position of the current record. */
+	uint64_t tail;
+	/** The offset of the current record within the ring. */
+	size_t offset;
+	/** The number of records dropped from the current ring. */
+	uint64_t n_dropped;
+	/** The drop notice. */
+	char notice[64];
+	/** The length of the drop notice. */
+	size_t notice_length;
+
+	if(!output_lock_acquire(false, &flags)) {
+		return false;
+	}
+
+	// Cleared before draining, so that a ring filling again meanwhile asks
+	// for another drain.
+	__atomic_store_n(&drain_requested, false, __ATOMIC_RELAXED);
+
+	for(uint32_t cpu = 0; cpu < LOG_MAX_CPUS; cpu++) {
+		ring = &log_rings[cpu];
+		tail = ring->tail;
+
+		while(tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+			offset = tail & (LOG_RING_SIZE - 1);
+			header = (Log_Record_Header*)&ring->buffer[offset];
+			if(!__atomic_load_n(&header->committed, __ATOMIC_ACQUIRE)) {
+				break;
+			}
+
+			if(header->level != LOG_RECORD_PADDING) {
+				append_record_to_batch(cpu, header);
+			}
+
+			// Records never cross the end of the ring, so neither do their slots.
+			tail += header->size;
+			for(size_t slot = offset; slot < offset + header->size;
+				slot += LOG_RECORD_ALIGNMENT) {
+				((Log_Record_Header*)&ring->buffer[slot])->committed = 0;
+			}
+
+			__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+		}
+
+		n_dropped = __atomic_load_n(&ring->n_dropped, __ATOMIC_RELAXED);
+		if(n_dropped != ring->n_dropped_reported) {
+			flush_drain_batch();
+
+			notice_length = ksnprintf(notice, sizeof(notice),
+				"Log: %lu records dropped on CPU %u\n",
+				n_dropped - ring->n_dropped_reported, cpu);
+			for(size_t i = 0; i < n_sinks; i++) {
+				sinks[i]->write(notice, notice_length);
+			}
+
+			ring->n_dropped_reported = n_dropped;
+		}
+	}
+
+	flush_drain_batch();
+	output_lock_release(flags);
+
+	return true;
+}
+
+
+/**
+ * log_output
+ */
+void log_output(const char* text,
+	const size_t length)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	log_drain();
+
+	output_lock_acquire(true, &flags);
+
+	for(size_t i = 0; i < n_sinks; i++) {
+		sinks[i]->write(text, length);
+	}
+
+	output_lock_release(flags);
+}
@@ -0,0 +1,465 @@
+/**
+ * @file numa.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief NUMA topology.
+ * Contains the implementation of NUMA topology discovery, and the benchmark
+ * comparing node-local and remote memory.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <acpi.h>
+#include <apic.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <numa.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <smp.h>
+
+/** The number of blocks allocated at once by each benchmark round. */
+#define NUMA_BENCHMARK_BATCH          8
+/** The number of rounds of the allocation benchmark. */
+#define NUMA_BENCHMARK_ROUNDS         4096
+/** The number of passes over the block read by the read benchmark. */
+#define NUMA_BENCHMARK_READ_PASSES    64
+
+/**
+ * Refer to definition in numa.h
+ */
+Numa numa = {
+	.n_nodes = 1,
+	.n_memory_ranges = 0,
+	.n_cpus = 0,
+	.srat_found = false,
+	.slit_found = false
+};
+
+/**
+ * @brief Gets the node of a proximity domain, adding one if needed.
+ * @param[in] proximity_domain The proximity domain.
+ * @return The node.
+ */
+static uint32_t get_domain_node(const uint32_t proximity_domain);
+
+/**
+ * @brief Records the node of a processor listed in the SRAT.
+ * @param[in] apic_id The processor's APIC ID.
+ * @param[in] proximity_domain The processor's proximity domain.
+ */
+static void add_cpu(const uint32_t apic_id,
+	const uint32_t proximity_domain);
+
+/**
+ * @brief Records a memory range listed in the SRAT.
+ * Keeps the ranges sorted by address.
+ * @param[in] start The start of the range.
+ * @param[in] length The length of the range in bytes.
+ * @param[in] proximity_domain The range's proximity domain.
+ */
+static void add_memory_range(const uintptr_t start,
+	const uint64_t length,
+	const uint32_t proximity_domain);
+
+/**
+ * @brief Reads the processor and memory affinity entries of the SRAT.
+ * @return Whether a SRAT was found.
+ */
+static bool parse_srat(void);
+
+/**
+ * @brief Reads the node distances from the SLIT.
+ * Nodes whose proximity domain the SLIT does not cover keep the default
+ * distances.
+ * @return Whether a SLIT was found.
+ */
+static bool parse_slit(void);
+
+/**
+ * @brief Fills each node's fallback list from the distances.
+ */
+static void build_fallback_lists(void);
+
+/**
+ * @brief Runs the NUMA benchmarks.
+ * Measures allocating and freeing order 0 blocks, and reading a 2MiB block,
+ * on the current CPU's node and on every other node. Blocks are allocated
+ * from, and freed to, each node's zone directly, so that local and remote
+ * nodes are measured on the same path.
+ */
+static void numa_run_benchmark(void);
+
+BENCHMARK(numa, numa_run_benchmark);
+
+
+/**
+ * get_domain_node
+ */
+static uint32_t get_domain_node(const uint32_t proximity_domain)
+{
+	for(uint32_t node = 0; node < numa.n_nodes; node++) {
+		if(numa.proximity_domains[node] == proximity_domain) {
+			return node;
+		}
+	}
+
+	if(numa.n_nodes == NUMA_MAX_NODES) {
+		return 0;
+	}
+
+	numa.proximity_domains[numa.n_nodes] = proximity_domain;
+
+	return numa.n_nodes++;
+}
+
+
+/**
+ * add_cpu
+ */
+static void add_cpu(const uint32_t apic_id,
+	const uint32_t proximity_domain)
+{
+	if(numa.n_cpus == NUMA_MAX_CPUS) {
+		return;
+	}
+
+	numa.cpus[numa.n_cpus].apic_id = apic_id;
+	numa.cpus[numa.n_cpus].node = get_domain_node(proximity_domain);
+	numa.n_cpus++;
+}
+
+
+/**
+ * add_memory_range
+ */
+static void add_memory_range(const uintptr_t start,
+	const uint64_t length,
+	const uint32_t proximity_domain)
+{
+	/** The position the range is inserted at. */
+	uint32_t position = numa.n_memory_ranges;
+
+	if(length == 0 || numa.n_memory_ranges == NUMA_MAX_MEMORY_RANGES) {
+		return;
+	}
+
+	while(position > 0 && numa.memory_ranges[position - 1].start > start) {
+		numa.memory_ranges[position] = numa.memory_ranges[position - 1];
+		position--;
+	}
+
+	numa.memory_ranges[position].start = start;
+	numa.memory_ranges[position].end = start + length;
+	numa.memory_ranges[position].node = get_domain_node(proximity_domain);
+	numa.n_memory_ranges++;
+}
+
+
+/**
+ * parse_srat
+ */
+static bool parse_srat(void)
+{
+	/** The SRAT. */
+	const Acpi_Srat* srat = (const Acpi_Srat*)acpi_find_table(ACPI_SRAT_SIGNATURE, 0);
+	/** The current entry. */
+	const uint8_t* entry;
+	/** The end of the table. */
+	const uint8_t* end;
+
+	if(srat == NULL) {
+		return false;
+	}
+
+	entry = (const uint8_t*)(srat + 1);
+	end = (const uint8_t*)srat + srat->header.length;
+
+	// Nodes are numbered as their proximity domains are found.
+	numa.n_nodes = 0;
+
+	while(entry + sizeof(Acpi_Srat_Entry) <= end) {
+		/** The current entry's header. */
+		const Acpi_Srat_Entry* header = (const Acpi_Srat_Entry*)entry;
+
+		if(header->length < sizeof(Acpi_Srat_Entry) || entry + header->length > end) {
+			break;
+		}
+
+		if(header->type == ACPI_SRAT_TYPE_PROCESSOR_AFFINITY &&
+			header->length >= sizeof(Acpi_Srat_Processor_Affinity)) {
+			/** The processor affinity entry. */
+			const Acpi_Srat_Processor_Affinity* processor =
+				(const Acpi_Srat_Processor_Affinity*)entry;
+			/** The processor's proximity domain. */
+			uint32_t proximity_domain = processor->proximity_domain_low;
+
+			if(srat->header.revision >= 2) {
+				proximity_domain |= (uint32_t)processor->proximity_domain_high[0] << 8;
+				proximity_domain |= (uint32_t)processor->proximity_domain_high[1] << 16;
+				proximity_domain |= (uint32_t)processor->proximity_domain_high[2] << 24;
+			}
+
+			if(processor->flags & ACPI_SRAT_ENABLED) {
+				add_cpu(processor->apic_id, proximity_domain);
+			}
+		} else if(header->type == ACPI_SRAT_TYPE_X2APIC_AFFINITY &&
+			header->length >= sizeof(Acpi_Srat_X2apic_Affinity)) {
+			/** The x2APIC affinity entry. */
+			const Acpi_Srat_X2apic_Affinity* processor =
+				(const Acpi_Srat_X2apic_Affinity*)entry;
+
+			if(processor->flags & ACPI_SRAT_ENABLED) {
+				add_cpu(processor->x2apic_id, processor->proximity_domain);
+			}
+		} else if(header->type == ACPI_SRAT_TYPE_MEMORY_AFFINITY &&
+			header->length >= sizeof(Acpi_Srat_Memory_Affinity)) {
+			/** The memory affinity entry. */
+			const Acpi_Srat_Memory_Affinity* memory =
+				(const Acpi_Srat_Memory_Affinity*)entry;
+
+			if(memory->flags & ACPI_SRAT_ENABLED) {
+				add_memory_range(memory->base_address, memory->length,
+					memory->proximity_domain);
+			}
+		}
+
+		entry += header->length;
+	}
+
+	if(numa.n_nodes == 0) {
+		numa.n_nodes = 1;
+	}
+
+	return true;
+}
+
+
+/**
+ * parse_slit
+ */
+static bool parse_slit(void)
+{
+	/** The SLIT. */
+	const Acpi_Slit* slit = (const Acpi_Slit*)acpi_find_table(ACPI_SLIT_SIGNATURE, 0);
+	/** The distance matrix. */
+	const uint8_t* matrix;
+	/** The number of localities in the matrix. */
+	uint64_t n_localities;
+
+	if(slit == NULL) {
+		return false;
+	}
+
+	n_localities = slit->n_localities;
+	matrix = (const uint8_t*)(slit + 1);
+
+	// Rejects matrices running past the end of the table.
+	if(n_localities > 0xFFFF || (sizeof(Acpi_Slit) + (n_localities * n_localities)) >
+		slit->header.length) {
+		return false;
+	}
+
+	for(uint32_t from = 0; from < numa.n_nodes; from++) {
+		for(uint32_t to = 0; to < numa.n_nodes; to++) {
+			/** The proximity domain of the node measured from. */
+			const uint64_t from_domain = numa.proximity_domains[from];
+			/** The proximity domain of the node measured to. */
+			const uint64_t to_domain = numa.proximity_domains[to];
+
+			if(from_domain < n_localities && to_domain < n_localities) {
+				numa.distances[from][to] = matrix[(from_domain * n_localities) + to_domain];
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * build_fallback_lists
+ */
+static void build_fallback_lists(void)
+{
+	for(uint32_t node = 0; node < numa.n_nodes; node++) {
+		/** The node's fallback list. */
+		uint32_t* fallback = numa.fallback[node];
+
+		fallback[0] = node;
+		for(uint32_t other = 0, n_listed = 1; other < numa.n_nodes; other++) {
+			/** The position the node is inserted at. */
+			uint32_t position = n_listed;
+
+			if(other == node) {
+				continue;
+			}
+
+			while(position > 1 && numa.distances[node][fallback[position - 1]] >
+				numa.distances[node][other]) {
+				fallback[position] = fallback[position - 1];
+				position--;
+			}
+
+			fallback[position] = other;
+			n_listed++;
+		}
+	}
+}
+
+
+/**
+ * numa_initialize
+ */
+bool numa_initialize(void)
+{
+	for(uint32_t from = 0; from < NUMA_MAX_NODES; from++) {
+		for(uint32_t to = 0; to < NUMA_MAX_NODES; to++) {
+			numa.distances[from][to] = (from == to) ? NUMA_LOCAL_DISTANCE :
+				NUMA_REMOTE_DISTANCE;
+		}
+	}
+
+	numa.srat_found = parse_srat();
+	if(numa.srat_found) {
+		numa.slit_found = parse_slit();
+	}
+
+	build_fallback_lists();
+
+	cpu_locals[0].node = numa_get_cpu_node(apic_get_initial_id());
+
+	return numa.srat_found;
+}
+
+
+/**
+ * numa_get_cpu_node
+ */
+uint32_t numa_get_cpu_node(const uint32_t apic_id)
+{
+	for(uint32_t i = 0; i < numa.n_cpus; i++) {
+		if(numa.cpus[i].apic_id == apic_id) {
+			return numa.cpus[i].node;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * numa_get_memory_node
+ */
+uint32_t numa_get_memory_node(const uintptr_t address,
+	uintptr_t* end)
+{
+	for(uint32_t i = 0; i < numa.n_memory_ranges; i++) {
+		/** The range being compared. */
+		const Numa_Memory_Range* range = &numa.memory_ranges[i];
+
+		if(address < range->start) {
+			*end = range->start;
+			return 0;
+		}
+
+		if(address < range->end) {
+			*end = range->end;
+			return range->node;
+		}
+	}
+
+	*end = UINTPTR_MAX;
+
+	return 0;
+}
+
+
+/**
+ * numa_run_benchmark
+ */
+static void numa_run_benchmark(void)
+{
+	/** The current CPU's node. */
+	const uint32_t local_node = smp_get_cpu_node();
+	/** The blocks allocated in the current round. */
+	uintptr_t blocks[NUMA_BENCHMARK_BATCH];
+
+	if(numa.n_nodes < 2) {
+		benchmark_skip("numa", "single_node");
+		return;
+	}
+
+	for(uint32_t node = 0; node < numa.n_nodes; node++) {
+		/** The variant, by whether the node is the current CPU's. */
+		const char* variant = (node == local_node) ? "local" : "remote";
+		/** The block read by the read benchmark. */
+		uintptr_t block;
+		/** The number of allocations which failed. */
+		uint64_t failures = 0;
+		/** The timestamp at the start of the measurement. */
+		uint64_t start;
+		/** The cycles taken by the measurement. */
+		uint64_t cycles;
+		/** The sum of the words read. */
+		uint64_t sum = 0;
+
+		start = read_timestamp_counter();
+		for(size_t round = 0; round < NUMA_BENCHMARK_ROUNDS; round++) {
+			for(size_t i = 0; i < NUMA_BENCHMARK_BATCH; i++) {
+				blocks[i] = page_allocator_alloc_node(0, node);
+				if(blocks[i] == 0) {
+					failures++;
+					continue;
+				}
+
+				// Each page is touched, so that its memory's distance shows.
+				*(volatile uint64_t*)blocks[i] = round;
+			}
+
+			for(size_t i = 0; i < NUMA_BENCHMARK_BATCH; i++) {
+				page_allocator_free_node(blocks[i], 0);
+			}
+		}
+		cycles = read_timestamp_counter() - start;
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "numa", .name = "alloc_free_4k", .variant = variant,
+			.size = PAGE_SIZE,
+			.operations = NUMA_BENCHMARK_ROUNDS * NUMA_BENCHMARK_BATCH,
+			.cycles = cycles,
+			.counters = {
+				{ "distance", numa.distances[local_node][node] },
+				{ "failures", failures }
+			}
+		});
+
+		block = page_allocator_alloc_node(PAGE_ALLOCATOR_LARGE_ORDER, node);
+		if(block == 0) {
+			benchmark_skip("numa", "no_free_memory_on_node");
+			continue;
+		}
+
+		start = read_timestamp_counter();
+		for(size_t pass = 0; pass < NUMA_BENCHMARK_READ_PASSES; pass++) {
+			for(size_t offset = 0; offset < LARGE_PAGE_SIZE; offset += 64) {
+				sum += *(volatile uint64_t*)(block + offset);
+			}
+		}
+		cycles = read_timestamp_counter() - start;
+
+		(void)sum;
+
+		page_allocator_free_node(block, PAGE_ALLOCATOR_LARGE_ORDER);
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "numa", .name = "read_2m", .variant = variant,
+			.size = LARGE_PAGE_SIZE,
+			.operations = NUMA_BENCHMARK_READ_PASSES * (LARGE_PAGE_SIZE / 64),
+			.cycles = cycles,
+			.bytes = NUMA_BENCHMARK_READ_PASSES * LARGE_PAGE_SIZE,
+			.counters = { { "distance", numa.distances[local_node][node] } }
+		});
+	}
+}
@@ -0,0 +1,1250 @@
+/**
+ * @file page_allocator.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Physical page allocator.
+ * Contains the implementation of the buddy allocator and the per-CPU page
+ * caches. A block is free at a given order only while its header holds the
+ * tag for its address and order. The tag is cleared as soon as the block is
+ * allocated or merged, so that a buddy's state can be read from its header.
+ * Blocks only merge with buddies in the same region, so headers are never
+ * read outside managed memory.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <boot.h>
+#include <clock.h>
+#include <cpu.h>
+#include <numa.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <scheduler.h>
+#include <simd.h>
+#include <smp.h>
+#include <spinlock.h>
+#include <string.h>
+
+/** The tag marking a free block, combined with its address and order. */
+#define FREE_BLOCK_TAG                     0x46524545424C4B00ULL
+
+/** The number of blocks allocated at once by each benchmark round. */
+#define PAGE_ALLOCATOR_BENCHMARK_BATCH     8
+/** The number of rounds run by each benchmark. */
+#define PAGE_ALLOCATOR_BENCHMARK_ROUNDS    4096
+/** The number of loop parts per CPU in the parallel benchmarks. */
+#define PAGE_ALLOCATOR_BENCHMARK_SPLIT     4
+/** How long to wait for the zeroed page pool to fill, in nanoseconds. */
+#define PAGE_ALLOCATOR_BENCHMARK_FILL_NS   100000000ULL
+
+/**
+ * @brief The header of a free block.
+ */
+typedef struct s_free_block {
+	uint64_t tag;
+	struct s_free_block* next;
+	struct s_free_block* prev;
+} Free_Block;
+
+/**
+ * @brief A region of managed memory.
+ * `end` is the address past the end of the region. Each region lies on a
+ * single node.
+ */
+typedef struct s_memory_region {
+	uintptr_t start;
+	uintptr_t end;
+	uint32_t node;
+} Memory_Region;
+
+/**
+ * @brief A node's zone of free memory.
+ * Free lists are circular, with a sentinel block for each order.
+ * `free_list_mask` has a bit set for each order whose free list is not empty.
+ */
+typedef struct s_page_zone {
+	Spinlock lock;
+	uint32_t free_list_mask;
+	uint64_t free_pages;
+	Free_Block free_lists[PAGE_ALLOCATOR_ORDERS];
+} __attribute__((aligned(64))) Page_Zone;
+
+/**
+ * @brief A CPU's cache of free blocks of one order.
+ */
+typedef struct s_page_cache {
+	uint32_t count;
+	uint32_t size;
+	uint32_t batch;
+	uintptr_t pages[PAGE_ALLOCATOR_CACHE_SIZE];
+} Page_Cache;
+
+/**
+ * @brief A CPU's page caches.
+ * `zeroing` is the 2MiB page the CPU is zeroing in the background, if any, of
+ * which the first `zeroed` bytes are done.
+ */
+typedef struct s_page_allocator_cpu {
+	Page_Cache small;
+	Page_Cache large;
+	uintptr_t zeroing;
+	uint64_t zeroed;
+} __attribute__((aligned(64))) Page_Allocator_Cpu;
+
+/**
+ * @brief A pool of zeroed blocks of one order.
+ * The blocks are listed through their first word, which is cleared again as
+ * each block is taken. `n_filling` is the number of blocks being zeroed.
+ */
+typedef struct s_zero_pool {
+	Spinlock lock;
+	uint32_t order;
+	uint32_t size;
+	uint32_t count;
+	uint32_t n_filling;
+	uintptr_t head;
+} Zero_Pool;
+
+/**
+ * @brief The configuration of a page allocator benchmark.
+ */
+typedef struct s_page_allocator_benchmark {
+	uint32_t order;
+	bool cached;
+	uint64_t failures;
+} Page_Allocator_Benchmark;
+
+/**
+ * Refer to definition in page_allocator.h
+ */
+Page_Allocator page_allocator = {
+	.total_pages = 0,
+	.free_pages = 0,
+	.initialize_ns = 0,
+	.n_regions = 0
+};
+
+/** The zone of each node. */
+static Page_Zone zones[NUMA_MAX_NODES];
+/** The regions of managed memory, sorted by address. */
+static Memory_Region regions[PAGE_ALLOCATOR_MAX_REGIONS];
+/** The page caches of each CPU. */
+static Page_Allocator_Cpu page_allocator_cpus[SMP_MAX_CPUS];
+/** The zeroed page pools of each node, for order 0 and 2MiB blocks. */
+static Zero_Pool zero_pools[NUMA_MAX_NODES][2];
+/** The zeroed page pool statistics. */
+static Page_Allocator_Zero_Stats zero_stats;
+/** Whether an idle CPU has been woken to refill the zeroed page pools. */
+static bool zero_pool_refill_requested = false;
+
+/**
+ * @brief Gets the tag of a free block.
+ * @param[in] address The block's address.
+ * @param[in] order The block's order.
+ * @return The tag.
+ */
+static inline uint64_t get_block_tag(const uintptr_t address,
+	const uint32_t order);
+
+/**
+ * @brief Adds a block to its free list.
+ * Must be called with the zone locked.
+ * @param[in,out] zone The zone.
+ * @param[in] address The block's address.
+ * @param[in] order The block's order.
+ */
+static void push_block(Page_Zone* zone,
+	const uintptr_t address,
+	const uint32_t order);
+
+/**
+ * @brief Removes a block from its free list.
+ * Must be called with the zone locked.
+ * @param[in,out] zone The zone.
+ * @param[in,out] block The block.
+ * @param[in] order The block's order.
+ */
+static void remove_block(Page_Zone* zone,
+	Free_Block* block,
+	const uint32_t order);
+
+/**
+ * @brief Finds the region containing an address.
+ * @param[in] address The address.
+ * @return The region, or NULL if the address is not managed.
+ */
+static const Memory_Region* find_region(const uintptr_t address);
+
+/**
+ * @brief Allocates a block from a zone's free lists.
+ * Splits the smallest free block large enough. Must be called with the zone
+ * locked.
+ * @param[in,out] zone The zone.
+ * @param[in] order The block's order.
+ * @return The block's address, or zero if there is none.
+ */
+static uintptr_t buddy_alloc(Page_Zone* zone,
+	const uint32_t order);
+
+/**
+ * @brief Frees a block to its zone's free lists.
+ * Merges the block with its buddy for as long as the buddy is free. Must be
+ * called with the region's zone locked.
+ * @param[in] region The region the block belongs to.
+ * @param[in] address The block's address.
+ * @param[in] order The block's order.
+ */
+static void buddy_free(const Memory_Region* region,
+	uintptr_t address,
+	uint32_t order);
+
+/**
+ * @brief Allocates a block from a node's zone, taking the zone's lock.
+ * @param[in] node The node.
+ * @param[in] order The block's order.
+ * @return The block's address, or zero if the zone has none.
+ */
+static uintptr_t zone_alloc(const uint32_t node,
+	const uint32_t order);
+
+/**
+ * @brief Frees a block to its zone, taking the zone's lock.
+ * @param[in] address The block's address.
+ * @param[in] order The block's order.
+ */
+static void zone_free(const uintptr_t address,
+	const uint32_t order);
+
+/**
+ * @brief Allocates a block from the nearest zone which has one.
+ * @param[in] node The node to start from.
+ * @param[in] order The block's order.
+ * @return The block's address, or zero if no zone has one.
+ */
+static uintptr_t alloc_from_nearest_zone(const uint32_t node,
+	const uint32_t order);
+
+/**
+ * @brief Gets the current CPU's cache for an order.
+ * @param[in] order The order.
+ * @return The cache, or NULL if blocks of this order are not cached.
+ */
+static Page_Cache* get_cache(const uint32_t order);
+
+/**
+ * @brief Gets the current CPU's node's zeroed page pool for an order.
+ * @param[in] order The order.
+ * @return The pool, or NULL if blocks of this order are not pooled.
+ */
+static Zero_Pool* get_zero_pool(const uint32_t order);
+
+/**
+ * @brief Zeroes memory with non-temporal stores.
+ * The stores bypass the cache, so that background zeroing does not evict the
+ * working set of whichever task runs next.
+ * @param[out] address The start of the memory, aligned to 64 bytes.
+ * @param[in] size The size in bytes, a multiple of 64.
+ */
+static void zero_non_temporal(const uintptr_t address,
+	const size_t size);
+
+/**
+ * @brief Adds a zeroed block to a pool.
+ * Frees the block instead if the pool is full.
+ * @param[in,out] pool The pool.
+ * @param[in] address The block's address.
+ */
+static void push_zeroed_block(Zero_Pool* pool,
+	const uintptr_t address);
+
+/**
+ * @brief Adds a region of free memory.
+ * Keeps the regions sorted, merging the region with its neighbours if they
+ * are adjacent and on the same node. The memory map is usually sorted
+ * already, so this rarely moves any regions.
+ * @param[in] start The region's start address.
+ * @param[in] end The address past the end of the region.
+ * @param[in] node The node the region is on.
+ * @return Whether the region was added. This fails if there are too many
+ * regions.
+ */
+static bool add_region(uintptr_t start,
+	uintptr_t end,
+	const uint32_t node);
+
+/**
+ * @brief Adds a region's memory to the free lists.
+ * Covers the region with the largest naturally aligned blocks which fit, so
+ * this takes at most two blocks per order.
+ * @param[in] region The region.
+ */
+static void free_region(const Memory_Region* region);
+
+/**
+ * @brief Allocates and frees blocks, for the page allocator benchmarks.
+ * @param[in] begin The first round.
+ * @param[in] end The round past the last.
+ * @param[in,out] argument The `Page_Allocator_Benchmark`.
+ */
+static void benchmark_alloc_free(const size_t begin,
+	const size_t end,
+	void* argument);
+
+/**
+ * @brief Runs the zeroed page pool benchmarks.
+ * Measures allocating zeroed order 0 and 2MiB blocks, zeroing them
+ * synchronously, and taking them from a full pool.
+ */
+static void benchmark_alloc_zeroed(void);
+
+/**
+ * @brief Runs the page allocator benchmarks.
+ * Measures allocating and freeing order 0 and 2MiB blocks, through the
+ * per-CPU caches and straight from the locked free lists, on one CPU and on
+ * every CPU at once, then the zeroed page pool.
+ */
+static void page_allocator_run_benchmark(void);
+
+BENCHMARK(page_allocator, page_allocator_run_benchmark);
+
+
+/**
+ * get_block_tag
+ */
+static inline uint64_t get_block_tag(const uintptr_t address,
+	const uint32_t order)
+{
+	return FREE_BLOCK_TAG ^ address ^ order;
+}
+
+
+/**
+ * push_block
+ */
+static void push_block(Page_Zone* zone,
+	const uintptr_t address,
+	const uint32_t order)
+{
+	/** The block. */
+	Free_Block* block = (Free_Block*)address;
+	/** The free list sentinel. */
+	Free_Block* list = &zone->free_lists[order];
+
+	block->tag = get_block_tag(address, order);
+	block->prev = list;
+	block->next = list->next;
+	list->next->prev = block;
+	list->next = block;
+
+	zone->free_list_mask |= 1U << order;
+	zone->free_pages += 1ULL << order;
+	__atomic_add_fetch(&page_allocator.free_pages, 1ULL << order, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * remove_block
+ */
+static void remove_block(Page_Zone* zone,
+	Free_Block* block,
+	const uint32_t order)
+{
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+	block->tag = 0;
+
+	if(zone->free_lists[order].next == &zone->free_lists[order]) {
+		zone->free_list_mask &= ~(1U << order);
+	}
+
+	zone->free_pages -= 1ULL << order;
+	__atomic_sub_fetch(&page_allocator.free_pages, 1ULL << order, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * find_region
+ */
+static const Memory_Region* find_region(const uintptr_t address)
+{
+	/** The first region which may contain the address. */
+	uint32_t low = 0;
+	/** The region past the last which may contain the address. */
+	uint32_t high = page_allocator.n_regions;
+
+	while(low < high) {
+		/** The region being compared. */
+		const uint32_t middle = low + ((high - low) / 2);
+
+		if(address < regions[middle].start) {
+			high = middle;
+		} else if(address >= regions[middle].end) {
+			low = middle + 1;
+		} else {
+			return &regions[middle];
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * buddy_alloc
+ */
+static uintptr_t buddy_alloc(Page_Zone* zone,
+	const uint32_t order)
+{
+	/** The orders with free blocks large enough. */
+	const uint32_t available = zone->free_list_mask >> order;
+	/** The order of the block being split. */
+	uint32_t block_order;
+	/** The block's address. */
+	uintptr_t address;
+
+	if(available == 0) {
+		return 0;
+	}
+
+	block_order = order + (uint32_t)__builtin_ctz(available);
+	address = (uintptr_t)zone->free_lists[block_order].next;
+	remove_block(zone, (Free_Block*)address, block_order);
+
+	// The upper half of each split is returned to the free lists.
+	while(block_order > order) {
+		block_order--;
+		push_block(zone, address + (PAGE_SIZE << block_order), block_order);
+	}
+
+	return address;
+}
+
+
+/**
+ * buddy_free
+ */
+static void buddy_free(const Memory_Region* region,
+	uintptr_t address,
+	uint32_t order)
+{
+	/** The region's zone. */
+	Page_Zone* zone = &zones[region->node];
+
+	while(order < (PAGE_ALLOCATOR_ORDERS - 1)) {
+		/** The size of the block. */
+		const uintptr_t size = PAGE_SIZE << order;
+		/** The address of the block's buddy. */
+		const uintptr_t buddy = address ^ size;
+
+		if(buddy < region->start || (buddy + size) > region->end ||
+			((Free_Block*)buddy)->tag != get_block_tag(buddy, order)) {
+			break;
+		}
+
+		remove_block(zone, (Free_Block*)buddy, order);
+		address &= ~size;
+		order++;
+	}
+
+	push_block(zone, address, order);
+}
+
+
+/**
+ * zone_alloc
+ */
+static uintptr_t zone_alloc(const uint32_t node,
+	const uint32_t order)
+{
+	/** The node's zone. */
+	Page_Zone* zone = &zones[node];
+	/** The saved interrupt flag. */
+	const uint64_t flags = spinlock_acquire_irqsave(&zone->lock);
+	/** The allocated block's address. */
+	const uintptr_t address = buddy_alloc(zone, order);
+
+	spinlock_release_irqrestore(&zone->lock, flags);
+
+	return address;
+}
+
+
+/**
+ * zone_free
+ */
+static void zone_free(const uintptr_t address,
+	const uint32_t order)
+{
+	/** The region the block belongs to. */
+	const Memory_Region* region = find_region(address);
+	/** The region's zone. */
+	Page_Zone* zone;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(region == NULL) {
+		return;
+	}
+
+	zone = &zones[region->node];
+	flags = spinlock_acquire_irqsave(&zone->lock);
+	buddy_free(region, address, order);
+	spinlock_release_irqrestore(&zone->lock, flags);
+}
+
+
+/**
+ * alloc_from_nearest_zone
+ */
+static uintptr_t alloc_from_nearest_zone(const uint32_t node,
+	const uint32_t order)
+{
+	/** The allocated block's address. */
+	uintptr_t address = 0;
+
+	for(uint32_t i = 0; i < numa.n_nodes && address == 0; i++) {
+		address = zone_alloc(numa.fallback[node][i], order);
+	}
+
+	return address;
+}
+
+
+/**
+ * get_cache
+ */
+static Page_Cache* get_cache(const uint32_t order)
+{
+	/** The current CPU's caches. */
+	Page_Allocator_Cpu* cpu = &page_allocator_cpus[smp_get_cpu_index()];
+
+	if(order == 0) {
+		return &cpu->small;
+	} else if(order == PAGE_ALLOCATOR_LARGE_ORDER) {
+		return &cpu->large;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * get_zero_pool
+ */
+static Zero_Pool* get_zero_pool(const uint32_t order)
+{
+	if(order == 0) {
+		return &zero_pools[smp_get_cpu_node()][0];
+	} else if(order == PAGE_ALLOCATOR_LARGE_ORDER) {
+		return &zero_pools[smp_get_cpu_node()][1];
+	}
+
+	return NULL;
+}
+
+
+/**
+ * zero_non_temporal
+ */
+static void zero_non_temporal(const uintptr_t address,
+	const size_t size)
+{
+	/** The value stored. */
+	const v4u32 zero = { 0, 0, 0, 0 };
+
+	for(uintptr_t line = address; line < (address + size); line += 64) {
+		stream_store_v4u32((uint32_t*)line, zero);
+		stream_store_v4u32((uint32_t*)(line + 16), zero);
+		stream_store_v4u32((uint32_t*)(line + 32), zero);
+		stream_store_v4u32((uint32_t*)(line + 48), zero);
+	}
+
+	store_fence();
+}
+
+
+/**
+ * push_zeroed_block
+ */
+static void push_zeroed_block(Zero_Pool* pool,
+	const uintptr_t address)
+{
+	/** The saved interrupt flag. */
+	const uint64_t flags = spinlock_acquire_irqsave(&pool->lock);
+
+	if(pool->count == pool->size) {
+		spinlock_release_irqrestore(&pool->lock, flags);
+		page_allocator_free(address, pool->order);
+		return;
+	}
+
+	*(uintptr_t*)address = pool->head;
+	pool->head = address;
+	__atomic_store_n(&pool->count, pool->count + 1, __ATOMIC_RELAXED);
+
+	spinlock_release_irqrestore(&pool->lock, flags);
+}
+
+
+/**
+ * add_region
+ */
+static bool add_region(uintptr_t start,
+	uintptr_t end,
+	const uint32_t node)
+{
+	/** The position the region is inserted at. */
+	uint32_t position = page_allocator.n_regions;
+
+	while(position > 0 && regions[position - 1].start > start) {
+		position--;
+	}
+
+	if(position > 0 && regions[position - 1].end == start &&
+		regions[position - 1].node == node) {
+		regions[position - 1].end = end;
+		return true;
+	}
+
+	if(position < page_allocator.n_regions && regions[position].start == end &&
+		regions[position].node == node) {
+		regions[position].start = start;
+		return true;
+	}
+
+	if(page_allocator.n_regions == PAGE_ALLOCATOR_MAX_REGIONS) {
+		return false;
+	}
+
+	for(uint32_t i = page_allocator.n_regions; i > position; i--) {
+		regions[i] = regions[i - 1];
+	}
+
+	regions[position].start = start;
+	regions[position].end = end;
+	regions[position].node = node;
+	page_allocator.n_regions++;
+
+	return true;
+}
+
+
+/**
+ * free_region
+ */
+static void free_region(const Memory_Region* region)
+{
+	/** The address of the next block. */
+	uintptr_t address = region->start;
+
+	while(address < region->end) {
+		/** The largest order the block's alignment allows. */
+		uint32_t order = (uint32_t)__builtin_ctzll(address) - 12;
+
+		if(order > (PAGE_ALLOCATOR_ORDERS - 1)) {
+			order = PAGE_ALLOCATOR_ORDERS - 1;
+		}
+
+		while((address + (PAGE_SIZE << order)) > region->end) {
+			order--;
+		}
+
+		push_block(&zones[region->node], address, order);
+		address += PAGE_SIZE << order;
+	}
+}
+
+
+/**
+ * page_allocator_initialize
+ */
+bool page_allocator_initialize(const Boot_Info* boot_info)
+{
+	/** The time at the start of the initialisation, in nanoseconds. */
+	const uint64_t start = clock_now_ns();
+	/** The number of descriptors in the memory map. */
+	const uint64_t n_descriptors = boot_info->mmap_size /
+		boot_info->mmap_descriptor_size;
+
+	for(size_t node = 0; node < NUMA_MAX_NODES; node++) {
+		for(size_t i = 0; i < PAGE_ALLOCATOR_ORDERS; i++) {
+			zones[node].free_lists[i].next = &zones[node].free_lists[i];
+			zones[node].free_lists[i].prev = &zones[node].free_lists[i];
+		}
+
+		zero_pools[node][0].order = 0;
+		zero_pools[node][0].size = PAGE_ALLOCATOR_ZERO_POOL_SIZE;
+		zero_pools[node][1].order = PAGE_ALLOCATOR_LARGE_ORDER;
+		zero_pools[node][1].size = PAGE_ALLOCATOR_ZERO_POOL_LARGE_SIZE;
+	}
+
+	for(size_t i = 0; i < SMP_MAX_CPUS; i++) {
+		page_allocator_cpus[i].small.size = PAGE_ALLOCATOR_CACHE_SIZE;
+		page_allocator_cpus[i].small.batch = PAGE_ALLOCATOR_CACHE_BATCH;
+		page_allocator_cpus[i].large.size = PAGE_ALLOCATOR_LARGE_CACHE_SIZE;
+		page_allocator_cpus[i].large.batch = PAGE_ALLOCATOR_LARGE_CACHE_BATCH;
+	}
+
+	for(uint64_t i = 0; i < n_descriptors; i++) {
+		/** The memory map descriptor. */
+		const Memory_Map_Descriptor* descriptor = (const Memory_Map_Descriptor*)
+			((uintptr_t)boot_info->memory_map + (i * boot_info->mmap_descriptor_size));
+		/** The region's start address, rounded up to a page. */
+		uintptr_t region_start = descriptor->physical_start;
+		/** The address past the end of the region, rounded down to a page. */
+		const uintptr_t region_end = (descriptor->physical_start +
+			(descriptor->count * PAGE_SIZE)) & ~(PAGE_SIZE - 1);
+
+		if(descriptor->type != MEMORY_REGION_CONVENTIONAL) {
+			continue;
+		}
+
+		if(region_start < PAGE_ALLOCATOR_MIN_ADDRESS) {
+			region_start = PAGE_ALLOCATOR_MIN_ADDRESS;
+		}
+
+		region_start = (region_start + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+		if(region_start >= region_end) {
+			continue;
+		}
+
+		// Ranges spanning more than one node are split at each node boundary.
+		while(region_start < region_end) {
+			/** The address past the end of the run on the same node. */
+			uintptr_t part_end;
+			/** The run's node. */
+			const uint32_t node = numa_get_memory_node(region_start, &part_end);
+
+			part_end = part_end > region_end ? region_end : part_end & ~(PAGE_SIZE - 1);
+			if(part_end <= region_start) {
+				part_end = region_start + PAGE_SIZE;
+			}
+
+			if(!add_region(region_start, part_end, node)) {
+				break;
+			}
+
+			region_start = part_end;
+		}
+
+		if(region_start < region_end) {
+			break;
+		}
+	}
+
+	for(uint32_t i = 0; i < page_allocator.n_regions; i++) {
+		free_region(&regions[i]);
+	}
+
+	for(uint32_t node = 0; node < NUMA_MAX_NODES; node++) {
+		page_allocator.node_pages[node] = zones[node].free_pages;
+	}
+
+	page_allocator.total_pages = page_allocator.free_pages;
+	page_allocator.initialize_ns = clock_now_ns() - start;
+
+	return page_allocator.total_pages != 0;
+}
+
+
+/**
+ * page_allocator_alloc
+ */
+uintptr_t page_allocator_alloc(const uint32_t order)
+{
+	/** The saved interrupt flag. */
+	const uint64_t flags = save_and_disable_interrupts();
+	/** The current CPU's node. */
+	const uint32_t node = smp_get_cpu_node();
+	/** The current CPU's cache for this order. */
+	Page_Cache* cache;
+	/** The allocated block's address. */
+	uintptr_t address = 0;
+
+	if(order >= PAGE_ALLOCATOR_ORDERS) {
+		restore_interrupts(flags);
+		return 0;
+	}
+
+	cache = get_cache(order);
+	if(cache == NULL) {
+		address = alloc_from_nearest_zone(node, order);
+
+		restore_interrupts(flags);
+		return address;
+	}
+
+	// The cache only holds blocks from the local zone, so that its blocks
+	// are always local to the CPU using them.
+	if(cache->count == 0) {
+		spinlock_acquire(&zones[node].lock);
+		while(cache->count < cache->batch) {
+			address = buddy_alloc(&zones[node], order);
+			if(address == 0) {
+				break;
+			}
+
+			cache->pages[cache->count++] = address;
+		}
+		spinlock_release(&zones[node].lock);
+	}
+
+	if(cache->count != 0) {
+		address = cache->pages[--cache->count];
+	} else {
+		address = alloc_from_nearest_zone(node, order);
+	}
+
+	restore_interrupts(flags);
+
+	return address;
+}
+
+
+/**
+ * page_allocator_alloc_node
+ */
+uintptr_t page_allocator_alloc_node(const uint32_t order,
+	const uint32_t node)
+{
+	if(order >= PAGE_ALLOCATOR_ORDERS || node >= numa.n_nodes) {
+		return 0;
+	}
+
+	return zone_alloc(node, order);
+}
+
+
+/**
+ * page_allocator_free
+ */
+void page_allocator_free(const uintptr_t address,
+	const uint32_t order)
+{
+	/** The saved interrupt flag. */
+	const uint64_t flags = save_and_disable_interrupts();
+	/** The current CPU's node. */
+	const uint32_t node = smp_get_cpu_node();
+	/** The current CPU's cache for this order. */
+	Page_Cache* cache;
+	/** The region the block belongs to. */
+	const Memory_Region* region;
+
+	if(address == 0 || order >= PAGE_ALLOCATOR_ORDERS) {
+		restore_interrupts(flags);
+		return;
+	}
+
+	// Blocks from a remote zone go straight back to it, rather than being
+	// handed out again from the local cache.
+	cache = get_cache(order);
+	if(cache == NULL ||
+		(numa.n_nodes > 1 && (region = find_region(address)) != NULL &&
+		region->node != node)) {
+		zone_free(address, order);
+
+		restore_interrupts(flags);
+		return;
+	}
+
+	// The least recently freed blocks are drained, keeping the cache-hot ones.
+	if(cache->count == cache->size) {
+		spinlock_acquire(&zones[node].lock);
+		for(uint32_t i = 0; i < cache->batch; i++) {
+			region = find_region(cache->pages[i]);
+			if(region) {
+				buddy_free(region, cache->pages[i], order);
+			}
+		}
+		spinlock_release(&zones[node].lock);
+
+		for(uint32_t i = cache->batch; i < cache->count; i++) {
+			cache->pages[i - cache->batch] = cache->pages[i];
+		}
+
+		cache->count -= cache->batch;
+	}
+
+	cache->pages[cache->count++] = address;
+
+	restore_interrupts(flags);
+}
+
+
+/**
+ * page_allocator_free_node
+ */
+void page_allocator_free_node(const uintptr_t address,
+	const uint32_t order)
+{
+	if(address == 0 || order >= PAGE_ALLOCATOR_ORDERS) {
+		return;
+	}
+
+	zone_free(address, order);
+}
+
+
+/**
+ * page_allocator_alloc_zeroed
+ */
+uintptr_t page_allocator_alloc_zeroed(const uint32_t order)
+{
+	/** The pool for this order. */
+	Zero_Pool* pool = get_zero_pool(order);
+	/** The allocated block's address. */
+	uintptr_t address = 0;
+	/** The number of blocks left in the pool. */
+	uint32_t count;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+	/** The timestamp at the start of zeroing. */
+	uint64_t start;
+
+	if(pool) {
+		flags = spinlock_acquire_irqsave(&pool->lock);
+		address = pool->head;
+		if(address) {
+			pool->head = *(uintptr_t*)address;
+			__atomic_store_n(&pool->count, pool->count - 1, __ATOMIC_RELAXED);
+		}
+		count = pool->count;
+		spinlock_release_irqrestore(&pool->lock, flags);
+
+		if(count < (pool->size / 2) &&
+			!__atomic_exchange_n(&zero_pool_refill_requested, true, __ATOMIC_RELAXED)) {
+			scheduler_wake_idle_cpu();
+		}
+
+		if(address) {
+			*(uintptr_t*)address = 0;
+			__atomic_add_fetch(&zero_stats.hits, 1, __ATOMIC_RELAXED);
+
+			return address;
+		}
+
+		__atomic_add_fetch(&zero_stats.misses, 1, __ATOMIC_RELAXED);
+	}
+
+	address = page_allocator_alloc(order);
+	if(address == 0) {
+		return 0;
+	}
+
+	// The caller is about to use the block, so it is zeroed through the cache.
+	start = read_timestamp_counter();
+	memset((void*)address, 0, PAGE_SIZE << order);
+	__atomic_add_fetch(&zero_stats.sync_cycles, read_timestamp_counter() - start,
+		__ATOMIC_RELAXED);
+	__atomic_add_fetch(&zero_stats.sync_bytes, PAGE_SIZE << order,
+		__ATOMIC_RELAXED);
+
+	return address;
+}
+
+
+/**
+ * page_allocator_zero_idle
+ */
+bool page_allocator_zero_idle(void)
+{
+	/** The current CPU's state. */
+	Page_Allocator_Cpu* cpu = &page_allocator_cpus[smp_get_cpu_index()];
+	/** The current CPU's node's pools. */
+	Zero_Pool* pools = zero_pools[smp_get_cpu_node()];
+	/** The pool being filled. */
+	Zero_Pool* pool = &pools[0];
+	/** The block being zeroed. */
+	uintptr_t address;
+	/** The timestamp at the start of zeroing. */
+	uint64_t start;
+
+	// A 2MiB block in progress is finished before the order 0 pool is topped
+	// up again.
+	if(cpu->zeroing == 0) {
+		if(__atomic_load_n(&pool->count, __ATOMIC_RELAXED) < pool->size) {
+			address = page_allocator_alloc(0);
+			if(address == 0) {
+				__atomic_store_n(&zero_pool_refill_requested, false, __ATOMIC_RELAXED);
+				return false;
+			}
+
+			start = read_timestamp_counter();
+			zero_non_temporal(address, PAGE_SIZE);
+			__atomic_add_fetch(&zero_stats.background_cycles,
+				read_timestamp_counter() - start, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&zero_stats.background_bytes, PAGE_SIZE,
+				__ATOMIC_RELAXED);
+
+			push_zeroed_block(pool, address);
+
+			return true;
+		}
+
+		pool = &pools[1];
+		if((__atomic_load_n(&pool->count, __ATOMIC_RELAXED) +
+			__atomic_load_n(&pool->n_filling, __ATOMIC_RELAXED)) >= pool->size) {
+			__atomic_store_n(&zero_pool_refill_requested, false, __ATOMIC_RELAXED);
+			return false;
+		}
+
+		cpu->zeroing = page_allocator_alloc(PAGE_ALLOCATOR_LARGE_ORDER);
+		if(cpu->zeroing == 0) {
+			__atomic_store_n(&zero_pool_refill_requested, false, __ATOMIC_RELAXED);
+			return false;
+		}
+
+		cpu->zeroed = 0;
+		__atomic_add_fetch(&pool->n_filling, 1, __ATOMIC_RELAXED);
+	}
+
+	pool = &pools[1];
+
+	start = read_timestamp_counter();
+	zero_non_temporal(cpu->zeroing + cpu->zeroed, PAGE_ALLOCATOR_ZERO_CHUNK);
+	__atomic_add_fetch(&zero_stats.background_cycles,
+		read_timestamp_counter() - start, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&zero_stats.background_bytes, PAGE_ALLOCATOR_ZERO_CHUNK,
+		__ATOMIC_RELAXED);
+
+	cpu->zeroed += PAGE_ALLOCATOR_ZERO_CHUNK;
+	if(cpu->zeroed == (PAGE_SIZE << PAGE_ALLOCATOR_LARGE_ORDER)) {
+		push_zeroed_block(pool, cpu->zeroing);
+		__atomic_sub_fetch(&pool->n_filling, 1, __ATOMIC_RELAXED);
+		cpu->zeroing = 0;
+	}
+
+	return true;
+}
+
+
+/**
+ * page_allocator_get_zero_stats
+ */
+void page_allocator_get_zero_stats(Page_Allocator_Zero_Stats* stats)
+{
+	stats->hits = __atomic_load_n(&zero_stats.hits, __ATOMIC_RELAXED);
+	stats->misses = __atomic_load_n(&zero_stats.misses, __ATOMIC_RELAXED);
+	stats->background_bytes = __atomic_load_n(&zero_stats.background_bytes,
+		__ATOMIC_RELAXED);
+	stats->background_cycles = __atomic_load_n(&zero_stats.background_cycles,
+		__ATOMIC_RELAXED);
+	stats->sync_bytes = __atomic_load_n(&zero_stats.sync_bytes, __ATOMIC_RELAXED);
+	stats->sync_cycles = __atomic_load_n(&zero_stats.sync_cycles,
+		__ATOMIC_RELAXED);
+}
+
+
+/**
+ * benchmark_alloc_free
+ */
+static void benchmark_alloc_free(const size_t begin,
+	const size_t end,
+	void* argument)
+{
+	/** The benchmark configuration. */
+	Page_Allocator_Benchmark* benchmark = argument;
+	/** The blocks allocated in the current round. */
+	uintptr_t blocks[PAGE_ALLOCATOR_BENCHMARK_BATCH];
+	/** The number of allocations which failed. */
+	uint64_t failures = 0;
+	/** The current CPU's node. */
+	const uint32_t node = smp_get_cpu_node();
+
+	for(size_t round = begin; round < end; round++) {
+		for(size_t i = 0; i < PAGE_ALLOCATOR_BENCHMARK_BATCH; i++) {
+			if(benchmark->cached) {
+				blocks[i] = page_allocator_alloc(benchmark->order);
+			} else {
+				blocks[i] = zone_alloc(node, benchmark->order);
+			}
+
+			if(blocks[i] == 0) {
+				failures++;
+			}
+		}
+
+		for(size_t i = 0; i < PAGE_ALLOCATOR_BENCHMARK_BATCH; i++) {
+			if(blocks[i] == 0) {
+				continue;
+			}
+
+			if(benchmark->cached) {
+				page_allocator_free(blocks[i], benchmark->order);
+			} else {
+				zone_free(blocks[i], benchmark->order);
+			}
+		}
+	}
+
+	__atomic_fetch_add(&benchmark->failures, failures, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * page_allocator_run_benchmark
+ */
+static void page_allocator_run_benchmark(void)
+{
+	/** The orders benchmarked. */
+	static const uint32_t orders[] = { 0, PAGE_ALLOCATOR_LARGE_ORDER };
+	/** The name of each benchmarked order. */
+	static const char* const order_names[] = { "alloc_free_4k", "alloc_free_2m" };
+	/** The grain splitting the rounds across every CPU. */
+	size_t grain = PAGE_ALLOCATOR_BENCHMARK_ROUNDS /
+		(smp.n_online * PAGE_ALLOCATOR_BENCHMARK_SPLIT);
+	/** The configuration of the running benchmark. */
+	Page_Allocator_Benchmark benchmark;
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles taken by the measurement. */
+	uint64_t cycles;
+
+	if(page_allocator.total_pages == 0) {
+		benchmark_skip("page_allocator", "no_free_memory");
+		return;
+	}
+
+	if(grain == 0) {
+		grain = 1;
+	}
+
+	for(size_t i = 0; i < (sizeof(orders) / sizeof(orders[0])); i++) {
+		for(size_t cached = 0; cached < 2; cached++) {
+			benchmark.order = orders[i];
+			benchmark.cached = (cached != 0);
+			benchmark.failures = 0;
+
+			start = read_timestamp_counter();
+			benchmark_alloc_free(0, PAGE_ALLOCATOR_BENCHMARK_ROUNDS, &benchmark);
+			cycles = read_timestamp_counter() - start;
+
+			benchmark_report(&(Benchmark_Result){
+				.suite = "page_allocator", .name = order_names[i],
+				.variant = benchmark.cached ? "cached_1cpu" : "locked_1cpu",
+				.size = PAGE_SIZE << orders[i],
+				.operations = PAGE_ALLOCATOR_BENCHMARK_ROUNDS *
+					PAGE_ALLOCATOR_BENCHMARK_BATCH,
+				.cycles = cycles,
+				.counters = { { "cpus", 1 }, { "failures", benchmark.failures } }
+			});
+
+			benchmark.failures = 0;
+
+			start = read_timestamp_counter();
+			scheduler_parallel_for(0, PAGE_ALLOCATOR_BENCHMARK_ROUNDS, grain,
+				benchmark_alloc_free, &benchmark);
+			cycles = read_timestamp_counter() - start;
+
+			benchmark_report(&(Benchmark_Result){
+				.suite = "page_allocator", .name = order_names[i],
+				.variant = benchmark.cached ? "cached_all_cpus" : "locked_all_cpus",
+				.size = PAGE_SIZE << orders[i],
+				.operations = PAGE_ALLOCATOR_BENCHMARK_ROUNDS *
+					PAGE_ALLOCATOR_BENCHMARK_BATCH,
+				.cycles = cycles,
+				.counters = {
+					{ "cpus", smp.n_online },
+					{ "failures", benchmark.failures }
+				}
+			});
+		}
+	}
+
+	benchmark_alloc_zeroed();
+}
+
+
+/**
+ * benchmark_alloc_zeroed
+ */
+static void benchmark_alloc_zeroed(void)
+{
+	/** The name of each pool's benchmark. */
+	static const char* const pool_names[] = { "alloc_zeroed_4k", "alloc_zeroed_2m" };
+	/** The blocks allocated. */
+	uintptr_t blocks[PAGE_ALLOCATOR_ZERO_POOL_SIZE];
+	/** The statistics before the measurement. */
+	Page_Allocator_Zero_Stats before;
+	/** The statistics after the measurement. */
+	Page_Allocator_Zero_Stats after;
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles taken by the measurement. */
+	uint64_t cycles;
+
+	for(size_t i = 0; i < 2; i++) {
+		/** The pool benchmarked, which is the current CPU's node's. */
+		Zero_Pool* pool = &zero_pools[smp_get_cpu_node()][i];
+		/** The time after which to stop waiting for the pool to fill. */
+		uint64_t deadline;
+
+		start = read_timestamp_counter();
+		for(uint32_t block = 0; block < pool->size; block++) {
+			blocks[block] = page_allocator_alloc(pool->order);
+			if(blocks[block] != 0) {
+				memset((void*)blocks[block], 0, PAGE_SIZE << pool->order);
+			}
+		}
+		cycles = read_timestamp_counter() - start;
+
+		for(uint32_t block = 0; block < pool->size; block++) {
+			page_allocator_free(blocks[block], pool->order);
+		}
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "page_allocator", .name = pool_names[i], .variant = "sync",
+			.size = PAGE_SIZE << pool->order,
+			.operations = pool->size,
+			.cycles = cycles,
+			.bytes = (PAGE_SIZE << pool->order) * pool->size
+		});
+
+		scheduler_wake_idle_cpu();
+		deadline = clock_now_ns() + PAGE_ALLOCATOR_BENCHMARK_FILL_NS;
+		while(__atomic_load_n(&pool->count, __ATOMIC_RELAXED) < pool->size &&
+			clock_now_ns() < deadline) {
+			cpu_relax();
+		}
+
+		page_allocator_get_zero_stats(&before);
+
+		start = read_timestamp_counter();
+		for(uint32_t block = 0; block < pool->size; block++) {
+			blocks[block] = page_allocator_alloc_zeroed(pool->order);
+		}
+		cycles = read_timestamp_counter() - start;
+
+		page_allocator_get_zero_stats(&after);
+
+		for(uint32_t block = 0; block < pool->size; block++) {
+			page_allocator_free(blocks[block], pool->order);
+		}
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "page_allocator", .name = pool_names[i], .variant = "pool",
+			.size = PAGE_SIZE << pool->order,
+			.operations = pool->size,
+			.cycles = cycles,
+			.bytes = (PAGE_SIZE << pool->order) * pool->size,
+			.counters = {
+				{ "hits", after.hits - before.hits },
+				{ "misses", after.misses - before.misses }
+			}
+		});
+	}
+
+	page_allocator_get_zero_stats(&after);
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "page_allocator", .name = "background_zero",
+		.variant = "non_temporal",
+		.size = PAGE_SIZE,
+		.operations = after.background_bytes / PAGE_SIZE,
+		.cycles = after.background_cycles,
+		.bytes = after.background_bytes,
+		.counters = { { "hits", after.hits }, { "misses", after.misses } }
+	});
+}
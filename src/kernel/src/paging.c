@@ -0,0 +1,1117 @@
+/**
+ * @file paging.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Paging functionality.
+ * Contains the implementation of the kernel's address space, and of page
+ * attribute changes on the active page tables. Both the firmware's page tables
+ * and the kernel's identity map physical memory, so page table addresses are
+ * used directly.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <boot.h>
+#include <clock.h>
+#include <cpu.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <spinlock.h>
+#include <string.h>
+#include <tlb.h>
+
+/**
+ * The number of page table pages reserved for splitting large pages when
+ * changing the attributes of part of a large page, before the page allocator
+ * is initialised. Split tables are allocated from the page allocator after.
+ */
+#define PAGING_SPLIT_TABLE_POOL_SIZE    16
+
+/** The number of entries in a page table. */
+#define PAGE_TABLE_ENTRY_COUNT          512
+
+/** The number of round trips between address spaces measured. */
+#define PAGING_BENCHMARK_SWITCHES       10000
+/** The order of the block of pages touched after each switch. */
+#define PAGING_BENCHMARK_TOUCH_ORDER    6
+
+/** PAT memory type encodings. */
+#define PAT_TYPE_UC                     0x00ULL
+#define PAT_TYPE_WC                     0x01ULL
+#define PAT_TYPE_WT                     0x04ULL
+#define PAT_TYPE_WP                     0x05ULL
+#define PAT_TYPE_WB                     0x06ULL
+#define PAT_TYPE_UC_MINUS               0x07ULL
+
+/**
+ * The PAT value programmed by `pat_initialize`. Indexes 0-3 match the
+ * power-on default. Indexes 4 and 5 select write-combining and
+ * write-protected.
+ */
+#define PAT_VALUE ((PAT_TYPE_WB) | (PAT_TYPE_WT << 8) |      \
+	(PAT_TYPE_UC_MINUS << 16) | (PAT_TYPE_UC << 24) |        \
+	(PAT_TYPE_WC << 32) | (PAT_TYPE_WP << 40) |              \
+	(PAT_TYPE_UC_MINUS << 48) | (PAT_TYPE_UC << 56))
+
+/** The start of the kernel image. Defined in the linker script. */
+extern char kernel_start[];
+/** The end of the kernel image. Defined in the linker script. */
+extern char kernel_end[];
+
+/**
+ * Refer to definition in paging.h
+ */
+Paging kernel_paging = {
+	.identity_map_size = 0,
+	.direct_map_size = 0,
+	.page_size = 0,
+	.n_tables = 0,
+	.n_direct_map_tables = 0,
+	.build_ns = 0,
+	.n_address_spaces = 0,
+	.pcid = false
+};
+
+/**
+ * Refer to definition in paging.h
+ */
+Address_Space kernel_address_space = {
+	.root = 0,
+	.pcid = 0
+};
+
+/**
+ * The kernel's top level page table. Kept in the kernel image, so that its
+ * address fits in the 32-bit CR3 loaded by the secondary CPU trampoline.
+ */
+static uint64_t kernel_root_table[PAGE_TABLE_ENTRY_COUNT]
+	__attribute__((aligned(PAGE_SIZE)));
+/** The number of PCIDs assigned to address spaces so far. */
+static uint32_t n_pcids_assigned = 0;
+/**
+ * Page table pages used when splitting large pages before the page allocator
+ * is initialised.
+ */
+static uint64_t split_tables[PAGING_SPLIT_TABLE_POOL_SIZE][PAGE_TABLE_ENTRY_COUNT]
+	__attribute__((aligned(PAGE_SIZE)));
+/** The number of split table pages used. */
+static size_t n_split_tables_used = 0;
+/**
+ * The lock serialising changes to the kernel's page tables, and the split
+ * table pool, across CPUs.
+ */
+static Spinlock paging_lock = SPINLOCK_INITIALIZER;
+/** Whether the PAT has been programmed. */
+static bool pat_enabled = false;
+
+/**
+ * @brief Updates a leaf page table entry.
+ * Applied by `update_range` to each leaf entry mapping a range.
+ * @param[in,out] entry The leaf entry.
+ * @param[in] is_large Whether the entry maps a 2MiB or 1GiB page.
+ * @param[in] argument The argument passed to `update_range`.
+ */
+typedef void (*Entry_Update_Function)(uint64_t* entry,
+	const bool is_large,
+	const uint64_t argument);
+
+/**
+ * @brief Gets the active top level page table.
+ * @return The active top level page table.
+ */
+static inline uint64_t* get_active_root(void);
+
+/**
+ * @brief Allocates a zeroed page table page.
+ * @return The page table, or NULL if no pages are free.
+ */
+static uint64_t* allocate_table(void);
+
+/**
+ * @brief Maps a range of physical memory.
+ * Uses the largest pages the alignment of each part of the range allows, up
+ * to `max_page_size`, allocating page tables as needed.
+ * @param[in,out] root The top level page table.
+ * @param[in] virtual_address The virtual address to map the range at.
+ * @param[in] physical_address The physical address of the range.
+ * @param[in] size The size of the range in bytes.
+ * @param[in] max_page_size The largest page size to use.
+ * @param[in] flags The flags of each leaf entry.
+ * @return The status of the operation.
+ */
+static Paging_Status map_range(uint64_t* root,
+	uintptr_t virtual_address,
+	uintptr_t physical_address,
+	uint64_t size,
+	const uint64_t max_page_size,
+	const uint64_t flags);
+
+/**
+ * @brief Gets the end of the highest region in the memory map.
+ * @param[in] boot_info The boot info.
+ * @param[in] ram_only Whether to only consider regions backed by RAM.
+ * @return The address past the end of the highest region.
+ */
+static uint64_t get_memory_map_end(const Boot_Info* boot_info,
+	const bool ram_only);
+
+/**
+ * @brief Finds the leaf page table entry mapping an address.
+ * @param[in] root The top level page table to walk.
+ * @param[in] address The virtual address to look up.
+ * @param[out] entry A pointer to the leaf entry.
+ * @param[out] page_size The size of the page mapped by the leaf entry.
+ * @return The status of the lookup.
+ */
+static Paging_Status find_leaf_entry(uint64_t* root,
+	const uintptr_t address,
+	uint64_t** entry,
+	uint64_t* page_size);
+
+/**
+ * @brief Splits a large page into a table of smaller pages.
+ * Replaces a 1GiB or 2MiB page entry with a pointer to a new table mapping the
+ * same range with pages of the next size down, keeping all attributes. The new
+ * table is allocated from the page allocator once it is initialised, and taken
+ * from the split table pool before then. Must be called with the paging lock
+ * held.
+ * @param[in,out] entry The large page entry to split.
+ * @param[in] page_size The size of the page mapped by the entry.
+ * @return The status of the operation.
+ */
+static Paging_Status split_large_page(uint64_t* entry,
+	const uint64_t page_size);
+
+/**
+ * @brief Sets the memory type bits of a leaf page table entry.
+ * @param[in,out] entry The leaf entry.
+ * @param[in] is_large Whether the entry maps a 2MiB or 1GiB page.
+ * @param[in] type The memory type to set.
+ */
+static void set_entry_memory_type(uint64_t* entry,
+	const bool is_large,
+	const Memory_Type type);
+
+/**
+ * @brief Gets the memory type of a leaf page table entry.
+ * @param[in] entry The leaf entry.
+ * @param[in] is_large Whether the entry maps a 2MiB or 1GiB page.
+ * @return The memory type the entry selects.
+ */
+static Memory_Type get_entry_memory_type(const uint64_t entry,
+	const bool is_large);
+
+/**
+ * @brief Updates the memory type of a leaf page table entry.
+ * An `Entry_Update_Function` wrapping `set_entry_memory_type`.
+ * @param[in,out] entry The leaf entry.
+ * @param[in] is_large Whether the entry maps a 2MiB or 1GiB page.
+ * @param[in] argument The `Memory_Type` to set.
+ */
+static void update_entry_memory_type(uint64_t* entry,
+	const bool is_large,
+	const uint64_t argument);
+
+/**
+ * @brief Marks a leaf page table entry not present.
+ * An `Entry_Update_Function`.
+ * @param[in,out] entry The leaf entry.
+ * @param[in] is_large Unused.
+ * @param[in] argument Unused.
+ */
+static void update_entry_unmap(uint64_t* entry,
+	const bool is_large,
+	const uint64_t argument);
+
+/**
+ * @brief Updates every leaf entry mapping a range of memory.
+ * Walks the active page tables, splitting large pages only partially covered
+ * by the range, and applies the update function to each leaf entry. The range
+ * is added to the given TLB shootdown batch, or invalidated on every CPU if no
+ * batch is given. Splitting a large page flushes the whole TLB. The walk is
+ * done with the paging lock held, so that two CPUs never split the same entry.
+ * @param[in] address The virtual address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @param[in] update The function applied to each leaf entry.
+ * @param[in] argument The argument passed to the update function.
+ * @param[in,out] batch The batch to add the range to. May be NULL.
+ * @return The status of the operation.
+ */
+static Paging_Status update_range(const uintptr_t address,
+	const size_t size,
+	const Entry_Update_Function update,
+	const uint64_t argument,
+	Tlb_Batch* batch);
+
+/**
+ * @brief Updates every leaf entry mapping a range, and its direct map alias.
+ * As `update_range`. If the range lies in the identity map, and so is also
+ * mapped in the direct map, the alias is updated too, so that the same
+ * memory is never mapped with conflicting memory types, and unmapped memory
+ * stays unreachable.
+ * @param[in] address The virtual address of the start of the range.
+ * @param[in] size The size of the range in bytes.
+ * @param[in] update The function applied to each leaf entry.
+ * @param[in] argument The argument passed to the update function.
+ * @param[in,out] batch The batch to add both ranges to. May be NULL.
+ * @return The status of the operation.
+ */
+static Paging_Status update_range_and_alias(const uintptr_t address,
+	const size_t size,
+	const Entry_Update_Function update,
+	const uint64_t argument,
+	Tlb_Batch* batch);
+
+/**
+ * @brief Loads an address space on the current CPU.
+ * @param[in] space The address space.
+ * @param[in] keep_tlb Whether to keep the TLB entries tagged with the space's
+ * PCID. Ignored if PCIDs are not enabled.
+ */
+static inline void load_address_space(const Address_Space* space,
+	const bool keep_tlb);
+
+/**
+ * @brief Runs the paging benchmarks.
+ * Measures switching between two address spaces and touching a set of pages
+ * after each switch, so that the cost of refilling a flushed TLB is included.
+ * With PCIDs enabled, switching is measured both keeping and flushing the
+ * TLB entries of the space switched to.
+ */
+static void paging_run_benchmark(void);
+
+BENCHMARK(paging, paging_run_benchmark);
+
+
+/**
+ * pat_initialize
+ */
+bool pat_initialize(void)
+{
+	if(!cpu_features.pat) {
+		return false;
+	}
+
+	// Changing the PAT requires that no stale cache lines or TLB entries exist
+	// with the old memory types.
+	write_back_invalidate_caches();
+	write_msr(MSR_IA32_PAT, PAT_VALUE);
+	paging_flush_tlb();
+	write_back_invalidate_caches();
+
+	pat_enabled = true;
+
+	return true;
+}
+
+
+/**
+ * get_memory_type_name
+ */
+const char* get_memory_type_name(const Memory_Type type)
+{
+	switch(type) {
+		case MEMORY_TYPE_WRITE_BACK:
+			return "WB";
+		case MEMORY_TYPE_WRITE_THROUGH:
+			return "WT";
+		case MEMORY_TYPE_UNCACHED_MINUS:
+			return "UC-";
+		case MEMORY_TYPE_UNCACHEABLE:
+			return "UC";
+		case MEMORY_TYPE_WRITE_COMBINING:
+			return "WC";
+		case MEMORY_TYPE_WRITE_PROTECTED:
+			return "WP";
+	}
+
+	return "Unknown";
+}
+
+
+/**
+ * get_active_root
+ */
+static inline uint64_t* get_active_root(void)
+{
+	return (uint64_t*)(read_cr3() & PAGE_ADDRESS_MASK);
+}
+
+
+/**
+ * allocate_table
+ */
+static uint64_t* allocate_table(void)
+{
+	/** The page table. */
+	uint64_t* table = (uint64_t*)page_allocator_alloc_zeroed(0);
+
+	if(table == NULL) {
+		return NULL;
+	}
+
+	kernel_paging.n_tables++;
+
+	return table;
+}
+
+
+/**
+ * map_range
+ */
+static Paging_Status map_range(uint64_t* root,
+	uintptr_t virtual_address,
+	uintptr_t physical_address,
+	uint64_t size,
+	const uint64_t max_page_size,
+	const uint64_t flags)
+{
+	while(size != 0) {
+		/** The size of the page mapping the current address. */
+		uint64_t page_size = max_page_size;
+		/** The current page table being walked. */
+		uint64_t* table = root;
+		/** The shift of the index into the current table. */
+		unsigned int shift = 39;
+
+		while(page_size > PAGE_SIZE && (page_size > size ||
+			((virtual_address | physical_address) & (page_size - 1)) != 0)) {
+			page_size /= PAGE_TABLE_ENTRY_COUNT;
+		}
+
+		for(; (1ULL << shift) > page_size; shift -= 9) {
+			/** The entry for this address in the current table. */
+			uint64_t* entry = &table[(virtual_address >> shift) &
+				(PAGE_TABLE_ENTRY_COUNT - 1)];
+
+			if(!(*entry & PAGE_PRESENT)) {
+				/** The new page table. */
+				uint64_t* child = allocate_table();
+
+				if(child == NULL) {
+					return PAGING_OUT_OF_TABLES;
+				}
+
+				*entry = (uint64_t)(uintptr_t)child | PAGE_PRESENT | PAGE_WRITABLE;
+			}
+
+			table = (uint64_t*)(*entry & PAGE_ADDRESS_MASK);
+		}
+
+		table[(virtual_address >> shift) & (PAGE_TABLE_ENTRY_COUNT - 1)] =
+			physical_address | flags | ((page_size > PAGE_SIZE) ? PAGE_LARGE : 0);
+
+		virtual_address += page_size;
+		physical_address += page_size;
+		size -= page_size;
+	}
+
+	return PAGING_SUCCESS;
+}
+
+
+/**
+ * get_memory_map_end
+ */
+static uint64_t get_memory_map_end(const Boot_Info* boot_info,
+	const bool ram_only)
+{
+	/** The number of descriptors in the memory map. */
+	const uint64_t n_descriptors = boot_info->mmap_size /
+		boot_info->mmap_descriptor_size;
+	/** The end of the highest region. */
+	uint64_t end = 0;
+
+	for(uint64_t i = 0; i < n_descriptors; i++) {
+		/** The memory map descriptor. */
+		const Memory_Map_Descriptor* descriptor = (const Memory_Map_Descriptor*)
+			((uintptr_t)boot_info->memory_map + (i * boot_info->mmap_descriptor_size));
+		/** The end of the region. */
+		const uint64_t region_end = descriptor->physical_start +
+			(descriptor->count * PAGE_SIZE);
+
+		if(ram_only && (descriptor->type == MEMORY_REGION_RESERVED ||
+			descriptor->type == MEMORY_REGION_UNUSABLE ||
+			descriptor->type == MEMORY_REGION_MMIO ||
+			descriptor->type == MEMORY_REGION_MMIO_PORT_SPACE ||
+			descriptor->type == MEMORY_REGION_PAL_CODE)) {
+			continue;
+		}
+
+		if(region_end > end) {
+			end = region_end;
+		}
+	}
+
+	return end;
+}
+
+
+/**
+ * find_leaf_entry
+ */
+static Paging_Status find_leaf_entry(uint64_t* root,
+	const uintptr_t address,
+	uint64_t** entry,
+	uint64_t* page_size)
+{
+	/** The current page table being walked. */
+	uint64_t* table = root;
+	/** The shift of the index into the current table. */
+	unsigned int shift = 39;
+
+	for(int level = 4; level >= 1; level--) {
+		/** The entry for this address in the current table. */
+		uint64_t* current = &table[(address >> shift) & (PAGE_TABLE_ENTRY_COUNT - 1)];
+
+		if(!(*current & PAGE_PRESENT)) {
+			return PAGING_NOT_MAPPED;
+		}
+
+		if(level == 1 || ((level == 2 || level == 3) && (*current & PAGE_LARGE))) {
+			*entry = current;
+			*page_size = 1ULL << shift;
+
+			return PAGING_SUCCESS;
+		}
+
+		table = (uint64_t*)(*current & PAGE_ADDRESS_MASK);
+		shift -= 9;
+	}
+
+	return PAGING_NOT_MAPPED;
+}
+
+
+/**
+ * split_large_page
+ */
+static Paging_Status split_large_page(uint64_t* entry,
+	const uint64_t page_size)
+{
+	/** The new table. */
+	uint64_t* table = NULL;
+	/** The size of the pages in the new table. */
+	const uint64_t child_size = page_size / PAGE_TABLE_ENTRY_COUNT;
+	/** The physical base of the large page. */
+	const uint64_t base = *entry & PAGE_ADDRESS_MASK & ~(page_size - 1);
+	/** The attributes of the large page, excluding its address. */
+	uint64_t attributes = *entry & ~(PAGE_ADDRESS_MASK & ~(page_size - 1));
+
+	if(page_allocator.total_pages != 0) {
+		table = allocate_table();
+	} else if(n_split_tables_used < PAGING_SPLIT_TABLE_POOL_SIZE) {
+		table = split_tables[n_split_tables_used++];
+	}
+
+	if(table == NULL) {
+		return PAGING_OUT_OF_TABLES;
+	}
+
+	if(child_size == PAGE_SIZE) {
+		// 4KiB entries keep the PAT bit in the position of the large page bit.
+		/** Whether the large page had its PAT bit set. */
+		const bool pat = (attributes & PAGE_PAT_LARGE) != 0;
+
+		attributes &= ~(PAGE_PAT_LARGE | PAGE_LARGE);
+		if(pat) {
+			attributes |= PAGE_PAT_SMALL;
+		}
+	}
+
+	for(size_t i = 0; i < PAGE_TABLE_ENTRY_COUNT; i++) {
+		table[i] = (base + (i * child_size)) | attributes;
+	}
+
+	// The new table inherits permissions from the leaf entries. The parent
+	// entry is made fully permissive so as not to restrict them further.
+	*entry = (uint64_t)(uintptr_t)table | PAGE_PRESENT | PAGE_WRITABLE |
+		(attributes & PAGE_USER);
+
+	return PAGING_SUCCESS;
+}
+
+
+/**
+ * set_entry_memory_type
+ */
+static void set_entry_memory_type(uint64_t* entry,
+	const bool is_large,
+	const Memory_Type type)
+{
+	/** The PAT bit for this entry size. */
+	const uint64_t pat_bit = is_large ? PAGE_PAT_LARGE : PAGE_PAT_SMALL;
+	/** The PAT index selecting the memory type. */
+	const unsigned int index = (unsigned int)type;
+	/** The new value of the entry. */
+	uint64_t value = *entry & ~(PAGE_WRITE_THROUGH | PAGE_CACHE_DISABLE | pat_bit);
+
+	if(index & 1) {
+		value |= PAGE_WRITE_THROUGH;
+	}
+
+	if(index & 2) {
+		value |= PAGE_CACHE_DISABLE;
+	}
+
+	if(index & 4) {
+		value |= pat_bit;
+	}
+
+	*entry = value;
+}
+
+
+/**
+ * get_entry_memory_type
+ */
+static Memory_Type get_entry_memory_type(const uint64_t entry,
+	const bool is_large)
+{
+	/** The PAT bit for this entry size. */
+	const uint64_t pat_bit = is_large ? PAGE_PAT_LARGE : PAGE_PAT_SMALL;
+	/** The PAT index selected by the entry. */
+	unsigned int index = 0;
+
+	index |= (entry & PAGE_WRITE_THROUGH) ? 1 : 0;
+	index |= (entry & PAGE_CACHE_DISABLE) ? 2 : 0;
+	index |= (entry & pat_bit) ? 4 : 0;
+
+	// Indexes 6 and 7 repeat the types of indexes 2 and 3. Without the PAT
+	// programmed, indexes 4-7 repeat indexes 0-3.
+	if(index >= 6 || (!pat_enabled && index >= 4)) {
+		index -= 4;
+	}
+
+	return (Memory_Type)index;
+}
+
+
+/**
+ * update_entry_memory_type
+ */
+static void update_entry_memory_type(uint64_t* entry,
+	const bool is_large,
+	const uint64_t argument)
+{
+	set_entry_memory_type(entry, is_large, (Memory_Type)argument);
+}
+
+
+/**
+ * update_entry_unmap
+ */
+static void update_entry_unmap(uint64_t* entry,
+	const bool is_large,
+	const uint64_t argument)
+{
+	(void)is_large;
+	(void)argument;
+
+	*entry &= ~PAGE_PRESENT;
+}
+
+
+/**
+ * update_range
+ */
+static Paging_Status update_range(const uintptr_t address,
+	const size_t size,
+	const Entry_Update_Function update,
+	const uint64_t argument,
+	Tlb_Batch* batch)
+{
+	/** The status of the operation. */
+	Paging_Status status = PAGING_SUCCESS;
+	/** The batch used if the caller gives none. */
+	Tlb_Batch local_batch = {0};
+	/** The address of the page currently being changed. */
+	uintptr_t current = address & ~(PAGE_SIZE - 1);
+	/** The end of the range. */
+	const uintptr_t end = (address + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+	/** The saved interrupt flag. */
+	const uint64_t flags = spinlock_acquire_irqsave(&paging_lock);
+	/** The original value of CR0. */
+	const uint64_t cr0 = read_cr0();
+
+	// The firmware may have mapped its page tables read-only.
+	write_cr0(cr0 & ~CR0_WP);
+
+	while(current < end) {
+		/** The leaf entry mapping the current address. */
+		uint64_t* entry = NULL;
+		/** The size of the page mapped by the entry. */
+		uint64_t page_size = 0;
+
+		status = find_leaf_entry(get_active_root(), current, &entry, &page_size);
+		if(status != PAGING_SUCCESS) {
+			break;
+		}
+
+		if(page_size > PAGE_SIZE) {
+			/** Whether the range covers the whole large page. */
+			const bool covers_page = ((current & (page_size - 1)) == 0) &&
+				((end - current) >= page_size);
+
+			if(!covers_page) {
+				status = split_large_page(entry, page_size);
+				if(status != PAGING_SUCCESS) {
+					break;
+				}
+
+				// The large page's entries may be cached alongside the new ones.
+				local_batch.flush_all = true;
+
+				// Walk again to reach the new, smaller entry.
+				continue;
+			}
+		}
+
+		update(entry, page_size > PAGE_SIZE, argument);
+		current += page_size;
+	}
+
+	write_cr0(cr0);
+
+	// The lock is released before the shootdown, which waits on other CPUs
+	// that may be spinning on it with interrupts disabled.
+	spinlock_release_irqrestore(&paging_lock, flags);
+
+	if(batch == NULL) {
+		batch = &local_batch;
+	} else if(local_batch.flush_all) {
+		batch->flush_all = true;
+	}
+
+	tlb_batch_add(batch, address, size);
+	if(batch == &local_batch) {
+		tlb_batch_finish(batch);
+	}
+
+	return status;
+}
+
+
+/**
+ * update_range_and_alias
+ */
+static Paging_Status update_range_and_alias(const uintptr_t address,
+	const size_t size,
+	const Entry_Update_Function update,
+	const uint64_t argument,
+	Tlb_Batch* batch)
+{
+	/** The status of the operation. */
+	Paging_Status status = update_range(address, size, update, argument, batch);
+	/** The size of the part of the range within the direct map. */
+	size_t alias_size = size;
+
+	// Identity mapped addresses are physical addresses.
+	if(status != PAGING_SUCCESS || address >= kernel_paging.identity_map_size ||
+		address >= kernel_paging.direct_map_size) {
+		return status;
+	}
+
+	if(alias_size > kernel_paging.direct_map_size - address) {
+		alias_size = kernel_paging.direct_map_size - address;
+	}
+
+	return update_range(PAGING_DIRECT_MAP_BASE + address, alias_size, update,
+		argument, batch);
+}
+
+
+/**
+ * load_address_space
+ */
+static inline void load_address_space(const Address_Space* space,
+	const bool keep_tlb)
+{
+	if(kernel_paging.pcid) {
+		write_cr3(space->root | space->pcid | (keep_tlb ? PAGING_CR3_NO_FLUSH : 0));
+	} else {
+		write_cr3(space->root);
+	}
+}
+
+
+/**
+ * paging_initialize
+ */
+Paging_Status paging_initialize(const Boot_Info* boot_info)
+{
+	/** The time at the start of the build, in nanoseconds. */
+	const uint64_t start = clock_now_ns();
+	/** The page tables the kernel is running on. */
+	uint64_t* previous_root = get_active_root();
+	/** The size of the pages used by the identity map and the direct map. */
+	const uint64_t page_size = cpu_features.page_1gb ? HUGE_PAGE_SIZE :
+		LARGE_PAGE_SIZE;
+	/** The size of the identity map. */
+	uint64_t identity_map_size = 1ULL << cpu_features.physical_address_bits;
+	/** The size of the direct map. */
+	uint64_t direct_map_size;
+	/** The end of the memory map, including memory mapped devices. */
+	uint64_t memory_map_end;
+	/** The number of page tables used before the direct map was built. */
+	uint64_t n_tables;
+	/** The status of the operation. */
+	Paging_Status status;
+	/** The status of carrying over the kernel image's unmapped pages. */
+	Paging_Status guard_status = PAGING_SUCCESS;
+
+	// The identity map covers the whole physical address space where it is
+	// cheap to do so, since PCI BARs may lie anywhere within it.
+	if(!cpu_features.page_1gb && identity_map_size > PAGING_MAX_IDENTITY_SIZE_2MB) {
+		identity_map_size = PAGING_MAX_IDENTITY_SIZE_2MB;
+	}
+
+	memory_map_end = (get_memory_map_end(boot_info, false) + page_size - 1) &
+		~(page_size - 1);
+	if(memory_map_end > identity_map_size) {
+		identity_map_size = memory_map_end;
+	}
+
+	if(identity_map_size > PAGING_MAX_MAPPED_SIZE) {
+		identity_map_size = PAGING_MAX_MAPPED_SIZE;
+	}
+
+	direct_map_size = (get_memory_map_end(boot_info, true) + page_size - 1) &
+		~(page_size - 1);
+	if(direct_map_size > PAGING_MAX_MAPPED_SIZE) {
+		direct_map_size = PAGING_MAX_MAPPED_SIZE;
+	}
+
+	memset(kernel_root_table, 0, sizeof(kernel_root_table));
+	kernel_paging.n_tables = 1;
+
+	status = map_range(kernel_root_table, 0, 0, identity_map_size, page_size,
+		PAGE_PRESENT | PAGE_WRITABLE);
+	if(status != PAGING_SUCCESS) {
+		return status;
+	}
+
+	n_tables = kernel_paging.n_tables;
+	status = map_range(kernel_root_table, PAGING_DIRECT_MAP_BASE, 0,
+		direct_map_size, page_size, PAGE_PRESENT | PAGE_WRITABLE | PAGE_GLOBAL);
+	if(status != PAGING_SUCCESS) {
+		return status;
+	}
+
+	kernel_paging.n_direct_map_tables = kernel_paging.n_tables - n_tables;
+
+	write_cr4(read_cr4() | CR4_PGE);
+	write_cr3((uintptr_t)kernel_root_table);
+
+	// The sizes are set before the guard pages are carried over, so that they
+	// are unmapped from the direct map too.
+	kernel_paging.identity_map_size = identity_map_size;
+	kernel_paging.direct_map_size = direct_map_size;
+	kernel_paging.page_size = page_size;
+
+	// Carries over guard pages. The large pages they lie in are split with
+	// tables from the page allocator, which may have run out.
+	for(uintptr_t page = (uintptr_t)kernel_start;
+		page < (uintptr_t)kernel_end && guard_status == PAGING_SUCCESS;
+		page += PAGE_SIZE) {
+		/** The page's leaf entry in the previous page tables. */
+		uint64_t* entry = NULL;
+		/** The size of the page mapped by the entry. */
+		uint64_t previous_page_size = 0;
+
+		if(find_leaf_entry(previous_root, page, &entry, &previous_page_size) !=
+			PAGING_SUCCESS) {
+			guard_status = paging_unmap(page, PAGE_SIZE);
+		}
+	}
+
+	// PCIDs can only be enabled while CR3 selects PCID zero.
+	if(cpu_features.pcid) {
+		write_cr4(read_cr4() | CR4_PCIDE);
+		kernel_paging.pcid = true;
+	}
+
+	kernel_address_space.root = (uintptr_t)kernel_root_table;
+	kernel_address_space.pcid = 0;
+
+	kernel_paging.build_ns = clock_now_ns() - start;
+
+	return guard_status;
+}
+
+
+/**
+ * paging_create_address_space
+ */
+Paging_Status paging_create_address_space(Address_Space* space)
+{
+	/** The space's top level page table. */
+	const uintptr_t root = page_allocator_alloc(0);
+	/** The number of PCIDs assigned before this one. */
+	uint32_t n_assigned;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(root == 0) {
+		return PAGING_OUT_OF_TABLES;
+	}
+
+	flags = spinlock_acquire_irqsave(&paging_lock);
+	memcpy((void*)root, (const void*)kernel_address_space.root, PAGE_SIZE);
+	spinlock_release_irqrestore(&paging_lock, flags);
+
+	// PCID zero belongs to the kernel's address space.
+	n_assigned = __atomic_fetch_add(&n_pcids_assigned, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&kernel_paging.n_address_spaces, 1, __ATOMIC_RELAXED);
+	space->root = root;
+	space->pcid = (uint16_t)(1 + (n_assigned % (PAGING_PCID_COUNT - 1)));
+
+	// Once PCIDs are reused, any CPU may still hold entries tagged with them.
+	// A full flush toggles CR4.PGE, which drops the entries of every PCID.
+	if(n_assigned >= (PAGING_PCID_COUNT - 1) && space->pcid == 1) {
+		/** The batch flushing every CPU's TLB. */
+		Tlb_Batch batch = {0};
+
+		batch.flush_all = true;
+		tlb_batch_finish(&batch);
+	}
+
+	return PAGING_SUCCESS;
+}
+
+
+/**
+ * paging_destroy_address_space
+ */
+void paging_destroy_address_space(const Address_Space* space)
+{
+	page_allocator_free(space->root, 0);
+	__atomic_sub_fetch(&kernel_paging.n_address_spaces, 1, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * paging_switch_address_space
+ */
+void paging_switch_address_space(const Address_Space* space)
+{
+	load_address_space(space, true);
+}
+
+
+/**
+ * paging_set_memory_type
+ */
+Paging_Status paging_set_memory_type(const uintptr_t address,
+	const size_t size,
+	const Memory_Type type)
+{
+	/** The status of the operation. */
+	Paging_Status status;
+
+	if(!pat_enabled && type >= MEMORY_TYPE_WRITE_COMBINING) {
+		return PAGING_UNSUPPORTED;
+	}
+
+	write_back_invalidate_caches();
+
+	status = update_range_and_alias(address, size, update_entry_memory_type,
+		(uint64_t)type, NULL);
+
+	write_back_invalidate_caches();
+
+	return status;
+}
+
+
+/**
+ * paging_unmap
+ */
+Paging_Status paging_unmap(const uintptr_t address,
+	const size_t size)
+{
+	return update_range_and_alias(address, size, update_entry_unmap, 0, NULL);
+}
+
+
+/**
+ * paging_unmap_batched
+ */
+Paging_Status paging_unmap_batched(const uintptr_t address,
+	const size_t size,
+	Tlb_Batch* batch)
+{
+	return update_range_and_alias(address, size, update_entry_unmap, 0, batch);
+}
+
+
+/**
+ * paging_map
+ */
+Paging_Status paging_map(const uintptr_t virtual_address,
+	const uintptr_t physical_address,
+	const size_t size)
+{
+	/** The offset of the range within its first page. */
+	const uintptr_t offset = virtual_address & (PAGE_SIZE - 1);
+	/** The status of the operation. */
+	Paging_Status status;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(kernel_address_space.root == 0) {
+		return PAGING_UNSUPPORTED;
+	}
+
+	flags = spinlock_acquire_irqsave(&paging_lock);
+	status = map_range((uint64_t*)kernel_address_space.root,
+		virtual_address - offset, physical_address & ~(PAGE_SIZE - 1),
+		(size + offset + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1), PAGE_SIZE,
+		PAGE_PRESENT | PAGE_WRITABLE);
+	spinlock_release_irqrestore(&paging_lock, flags);
+
+	return status;
+}
+
+
+/**
+ * paging_get_memory_type
+ */
+Paging_Status paging_get_memory_type(const uintptr_t address,
+	Memory_Type* type)
+{
+	/** The status of the lookup. */
+	Paging_Status status;
+	/** The leaf entry mapping the address. */
+	uint64_t* entry = NULL;
+	/** The size of the page mapped by the entry. */
+	uint64_t page_size = 0;
+
+	status = find_leaf_entry(get_active_root(), address, &entry, &page_size);
+	if(status != PAGING_SUCCESS) {
+		return status;
+	}
+
+	*type = get_entry_memory_type(*entry, page_size > PAGE_SIZE);
+
+	return PAGING_SUCCESS;
+}
+
+
+/**
+ * paging_verify_memory_type
+ */
+void paging_verify_memory_type(const uintptr_t address,
+	const size_t size,
+	const Memory_Type type,
+	size_t* n_mismatched)
+{
+	/** The address of the page currently being checked. */
+	uintptr_t current = address & ~(PAGE_SIZE - 1);
+	/** The end of the range. */
+	const uintptr_t end = (address + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+	*n_mismatched = 0;
+
+	for(; current < end; current += PAGE_SIZE) {
+		/** The memory type of the current page. */
+		Memory_Type current_type;
+
+		if(paging_get_memory_type(current, &current_type) != PAGING_SUCCESS ||
+			current_type != type) {
+			(*n_mismatched)++;
+		}
+	}
+}
+
+
+/**
+ * paging_flush_tlb
+ */
+void paging_flush_tlb(void)
+{
+	/** The current value of CR4. */
+	const uint64_t cr4 = read_cr4();
+
+	if(cr4 & CR4_PGE) {
+		// Toggling global pages flushes the entire TLB, including global entries.
+		write_cr4(cr4 & ~CR4_PGE);
+		write_cr4(cr4);
+	} else {
+		write_cr3(read_cr3());
+	}
+}
+
+
+/**
+ * paging_run_benchmark
+ */
+static void paging_run_benchmark(void)
+{
+	/** The number of pages touched after each switch. */
+	const size_t n_pages = 1ULL << PAGING_BENCHMARK_TOUCH_ORDER;
+	/** The address space switched to and from. */
+	Address_Space space;
+	/** The pages touched after each switch. */
+	uintptr_t pages;
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles taken by the measurement. */
+	uint64_t cycles;
+	/** The sum of the bytes read, which keeps the reads from being removed. */
+	uint64_t sum = 0;
+
+	if(kernel_address_space.root == 0) {
+		benchmark_skip("paging", "kernel_address_space_inactive");
+		return;
+	}
+
+	pages = page_allocator_alloc(PAGING_BENCHMARK_TOUCH_ORDER);
+	if(pages == 0) {
+		benchmark_skip("paging", "no_free_memory");
+		return;
+	}
+
+	if(paging_create_address_space(&space) != PAGING_SUCCESS) {
+		page_allocator_free(pages, PAGING_BENCHMARK_TOUCH_ORDER);
+		benchmark_skip("paging", "no_free_memory");
+		return;
+	}
+
+	for(int keep_tlb = 1; keep_tlb >= 0; keep_tlb--) {
+		if(!keep_tlb && !kernel_paging.pcid) {
+			break;
+		}
+
+		start = read_timestamp_counter();
+		for(size_t i = 0; i < PAGING_BENCHMARK_SWITCHES; i++) {
+			load_address_space(&space, keep_tlb);
+			for(size_t page = 0; page < n_pages; page++) {
+				sum += *(volatile uint8_t*)(pages + (page * PAGE_SIZE));
+			}
+
+			load_address_space(&kernel_address_space, keep_tlb);
+			for(size_t page = 0; page < n_pages; page++) {
+				sum += *(volatile uint8_t*)(pages + (page * PAGE_SIZE));
+			}
+		}
+		cycles = read_timestamp_counter() - start;
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "paging", .name = "switch_and_touch",
+			.variant = !kernel_paging.pcid ? "no_pcid" :
+				(keep_tlb ? "pcid_keep_tlb" : "pcid_flush_tlb"),
+			.size = n_pages,
+			.operations = PAGING_BENCHMARK_SWITCHES * 2,
+			.cycles = cycles,
+			.counters = { { "pcid", kernel_paging.pcid } }
+		});
+	}
+
+	(void)sum;
+
+	paging_destroy_address_space(&space);
+	page_allocator_free(pages, PAGING_BENCHMARK_TOUCH_ORDER);
+}
@@ -0,0 +1,145 @@
+/**
+ * @file pci.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief PCI functionality.
+ * Contains the implementation of PCI configuration space access.
+ * Refer to: https://wiki.osdev.org/PCI
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pci.h>
+#include <port_io.h>
+
+#define PCI_CONFIG_ADDRESS_PORT       0xCF8
+#define PCI_CONFIG_DATA_PORT          0xCFC
+
+/** Configuration address: Enable the configuration space access. */
+#define PCI_CONFIG_ADDRESS_ENABLE     (1U << 31)
+/** Header type: The device has multiple functions. */
+#define PCI_HEADER_TYPE_MULTIFUNCTION 0x80
+
+#define PCI_BUS_COUNT                 256
+#define PCI_DEVICES_PER_BUS           32
+#define PCI_FUNCTIONS_PER_DEVICE      8
+
+/**
+ * @brief Selects a configuration space register.
+ * Writes the address of a register to the configuration address port, so
+ * that it can be accessed through the data port.
+ * @param[in] dev The function.
+ * @param[in] offset The offset of the register.
+ */
+static void pci_select_register(const Pci_Device* dev,
+	const uint8_t offset);
+
+
+/**
+ * pci_select_register
+ */
+static void pci_select_register(const Pci_Device* dev,
+	const uint8_t offset)
+{
+	outl(PCI_CONFIG_ADDRESS_PORT, PCI_CONFIG_ADDRESS_ENABLE |
+		((uint32_t)dev->bus << 16) | ((uint32_t)dev->device << 11) |
+		((uint32_t)dev->function << 8) | (offset & 0xFC));
+}
+
+
+/**
+ * pci_config_read32
+ */
+uint32_t pci_config_read32(const Pci_Device* dev,
+	const uint8_t offset)
+{
+	pci_select_register(dev, offset);
+
+	return inl(PCI_CONFIG_DATA_PORT);
+}
+
+
+/**
+ * pci_config_read16
+ */
+uint16_t pci_config_read16(const Pci_Device* dev,
+	const uint8_t offset)
+{
+	pci_select_register(dev, offset);
+
+	return inw(PCI_CONFIG_DATA_PORT + (offset & 2));
+}
+
+
+/**
+ * pci_config_read8
+ */
+uint8_t pci_config_read8(const Pci_Device* dev,
+	const uint8_t offset)
+{
+	pci_select_register(dev, offset);
+
+	return inb(PCI_CONFIG_DATA_PORT + (offset & 3));
+}
+
+
+/**
+ * pci_config_write16
+ */
+void pci_config_write16(const Pci_Device* dev,
+	const uint8_t offset,
+	const uint16_t value)
+{
+	pci_select_register(dev, offset);
+
+	outw(PCI_CONFIG_DATA_PORT + (offset & 2), value);
+}
+
+
+/**
+ * pci_find_device
+ */
+bool pci_find_device(const uint16_t vendor_id,
+	const uint16_t device_id,
+	const size_t index,
+	Pci_Device* dev)
+{
+	/** The number of matching functions found so far. */
+	size_t n_found = 0;
+	/** The number of functions to probe in the current device. */
+	uint8_t n_functions;
+
+	for(size_t bus = 0; bus < PCI_BUS_COUNT; bus++) {
+		for(size_t device = 0; device < PCI_DEVICES_PER_BUS; device++) {
+			dev->bus = bus;
+			dev->device = device;
+			dev->function = 0;
+
+			if(pci_config_read16(dev, PCI_CONFIG_VENDOR_ID) == PCI_VENDOR_ID_NONE) {
+				continue;
+			}
+
+			n_functions = 1;
+			if(pci_config_read8(dev, PCI_CONFIG_HEADER_TYPE) &
+				PCI_HEADER_TYPE_MULTIFUNCTION) {
+				n_functions = PCI_FUNCTIONS_PER_DEVICE;
+			}
+
+			for(uint8_t function = 0; function < n_functions; function++) {
+				dev->function = function;
+
+				if(pci_config_read16(dev, PCI_CONFIG_VENDOR_ID) != vendor_id ||
+					pci_config_read16(dev, PCI_CONFIG_DEVICE_ID) != device_id) {
+					continue;
+				}
+
+				if(n_found++ == index) {
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
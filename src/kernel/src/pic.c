@@ -0,0 +1,153 @@
+/**
+ * @file pic.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief 8259 PIC functionality.
+ * Contains the implementation of the 8259 PIC driver.
+ * Refer to: https://wiki.osdev.org/8259_PIC
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pic.h>
+#include <port_io.h>
+
+#define PIC_MASTER_COMMAND     0x20
+#define PIC_MASTER_DATA        0x21
+#define PIC_SLAVE_COMMAND      0xA0
+#define PIC_SLAVE_DATA         0xA1
+
+/** ICW1: Initialisation, with ICW4 to follow. */
+#define PIC_ICW1_INIT          0x11
+/** ICW4: 8086 mode. */
+#define PIC_ICW4_8086          0x01
+/** OCW2: Non-specific end of interrupt. */
+#define PIC_OCW2_EOI           0x20
+/** OCW3: Read the in-service register. */
+#define PIC_OCW3_READ_ISR      0x0B
+
+/** The port written to in order to wait for a PIC to settle. */
+#define PIC_IO_WAIT_PORT       0x80
+
+/**
+ * @brief Waits for the PIC to process a command.
+ * Writes to an unused port, which takes long enough for the PICs to settle
+ * between initialisation words on older hardware.
+ */
+static void pic_io_wait(void);
+
+
+/**
+ * pic_io_wait
+ */
+static void pic_io_wait(void)
+{
+	outb(PIC_IO_WAIT_PORT, 0);
+}
+
+
+/**
+ * pic_initialize
+ */
+void pic_initialize(void)
+{
+	outb(PIC_MASTER_COMMAND, PIC_ICW1_INIT);
+	pic_io_wait();
+	outb(PIC_SLAVE_COMMAND, PIC_ICW1_INIT);
+	pic_io_wait();
+
+	// ICW2: Vector offsets.
+	outb(PIC_MASTER_DATA, PIC_IRQ_BASE_VECTOR);
+	pic_io_wait();
+	outb(PIC_SLAVE_DATA, PIC_IRQ_BASE_VECTOR + 8);
+	pic_io_wait();
+
+	// ICW3: The master has a slave on the cascade line, and the slave's
+	// cascade identity.
+	outb(PIC_MASTER_DATA, 1 << PIC_CASCADE_IRQ);
+	pic_io_wait();
+	outb(PIC_SLAVE_DATA, PIC_CASCADE_IRQ);
+	pic_io_wait();
+
+	outb(PIC_MASTER_DATA, PIC_ICW4_8086);
+	pic_io_wait();
+	outb(PIC_SLAVE_DATA, PIC_ICW4_8086);
+	pic_io_wait();
+
+	// Mask everything except the cascade line, so that unmasking a slave IRQ
+	// only needs the slave's mask to change.
+	outb(PIC_MASTER_DATA, (uint8_t)~(1 << PIC_CASCADE_IRQ));
+	outb(PIC_SLAVE_DATA, 0xFF);
+}
+
+
+/**
+ * pic_set_irq_masked
+ */
+void pic_set_irq_masked(const uint8_t irq,
+	const bool masked)
+{
+	/** The data port of the PIC the IRQ belongs to. */
+	uint16_t port = PIC_MASTER_DATA;
+	/** The IRQ's line on its PIC. */
+	uint8_t line = irq;
+	/** The PIC's interrupt mask. */
+	uint8_t mask;
+
+	if(irq >= 8) {
+		port = PIC_SLAVE_DATA;
+		line = irq - 8;
+	}
+
+	mask = inb(port);
+	if(masked) {
+		mask |= (1 << line);
+	} else {
+		mask &= ~(1 << line);
+	}
+
+	outb(port, mask);
+}
+
+
+/**
+ * pic_is_spurious_irq
+ */
+bool pic_is_spurious_irq(const uint8_t irq)
+{
+	/** The in-service register of the PIC raising the IRQ. */
+	uint8_t in_service;
+
+	if(irq == 7) {
+		outb(PIC_MASTER_COMMAND, PIC_OCW3_READ_ISR);
+		in_service = inb(PIC_MASTER_COMMAND);
+
+		return (in_service & (1 << 7)) == 0;
+	}
+
+	if(irq == 15) {
+		outb(PIC_SLAVE_COMMAND, PIC_OCW3_READ_ISR);
+		in_service = inb(PIC_SLAVE_COMMAND);
+		if((in_service & (1 << 7)) == 0) {
+			// The master did see the cascade line raised, so it still needs
+			// to be acknowledged.
+			outb(PIC_MASTER_COMMAND, PIC_OCW2_EOI);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * pic_send_end_of_interrupt
+ */
+void pic_send_end_of_interrupt(const uint8_t irq)
+{
+	if(irq >= 8) {
+		outb(PIC_SLAVE_COMMAND, PIC_OCW2_EOI);
+	}
+
+	outb(PIC_MASTER_COMMAND, PIC_OCW2_EOI);
+}
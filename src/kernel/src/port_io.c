@@ -26,3 +26,43 @@ void outb(uint16_t port, uint8_t val)
 {
 	asm volatile("outb %0, %1" : : "a"(val), "Nd"(port));
 }
+
+
+/**
+ * inw
+ */
+uint16_t inw(uint16_t port)
+{
+	uint16_t ret;
+	asm volatile("inw %1, %0" : "=a"(ret) : "Nd"(port));
+	return ret;
+}
+
+
+/**
+ * outw
+ */
+void outw(uint16_t port, uint16_t val)
+{
+	asm volatile("outw %0, %1" : : "a"(val), "Nd"(port));
+}
+
+
+/**
+ * inl
+ */
+uint32_t inl(uint16_t port)
+{
+	uint32_t ret;
+	asm volatile("inl %1, %0" : "=a"(ret) : "Nd"(port));
+	return ret;
+}
+
+
+/**
+ * outl
+ */
+void outl(uint16_t port, uint32_t val)
+{
+	asm volatile("outl %0, %1" : : "a"(val), "Nd"(port));
+}
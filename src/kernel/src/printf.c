@@ -0,0 +1,372 @@
+/**
+ * @file printf.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Formatted output functionality.
+ * Contains the implementation of the kernel's freestanding formatter.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <log.h>
+#include <printf.h>
+#include <uart.h>
+#include <virtio_console.h>
+
+/**
+ * @brief Formatter output state.
+ * Tracks the position in the output buffer while formatting.
+ */
+typedef struct s_format_output {
+	char* buffer;
+	size_t buffer_size;
+	size_t position;
+} Format_Output;
+
+/**
+ * @brief Appends a character to the output.
+ * Characters past the end of the buffer are counted but discarded.
+ * @param[in,out] output The formatter output state.
+ * @param[in] c The character to append.
+ */
+static inline void output_char(Format_Output* output,
+	const char c);
+
+/**
+ * @brief Appends a padded string to the output.
+ * @param[in,out] output The formatter output state.
+ * @param[in] str The string to append.
+ * @param[in] len The length of the string.
+ * @param[in] width The minimum field width.
+ * @param[in] pad The character to pad with.
+ * @param[in] left_align Whether to pad on the right instead of the left.
+ */
+static void output_padded(Format_Output* output,
+	const char* str,
+	const size_t len,
+	const size_t width,
+	const char pad,
+	const bool left_align);
+
+/**
+ * @brief Converts an unsigned integer to digits.
+ * Writes the digits in reverse order into the provided buffer.
+ * @param[in] value The value to convert.
+ * @param[in] base The numeric base.
+ * @param[in] uppercase Whether to use uppercase hex digits.
+ * @param[out] digits The buffer to write into. Must hold 20 characters.
+ * @return The number of digits written.
+ */
+static size_t convert_unsigned(uint64_t value,
+	const unsigned int base,
+	const bool uppercase,
+	char* digits);
+
+
+/**
+ * output_char
+ */
+static inline void output_char(Format_Output* output,
+	const char c)
+{
+	if(output->position + 1 < output->buffer_size) {
+		output->buffer[output->position] = c;
+	}
+
+	output->position++;
+}
+
+
+/**
+ * output_padded
+ */
+static void output_padded(Format_Output* output,
+	const char* str,
+	const size_t len,
+	const size_t width,
+	const char pad,
+	const bool left_align)
+{
+	/** The number of pad characters required. */
+	const size_t n_pad = (width > len) ? (width - len) : 0;
+
+	if(!left_align) {
+		for(size_t i = 0; i < n_pad; i++) {
+			output_char(output, pad);
+		}
+	}
+
+	for(size_t i = 0; i < len; i++) {
+		output_char(output, str[i]);
+	}
+
+	if(left_align) {
+		for(size_t i = 0; i < n_pad; i++) {
+			output_char(output, ' ');
+		}
+	}
+}
+
+
+/**
+ * convert_unsigned
+ */
+static size_t convert_unsigned(uint64_t value,
+	const unsigned int base,
+	const bool uppercase,
+	char* digits)
+{
+	/** The digit characters. */
+	const char* digit_chars = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+	/** The number of digits written. */
+	size_t n_digits = 0;
+
+	do {
+		digits[n_digits++] = digit_chars[value % base];
+		value /= base;
+	} while(value);
+
+	return n_digits;
+}
+
+
+/**
+ * kvsnprintf
+ */
+size_t kvsnprintf(char* buffer,
+	const size_t buffer_size,
+	const char* format,
+	va_list args)
+{
+	/** The formatter output state. */
+	Format_Output output = {buffer, buffer_size, 0};
+	/** Buffer holding converted digits, in reverse order. */
+	char reversed[20];
+	/** Buffer holding a converted number, including its sign. */
+	char number[21];
+
+	while(*format) {
+		/** Whether to left-align the field. */
+		bool left_align = false;
+		/** The field padding character. */
+		char pad = ' ';
+		/** The minimum field width. */
+		size_t width = 0;
+		/** The length modifier, counted in `l` characters. */
+		int n_long = 0;
+		/** Whether the current conversion is signed. */
+		bool is_signed = false;
+		/** The numeric base of the current conversion. */
+		unsigned int base = 10;
+		/** The value of the current numeric conversion. */
+		uint64_t value = 0;
+		/** Whether the current numeric conversion is negative. */
+		bool negative = false;
+		/** The length of the converted number. */
+		size_t number_len = 0;
+
+		if(*format != '%') {
+			output_char(&output, *format++);
+			continue;
+		}
+
+		format++;
+
+		// Flags.
+		while(*format == '-' || *format == '0') {
+			if(*format == '-') {
+				left_align = true;
+			} else {
+				pad = '0';
+			}
+
+			format++;
+		}
+
+		// Field width.
+		while(*format >= '0' && *format <= '9') {
+			width = (width * 10) + (*format - '0');
+			format++;
+		}
+
+		// Length modifiers.
+		while(*format == 'l' || *format == 'z') {
+			n_long = (*format == 'z') ? 2 : n_long + 1;
+			format++;
+		}
+
+		switch(*format) {
+			case 'c':
+				number[0] = (char)va_arg(args, int);
+				output_padded(&output, number, 1, width, ' ', left_align);
+				format++;
+				continue;
+			case 's': {
+				/** The string argument. */
+				const char* str = va_arg(args, const char*);
+				/** The length of the string argument. */
+				size_t str_len = 0;
+
+				if(str == NULL) {
+					str = "(null)";
+				}
+
+				while(str[str_len]) {
+					str_len++;
+				}
+
+				output_padded(&output, str, str_len, width, ' ', left_align);
+				format++;
+				continue;
+			}
+			case 'p':
+				value = (uintptr_t)va_arg(args, void*);
+				base = 16;
+				output_char(&output, '0');
+				output_char(&output, 'x');
+				break;
+			case 'd':
+			case 'i':
+				is_signed = true;
+				break;
+			case 'u':
+				break;
+			case 'x':
+			case 'X':
+				base = 16;
+				break;
+			case '%':
+				output_char(&output, '%');
+				format++;
+				continue;
+			default:
+				// Unknown conversion. Print it verbatim.
+				output_char(&output, '%');
+				if(*format) {
+					output_char(&output, *format++);
+				}
+				continue;
+		}
+
+		if(*format != 'p') {
+			if(is_signed) {
+				/** The signed argument value. */
+				int64_t signed_value = (n_long >= 2) ? va_arg(args, long long) :
+					(n_long == 1) ? va_arg(args, long) : va_arg(args, int);
+
+				negative = signed_value < 0;
+				value = negative ? -(uint64_t)signed_value : (uint64_t)signed_value;
+			} else {
+				value = (n_long >= 2) ? va_arg(args, unsigned long long) :
+					(n_long == 1) ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+			}
+		}
+
+		{
+			/** The number of converted digits. */
+			const size_t n_digits = convert_unsigned(value, base, *format == 'X',
+				reversed);
+
+			if(negative) {
+				if(pad == '0') {
+					// Zero padding goes between the sign and the digits.
+					output_char(&output, '-');
+					width = (width > 0) ? width - 1 : 0;
+				} else {
+					number[number_len++] = '-';
+				}
+			}
+
+			for(size_t i = 0; i < n_digits; i++) {
+				number[number_len++] = reversed[n_digits - i - 1];
+			}
+		}
+
+		output_padded(&output, number, number_len, width,
+			left_align ? ' ' : pad, left_align);
+		format++;
+	}
+
+	if(buffer_size > 0) {
+		buffer[(output.position < buffer_size) ? output.position : buffer_size - 1] = '\0';
+	}
+
+	return output.position;
+}
+
+
+/**
+ * ksnprintf
+ */
+size_t ksnprintf(char* buffer,
+	const size_t buffer_size,
+	const char* format,
+	...)
+{
+	/** The variadic argument list. */
+	va_list args;
+	/** The number of characters written. */
+	size_t len = 0;
+
+	va_start(args, format);
+	len = kvsnprintf(buffer, buffer_size, format, args);
+	va_end(args);
+
+	return len;
+}
+
+
+/**
+ * kprintf
+ */
+void kprintf(const char* format,
+	...)
+{
+	/** The variadic argument list. */
+	va_list args;
+	/** The formatted output buffer. */
+	char output[KPRINTF_BUFFER_SIZE];
+
+	/** The length of the formatted output. */
+	size_t length;
+
+	va_start(args, format);
+	length = kvsnprintf(output, KPRINTF_BUFFER_SIZE, format, args);
+	va_end(args);
+
+	if(length >= KPRINTF_BUFFER_SIZE) {
+		length = KPRINTF_BUFFER_SIZE - 1;
+	}
+
+	log_output(output, length);
+}
+
+
+/**
+ * kexport
+ */
+void kexport(const void* data,
+	const size_t length)
+{
+	if(virtio_data_console.initialized) {
+		virtio_console_write(&virtio_data_console, data, length);
+	} else {
+		uart_port_write(&uart_data_port, data, length);
+	}
+}
+
+
+/**
+ * kflush
+ */
+void kflush(void)
+{
+	log_drain();
+
+	virtio_console_flush(&virtio_log_console);
+	virtio_console_flush(&virtio_data_console);
+	uart_flush();
+	uart_port_flush(&uart_data_port);
+}
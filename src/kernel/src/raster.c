@@ -0,0 +1,494 @@
+/**
+ * @file raster.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief 2D raster primitives.
+ * Contains the scalar reference raster primitives, implementation selection,
+ * the self test and the microbenchmark.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <printf.h>
+#include <raster.h>
+
+/** The dimensions of the self test surfaces. */
+#define RASTER_TEST_STRIDE              83
+#define RASTER_TEST_WIDTH               77
+#define RASTER_TEST_HEIGHT              9
+/** The offset of the self test rectangles, so that rows start unaligned. */
+#define RASTER_TEST_OFFSET              3
+#define RASTER_TEST_BUFFER_SIZE         (RASTER_TEST_STRIDE * (RASTER_TEST_HEIGHT + 1))
+
+/** The dimensions of the benchmark surfaces. */
+#define RASTER_BENCHMARK_SIZE           256
+/** The number of iterations of each benchmark pass. */
+#define RASTER_BENCHMARK_ITERATIONS     64
+
+/**
+ * Selected raster operations.
+ * Refer to definition in raster.h
+ */
+Raster_Operations raster;
+
+/** Self test surfaces. */
+static uint32_t test_src[RASTER_TEST_BUFFER_SIZE];
+static uint32_t test_expected[RASTER_TEST_BUFFER_SIZE];
+static uint32_t test_actual[RASTER_TEST_BUFFER_SIZE];
+
+/** Benchmark surfaces. */
+static uint32_t benchmark_src[RASTER_BENCHMARK_SIZE * RASTER_BENCHMARK_SIZE]
+	__attribute__((aligned(64)));
+static uint32_t benchmark_dest[RASTER_BENCHMARK_SIZE * RASTER_BENCHMARK_SIZE]
+	__attribute__((aligned(64)));
+
+/** An 8x2 pattern used by the self test and benchmark. */
+static const uint32_t test_pattern[16] = {
+	0x00000000, 0x00FFFFFF, 0x00FF0000, 0x0000FF00,
+	0x000000FF, 0x00FFFF00, 0x0000FFFF, 0x00FF00FF,
+	0x00808080, 0x00404040, 0x00C0C0C0, 0x00102030,
+	0x00302010, 0x00AABBCC, 0x00CCBBAA, 0x00123456
+};
+
+/**
+ * @brief Gets the implementations supported by the processor.
+ * @param[out] operations The supported implementations, fastest last.
+ * @return The number of supported implementations.
+ */
+static size_t get_supported_operations(const Raster_Operations* operations[3]);
+
+/**
+ * @brief Fills a buffer with pseudo-random pixels.
+ * @param[out] buffer The buffer to fill.
+ * @param[in] count The number of pixels.
+ * @param[in] seed The random seed.
+ */
+static void fill_random(uint32_t* buffer,
+	const size_t count,
+	uint32_t seed);
+
+/**
+ * @brief Compares the self test surfaces.
+ * @param[in] operations The implementation being tested.
+ * @param[in] primitive The name of the primitive being tested.
+ * @return Whether the actual surface matches the expected surface.
+ */
+static bool compare_test_surfaces(const Raster_Operations* operations,
+	const char* primitive);
+
+/**
+ * @brief Tests one implementation against the scalar reference.
+ * @param[in] operations The implementation to test.
+ * @return Whether every primitive matched the reference.
+ */
+static bool test_operations(const Raster_Operations* operations);
+
+/**
+ * @brief Runs the raster microbenchmark.
+ * Measures the throughput of every primitive of every implementation supported
+ * by the processor.
+ */
+static void raster_run_benchmark(void);
+
+
+/**
+ * fill_scalar
+ */
+static void fill_scalar(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t colour)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		for(uint32_t x = 0; x < width; x++) {
+			dest[(y * dest_stride) + x] = colour;
+		}
+	}
+}
+
+
+/**
+ * copy_scalar
+ */
+static void copy_scalar(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t* src,
+	const size_t src_stride,
+	const uint32_t width,
+	const uint32_t height)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		for(uint32_t x = 0; x < width; x++) {
+			dest[(y * dest_stride) + x] = src[(y * src_stride) + x];
+		}
+	}
+}
+
+
+/**
+ * pattern_scalar
+ */
+static void pattern_scalar(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t* pattern,
+	const uint32_t pattern_width,
+	const uint32_t pattern_height,
+	const uint32_t origin_x,
+	const uint32_t origin_y)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		for(uint32_t x = 0; x < width; x++) {
+			dest[(y * dest_stride) + x] =
+				pattern[(((y + origin_y) % pattern_height) * pattern_width) +
+				((x + origin_x) % pattern_width)];
+		}
+	}
+}
+
+
+/**
+ * blend_scalar
+ */
+static void blend_scalar(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t* src,
+	const size_t src_stride,
+	const uint32_t width,
+	const uint32_t height)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		for(uint32_t x = 0; x < width; x++) {
+			/** The source pixel. */
+			const uint32_t s = src[(y * src_stride) + x];
+			/** The destination pixel. */
+			uint32_t* d = &dest[(y * dest_stride) + x];
+			/** The source alpha. */
+			const uint32_t a = s >> 24;
+			/** The blended pixel. */
+			uint32_t result = 0;
+
+			for(unsigned int shift = 0; shift < 24; shift += 8) {
+				/** The weighted sum of the channel. */
+				const uint32_t sum = (((s >> shift) & 0xFF) * a) +
+					(((*d >> shift) & 0xFF) * (255 - a));
+
+				// Division by 255, rounded to nearest.
+				result |= ((sum + 127) / 255) << shift;
+			}
+
+			*d = result;
+		}
+	}
+}
+
+
+/**
+ * convert_scalar
+ */
+static void convert_scalar(uint32_t* dest,
+	const uint32_t* src,
+	const size_t count)
+{
+	for(size_t i = 0; i < count; i++) {
+		dest[i] = ((src[i] & 0xFF) << 16) | (src[i] & 0xFF00FF00) |
+			((src[i] >> 16) & 0xFF);
+	}
+}
+
+
+/**
+ * test_texture_scalar
+ */
+static void test_texture_scalar(uint32_t* dest,
+	const size_t dest_stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t frame)
+{
+	for(uint32_t y = 0; y < height; y++) {
+		for(uint32_t x = 0; x < width; x++) {
+			/** The texture value of this pixel. */
+			const uint32_t c = (x ^ (y + frame)) % 256;
+
+			dest[(y * dest_stride) + x] = ((255 - (c % 128)) << 16) | (c << 8) |
+				(c % 128);
+		}
+	}
+}
+
+
+/**
+ * Scalar raster operations.
+ * Refer to definition in raster.h
+ */
+const Raster_Operations raster_scalar_operations = {
+	.name = "scalar",
+	.fill = fill_scalar,
+	.copy = copy_scalar,
+	.pattern = pattern_scalar,
+	.blend = blend_scalar,
+	.convert = convert_scalar,
+	.test_texture = test_texture_scalar
+};
+
+
+/**
+ * get_supported_operations
+ */
+static size_t get_supported_operations(const Raster_Operations* operations[3])
+{
+	/** The number of supported implementations. */
+	size_t n_operations = 0;
+
+	operations[n_operations++] = &raster_scalar_operations;
+	operations[n_operations++] = &raster_sse2_operations;
+
+	if(cpu_features.avx2) {
+		operations[n_operations++] = &raster_avx2_operations;
+	}
+
+	return n_operations;
+}
+
+
+/**
+ * raster_initialize
+ */
+void raster_initialize(void)
+{
+	/** The supported implementations. */
+	const Raster_Operations* operations[3];
+	/** The number of supported implementations. */
+	const size_t n_operations = get_supported_operations(operations);
+
+	raster = *operations[n_operations - 1];
+}
+
+
+/**
+ * raster_scroll
+ */
+void raster_scroll(uint32_t* buffer,
+	const size_t stride,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t rows,
+	const uint32_t colour)
+{
+	if(rows >= height) {
+		raster.fill(buffer, stride, width, height, colour);
+		return;
+	}
+
+	// Rows are copied top to bottom, so every source row is read before it is
+	// overwritten.
+	for(uint32_t y = 0; y < (height - rows); y++) {
+		raster.copy(buffer + (y * stride), stride,
+			buffer + ((y + rows) * stride), stride, width, 1);
+	}
+
+	raster.fill(buffer + ((height - rows) * stride), stride, width, rows, colour);
+}
+
+
+/**
+ * fill_random
+ */
+static void fill_random(uint32_t* buffer,
+	const size_t count,
+	uint32_t seed)
+{
+	for(size_t i = 0; i < count; i++) {
+		// Xorshift32.
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		buffer[i] = seed;
+	}
+}
+
+
+/**
+ * compare_test_surfaces
+ */
+static bool compare_test_surfaces(const Raster_Operations* operations,
+	const char* primitive)
+{
+	for(size_t i = 0; i < RASTER_TEST_BUFFER_SIZE; i++) {
+		if(test_actual[i] != test_expected[i]) {
+			kprintf("Raster self test: %s %s mismatch at %lu: 0x%08x != 0x%08x\n",
+				operations->name, primitive, i, test_actual[i], test_expected[i]);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * test_operations
+ */
+static bool test_operations(const Raster_Operations* operations)
+{
+	/** Whether every primitive matched the reference. */
+	bool passed = true;
+	/** The self test rectangle in the expected surface. */
+	uint32_t* expected = test_expected + RASTER_TEST_OFFSET;
+	/** The self test rectangle in the actual surface. */
+	uint32_t* actual = test_actual + RASTER_TEST_OFFSET;
+	/** The self test rectangle in the source surface. */
+	const uint32_t* src = test_src + RASTER_TEST_OFFSET;
+
+	fill_random(test_src, RASTER_TEST_BUFFER_SIZE, 0x12345678);
+
+	fill_random(test_expected, RASTER_TEST_BUFFER_SIZE, 0x9ABCDEF0);
+	fill_random(test_actual, RASTER_TEST_BUFFER_SIZE, 0x9ABCDEF0);
+	raster_scalar_operations.fill(expected, RASTER_TEST_STRIDE,
+		RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, 0x00ABCDEF);
+	operations->fill(actual, RASTER_TEST_STRIDE,
+		RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, 0x00ABCDEF);
+	passed &= compare_test_surfaces(operations, "fill");
+
+	raster_scalar_operations.copy(expected, RASTER_TEST_STRIDE,
+		src + 1, RASTER_TEST_STRIDE, RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT);
+	operations->copy(actual, RASTER_TEST_STRIDE,
+		src + 1, RASTER_TEST_STRIDE, RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT);
+	passed &= compare_test_surfaces(operations, "copy");
+
+	// Exercise pattern widths both narrower and wider than a vector.
+	for(uint32_t pattern_width = 1; pattern_width <= 16; pattern_width += 3) {
+		raster_scalar_operations.pattern(expected, RASTER_TEST_STRIDE,
+			RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, test_pattern, pattern_width,
+			16 / pattern_width, 2, 1);
+		operations->pattern(actual, RASTER_TEST_STRIDE,
+			RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, test_pattern, pattern_width,
+			16 / pattern_width, 2, 1);
+		passed &= compare_test_surfaces(operations, "pattern");
+	}
+
+	raster_scalar_operations.blend(expected, RASTER_TEST_STRIDE,
+		src, RASTER_TEST_STRIDE, RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT);
+	operations->blend(actual, RASTER_TEST_STRIDE,
+		src, RASTER_TEST_STRIDE, RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT);
+	passed &= compare_test_surfaces(operations, "blend");
+
+	raster_scalar_operations.convert(expected, src,
+		RASTER_TEST_WIDTH * RASTER_TEST_HEIGHT);
+	operations->convert(actual, src, RASTER_TEST_WIDTH * RASTER_TEST_HEIGHT);
+	passed &= compare_test_surfaces(operations, "convert");
+
+	raster_scalar_operations.test_texture(expected, RASTER_TEST_STRIDE,
+		RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, 13);
+	operations->test_texture(actual, RASTER_TEST_STRIDE,
+		RASTER_TEST_WIDTH, RASTER_TEST_HEIGHT, 13);
+	passed &= compare_test_surfaces(operations, "test texture");
+
+	return passed;
+}
+
+
+/**
+ * raster_self_test
+ */
+bool raster_self_test(void)
+{
+	/** The supported implementations. */
+	const Raster_Operations* operations[3];
+	/** The number of supported implementations. */
+	const size_t n_operations = get_supported_operations(operations);
+	/** Whether every implementation matched the reference. */
+	bool passed = true;
+
+	// The first supported implementation is the scalar reference itself.
+	for(size_t i = 1; i < n_operations; i++) {
+		/** Whether this implementation matched the reference. */
+		const bool operations_passed = test_operations(operations[i]);
+
+		kprintf("Raster self test: %s %s\n", operations[i]->name,
+			operations_passed ? "passed" : "FAILED");
+		passed &= operations_passed;
+	}
+
+	return passed;
+}
+
+
+/**
+ * raster_run_benchmark
+ */
+static void raster_run_benchmark(void)
+{
+	/** The supported implementations. */
+	const Raster_Operations* operations[3];
+	/** The number of supported implementations. */
+	const size_t n_operations = get_supported_operations(operations);
+	/** The number of pixels processed by each benchmark pass. */
+	const uint64_t n_pixels = (uint64_t)RASTER_BENCHMARK_SIZE * RASTER_BENCHMARK_SIZE *
+		RASTER_BENCHMARK_ITERATIONS;
+	/** The name of each benchmarked primitive, as reported. */
+	const char* primitive_names[] = {
+		"fill", "copy", "pattern", "blend", "convert", "test_texture"
+	};
+
+	fill_random(benchmark_src, RASTER_BENCHMARK_SIZE * RASTER_BENCHMARK_SIZE, 1);
+
+	for(size_t i = 0; i < n_operations; i++) {
+		/** The implementation being measured. */
+		const Raster_Operations* ops = operations[i];
+
+		for(size_t primitive = 0; primitive < 6; primitive++) {
+			/** The timestamp at the start of the benchmark pass. */
+			const uint64_t start = read_timestamp_counter();
+			/** The number of cycles taken by the benchmark pass. */
+			uint64_t cycles = 0;
+
+			for(uint32_t n = 0; n < RASTER_BENCHMARK_ITERATIONS; n++) {
+				switch(primitive) {
+					case 0:
+						ops->fill(benchmark_dest, RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE,
+							RASTER_BENCHMARK_SIZE, n);
+						break;
+					case 1:
+						ops->copy(benchmark_dest, RASTER_BENCHMARK_SIZE, benchmark_src,
+							RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE);
+						break;
+					case 2:
+						ops->pattern(benchmark_dest, RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE,
+							RASTER_BENCHMARK_SIZE, test_pattern, 8, 2, n, n);
+						break;
+					case 3:
+						ops->blend(benchmark_dest, RASTER_BENCHMARK_SIZE, benchmark_src,
+							RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE);
+						break;
+					case 4:
+						ops->convert(benchmark_dest, benchmark_src,
+							RASTER_BENCHMARK_SIZE * RASTER_BENCHMARK_SIZE);
+						break;
+					default:
+						ops->test_texture(benchmark_dest, RASTER_BENCHMARK_SIZE,
+							RASTER_BENCHMARK_SIZE, RASTER_BENCHMARK_SIZE, n);
+						break;
+				}
+			}
+
+			cycles = read_timestamp_counter() - start;
+			benchmark_report(&(Benchmark_Result){
+				.suite = "raster", .name = primitive_names[primitive],
+				.variant = ops->name,
+				.size = (uint64_t)RASTER_BENCHMARK_SIZE * RASTER_BENCHMARK_SIZE,
+				.operations = RASTER_BENCHMARK_ITERATIONS, .cycles = cycles,
+				.bytes = n_pixels * sizeof(uint32_t)
+			});
+		}
+	}
+}
+
+BENCHMARK(raster, raster_run_benchmark);
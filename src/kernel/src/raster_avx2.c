@@ -0,0 +1,33 @@
+/**
+ * @file raster_avx2.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief AVX2 raster primitives.
+ * Instantiates the raster primitive template with 256-bit vectors. These must
+ * only be used once `raster_initialize` has confirmed that the processor
+ * supports AVX2, and that AVX state is enabled.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <raster.h>
+
+#pragma GCC target("avx2")
+
+#define RASTER_VECTOR_LANES 8
+
+#include <raster_template.h>
+
+/**
+ * AVX2 raster operations.
+ * Refer to definition in raster.h
+ */
+const Raster_Operations raster_avx2_operations = {
+	.name = "AVX2",
+	.fill = raster_fill,
+	.copy = raster_copy,
+	.pattern = raster_pattern,
+	.blend = raster_blend,
+	.convert = raster_convert,
+	.test_texture = raster_test_texture
+};
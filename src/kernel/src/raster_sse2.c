@@ -0,0 +1,30 @@
+/**
+ * @file raster_sse2.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief SSE2 raster primitives.
+ * Instantiates the raster primitive template with 128-bit vectors. SSE2 is
+ * part of the x86-64 baseline, so these are always available.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <raster.h>
+
+#define RASTER_VECTOR_LANES 4
+
+#include <raster_template.h>
+
+/**
+ * SSE2 raster operations.
+ * Refer to definition in raster.h
+ */
+const Raster_Operations raster_sse2_operations = {
+	.name = "SSE2",
+	.fill = raster_fill,
+	.copy = raster_copy,
+	.pattern = raster_pattern,
+	.blend = raster_blend,
+	.convert = raster_convert,
+	.test_texture = raster_test_texture
+};
@@ -0,0 +1,395 @@
+/**
+ * @file renderer.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Back-buffered framebuffer renderer.
+ * Contains the implementation of the back-buffered renderer.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <graphics.h>
+#include <raster.h>
+#include <renderer.h>
+#include <simd.h>
+
+/** The number of iterations of each benchmark pass. */
+#define RENDERER_BENCHMARK_ITERATIONS    16
+/** The size of the small region updated in the benchmark. */
+#define RENDERER_BENCHMARK_REGION_WIDTH  64
+#define RENDERER_BENCHMARK_REGION_HEIGHT 16
+
+/**
+ * Renderer instance.
+ * Refer to definition in renderer.h
+ */
+Renderer renderer;
+
+/**
+ * @brief The back buffer storage.
+ * Aligned to a cache line so that every row of a back buffer whose width is a
+ * multiple of 16 pixels starts on a cache line.
+ */
+static uint32_t back_buffer_storage[RENDERER_MAX_WIDTH * RENDERER_MAX_HEIGHT]
+	__attribute__((aligned(64)));
+
+/**
+ * @brief Gets the area of a rectangle.
+ * @param[in] rect The rectangle.
+ * @return The area in pixels.
+ */
+static inline uint64_t rect_area(const Rect* rect);
+
+/**
+ * @brief Gets the bounding rectangle of two rectangles.
+ * @param[in] a The first rectangle.
+ * @param[in] b The second rectangle.
+ * @param[out] result The bounding rectangle.
+ */
+static void rect_union(const Rect* a,
+	const Rect* b,
+	Rect* result);
+
+/**
+ * @brief Tests whether two rectangles overlap or touch.
+ * @param[in] a The first rectangle.
+ * @param[in] b The second rectangle.
+ * @return Whether the rectangles overlap or share an edge.
+ */
+static bool rect_touches(const Rect* a,
+	const Rect* b);
+
+/**
+ * @brief Draws the XOR test texture into the back buffer.
+ * @param[in,out] r The renderer.
+ * @param[in] frame The frame number, used to vary the texture.
+ */
+static void draw_benchmark_frame(Renderer* r,
+	const uint32_t frame);
+
+/**
+ * @brief Runs the renderer benchmark.
+ * Measures full-screen and small-region update costs through the renderer,
+ * against drawing directly to the framebuffer.
+ */
+static void renderer_run_benchmark(void);
+
+
+/**
+ * rect_area
+ */
+static inline uint64_t rect_area(const Rect* rect)
+{
+	return (uint64_t)rect->width * rect->height;
+}
+
+
+/**
+ * rect_union
+ */
+static void rect_union(const Rect* a,
+	const Rect* b,
+	Rect* result)
+{
+	/** The left edge of the union. */
+	const uint32_t left = (a->x < b->x) ? a->x : b->x;
+	/** The top edge of the union. */
+	const uint32_t top = (a->y < b->y) ? a->y : b->y;
+	/** The right edge of the union. */
+	const uint32_t right = ((a->x + a->width) > (b->x + b->width)) ?
+		(a->x + a->width) : (b->x + b->width);
+	/** The bottom edge of the union. */
+	const uint32_t bottom = ((a->y + a->height) > (b->y + b->height)) ?
+		(a->y + a->height) : (b->y + b->height);
+
+	result->x = left;
+	result->y = top;
+	result->width = right - left;
+	result->height = bottom - top;
+}
+
+
+/**
+ * rect_touches
+ */
+static bool rect_touches(const Rect* a,
+	const Rect* b)
+{
+	return (a->x <= (b->x + b->width)) && (b->x <= (a->x + a->width)) &&
+		(a->y <= (b->y + b->height)) && (b->y <= (a->y + a->height));
+}
+
+
+/**
+ * renderer_initialize
+ */
+bool renderer_initialize(const Framebuffer* fb)
+{
+	if(fb->base == NULL ||
+		fb->width > RENDERER_MAX_WIDTH ||
+		fb->height > RENDERER_MAX_HEIGHT) {
+		return false;
+	}
+
+	renderer.fb = fb;
+	renderer.back_buffer = back_buffer_storage;
+	renderer.width = fb->width;
+	renderer.height = fb->height;
+	// Round the stride up to a whole number of cache lines.
+	renderer.stride = (fb->width + 15) & ~15u;
+	renderer.n_dirty_rects = 0;
+
+	renderer_fill_rect(&renderer, 0, 0, renderer.width, renderer.height, 0);
+
+	return true;
+}
+
+
+/**
+ * renderer_mark_dirty
+ */
+void renderer_mark_dirty(Renderer* r,
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t width,
+	const uint32_t height)
+{
+	/** The region being added, after clipping. */
+	Rect region;
+	/** The index of the rectangle to merge with when the list is full. */
+	size_t best_idx = 0;
+	/** The area increase of merging with the best candidate. */
+	uint64_t best_growth = UINT64_MAX;
+
+	if(x >= r->width || y >= r->height || width == 0 || height == 0) {
+		return;
+	}
+
+	region.x = x;
+	region.y = y;
+	region.width = ((x + width) > r->width) ? (r->width - x) : width;
+	region.height = ((y + height) > r->height) ? (r->height - y) : height;
+
+	// Coalesce with any touching rectangle when the merged rectangle wastes no
+	// more than the area of the two parts combined. Merging can create new
+	// overlaps, so the scan restarts after every merge.
+	for(size_t i = 0; i < r->n_dirty_rects; i++) {
+		/** The candidate merged rectangle. */
+		Rect merged;
+
+		if(!rect_touches(&r->dirty_rects[i], &region)) {
+			continue;
+		}
+
+		rect_union(&r->dirty_rects[i], &region, &merged);
+		if(rect_area(&merged) <= (rect_area(&r->dirty_rects[i]) + rect_area(&region))) {
+			region = merged;
+			r->dirty_rects[i] = r->dirty_rects[--r->n_dirty_rects];
+			i = (size_t)-1;
+		}
+	}
+
+	if(r->n_dirty_rects < RENDERER_MAX_DIRTY_RECTS) {
+		r->dirty_rects[r->n_dirty_rects++] = region;
+		return;
+	}
+
+	for(size_t i = 0; i < r->n_dirty_rects; i++) {
+		/** The candidate merged rectangle. */
+		Rect merged;
+		/** The area added by merging with this candidate. */
+		uint64_t growth = 0;
+
+		rect_union(&r->dirty_rects[i], &region, &merged);
+		growth = rect_area(&merged) - rect_area(&r->dirty_rects[i]);
+		if(growth < best_growth) {
+			best_growth = growth;
+			best_idx = i;
+		}
+	}
+
+	rect_union(&r->dirty_rects[best_idx], &region, &r->dirty_rects[best_idx]);
+}
+
+
+/**
+ * renderer_fill_rect
+ */
+void renderer_fill_rect(Renderer* r,
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t colour)
+{
+	/** The clipped width. */
+	uint32_t clipped_width = width;
+	/** The clipped height. */
+	uint32_t clipped_height = height;
+
+	if(x >= r->width || y >= r->height) {
+		return;
+	}
+
+	if((x + clipped_width) > r->width) {
+		clipped_width = r->width - x;
+	}
+
+	if((y + clipped_height) > r->height) {
+		clipped_height = r->height - y;
+	}
+
+	raster.fill(r->back_buffer + ((size_t)y * r->stride) + x, r->stride,
+		clipped_width, clipped_height, colour);
+
+	renderer_mark_dirty(r, x, y, clipped_width, clipped_height);
+}
+
+
+/**
+ * renderer_flush
+ */
+void renderer_flush(Renderer* r)
+{
+	if(r->n_dirty_rects == 0) {
+		return;
+	}
+
+	for(size_t i = 0; i < r->n_dirty_rects; i++) {
+		/** The dirty rectangle being flushed. */
+		const Rect* rect = &r->dirty_rects[i];
+		/** Pointer to the current source row. */
+		const uint32_t* src = r->back_buffer + ((size_t)rect->y * r->stride) + rect->x;
+		/** Pointer to the current framebuffer row. */
+		uint32_t* dest = r->fb->base + ((size_t)rect->y * r->fb->pixels_per_scanline) +
+			rect->x;
+
+		for(uint32_t row = 0; row < rect->height; row++) {
+			r->fb->stream_span(dest, src, rect->width);
+			src += r->stride;
+			dest += r->fb->pixels_per_scanline;
+		}
+	}
+
+	store_fence();
+	r->n_dirty_rects = 0;
+}
+
+
+/**
+ * draw_benchmark_frame
+ */
+static void draw_benchmark_frame(Renderer* r,
+	const uint32_t frame)
+{
+	for(uint32_t y = 0; y < r->height; y++) {
+		for(uint32_t x = 0; x < r->width; x++) {
+			/** The texture value at this pixel. */
+			const uint8_t c = (x ^ (y + frame)) & 0xFF;
+
+			renderer_put_pixel(r, x, y, CANONICAL_COLOUR(255 - (c % 128), c, c % 128));
+		}
+	}
+}
+
+
+/**
+ * renderer_run_benchmark
+ */
+static void renderer_run_benchmark(void)
+{
+	/** The renderer being measured. */
+	Renderer* r = &renderer;
+	/** The number of bytes in a full-screen frame. */
+	const uint64_t frame_size = (uint64_t)r->width * r->height * sizeof(uint32_t);
+	/** The timestamp at the start of a benchmark pass. */
+	uint64_t start = 0;
+	/** The number of cycles taken by a benchmark pass. */
+	uint64_t cycles = 0;
+
+	if(r->back_buffer == NULL) {
+		benchmark_skip("renderer", "no-renderer");
+		return;
+	}
+
+	// Full-screen redraw, drawing pixel by pixel directly to the framebuffer.
+	start = read_timestamp_counter();
+	for(uint32_t i = 0; i < RENDERER_BENCHMARK_ITERATIONS; i++) {
+		for(uint32_t y = 0; y < r->height; y++) {
+			for(uint32_t x = 0; x < r->width; x++) {
+				/** The texture value at this pixel. */
+				const uint8_t c = (x ^ (y + i)) & 0xFF;
+
+				draw_pixel(r->fb, x, y,
+					convert_rgb_to_32bit_colour(255 - (c % 128), c, c % 128));
+			}
+		}
+	}
+	cycles = read_timestamp_counter() - start;
+	benchmark_report(&(Benchmark_Result){
+		.suite = "renderer", .name = "full_screen", .variant = "direct",
+		.size = frame_size, .operations = RENDERER_BENCHMARK_ITERATIONS,
+		.cycles = cycles, .bytes = frame_size * RENDERER_BENCHMARK_ITERATIONS
+	});
+
+	// Full-screen redraw through the back buffer.
+	start = read_timestamp_counter();
+	for(uint32_t i = 0; i < RENDERER_BENCHMARK_ITERATIONS; i++) {
+		draw_benchmark_frame(r, i);
+		renderer_mark_dirty(r, 0, 0, r->width, r->height);
+		renderer_flush(r);
+	}
+	cycles = read_timestamp_counter() - start;
+	benchmark_report(&(Benchmark_Result){
+		.suite = "renderer", .name = "full_screen", .variant = "back_buffer",
+		.size = frame_size, .operations = RENDERER_BENCHMARK_ITERATIONS,
+		.cycles = cycles, .bytes = frame_size * RENDERER_BENCHMARK_ITERATIONS
+	});
+
+	// Flush alone, to isolate the cost of the framebuffer writes.
+	start = read_timestamp_counter();
+	for(uint32_t i = 0; i < RENDERER_BENCHMARK_ITERATIONS; i++) {
+		renderer_mark_dirty(r, 0, 0, r->width, r->height);
+		renderer_flush(r);
+	}
+	cycles = read_timestamp_counter() - start;
+	benchmark_report(&(Benchmark_Result){
+		.suite = "renderer", .name = "full_screen", .variant = "flush_only",
+		.size = frame_size, .operations = RENDERER_BENCHMARK_ITERATIONS,
+		.cycles = cycles, .bytes = frame_size * RENDERER_BENCHMARK_ITERATIONS
+	});
+
+	// The regions are placed within the screen, less their own size.
+	if(r->width <= RENDERER_BENCHMARK_REGION_WIDTH ||
+		r->height <= RENDERER_BENCHMARK_REGION_HEIGHT) {
+		benchmark_skip("renderer", "mode-too-small");
+		return;
+	}
+
+	// Small-region updates, as when drawing a line of text.
+	start = read_timestamp_counter();
+	for(uint32_t i = 0; i < RENDERER_BENCHMARK_ITERATIONS * 64; i++) {
+		/** The position of the region being updated. */
+		const uint32_t x = (i * RENDERER_BENCHMARK_REGION_WIDTH) %
+			(r->width - RENDERER_BENCHMARK_REGION_WIDTH);
+
+		renderer_fill_rect(r, x, (i * 7) % (r->height - RENDERER_BENCHMARK_REGION_HEIGHT),
+			RENDERER_BENCHMARK_REGION_WIDTH, RENDERER_BENCHMARK_REGION_HEIGHT,
+			CANONICAL_COLOUR(i, 255 - i, 128));
+		renderer_flush(r);
+	}
+	cycles = read_timestamp_counter() - start;
+	benchmark_report(&(Benchmark_Result){
+		.suite = "renderer", .name = "region", .variant = "back_buffer",
+		.size = RENDERER_BENCHMARK_REGION_WIDTH * RENDERER_BENCHMARK_REGION_HEIGHT *
+			sizeof(uint32_t),
+		.operations = RENDERER_BENCHMARK_ITERATIONS * 64, .cycles = cycles,
+		.bytes = RENDERER_BENCHMARK_REGION_WIDTH * RENDERER_BENCHMARK_REGION_HEIGHT *
+			sizeof(uint32_t) * RENDERER_BENCHMARK_ITERATIONS * 64
+	});
+}
+
+BENCHMARK(renderer, renderer_run_benchmark);
@@ -0,0 +1,856 @@
+/**
+ * @file scheduler.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Task scheduler.
+ * Contains the implementation of the work-stealing scheduler. The deques
+ * follow Lê et al., "Correct and Efficient Work-Stealing for Weak Memory
+ * Models", with a fixed capacity.
+ * A CPU going idle sets its bit in `idle_mask`, then checks every deque once
+ * more before sleeping. A CPU spawning a task pushes it, then checks
+ * `idle_mask`. Both sides order their write before their read with a full
+ * barrier, so either the idle CPU sees the task, or the spawning CPU sees the
+ * idle CPU and wakes it.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <apic.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <interrupts.h>
+#include <numa.h>
+#include <scheduler.h>
+#include <smp.h>
+#include <tlb.h>
+
+#if SMP_MAX_CPUS > 64
+	#error "The scheduler's idle mask holds at most 64 CPUs"
+#endif
+
+/** The number of tasks spawned at once by the spawn benchmark. */
+#define SCHEDULER_BENCHMARK_BATCH    64
+/** The number of batches spawned by the spawn benchmark. */
+#define SCHEDULER_BENCHMARK_BATCHES  1000
+/** The number of loop iterations in the parallel loop benchmark. */
+#define SCHEDULER_BENCHMARK_ITEMS    0x10000
+/** The amount of work done for each loop iteration. */
+#define SCHEDULER_BENCHMARK_ROUNDS   256
+/** The grain size of the parallel loop benchmark. */
+#define SCHEDULER_BENCHMARK_GRAIN    256
+/** The bits of a task group's state counting its pending tasks. */
+#define TASK_GROUP_PENDING_MASK      0xFFFFFFFFULL
+/** The shift of the waiting CPU within a task group's state. */
+#define TASK_GROUP_WAITER_SHIFT      32
+/** The bits of a task group's state holding the waiting CPU. */
+#define TASK_GROUP_WAITER_MASK       (~TASK_GROUP_PENDING_MASK)
+
+/**
+ * @brief A CPU's scheduler state.
+ * The owner's end of the deque, the thieves' end, and the wake flag are on
+ * separate cache lines, so that stealing does not slow the owner.
+ */
+typedef struct s_scheduler_cpu {
+	int64_t top __attribute__((aligned(64)));
+	int64_t bottom __attribute__((aligned(64)));
+	Task* tasks[SCHEDULER_DEQUE_SIZE];
+	uint32_t wake __attribute__((aligned(64)));
+	bool need_resched;
+	uint64_t random;
+	Scheduler_Stats stats;
+} Scheduler_Cpu;
+
+/**
+ * @brief A parallel loop.
+ */
+typedef struct s_parallel_for {
+	Parallel_For_Function function;
+	void* argument;
+	size_t grain;
+} Parallel_For;
+
+/**
+ * @brief A part of a parallel loop, spawned as a task.
+ */
+typedef struct s_parallel_for_range {
+	Task task;
+	const Parallel_For* loop;
+	size_t begin;
+	size_t end;
+} Parallel_For_Range;
+
+/** The scheduler state of each CPU. */
+static Scheduler_Cpu scheduler_cpus[SMP_MAX_CPUS];
+/** The CPUs which are idle, or about to be, one bit per CPU index. */
+static uint64_t idle_mask = 0;
+/** Whether idle CPUs sleep with `mwait`. */
+static bool use_mwait = false;
+/** The background work done by idle CPUs. */
+static Scheduler_Idle_Work idle_work = NULL;
+/** Whether the yield timer is calibrated. */
+static bool timer_calibrated = false;
+/** The sum computed by the parallel loop benchmark. */
+static uint64_t benchmark_sum = 0;
+
+/**
+ * @brief Pushes a task onto the bottom of a CPU's deque.
+ * Only called by the deque's owner.
+ * @param[in,out] cpu The CPU owning the deque.
+ * @param[in] task The task.
+ * @return Whether the task was pushed. This fails if the deque is full.
+ */
+static bool deque_push(Scheduler_Cpu* cpu,
+	Task* task);
+
+/**
+ * @brief Pops a task from the bottom of a CPU's deque.
+ * Only called by the deque's owner.
+ * @param[in,out] cpu The CPU owning the deque.
+ * @return The most recently pushed task, or NULL if the deque is empty.
+ */
+static Task* deque_pop(Scheduler_Cpu* cpu);
+
+/**
+ * @brief Steals a task from the top of another CPU's deque.
+ * @param[in,out] cpu The CPU owning the deque.
+ * @return The least recently pushed task, or NULL if the deque is empty or
+ * another CPU took the task first.
+ */
+static Task* deque_steal(Scheduler_Cpu* cpu);
+
+/**
+ * @brief Finds a task for the current CPU to run.
+ * Pops from the CPU's own deque, then tries to steal from every other CPU,
+ * starting from a random one. CPUs on the same node are tried first.
+ * @param[in,out] cpu The current CPU's scheduler state.
+ * @param[in] index The current CPU's index.
+ * @return The task, or NULL if none was found.
+ */
+static Task* find_task(Scheduler_Cpu* cpu,
+	const uint32_t index);
+
+/**
+ * @brief Runs a task, then marks it complete in its group.
+ * The task's storage must not be touched once it is complete.
+ * @param[in,out] cpu The current CPU's scheduler state.
+ * @param[in] task The task.
+ */
+static void run_task(Scheduler_Cpu* cpu,
+	Task* task);
+
+/**
+ * @brief Tests whether any CPU's deque holds a task.
+ * @return Whether there is a task to steal.
+ */
+static bool any_work(void);
+
+/**
+ * @brief Wakes a CPU from `idle`.
+ * Does nothing to a CPU which is not asleep, besides ending its next sleep
+ * early.
+ * @param[in] index The CPU's index.
+ */
+static void wake_cpu(const uint32_t index);
+
+/**
+ * @brief Puts the current CPU to sleep until it is woken, or interrupted.
+ * @param[in,out] cpu The current CPU's scheduler state.
+ * @param[in] index The current CPU's index.
+ */
+static void idle(Scheduler_Cpu* cpu,
+	const uint32_t index);
+
+/**
+ * @brief Handles the wake IPI.
+ * There is nothing to do, since the interrupt has already ended the sleep.
+ * @param[in] frame The interrupt frame.
+ */
+static void handle_wake_ipi(Interrupt_Frame* frame);
+
+/**
+ * @brief Handles the yield timer.
+ * Asks the current task to yield.
+ * @param[in] frame The interrupt frame.
+ */
+static void handle_timer(Interrupt_Frame* frame);
+
+/**
+ * @brief Runs part of a parallel loop, splitting it while it is too large.
+ * @param[in] loop The loop.
+ * @param[in] begin The first index of the part.
+ * @param[in] end The index past the end of the part.
+ */
+static void parallel_for_split(const Parallel_For* loop,
+	size_t begin,
+	size_t end);
+
+/**
+ * @brief Runs a spawned part of a parallel loop.
+ * @param[in] argument The `Parallel_For_Range`.
+ */
+static void parallel_for_task(void* argument);
+
+/**
+ * @brief An empty task, used to measure scheduling overhead.
+ * @param[in] argument Unused.
+ */
+static void benchmark_empty_task(void* argument);
+
+/**
+ * @brief The parallel loop benchmark's body.
+ * Hashes each index of the range a number of times, and adds the results to
+ * `benchmark_sum`.
+ * @param[in] begin The first index of the range.
+ * @param[in] end The index past the end of the range.
+ * @param[in] argument Unused.
+ */
+static void benchmark_loop_body(const size_t begin,
+	const size_t end,
+	void* argument);
+
+/**
+ * @brief Runs the scheduler benchmarks.
+ * Measures the cost of spawning and completing a task, and the time taken by
+ * a compute-bound loop run serially and with `scheduler_parallel_for`.
+ */
+static void scheduler_run_benchmark(void);
+
+BENCHMARK(scheduler, scheduler_run_benchmark);
+
+
+/**
+ * deque_push
+ */
+static bool deque_push(Scheduler_Cpu* cpu,
+	Task* task)
+{
+	/** The bottom of the deque. */
+	const int64_t bottom = __atomic_load_n(&cpu->bottom, __ATOMIC_RELAXED);
+	/** The top of the deque. */
+	const int64_t top = __atomic_load_n(&cpu->top, __ATOMIC_ACQUIRE);
+
+	if((bottom - top) >= SCHEDULER_DEQUE_SIZE) {
+		return false;
+	}
+
+	__atomic_store_n(&cpu->tasks[bottom & (SCHEDULER_DEQUE_SIZE - 1)], task,
+		__ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&cpu->bottom, bottom + 1, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+
+/**
+ * deque_pop
+ */
+static Task* deque_pop(Scheduler_Cpu* cpu)
+{
+	/** The bottom of the deque, once the last task is claimed. */
+	const int64_t bottom = __atomic_load_n(&cpu->bottom, __ATOMIC_RELAXED) - 1;
+	/** The top of the deque. */
+	int64_t top;
+	/** The popped task. */
+	Task* task = NULL;
+
+	__atomic_store_n(&cpu->bottom, bottom, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	top = __atomic_load_n(&cpu->top, __ATOMIC_RELAXED);
+
+	if(top > bottom) {
+		__atomic_store_n(&cpu->bottom, bottom + 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	task = __atomic_load_n(&cpu->tasks[bottom & (SCHEDULER_DEQUE_SIZE - 1)],
+		__ATOMIC_RELAXED);
+
+	// The last task may be contended by a thief, which takes it from the top.
+	if(top == bottom) {
+		if(!__atomic_compare_exchange_n(&cpu->top, &top, top + 1, false,
+			__ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+			task = NULL;
+		}
+
+		__atomic_store_n(&cpu->bottom, bottom + 1, __ATOMIC_RELAXED);
+	}
+
+	return task;
+}
+
+
+/**
+ * deque_steal
+ */
+static Task* deque_steal(Scheduler_Cpu* cpu)
+{
+	/** The top of the deque. */
+	int64_t top = __atomic_load_n(&cpu->top, __ATOMIC_ACQUIRE);
+	/** The bottom of the deque. */
+	int64_t bottom;
+	/** The stolen task. */
+	Task* task;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	bottom = __atomic_load_n(&cpu->bottom, __ATOMIC_ACQUIRE);
+
+	if(top >= bottom) {
+		return NULL;
+	}
+
+	task = __atomic_load_n(&cpu->tasks[top & (SCHEDULER_DEQUE_SIZE - 1)],
+		__ATOMIC_RELAXED);
+	if(!__atomic_compare_exchange_n(&cpu->top, &top, top + 1, false,
+		__ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+		return NULL;
+	}
+
+	return task;
+}
+
+
+/**
+ * find_task
+ */
+static Task* find_task(Scheduler_Cpu* cpu,
+	const uint32_t index)
+{
+	/** The number of CPUs which may hold tasks. */
+	const uint32_t n_cpus = smp.n_cpus;
+	/** The task found. */
+	Task* task = deque_pop(cpu);
+	/** The first CPU to steal from. */
+	uint32_t start;
+
+	if(task || n_cpus == 1) {
+		return task;
+	}
+
+	// Xorshift, so that thieves spread across their victims.
+	cpu->random ^= cpu->random << 13;
+	cpu->random ^= cpu->random >> 7;
+	cpu->random ^= cpu->random << 17;
+	start = (uint32_t)(cpu->random % n_cpus);
+
+	// Stealing from the same node first keeps tasks near the memory their
+	// parent allocated. Remote CPUs are only tried once the node has no work.
+	for(uint32_t pass = 0; pass < (numa.n_nodes > 1 ? 2 : 1); pass++) {
+		for(uint32_t i = 0; i < n_cpus; i++) {
+			/** The CPU being stolen from. */
+			const uint32_t victim = (start + i) % n_cpus;
+			/** Whether the victim is on the current CPU's node. */
+			const bool local = cpu_locals[victim].node == cpu_locals[index].node;
+
+			if(victim == index || (numa.n_nodes > 1 && local != (pass == 0))) {
+				continue;
+			}
+
+			task = deque_steal(&scheduler_cpus[victim]);
+			if(task) {
+				cpu->stats.steals++;
+				return task;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * run_task
+ */
+static void run_task(Scheduler_Cpu* cpu,
+	Task* task)
+{
+	/** The task's group, read before the task completes. */
+	Task_Group* group = task->group;
+
+	/** The group's state once the task has completed. */
+	uint64_t state;
+
+	task->function(task->argument);
+	cpu->stats.tasks_run++;
+
+	// The group may be gone as soon as its count reaches zero, so the waiter
+	// is taken from the same atomic operation.
+	state = __atomic_sub_fetch(&group->state, 1, __ATOMIC_ACQ_REL);
+	if((state & TASK_GROUP_PENDING_MASK) == 0 && (state >> TASK_GROUP_WAITER_SHIFT)) {
+		wake_cpu((uint32_t)(state >> TASK_GROUP_WAITER_SHIFT) - 1);
+	}
+}
+
+
+/**
+ * any_work
+ */
+static bool any_work(void)
+{
+	for(uint32_t i = 0; i < smp.n_cpus; i++) {
+		if(__atomic_load_n(&scheduler_cpus[i].top, __ATOMIC_RELAXED) <
+			__atomic_load_n(&scheduler_cpus[i].bottom, __ATOMIC_RELAXED)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * scheduler_wake_idle_cpu
+ */
+void scheduler_wake_idle_cpu(void)
+{
+	/** The idle CPUs. */
+	uint64_t mask;
+	/** The index of the CPU being woken. */
+	uint32_t index;
+
+	// Pairs with the barrier in `idle`, between setting the idle bit and
+	// checking for work.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	mask = __atomic_load_n(&idle_mask, __ATOMIC_RELAXED);
+	while(mask) {
+		index = (uint32_t)__builtin_ctzll(mask);
+
+		// Only the CPU which clears the idle bit wakes the idle CPU.
+		if(__atomic_fetch_and(&idle_mask, ~(1ULL << index), __ATOMIC_ACQ_REL) &
+			(1ULL << index)) {
+			wake_cpu(index);
+			return;
+		}
+
+		mask = __atomic_load_n(&idle_mask, __ATOMIC_RELAXED);
+	}
+}
+
+
+/**
+ * wake_cpu
+ */
+static void wake_cpu(const uint32_t index)
+{
+	__atomic_store_n(&scheduler_cpus[index].wake, 1, __ATOMIC_RELEASE);
+	if(!use_mwait) {
+		apic_send_ipi(cpu_locals[index].apic_id, SCHEDULER_WAKE_VECTOR);
+	}
+}
+
+
+/**
+ * idle
+ */
+static void idle(Scheduler_Cpu* cpu,
+	const uint32_t index)
+{
+	/** The CPU's bit in the idle mask. */
+	const uint64_t bit = 1ULL << index;
+
+	disable_interrupts();
+
+	__atomic_fetch_or(&idle_mask, bit, __ATOMIC_SEQ_CST);
+
+	if(any_work() || __atomic_load_n(&cpu->wake, __ATOMIC_ACQUIRE)) {
+		__atomic_fetch_and(&idle_mask, ~bit, __ATOMIC_RELAXED);
+		__atomic_store_n(&cpu->wake, 0, __ATOMIC_RELAXED);
+		enable_interrupts();
+		return;
+	}
+
+	// TLB shootdowns skip the CPU while it sleeps, and are caught up on waking.
+	tlb_enter_lazy();
+
+	if(use_mwait) {
+		// A write to the wake flag after it is armed ends the wait.
+		monitor(&cpu->wake);
+		if(__atomic_load_n(&cpu->wake, __ATOMIC_ACQUIRE)) {
+			enable_interrupts();
+		} else {
+			enable_interrupts_and_mwait();
+		}
+	} else {
+		enable_interrupts_and_halt();
+	}
+
+	tlb_exit_lazy();
+
+	__atomic_fetch_and(&idle_mask, ~bit, __ATOMIC_RELAXED);
+	__atomic_store_n(&cpu->wake, 0, __ATOMIC_RELAXED);
+	cpu->stats.wakeups++;
+}
+
+
+/**
+ * handle_wake_ipi
+ */
+static void handle_wake_ipi(Interrupt_Frame* frame)
+{
+	(void)frame;
+}
+
+
+/**
+ * handle_timer
+ */
+static void handle_timer(Interrupt_Frame* frame)
+{
+	(void)frame;
+
+	scheduler_cpus[smp_get_cpu_index()].need_resched = true;
+}
+
+
+/**
+ * scheduler_initialize
+ */
+void scheduler_initialize(void)
+{
+	use_mwait = cpu_features.monitor;
+
+	for(size_t i = 0; i < SMP_MAX_CPUS; i++) {
+		// Any non-zero seed will do.
+		scheduler_cpus[i].random = (i + 1) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	interrupts_register_vector_handler(SCHEDULER_WAKE_VECTOR, handle_wake_ipi);
+
+	#if SCHEDULER_YIELD_TIMER
+		interrupts_register_vector_handler(SCHEDULER_TIMER_VECTOR, handle_timer);
+		timer_calibrated = apic_timer_calibrate();
+	#else
+		(void)handle_timer;
+	#endif
+}
+
+
+/**
+ * scheduler_set_idle_work
+ */
+void scheduler_set_idle_work(Scheduler_Idle_Work work)
+{
+	__atomic_store_n(&idle_work, work, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * scheduler_run
+ */
+void scheduler_run(Scheduler_Idle_Hook idle_hook)
+{
+	/** The current CPU's index. */
+	const uint32_t index = smp_get_cpu_index();
+	/** The current CPU's scheduler state. */
+	Scheduler_Cpu* cpu = &scheduler_cpus[index];
+	/** The task being run. */
+	Task* task;
+	/** The background work to do. */
+	Scheduler_Idle_Work work;
+
+	if(timer_calibrated) {
+		apic_timer_start(SCHEDULER_TIMER_VECTOR, SCHEDULER_TIMESLICE_US);
+	}
+
+	enable_interrupts();
+
+	while(1) {
+		task = find_task(cpu, index);
+		if(task) {
+			cpu->need_resched = false;
+			run_task(cpu, task);
+			continue;
+		}
+
+		work = __atomic_load_n(&idle_work, __ATOMIC_ACQUIRE);
+		if(work && work()) {
+			continue;
+		}
+
+		idle(cpu, index);
+
+		if(idle_hook) {
+			idle_hook();
+		}
+	}
+}
+
+
+/**
+ * scheduler_spawn
+ */
+void scheduler_spawn(Task* task,
+	Task_Function function,
+	void* argument,
+	Task_Group* group)
+{
+	/** The current CPU's scheduler state. */
+	Scheduler_Cpu* cpu = &scheduler_cpus[smp_get_cpu_index()];
+
+	task->function = function;
+	task->argument = argument;
+	task->group = group;
+
+	__atomic_add_fetch(&group->state, 1, __ATOMIC_RELAXED);
+
+	if(!deque_push(cpu, task)) {
+		run_task(cpu, task);
+		return;
+	}
+
+	scheduler_wake_idle_cpu();
+}
+
+
+/**
+ * scheduler_wait
+ */
+void scheduler_wait(Task_Group* group)
+{
+	/** The current CPU's index. */
+	const uint32_t index = smp_get_cpu_index();
+	/** The current CPU's scheduler state. */
+	Scheduler_Cpu* cpu = &scheduler_cpus[index];
+	/** The task being run while waiting. */
+	Task* task;
+	/** The group's state. */
+	uint64_t state;
+
+	while(__atomic_load_n(&group->state, __ATOMIC_ACQUIRE) & TASK_GROUP_PENDING_MASK) {
+		task = find_task(cpu, index);
+		if(task) {
+			run_task(cpu, task);
+			continue;
+		}
+
+		// The remaining tasks are running on other CPUs. Registering as the
+		// waiter, then checking the count in the same operation, means either
+		// the last task sees this CPU, or this CPU sees the group complete.
+		state = __atomic_or_fetch(&group->state,
+			(uint64_t)(index + 1) << TASK_GROUP_WAITER_SHIFT, __ATOMIC_ACQ_REL);
+		if((state & TASK_GROUP_PENDING_MASK) == 0) {
+			break;
+		}
+
+		idle(cpu, index);
+	}
+
+	// The group may be reused, so the waiter is cleared once the wait is over.
+	// A last task which read it just before then only causes a spurious wake.
+	if(__atomic_load_n(&group->state, __ATOMIC_RELAXED) & TASK_GROUP_WAITER_MASK) {
+		__atomic_and_fetch(&group->state, ~TASK_GROUP_WAITER_MASK, __ATOMIC_RELAXED);
+	}
+}
+
+
+/**
+ * parallel_for_task
+ */
+static void parallel_for_task(void* argument)
+{
+	/** The part of the loop to run. */
+	const Parallel_For_Range* range = argument;
+
+	parallel_for_split(range->loop, range->begin, range->end);
+}
+
+
+/**
+ * parallel_for_split
+ */
+static void parallel_for_split(const Parallel_For* loop,
+	size_t begin,
+	size_t end)
+{
+	/** The upper half, while it is spawned. */
+	Parallel_For_Range upper;
+	/** The group holding the upper half. */
+	Task_Group group = {0};
+
+	if((end - begin) <= loop->grain) {
+		loop->function(begin, end, loop->argument);
+		return;
+	}
+
+	upper.loop = loop;
+	upper.begin = begin + ((end - begin) / 2);
+	upper.end = end;
+	scheduler_spawn(&upper.task, parallel_for_task, &upper, &group);
+
+	parallel_for_split(loop, begin, upper.begin);
+
+	scheduler_wait(&group);
+}
+
+
+/**
+ * scheduler_parallel_for
+ */
+void scheduler_parallel_for(const size_t begin,
+	const size_t end,
+	const size_t grain,
+	Parallel_For_Function function,
+	void* argument)
+{
+	/** The loop. */
+	Parallel_For loop;
+
+	if(end <= begin) {
+		return;
+	}
+
+	loop.function = function;
+	loop.argument = argument;
+	loop.grain = (grain == 0) ? 1 : grain;
+
+	parallel_for_split(&loop, begin, end);
+}
+
+
+/**
+ * scheduler_should_yield
+ */
+bool scheduler_should_yield(void)
+{
+	return scheduler_cpus[smp_get_cpu_index()].need_resched;
+}
+
+
+/**
+ * scheduler_yield
+ */
+void scheduler_yield(void)
+{
+	/** The current CPU's index. */
+	const uint32_t index = smp_get_cpu_index();
+	/** The current CPU's scheduler state. */
+	Scheduler_Cpu* cpu = &scheduler_cpus[index];
+	/** The task run in place of the current one. */
+	Task* task;
+
+	cpu->need_resched = false;
+
+	task = find_task(cpu, index);
+	if(task) {
+		run_task(cpu, task);
+	}
+}
+
+
+/**
+ * scheduler_get_stats
+ */
+const Scheduler_Stats* scheduler_get_stats(const uint32_t cpu_index)
+{
+	return &scheduler_cpus[cpu_index].stats;
+}
+
+
+/**
+ * benchmark_empty_task
+ */
+static void benchmark_empty_task(void* argument)
+{
+	(void)argument;
+}
+
+
+/**
+ * benchmark_loop_body
+ */
+static void benchmark_loop_body(const size_t begin,
+	const size_t end,
+	void* argument)
+{
+	/** The sum of the hashes of the range. */
+	uint64_t sum = 0;
+
+	(void)argument;
+
+	for(size_t i = begin; i < end; i++) {
+		/** The value being hashed. */
+		uint64_t value = i;
+
+		for(size_t round = 0; round < SCHEDULER_BENCHMARK_ROUNDS; round++) {
+			value ^= value >> 33;
+			value *= 0xFF51AFD7ED558CCDULL;
+			value ^= value >> 29;
+		}
+
+		sum += value;
+	}
+
+	__atomic_fetch_add(&benchmark_sum, sum, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * scheduler_run_benchmark
+ */
+static void scheduler_run_benchmark(void)
+{
+	/** The tasks spawned by the spawn benchmark. */
+	Task tasks[SCHEDULER_BENCHMARK_BATCH];
+	/** The group of the current batch. */
+	Task_Group group = {0};
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles taken by the measurement. */
+	uint64_t cycles;
+	/** The steals by every CPU during the parallel loop. */
+	uint64_t steals = 0;
+
+	start = read_timestamp_counter();
+	for(size_t batch = 0; batch < SCHEDULER_BENCHMARK_BATCHES; batch++) {
+		for(size_t i = 0; i < SCHEDULER_BENCHMARK_BATCH; i++) {
+			scheduler_spawn(&tasks[i], benchmark_empty_task, NULL, &group);
+		}
+
+		scheduler_wait(&group);
+	}
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "scheduler", .name = "spawn_wait", .variant = "empty",
+		.size = SCHEDULER_BENCHMARK_BATCH,
+		.operations = SCHEDULER_BENCHMARK_BATCHES * SCHEDULER_BENCHMARK_BATCH,
+		.cycles = read_timestamp_counter() - start,
+		.counters = { { "cpus", smp.n_online } }
+	});
+
+	benchmark_sum = 0;
+	start = read_timestamp_counter();
+	benchmark_loop_body(0, SCHEDULER_BENCHMARK_ITEMS, NULL);
+	cycles = read_timestamp_counter() - start;
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "scheduler", .name = "parallel_for", .variant = "serial",
+		.size = SCHEDULER_BENCHMARK_GRAIN,
+		.operations = SCHEDULER_BENCHMARK_ITEMS,
+		.cycles = cycles,
+		.counters = { { "cpus", 1 } }
+	});
+
+	for(uint32_t i = 0; i < smp.n_cpus; i++) {
+		steals -= __atomic_load_n(&scheduler_cpus[i].stats.steals, __ATOMIC_RELAXED);
+	}
+
+	benchmark_sum = 0;
+	start = read_timestamp_counter();
+	scheduler_parallel_for(0, SCHEDULER_BENCHMARK_ITEMS,
+		SCHEDULER_BENCHMARK_GRAIN, benchmark_loop_body, NULL);
+	cycles = read_timestamp_counter() - start;
+
+	for(uint32_t i = 0; i < smp.n_cpus; i++) {
+		steals += __atomic_load_n(&scheduler_cpus[i].stats.steals, __ATOMIC_RELAXED);
+	}
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "scheduler", .name = "parallel_for", .variant = "parallel",
+		.size = SCHEDULER_BENCHMARK_GRAIN,
+		.operations = SCHEDULER_BENCHMARK_ITEMS,
+		.cycles = cycles,
+		.counters = { { "cpus", smp.n_online }, { "steals", steals } }
+	});
+}
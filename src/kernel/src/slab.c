@@ -0,0 +1,779 @@
+/**
+ * @file slab.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Slab allocator.
+ * Contains the implementation of the object caches and the kernel heap. Each
+ * slab is a single page, so the slab holding an object is found by rounding
+ * the object's address down to a page. Allocations too large for a size class
+ * start with a `Slab` header whose cache is NULL, recording the order of the
+ * pages to free.
+ * Free objects within a slab are linked through their first word.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <clock.h>
+#include <cpu.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <scheduler.h>
+#include <slab.h>
+#include <smp.h>
+#include <spinlock.h>
+
+/** The offset of a large allocation from the start of its pages. */
+#define SLAB_LARGE_OFFSET            64
+/** The highest order of a large allocation: The page allocator's highest. */
+#define SLAB_LARGE_MAX_ORDER         (PAGE_ALLOCATOR_ORDERS - 1)
+/** The granularity of the size class lookup table. */
+#define SLAB_CLASS_SHIFT             4
+
+/** The number of objects allocated at once by each benchmark round. */
+#define SLAB_BENCHMARK_BATCH         16
+/** The number of rounds run by each benchmark. */
+#define SLAB_BENCHMARK_ROUNDS        4096
+/** The number of objects passed between CPUs by the cross-CPU benchmark. */
+#define SLAB_BENCHMARK_TRANSFERS     0x10000
+/** The capacity of the cross-CPU benchmark's ring. This must be a power of two. */
+#define SLAB_BENCHMARK_RING_SIZE     256
+/** How long to wait for another CPU to take the consumer, in nanoseconds. */
+#define SLAB_BENCHMARK_START_TIMEOUT_NS  100000000ULL
+
+/**
+ * @brief The ring passing objects from producer to consumer in the cross-CPU
+ * benchmark.
+ * `head` is written only by the producer and `tail` only by the consumer,
+ * each on its own cache line.
+ */
+typedef struct s_slab_benchmark_ring {
+	uint64_t head __attribute__((aligned(64)));
+	uint64_t tail __attribute__((aligned(64)));
+	bool started __attribute__((aligned(64)));
+	bool abort;
+	void* objects[SLAB_BENCHMARK_RING_SIZE];
+} Slab_Benchmark_Ring;
+
+/** The size of each `kmalloc` size class. */
+static const uint32_t class_sizes[SLAB_N_CLASSES] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+/** The name of each `kmalloc` size class. */
+static const char* const class_names[SLAB_N_CLASSES] = {
+	"kmalloc-16", "kmalloc-32", "kmalloc-48", "kmalloc-64", "kmalloc-96",
+	"kmalloc-128", "kmalloc-192", "kmalloc-256", "kmalloc-384", "kmalloc-512",
+	"kmalloc-768", "kmalloc-1024"
+};
+
+/** The cache of each `kmalloc` size class. */
+static Slab_Cache kmalloc_caches[SLAB_N_CLASSES];
+/** The size class of each request size, in units of 16 bytes, rounded up. */
+static uint8_t class_lookup[(SLAB_MAX_CLASS_SIZE >> SLAB_CLASS_SHIFT) + 1];
+/** The cache of cache line aligned objects used by the benchmarks. */
+static Slab_Cache benchmark_cache;
+/** The ring used by the cross-CPU benchmark. */
+static Slab_Benchmark_Ring benchmark_ring;
+
+/**
+ * @brief Gets the slab holding an object.
+ * @param[in] object The object.
+ * @return The slab.
+ */
+static inline Slab* get_slab(const void* object);
+
+/**
+ * @brief Adds a slab to its cache's list of slabs with free objects.
+ * @param[in,out] cache The cache.
+ * @param[in,out] slab The slab.
+ */
+static void link_slab(Slab_Cache* cache,
+	Slab* slab);
+
+/**
+ * @brief Removes a slab from its cache's list of slabs with free objects.
+ * @param[in,out] cache The cache.
+ * @param[in,out] slab The slab.
+ */
+static void unlink_slab(Slab_Cache* cache,
+	Slab* slab);
+
+/**
+ * @brief Creates a slab for a cache.
+ * Allocates a page and links every object into the slab's free list. Must be
+ * called with the cache locked.
+ * @param[in,out] cache The cache.
+ * @return The slab, or NULL if no memory is free.
+ */
+static Slab* create_slab(Slab_Cache* cache);
+
+/**
+ * @brief Fills a magazine with objects from the cache's slabs.
+ * Takes the cache's lock.
+ * @param[in,out] cache The cache.
+ * @param[in,out] magazine The magazine, which must be empty.
+ */
+static void refill_magazine(Slab_Cache* cache,
+	Slab_Magazine* magazine);
+
+/**
+ * @brief Returns every object in a magazine to its slab.
+ * Frees slabs left with no objects in use, beyond the `SLAB_MAX_EMPTY_SLABS`
+ * kept by the cache. Takes the cache's lock.
+ * @param[in,out] cache The cache.
+ * @param[in,out] magazine The magazine.
+ */
+static void flush_magazine(Slab_Cache* cache,
+	Slab_Magazine* magazine);
+
+/**
+ * @brief Swaps a CPU's loaded and previous magazines.
+ * @param[in,out] cpu The CPU's magazines.
+ */
+static inline void swap_magazines(Slab_Cpu* cpu);
+
+/**
+ * @brief Allocates and frees objects with `kmalloc`, for the benchmarks.
+ * @param[in] size The size of each object.
+ * @param[in] rounds The number of rounds to run.
+ */
+static void benchmark_kmalloc(const size_t size,
+	const size_t rounds);
+
+/**
+ * @brief Frees the objects passed through the benchmark ring.
+ * Run as a task, which the producer waits for another CPU to take.
+ * @param[in] argument Unused.
+ */
+static void benchmark_consume(void* argument);
+
+/**
+ * @brief Measures freeing objects on a different CPU from the one which
+ * allocated them.
+ * The current CPU allocates objects and passes them through a ring to a
+ * consumer task running on another CPU, which frees them.
+ */
+static void benchmark_cross_cpu(void);
+
+/**
+ * @brief Runs the slab allocator benchmarks.
+ * Measures `kmalloc` and `kfree` for a range of sizes on one CPU, a cache of
+ * cache line aligned objects, and the cross-CPU producer-consumer pattern.
+ */
+static void slab_run_benchmark(void);
+
+BENCHMARK(slab, slab_run_benchmark);
+
+
+/**
+ * get_slab
+ */
+static inline Slab* get_slab(const void* object)
+{
+	return (Slab*)((uintptr_t)object & ~(PAGE_SIZE - 1));
+}
+
+
+/**
+ * link_slab
+ */
+static void link_slab(Slab_Cache* cache,
+	Slab* slab)
+{
+	slab->prev = NULL;
+	slab->next = cache->partial;
+	if(cache->partial) {
+		cache->partial->prev = slab;
+	}
+
+	cache->partial = slab;
+}
+
+
+/**
+ * unlink_slab
+ */
+static void unlink_slab(Slab_Cache* cache,
+	Slab* slab)
+{
+	if(slab->prev) {
+		slab->prev->next = slab->next;
+	} else {
+		cache->partial = slab->next;
+	}
+
+	if(slab->next) {
+		slab->next->prev = slab->prev;
+	}
+
+	slab->next = NULL;
+	slab->prev = NULL;
+}
+
+
+/**
+ * create_slab
+ */
+static Slab* create_slab(Slab_Cache* cache)
+{
+	/** The slab's page. */
+	const uintptr_t page = page_allocator_alloc(0);
+	/** The slab. */
+	Slab* slab = (Slab*)page;
+	/** The object being linked into the free list. */
+	uintptr_t object;
+
+	if(page == 0) {
+		return NULL;
+	}
+
+	slab->cache = cache;
+	slab->next = NULL;
+	slab->prev = NULL;
+	slab->free = NULL;
+	slab->in_use = 0;
+	slab->order = 0;
+
+	// Linked from the last object, so that objects are handed out in order.
+	object = page + cache->offset +
+		((cache->objects_per_slab - 1) * cache->object_size);
+	for(uint32_t i = 0; i < cache->objects_per_slab; i++) {
+		*(void**)object = slab->free;
+		slab->free = (void*)object;
+		object -= cache->object_size;
+	}
+
+	cache->n_slabs++;
+	cache->n_empty++;
+
+	return slab;
+}
+
+
+/**
+ * refill_magazine
+ */
+static void refill_magazine(Slab_Cache* cache,
+	Slab_Magazine* magazine)
+{
+	/** The slab objects are taken from. */
+	Slab* slab;
+
+	spinlock_acquire(&cache->lock);
+
+	while(magazine->count < SLAB_MAGAZINE_SIZE) {
+		slab = cache->partial;
+		if(slab == NULL) {
+			slab = create_slab(cache);
+			if(slab == NULL) {
+				break;
+			}
+
+			link_slab(cache, slab);
+		}
+
+		if(slab->in_use == 0) {
+			cache->n_empty--;
+		}
+
+		while(slab->free && magazine->count < SLAB_MAGAZINE_SIZE) {
+			magazine->objects[magazine->count++] = slab->free;
+			slab->free = *(void**)slab->free;
+			slab->in_use++;
+		}
+
+		if(slab->free == NULL) {
+			unlink_slab(cache, slab);
+		}
+	}
+
+	spinlock_release(&cache->lock);
+}
+
+
+/**
+ * flush_magazine
+ */
+static void flush_magazine(Slab_Cache* cache,
+	Slab_Magazine* magazine)
+{
+	spinlock_acquire(&cache->lock);
+
+	for(uint32_t i = 0; i < magazine->count; i++) {
+		/** The object being returned. */
+		void* object = magazine->objects[i];
+		/** The object's slab. */
+		Slab* slab = get_slab(object);
+
+		if(slab->free == NULL) {
+			link_slab(cache, slab);
+		}
+
+		*(void**)object = slab->free;
+		slab->free = object;
+		slab->in_use--;
+
+		if(slab->in_use != 0) {
+			continue;
+		}
+
+		if(cache->n_empty < SLAB_MAX_EMPTY_SLABS) {
+			cache->n_empty++;
+		} else {
+			unlink_slab(cache, slab);
+			cache->n_slabs--;
+			page_allocator_free((uintptr_t)slab, 0);
+		}
+	}
+
+	magazine->count = 0;
+
+	spinlock_release(&cache->lock);
+}
+
+
+/**
+ * swap_magazines
+ */
+static inline void swap_magazines(Slab_Cpu* cpu)
+{
+	/** The loaded magazine. */
+	Slab_Magazine* loaded = cpu->loaded;
+
+	cpu->loaded = cpu->previous;
+	cpu->previous = loaded;
+}
+
+
+/**
+ * slab_cache_initialize
+ */
+bool slab_cache_initialize(Slab_Cache* cache,
+	const char* name,
+	const size_t object_size,
+	const size_t align)
+{
+	/** The object size, rounded up to the alignment. */
+	size_t size;
+
+	if(align == 0 || (align & (align - 1)) != 0) {
+		return false;
+	}
+
+	size = (object_size + align - 1) & ~(align - 1);
+	if(size < sizeof(void*)) {
+		size = sizeof(void*);
+	}
+
+	cache->name = name;
+	cache->object_size = (uint32_t)size;
+	cache->offset = (uint32_t)((sizeof(Slab) + align - 1) & ~(align - 1));
+	if((cache->offset + size) > PAGE_SIZE) {
+		return false;
+	}
+
+	cache->objects_per_slab = (uint32_t)((PAGE_SIZE - cache->offset) / size);
+	cache->n_empty = 0;
+	cache->n_slabs = 0;
+	cache->lock = (Spinlock)SPINLOCK_INITIALIZER;
+	cache->partial = NULL;
+
+	for(size_t i = 0; i < SMP_MAX_CPUS; i++) {
+		cache->cpus[i].magazines[0].count = 0;
+		cache->cpus[i].magazines[1].count = 0;
+		cache->cpus[i].loaded = &cache->cpus[i].magazines[0];
+		cache->cpus[i].previous = &cache->cpus[i].magazines[1];
+
+		#if SLAB_STATISTICS
+			cache->cpus[i].stats = (Slab_Stats){ 0 };
+		#endif
+	}
+
+	return true;
+}
+
+
+/**
+ * slab_cache_alloc
+ */
+void* slab_cache_alloc(Slab_Cache* cache)
+{
+	/** The saved interrupt flag. */
+	const uint64_t flags = save_and_disable_interrupts();
+	/** The current CPU's magazines. */
+	Slab_Cpu* cpu = &cache->cpus[smp_get_cpu_index()];
+	/** The allocated object. */
+	void* object = NULL;
+
+	if(cpu->loaded->count == 0) {
+		if(cpu->previous->count != 0) {
+			swap_magazines(cpu);
+		} else {
+			refill_magazine(cache, cpu->loaded);
+
+			#if SLAB_STATISTICS
+				cpu->stats.refills++;
+			#endif
+		}
+	}
+
+	if(cpu->loaded->count != 0) {
+		object = cpu->loaded->objects[--cpu->loaded->count];
+
+		#if SLAB_STATISTICS
+			cpu->stats.allocations++;
+		#endif
+	}
+
+	restore_interrupts(flags);
+
+	return object;
+}
+
+
+/**
+ * slab_cache_free
+ */
+void slab_cache_free(Slab_Cache* cache,
+	void* object)
+{
+	/** The saved interrupt flag. */
+	const uint64_t flags = save_and_disable_interrupts();
+	/** The current CPU's magazines. */
+	Slab_Cpu* cpu = &cache->cpus[smp_get_cpu_index()];
+
+	if(cpu->loaded->count == SLAB_MAGAZINE_SIZE) {
+		if(cpu->previous->count == SLAB_MAGAZINE_SIZE) {
+			flush_magazine(cache, cpu->previous);
+
+			#if SLAB_STATISTICS
+				cpu->stats.flushes++;
+			#endif
+		}
+
+		swap_magazines(cpu);
+	}
+
+	cpu->loaded->objects[cpu->loaded->count++] = object;
+
+	#if SLAB_STATISTICS
+		cpu->stats.frees++;
+	#endif
+
+	restore_interrupts(flags);
+}
+
+
+/**
+ * slab_cache_get_stats
+ */
+void slab_cache_get_stats(const Slab_Cache* cache,
+	Slab_Stats* stats)
+{
+	*stats = (Slab_Stats){ 0 };
+
+	#if SLAB_STATISTICS
+		for(size_t i = 0; i < SMP_MAX_CPUS; i++) {
+			stats->allocations += cache->cpus[i].stats.allocations;
+			stats->frees += cache->cpus[i].stats.frees;
+			stats->refills += cache->cpus[i].stats.refills;
+			stats->flushes += cache->cpus[i].stats.flushes;
+		}
+	#else
+		(void)cache;
+	#endif
+}
+
+
+/**
+ * slab_initialize
+ */
+void slab_initialize(void)
+{
+	/** The size class being filled into the lookup table. */
+	uint32_t class_index = 0;
+
+	for(uint32_t i = 0; i < SLAB_N_CLASSES; i++) {
+		slab_cache_initialize(&kmalloc_caches[i], class_names[i], class_sizes[i],
+			1U << SLAB_CLASS_SHIFT);
+	}
+
+	for(uint32_t i = 0; i <= (SLAB_MAX_CLASS_SIZE >> SLAB_CLASS_SHIFT); i++) {
+		while(class_sizes[class_index] < (i << SLAB_CLASS_SHIFT)) {
+			class_index++;
+		}
+
+		class_lookup[i] = (uint8_t)class_index;
+	}
+}
+
+
+/**
+ * kmalloc
+ */
+void* kmalloc(const size_t size)
+{
+	/** The order of the pages of a large allocation. */
+	uint32_t order = 0;
+	/** The pages of a large allocation. */
+	uintptr_t pages;
+
+	if(size == 0) {
+		return NULL;
+	}
+
+	if(size <= SLAB_MAX_CLASS_SIZE) {
+		return slab_cache_alloc(&kmalloc_caches[class_lookup[
+			(size + (1U << SLAB_CLASS_SHIFT) - 1) >> SLAB_CLASS_SHIFT]]);
+	}
+
+	// Requests which do not fit the largest block are rejected first, so that
+	// neither the header offset nor the block size overflows.
+	if(size > (PAGE_SIZE << SLAB_LARGE_MAX_ORDER) - SLAB_LARGE_OFFSET) {
+		return NULL;
+	}
+
+	while(order < SLAB_LARGE_MAX_ORDER &&
+		(PAGE_SIZE << order) < (size + SLAB_LARGE_OFFSET)) {
+		order++;
+	}
+
+	pages = page_allocator_alloc(order);
+	if(pages == 0) {
+		return NULL;
+	}
+
+	((Slab*)pages)->cache = NULL;
+	((Slab*)pages)->order = order;
+
+	return (void*)(pages + SLAB_LARGE_OFFSET);
+}
+
+
+/**
+ * kfree
+ */
+void kfree(void* pointer)
+{
+	/** The slab, or large allocation header, holding the memory. */
+	Slab* slab = get_slab(pointer);
+
+	if(pointer == NULL) {
+		return;
+	}
+
+	if(slab->cache) {
+		slab_cache_free(slab->cache, pointer);
+	} else {
+		page_allocator_free((uintptr_t)slab, slab->order);
+	}
+}
+
+
+/**
+ * benchmark_kmalloc
+ */
+static void benchmark_kmalloc(const size_t size,
+	const size_t rounds)
+{
+	/** The objects allocated in the current round. */
+	void* objects[SLAB_BENCHMARK_BATCH];
+
+	for(size_t round = 0; round < rounds; round++) {
+		for(size_t i = 0; i < SLAB_BENCHMARK_BATCH; i++) {
+			objects[i] = kmalloc(size);
+		}
+
+		for(size_t i = 0; i < SLAB_BENCHMARK_BATCH; i++) {
+			kfree(objects[i]);
+		}
+	}
+}
+
+
+/**
+ * benchmark_consume
+ */
+static void benchmark_consume(void* argument)
+{
+	/** The position of the next object to free. */
+	uint64_t tail = 0;
+	/** The position past the last object passed. */
+	uint64_t head;
+
+	(void)argument;
+
+	__atomic_store_n(&benchmark_ring.started, true, __ATOMIC_RELEASE);
+
+	while(tail < SLAB_BENCHMARK_TRANSFERS) {
+		if(__atomic_load_n(&benchmark_ring.abort, __ATOMIC_ACQUIRE)) {
+			return;
+		}
+
+		head = __atomic_load_n(&benchmark_ring.head, __ATOMIC_ACQUIRE);
+		if(head == tail) {
+			cpu_relax();
+			continue;
+		}
+
+		while(tail < head) {
+			kfree(benchmark_ring.objects[tail & (SLAB_BENCHMARK_RING_SIZE - 1)]);
+			tail++;
+		}
+
+		__atomic_store_n(&benchmark_ring.tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+
+/**
+ * benchmark_cross_cpu
+ */
+static void benchmark_cross_cpu(void)
+{
+	/** The consumer task. */
+	Task consumer;
+	/** The group holding the consumer. */
+	Task_Group group = {0};
+	/** The time by which another CPU must take the consumer. */
+	uint64_t deadline;
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles taken by the measurement. */
+	uint64_t cycles;
+
+	if(smp.n_online < 2) {
+		benchmark_skip("slab_cross_cpu", "single_cpu");
+		return;
+	}
+
+	benchmark_ring.head = 0;
+	benchmark_ring.tail = 0;
+	benchmark_ring.started = false;
+	benchmark_ring.abort = false;
+
+	// This CPU must not run the consumer itself, since the consumer would then
+	// wait forever for the producer beneath it.
+	scheduler_spawn(&consumer, benchmark_consume, NULL, &group);
+
+	deadline = clock_now_ns() + SLAB_BENCHMARK_START_TIMEOUT_NS;
+	while(!__atomic_load_n(&benchmark_ring.started, __ATOMIC_ACQUIRE)) {
+		if(clock_now_ns() > deadline) {
+			__atomic_store_n(&benchmark_ring.abort, true, __ATOMIC_RELEASE);
+			scheduler_wait(&group);
+			benchmark_skip("slab_cross_cpu", "consumer_not_scheduled");
+			return;
+		}
+
+		cpu_relax();
+	}
+
+	start = read_timestamp_counter();
+	for(uint64_t head = 0; head < SLAB_BENCHMARK_TRANSFERS; head++) {
+		while((head - __atomic_load_n(&benchmark_ring.tail, __ATOMIC_ACQUIRE)) >=
+			SLAB_BENCHMARK_RING_SIZE) {
+			cpu_relax();
+		}
+
+		benchmark_ring.objects[head & (SLAB_BENCHMARK_RING_SIZE - 1)] = kmalloc(64);
+		__atomic_store_n(&benchmark_ring.head, head + 1, __ATOMIC_RELEASE);
+	}
+
+	scheduler_wait(&group);
+	cycles = read_timestamp_counter() - start;
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "slab", .name = "producer_consumer", .variant = "cross_cpu",
+		.size = 64,
+		.operations = SLAB_BENCHMARK_TRANSFERS,
+		.cycles = cycles,
+		.counters = { { "cpus", 2 } }
+	});
+}
+
+
+/**
+ * slab_run_benchmark
+ */
+static void slab_run_benchmark(void)
+{
+	/** The sizes measured. The last is served by the page allocator. */
+	static const size_t sizes[] = { 16, 64, 256, 1024, 4000 };
+	/** The objects allocated in the current round. */
+	void* objects[SLAB_BENCHMARK_BATCH];
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles taken by the measurement. */
+	uint64_t cycles;
+	/** The cache statistics. */
+	Slab_Stats stats;
+
+	if(page_allocator.total_pages == 0) {
+		benchmark_skip("slab", "no_free_memory");
+		return;
+	}
+
+	for(size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		// Warms the magazines, so that the measurement covers the fast path.
+		benchmark_kmalloc(sizes[i], 1);
+
+		start = read_timestamp_counter();
+		benchmark_kmalloc(sizes[i], SLAB_BENCHMARK_ROUNDS);
+		cycles = read_timestamp_counter() - start;
+
+		benchmark_report(&(Benchmark_Result){
+			.suite = "slab", .name = "kmalloc_kfree", .variant = "batch",
+			.size = sizes[i],
+			.operations = SLAB_BENCHMARK_ROUNDS * SLAB_BENCHMARK_BATCH,
+			.cycles = cycles
+		});
+	}
+
+	start = read_timestamp_counter();
+	for(size_t i = 0; i < (SLAB_BENCHMARK_ROUNDS * SLAB_BENCHMARK_BATCH); i++) {
+		kfree(kmalloc(64));
+	}
+	cycles = read_timestamp_counter() - start;
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "slab", .name = "kmalloc_kfree", .variant = "pair",
+		.size = 64,
+		.operations = SLAB_BENCHMARK_ROUNDS * SLAB_BENCHMARK_BATCH,
+		.cycles = cycles
+	});
+
+	if(benchmark_cache.object_size == 0 &&
+		!slab_cache_initialize(&benchmark_cache, "benchmark-hot", 64, 64)) {
+		benchmark_skip("slab_cache", "initialisation_failed");
+		return;
+	}
+
+	start = read_timestamp_counter();
+	for(size_t round = 0; round < SLAB_BENCHMARK_ROUNDS; round++) {
+		for(size_t i = 0; i < SLAB_BENCHMARK_BATCH; i++) {
+			objects[i] = slab_cache_alloc(&benchmark_cache);
+		}
+
+		for(size_t i = 0; i < SLAB_BENCHMARK_BATCH; i++) {
+			slab_cache_free(&benchmark_cache, objects[i]);
+		}
+	}
+	cycles = read_timestamp_counter() - start;
+
+	slab_cache_get_stats(&benchmark_cache, &stats);
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "slab", .name = "cache_alloc_free", .variant = "aligned_64",
+		.size = 64,
+		.operations = SLAB_BENCHMARK_ROUNDS * SLAB_BENCHMARK_BATCH,
+		.cycles = cycles,
+		.counters = {
+			{ "refills", stats.refills },
+			{ "flushes", stats.flushes }
+		}
+	});
+
+	benchmark_cross_cpu();
+}
@@ -0,0 +1,460 @@
+/**
+ * @file smp.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Multiprocessor functionality.
+ * Contains the implementation of secondary CPU startup, and per-CPU data.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <acpi.h>
+#include <apic.h>
+#include <benchmark.h>
+#include <clock.h>
+#include <cpu.h>
+#include <gdt.h>
+#include <interrupts.h>
+#include <numa.h>
+#include <paging.h>
+#include <scheduler.h>
+#include <smp.h>
+#include <spinlock.h>
+#include <string.h>
+
+/**
+ * The delay between the INIT IPI and the first startup IPI in microseconds.
+ * Only older processors need it.
+ */
+#define SMP_INIT_DELAY_US            10000
+/** The delay between the two startup IPIs in microseconds. */
+#define SMP_STARTUP_DELAY_US         200
+/** The first processor family which does not need the INIT delay. */
+#define SMP_NO_INIT_DELAY_FAMILY     6
+/** The number of stacks for secondary CPUs. */
+#define SMP_AP_STACK_COUNT           (SMP_MAX_CPUS - 1)
+/** The number of lock round trips measured by the benchmark. */
+#define SMP_BENCHMARK_LOCK_ITERATIONS 100000
+
+/** The trampoline's 64-bit code segment descriptor. */
+#define TRAMPOLINE_CODE64_DESCRIPTOR 0x00AF9A000000FFFFULL
+/** The trampoline's data segment descriptor. */
+#define TRAMPOLINE_DATA_DESCRIPTOR   0x00CF92000000FFFFULL
+/** The trampoline's 32-bit code segment descriptor. */
+#define TRAMPOLINE_CODE32_DESCRIPTOR 0x00CF9A000000FFFFULL
+/** The trampoline's 64-bit code segment selector. */
+#define TRAMPOLINE_CODE64_SELECTOR   0x08
+/** The trampoline's 32-bit code segment selector. */
+#define TRAMPOLINE_CODE32_SELECTOR   0x18
+/** The number of entries in the trampoline's GDT. */
+#define TRAMPOLINE_GDT_ENTRY_COUNT   4
+
+/** Extended feature enable MSR: Long mode active. Set by the processor. */
+#define EFER_LMA                     (1ULL << 10)
+
+/**
+ * @brief The trampoline's data area.
+ * This must match the data area at the end of smp_trampoline.S.
+ */
+typedef struct s_smp_trampoline_data {
+	uint32_t next_ticket;
+	uint32_t n_stacks;
+	uint32_t cr0;
+	uint32_t cr3;
+	uint32_t cr4_initial;
+	uint32_t efer;
+	uint64_t cr4;
+	uint64_t xcr0;
+	uint64_t entry;
+	uint64_t stack_tops;
+	uint32_t protected_entry;
+	uint16_t protected_selector;
+	uint16_t gdt_limit;
+	uint64_t gdt_base;
+	uint32_t long_entry;
+	uint16_t long_selector;
+	uint16_t reserved;
+	uint64_t gdt[TRAMPOLINE_GDT_ENTRY_COUNT];
+} __attribute__((packed)) Smp_Trampoline_Data;
+
+/** The start of the trampoline, defined in smp_trampoline.S. */
+extern char smp_trampoline_start[];
+/** The trampoline's protected mode entry, defined in smp_trampoline.S. */
+extern char smp_trampoline_protected[];
+/** The trampoline's long mode entry, defined in smp_trampoline.S. */
+extern char smp_trampoline_long[];
+/** The trampoline's data area, defined in smp_trampoline.S. */
+extern char smp_trampoline_data[];
+/** The end of the trampoline, defined in smp_trampoline.S. */
+extern char smp_trampoline_end[];
+/** The guard page below the boot stack, defined in kernel.ld. */
+extern char stack_guard[];
+
+/**
+ * CPU local data.
+ * Refer to definition in smp.h
+ */
+Cpu_Local cpu_locals[SMP_MAX_CPUS];
+
+/**
+ * Multiprocessor state.
+ * Refer to definition in smp.h
+ */
+Smp smp = {
+	.n_cpus = 1,
+	.n_online = 1,
+	.startup_ns = 0
+};
+
+/**
+ * The secondary CPU stacks. Each begins with a guard page, which is unmapped,
+ * so that an overflow faults rather than corrupting the stack below.
+ */
+static uint8_t ap_stacks[SMP_AP_STACK_COUNT][PAGE_SIZE + SMP_STACK_SIZE]
+	__attribute__((aligned(PAGE_SIZE)));
+/** The top of each secondary CPU stack, indexed by ticket. */
+static uint64_t ap_stack_tops[SMP_AP_STACK_COUNT];
+/**
+ * The number of CPUs taking part in the TSC synchronisation check. Zero until
+ * the boot CPU has finished waiting for the secondary CPUs.
+ */
+static uint32_t tsc_sync_cpus = 0;
+
+/**
+ * @brief Finds the CPUs listed in the MADT.
+ * Records the APIC ID of every enabled CPU other than the boot CPU in
+ * `cpu_locals`, up to `SMP_MAX_CPUS`.
+ * @return The number of enabled CPUs listed, including any beyond
+ * `SMP_MAX_CPUS`.
+ */
+static uint32_t parse_madt(void);
+
+/**
+ * @brief Adds a CPU found in the MADT.
+ * Ignores the boot CPU, and CPUs already added.
+ * @param[in] apic_id The CPU's APIC ID.
+ * @param[in,out] n_listed The number of CPUs listed so far.
+ */
+static void add_cpu(const uint32_t apic_id,
+	uint32_t* n_listed);
+
+/**
+ * @brief Sets the current CPU's GS base to its local data.
+ * @param[in] index The current CPU's index.
+ */
+static void set_cpu_local(const uint32_t index);
+
+/**
+ * @brief The secondary CPU entry point.
+ * Called by the trampoline on the stack claimed with its ticket. Returns at
+ * once, leaving the CPU to be parked, if the MADT does not list it. Otherwise
+ * enables the CPU's local APIC, loads the kernel's descriptor tables, and
+ * marks the CPU online, then takes part in the TSC synchronisation check and
+ * runs the scheduler.
+ * @param[in] ticket The CPU's ticket, selecting its stack.
+ */
+static void smp_ap_main(const uint32_t ticket);
+
+/**
+ * @brief Runs the multiprocessor benchmarks.
+ * Reports the time taken to bring the secondary CPUs online, and the cost of
+ * an uncontended spinlock round trip.
+ */
+static void smp_run_benchmark(void);
+
+BENCHMARK(smp, smp_run_benchmark);
+
+
+/**
+ * set_cpu_local
+ */
+static void set_cpu_local(const uint32_t index)
+{
+	cpu_locals[index].self = &cpu_locals[index];
+	cpu_locals[index].index = index;
+
+	write_gs_base((uint64_t)(uintptr_t)&cpu_locals[index]);
+}
+
+
+/**
+ * smp_initialize_boot_cpu
+ */
+void smp_initialize_boot_cpu(void)
+{
+	gdt_initialize();
+	gdt_load(0);
+
+	set_cpu_local(0);
+	cpu_locals[0].stack_top = 0;
+	cpu_locals[0].online = true;
+
+	paging_unmap((uintptr_t)stack_guard, PAGE_SIZE);
+}
+
+
+/**
+ * add_cpu
+ */
+static void add_cpu(const uint32_t apic_id,
+	uint32_t* n_listed)
+{
+	if(apic_id == cpu_locals[0].apic_id) {
+		return;
+	}
+
+	for(uint32_t i = 1; i < smp.n_cpus; i++) {
+		if(cpu_locals[i].apic_id == apic_id) {
+			return;
+		}
+	}
+
+	(*n_listed)++;
+
+	if(smp.n_cpus < SMP_MAX_CPUS) {
+		cpu_locals[smp.n_cpus].apic_id = apic_id;
+		cpu_locals[smp.n_cpus].node = numa_get_cpu_node(apic_id);
+		cpu_locals[smp.n_cpus].online = false;
+		smp.n_cpus++;
+	}
+}
+
+
+/**
+ * parse_madt
+ */
+static uint32_t parse_madt(void)
+{
+	/** The MADT. */
+	const Acpi_Madt* madt = (const Acpi_Madt*)acpi_find_table(ACPI_MADT_SIGNATURE, 0);
+	/** The current entry. */
+	const uint8_t* entry;
+	/** The end of the table. */
+	const uint8_t* end;
+	/** The number of enabled CPUs listed, including the boot CPU. */
+	uint32_t n_listed = 1;
+
+	if(madt == NULL) {
+		return n_listed;
+	}
+
+	entry = (const uint8_t*)(madt + 1);
+	end = (const uint8_t*)madt + madt->header.length;
+
+	while(entry + sizeof(Acpi_Madt_Entry) <= end) {
+		/** The current entry's header. */
+		const Acpi_Madt_Entry* header = (const Acpi_Madt_Entry*)entry;
+
+		if(header->length < sizeof(Acpi_Madt_Entry) || entry + header->length > end) {
+			break;
+		}
+
+		if(header->type == ACPI_MADT_TYPE_LOCAL_APIC &&
+			header->length >= sizeof(Acpi_Madt_Local_Apic)) {
+			/** The local APIC entry. */
+			const Acpi_Madt_Local_Apic* local = (const Acpi_Madt_Local_Apic*)entry;
+
+			if(local->flags & ACPI_MADT_LOCAL_APIC_ENABLED) {
+				add_cpu(local->apic_id, &n_listed);
+			}
+		} else if(header->type == ACPI_MADT_TYPE_LOCAL_X2APIC &&
+			header->length >= sizeof(Acpi_Madt_Local_X2apic)) {
+			/** The local x2APIC entry. */
+			const Acpi_Madt_Local_X2apic* local = (const Acpi_Madt_Local_X2apic*)entry;
+
+			if(local->flags & ACPI_MADT_LOCAL_APIC_ENABLED) {
+				add_cpu(local->x2apic_id, &n_listed);
+			}
+		}
+
+		entry += header->length;
+	}
+
+	return n_listed;
+}
+
+
+/**
+ * smp_ap_main
+ */
+static void smp_ap_main(const uint32_t ticket)
+{
+	/** The CPU's APIC ID. */
+	uint32_t apic_id;
+	/** The CPU's index. */
+	uint32_t index = 0;
+	/** The number of CPUs online once this CPU came online. */
+	uint32_t position;
+	/** The number of CPUs taking part in the TSC synchronisation check. */
+	uint32_t n_sync_cpus;
+
+	// The local APIC is left disabled until the CPU is known to be listed, so
+	// its ID is read through CPUID.
+	apic_id = apic_get_initial_id();
+
+	for(uint32_t i = 1; i < smp.n_cpus; i++) {
+		if(cpu_locals[i].apic_id == apic_id) {
+			index = i;
+			break;
+		}
+	}
+
+	// CPUs which the MADT does not list as enabled are still started by the
+	// broadcast. They are parked by the trampoline with interrupts disabled,
+	// and with their local APIC never enabled.
+	if(index == 0) {
+		return;
+	}
+
+	apic_enable();
+
+	gdt_load(index);
+	set_cpu_local(index);
+	cpu_locals[index].stack_top = ap_stack_tops[ticket];
+	interrupts_load();
+	pat_initialize();
+
+	__atomic_store_n(&cpu_locals[index].online, true, __ATOMIC_RELEASE);
+	position = __atomic_add_fetch(&smp.n_online, 1, __ATOMIC_ACQ_REL);
+
+	while((n_sync_cpus = __atomic_load_n(&tsc_sync_cpus, __ATOMIC_ACQUIRE)) == 0) {
+		cpu_relax();
+	}
+
+	// CPUs which came online after the boot CPU stopped waiting take no part.
+	if(position <= n_sync_cpus) {
+		clock_check_tsc_sync(n_sync_cpus);
+	}
+
+	scheduler_run(NULL);
+}
+
+
+/**
+ * smp_initialize
+ */
+bool smp_initialize(void* trampoline)
+{
+	/** The trampoline's data area, in the copy. */
+	Smp_Trampoline_Data* data;
+	/** The physical address of the trampoline. */
+	const uintptr_t base = (uintptr_t)trampoline;
+	/** The number of enabled CPUs listed in the MADT. */
+	uint32_t n_listed;
+	/** The current value of CR3. */
+	const uint64_t cr3 = read_cr3();
+	/** The time at the start of the bring-up, in nanoseconds. */
+	uint64_t start;
+
+	cpu_locals[0].apic_id = apic_get_id();
+	cpu_locals[0].node = numa_get_cpu_node(cpu_locals[0].apic_id);
+	n_listed = parse_madt();
+
+	if(smp.n_cpus == 1) {
+		return n_listed == 1;
+	}
+
+	// The trampoline enters long mode from 32-bit code, so the page tables
+	// must be reachable with a 32-bit CR3.
+	if(trampoline == NULL || (cr3 >> 32) != 0) {
+		return false;
+	}
+
+	memcpy(trampoline, smp_trampoline_start,
+		(size_t)(smp_trampoline_end - smp_trampoline_start));
+	data = (Smp_Trampoline_Data*)(base +
+		(uintptr_t)(smp_trampoline_data - smp_trampoline_start));
+
+	for(size_t i = 0; i < SMP_AP_STACK_COUNT; i++) {
+		paging_unmap((uintptr_t)ap_stacks[i], PAGE_SIZE);
+		ap_stack_tops[i] = (uint64_t)(uintptr_t)&ap_stacks[i][PAGE_SIZE + SMP_STACK_SIZE];
+	}
+
+	data->next_ticket = 0;
+	data->n_stacks = SMP_AP_STACK_COUNT;
+	data->cr0 = (uint32_t)read_cr0();
+	data->cr3 = (uint32_t)cr3;
+	data->cr4_initial = (uint32_t)(read_cr4() & ~CR4_PCIDE);
+	data->efer = (uint32_t)(read_msr(MSR_IA32_EFER) & ~EFER_LMA);
+	data->cr4 = read_cr4();
+	data->xcr0 = cpu_features.xcr0;
+	data->entry = (uint64_t)(uintptr_t)smp_ap_main;
+	data->stack_tops = (uint64_t)(uintptr_t)ap_stack_tops;
+	data->protected_entry = (uint32_t)(base +
+		(uintptr_t)(smp_trampoline_protected - smp_trampoline_start));
+	data->protected_selector = TRAMPOLINE_CODE32_SELECTOR;
+	data->gdt_limit = sizeof(data->gdt) - 1;
+	data->gdt_base = (uint64_t)((uintptr_t)data +
+		offsetof(Smp_Trampoline_Data, gdt));
+	data->long_entry = (uint32_t)(base +
+		(uintptr_t)(smp_trampoline_long - smp_trampoline_start));
+	data->long_selector = TRAMPOLINE_CODE64_SELECTOR;
+	data->reserved = 0;
+	data->gdt[0] = 0;
+	data->gdt[1] = TRAMPOLINE_CODE64_DESCRIPTOR;
+	data->gdt[2] = TRAMPOLINE_DATA_DESCRIPTOR;
+	data->gdt[3] = TRAMPOLINE_CODE32_DESCRIPTOR;
+
+	// Every CPU is started by the same broadcast sequence, so that they start
+	// in parallel.
+	start = clock_now_ns();
+
+	apic_broadcast_init();
+	if(cpu_features.family < SMP_NO_INIT_DELAY_FAMILY) {
+		clock_delay_us(SMP_INIT_DELAY_US);
+	}
+
+	apic_broadcast_startup((uint8_t)(base / PAGE_SIZE));
+	clock_delay_us(SMP_STARTUP_DELAY_US);
+	if(__atomic_load_n(&smp.n_online, __ATOMIC_ACQUIRE) < smp.n_cpus) {
+		apic_broadcast_startup((uint8_t)(base / PAGE_SIZE));
+	}
+
+	while(__atomic_load_n(&smp.n_online, __ATOMIC_ACQUIRE) < smp.n_cpus &&
+		(clock_now_ns() - start) < (SMP_STARTUP_TIMEOUT_MS * 1000000ULL)) {
+		cpu_relax();
+	}
+
+	smp.startup_ns = clock_now_ns() - start;
+
+	__atomic_store_n(&tsc_sync_cpus, __atomic_load_n(&smp.n_online,
+		__ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+	clock_check_tsc_sync(tsc_sync_cpus);
+
+	return smp.n_online == n_listed;
+}
+
+
+/**
+ * smp_run_benchmark
+ */
+static void smp_run_benchmark(void)
+{
+	/** The lock being measured. */
+	Spinlock lock = SPINLOCK_INITIALIZER;
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "smp", .name = "bringup", .variant = "broadcast",
+		.size = smp.n_cpus, .operations = 1,
+		.cycles = clock_ns_to_cycles(smp.startup_ns),
+		.counters = {
+			{ "cpus_online", smp.n_online },
+			{ "tsc_warp_cycles", kernel_clock.tsc_warp }
+		}
+	});
+
+	start = read_timestamp_counter();
+	for(size_t i = 0; i < SMP_BENCHMARK_LOCK_ITERATIONS; i++) {
+		spinlock_acquire(&lock);
+		spinlock_release(&lock);
+	}
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "smp", .name = "spinlock", .variant = "uncontended",
+		.operations = SMP_BENCHMARK_LOCK_ITERATIONS,
+		.cycles = read_timestamp_counter() - start
+	});
+}
@@ -3,21 +3,736 @@
  * @author ajxs
  * @date Aug 2019
  * @brief String functionality.
- * Contains implementation for string functions.
+ * Contains implementation for string functions, the scalar reference and
+ * `rep movsb`/`rep stosb` memory functions, implementation selection, the self
+ * test and the microbenchmark.
  */
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <alternatives.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <printf.h>
 #include <string.h>
 
+/** The largest size tested at every alignment by the self test. */
+#define STRING_TEST_SWEEP_SIZE        256
+/** The number of destination alignments tested by the self test. */
+#define STRING_TEST_ALIGNMENTS        32
+/** The number of bytes either side of the destination checked for writes. */
+#define STRING_TEST_GUARD_SIZE        64
+/** The byte the self test destination is filled with before each test. */
+#define STRING_TEST_GUARD_BYTE        0xA5
+/** The size of the self test and benchmark buffers. */
+#define STRING_TEST_BUFFER_SIZE       (STRING_NON_TEMPORAL_THRESHOLD + 0x1000)
+/** The order of the blocks the self test and benchmark buffers are kept in. */
+#define STRING_TEST_BUFFER_ORDER      PAGE_ALLOCATOR_LARGE_ORDER
+
+#if STRING_TEST_BUFFER_SIZE > LARGE_PAGE_SIZE
+	#error "The string test buffers do not fit their page blocks"
+#endif
+
+/** The number of bytes processed by each benchmark pass. */
+#define STRING_BENCHMARK_BYTES        0x1000000
+
+/** A 64-bit word, which may alias other types. */
+typedef uint64_t word_u64 __attribute__((may_alias));
+/** A 64-bit word, with no alignment requirement. */
+typedef uint64_t word_u64_unaligned __attribute__((aligned(1), may_alias));
+
+/**
+ * Selected string operations.
+ * Refer to definition in string.h
+ */
+const String_Operations* string_operations = &string_sse2_operations;
+
+/**
+ * @brief Copies with the fastest vector implementation.
+ * A static call, patched by `alternatives_apply`.
+ */
+void* string_copy_vector(void* dest,
+	const void* src,
+	size_t n);
+
+/**
+ * @brief Fills with the fastest vector implementation.
+ * A static call, patched by `alternatives_apply`.
+ */
+void* string_set_vector(void* dest,
+	int c,
+	size_t n);
+
+STATIC_CALL_TRAMPOLINE(string_copy_vector, string_sse2_copy);
+ALTERNATIVE_CALL(string_copy_vector, CPU_FEATURE_AVX2, 1, string_avx2_copy);
+
+STATIC_CALL_TRAMPOLINE(string_set_vector, string_sse2_set);
+ALTERNATIVE_CALL(string_set_vector, CPU_FEATURE_AVX2, 1, string_avx2_set);
+
+/**
+ * The size from which copies and fills use the `rep` implementations. Left at
+ * `SIZE_MAX` unless the processor has enhanced string instructions.
+ */
+static size_t rep_threshold = SIZE_MAX;
+
+/**
+ * The self test and benchmark source buffer. Allocated only while either
+ * runs, so that it takes no space in the kernel image.
+ */
+static uint8_t* test_src = NULL;
+/** The self test and benchmark destination buffer. */
+static uint8_t* test_dest = NULL;
+
+/**
+ * @brief Gets the implementations supported by the processor.
+ * @param[out] operations The supported implementations, scalar reference
+ * first.
+ * @return The number of supported implementations.
+ */
+static size_t get_supported_operations(const String_Operations* operations[4]);
+
+/**
+ * @brief Allocates the self test and benchmark buffers.
+ * @return Whether the buffers were allocated.
+ */
+static bool allocate_test_buffers(void);
+
+/**
+ * @brief Frees the self test and benchmark buffers.
+ */
+static void free_test_buffers(void);
+
+/**
+ * @brief Runs the string microbenchmark.
+ * Measures the throughput of every memory function implementation supported
+ * by the processor, and of `strlen`, over a range of sizes.
+ */
+static void string_run_benchmark(void);
+
+/**
+ * @brief Gets the byte at a position of the self test pattern.
+ * @param[in] position The position.
+ * @return The pattern byte.
+ */
+static inline uint8_t test_pattern_byte(const size_t position);
+
+/**
+ * @brief Tests one copy or fill against the self test pattern.
+ * The source buffer must hold the self test pattern.
+ * @param[in] operations The implementation to test.
+ * @param[in] set Whether to test the fill, rather than the copy.
+ * @param[in] n The number of bytes.
+ * @param[in] dest_offset The offset of the destination in its buffer.
+ * @param[in] src_offset The offset of the source in its buffer.
+ * @return Whether the result was correct.
+ */
+static bool test_operation(const String_Operations* operations,
+	const bool set,
+	const size_t n,
+	const size_t dest_offset,
+	const size_t src_offset);
+
+/**
+ * @brief Tests `memmove` with overlapping buffers.
+ * @return Whether every move was correct.
+ */
+static bool test_memmove(void);
+
+/**
+ * @brief Tests `strlen`.
+ * @return Whether every length was correct.
+ */
+static bool test_strlen(void);
+
+
+/**
+ * copy_scalar
+ */
+static void* copy_scalar(void* dest,
+	const void* src,
+	size_t n)
+{
+	/** The destination buffer. */
+	uint8_t* d = dest;
+	/** The source buffer. */
+	const uint8_t* s = src;
+
+	for(size_t i = 0; i < n; i++) {
+		d[i] = s[i];
+	}
+
+	return dest;
+}
+
+
+/**
+ * set_scalar
+ */
+static void* set_scalar(void* dest,
+	int c,
+	size_t n)
+{
+	/** The destination buffer. */
+	uint8_t* d = dest;
+
+	for(size_t i = 0; i < n; i++) {
+		d[i] = (uint8_t)c;
+	}
+
+	return dest;
+}
+
+
+/**
+ * string_rep_copy
+ */
+void* string_rep_copy(void* dest,
+	const void* src,
+	size_t n)
+{
+	/** The next destination byte. */
+	void* d = dest;
+
+	asm volatile("rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory");
+
+	return dest;
+}
+
+
+/**
+ * string_rep_set
+ */
+void* string_rep_set(void* dest,
+	int c,
+	size_t n)
+{
+	/** The next destination byte. */
+	void* d = dest;
+
+	asm volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+
+	return dest;
+}
+
+
+/**
+ * Scalar string operations.
+ * Refer to definition in string.h
+ */
+const String_Operations string_scalar_operations = {
+	.name = "scalar",
+	.copy = copy_scalar,
+	.set = set_scalar
+};
+
+
+/**
+ * Rep string operations.
+ * Refer to definition in string.h
+ */
+const String_Operations string_rep_operations = {
+	.name = "rep",
+	.copy = string_rep_copy,
+	.set = string_rep_set
+};
+
+
+/**
+ * get_supported_operations
+ */
+static size_t get_supported_operations(const String_Operations* operations[4])
+{
+	/** The number of supported implementations. */
+	size_t n_operations = 0;
+
+	operations[n_operations++] = &string_scalar_operations;
+	operations[n_operations++] = &string_sse2_operations;
+
+	if(cpu_features.avx2) {
+		operations[n_operations++] = &string_avx2_operations;
+	}
+
+	// Every x86-64 processor implements the string instructions, but they are
+	// only worth benchmarking where they are enhanced.
+	if(cpu_features.erms) {
+		operations[n_operations++] = &string_rep_operations;
+	}
+
+	return n_operations;
+}
+
+
+/**
+ * string_initialize
+ */
+void string_initialize(void)
+{
+	if(cpu_features.avx2) {
+		string_operations = &string_avx2_operations;
+	}
+
+	// Enhanced string instructions outperform vector loops once their startup
+	// cost is amortised. Fast short string instructions are not treated
+	// specially: the threshold is a conservative default, and the string
+	// benchmark's rep variant measures the crossover on the processor at hand.
+	if(cpu_features.erms) {
+		rep_threshold = STRING_REP_THRESHOLD;
+	}
+}
+
+
+/**
+ * memcpy
+ */
+void* memcpy(void* dest,
+	const void* src,
+	size_t n)
+{
+	if(n >= rep_threshold) {
+		return string_rep_copy(dest, src, n);
+	}
+
+	return string_copy_vector(dest, src, n);
+}
+
+
+/**
+ * memmove
+ */
+void* memmove(void* dest,
+	const void* src,
+	size_t n)
+{
+	/** The destination buffer. */
+	uint8_t* d = dest;
+	/** The source buffer. */
+	const uint8_t* s = src;
+	/** The word being moved. */
+	uint64_t word;
+
+	if(((uintptr_t)d - (uintptr_t)s) >= n && ((uintptr_t)s - (uintptr_t)d) >= n) {
+		return memcpy(dest, src, n);
+	}
+
+	// The buffers overlap. Each word is loaded before it is stored, so copying
+	// away from the overlap never reads a byte that has been overwritten.
+	if(d < s) {
+		for(; n >= 8; n -= 8) {
+			word = *(const word_u64_unaligned*)s;
+			*(word_u64_unaligned*)d = word;
+
+			d += 8;
+			s += 8;
+		}
+
+		for(size_t i = 0; i < n; i++) {
+			d[i] = s[i];
+		}
+	} else {
+		for(; n >= 8; n -= 8) {
+			word = *(const word_u64_unaligned*)(s + n - 8);
+			*(word_u64_unaligned*)(d + n - 8) = word;
+		}
+
+		while(n > 0) {
+			n--;
+			d[n] = s[n];
+		}
+	}
+
+	return dest;
+}
+
+
+/**
+ * memset
+ */
+void* memset(void* dest,
+	int c,
+	size_t n)
+{
+	// Fills large enough to use non-temporal stores are left to the vector
+	// implementations.
+	if(n >= rep_threshold && n < STRING_NON_TEMPORAL_THRESHOLD) {
+		return string_rep_set(dest, c, n);
+	}
+
+	return string_set_vector(dest, c, n);
+}
+
+
+/**
+ * memcmp
+ */
+int memcmp(const void* a,
+	const void* b,
+	size_t n)
+{
+	/** The first buffer. */
+	const uint8_t* x = a;
+	/** The second buffer. */
+	const uint8_t* y = b;
+
+	for(size_t i = 0; i < n; i++) {
+		if(x[i] != y[i]) {
+			return x[i] - y[i];
+		}
+	}
+
+	return 0;
+}
+
+
 /**
  * strlen
  */
 size_t strlen(const char* str)
 {
-	/** The length of the string to be output. */
-	size_t len = 0;
-	while(str[len]) {
-		len++;
+	/** The current position in the string. */
+	const char* position = str;
+	/** The current word of the string. */
+	const word_u64* word;
+
+	while((uintptr_t)position & (sizeof(uint64_t) - 1)) {
+		if(*position == '\0') {
+			return position - str;
+		}
+
+		position++;
+	}
+
+	// Aligned words never cross a page boundary, so reading past the
+	// terminator within the last word is safe.
+	word = (const word_u64*)position;
+	while(!((*word - 0x0101010101010101ULL) & ~*word & 0x8080808080808080ULL)) {
+		word++;
+	}
+
+	position = (const char*)word;
+	while(*position) {
+		position++;
+	}
+
+	return position - str;
+}
+
+
+/**
+ * test_pattern_byte
+ */
+static inline uint8_t test_pattern_byte(const size_t position)
+{
+	return (uint8_t)((position * 31) + (position >> 8) + 7);
+}
+
+
+/**
+ * allocate_test_buffers
+ */
+static bool allocate_test_buffers(void)
+{
+	test_src = (uint8_t*)page_allocator_alloc(STRING_TEST_BUFFER_ORDER);
+	test_dest = (uint8_t*)page_allocator_alloc(STRING_TEST_BUFFER_ORDER);
+
+	if(test_src == NULL || test_dest == NULL) {
+		free_test_buffers();
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * free_test_buffers
+ */
+static void free_test_buffers(void)
+{
+	page_allocator_free((uintptr_t)test_src, STRING_TEST_BUFFER_ORDER);
+	page_allocator_free((uintptr_t)test_dest, STRING_TEST_BUFFER_ORDER);
+
+	test_src = NULL;
+	test_dest = NULL;
+}
+
+
+/**
+ * test_operation
+ */
+static bool test_operation(const String_Operations* operations,
+	const bool set,
+	const size_t n,
+	const size_t dest_offset,
+	const size_t src_offset)
+{
+	/** The destination. */
+	uint8_t* dest = test_dest + STRING_TEST_GUARD_SIZE + dest_offset;
+	/**
+	 * The fill value. Bits are set above the low byte to check they are ignored,
+	 * and it never matches the guard byte.
+	 */
+	const int c = 0x100 | (n & 0x7F);
+	/** The expected value of each byte. */
+	uint8_t expected;
+
+	set_scalar(dest - STRING_TEST_GUARD_SIZE, STRING_TEST_GUARD_BYTE,
+		n + (STRING_TEST_GUARD_SIZE * 2));
+
+	if(set) {
+		operations->set(dest, c, n);
+	} else {
+		operations->copy(dest, test_src + src_offset, n);
+	}
+
+	for(size_t i = 0; i < n + (STRING_TEST_GUARD_SIZE * 2); i++) {
+		/** The position relative to the destination. */
+		const ptrdiff_t position = (ptrdiff_t)i - STRING_TEST_GUARD_SIZE;
+
+		if(position < 0 || (size_t)position >= n) {
+			expected = STRING_TEST_GUARD_BYTE;
+		} else if(set) {
+			expected = (uint8_t)c;
+		} else {
+			expected = test_pattern_byte(src_offset + position);
+		}
+
+		if(dest[position] != expected) {
+			kprintf("String self test: %s %s of %lu bytes, offsets %lu/%lu, "
+				"mismatch at %ld: 0x%02x != 0x%02x\n", operations->name,
+				set ? "set" : "copy", n, dest_offset, src_offset, position,
+				dest[position], expected);
+
+			return false;
+		}
 	}
 
-	return len;
+	return true;
 }
+
+
+/**
+ * test_memmove
+ */
+static bool test_memmove(void)
+{
+	/** The buffer moved within. */
+	uint8_t* buffer = test_dest;
+	/** The base of the moves within the buffer. */
+	const size_t base = 64;
+	/** The expected value of each byte. */
+	uint8_t expected;
+
+	for(size_t n = 0; n <= STRING_TEST_SWEEP_SIZE; n++) {
+		for(ptrdiff_t shift = -40; shift <= 40; shift++) {
+			/** The offset of the source. */
+			const size_t src_offset = base + 40;
+			/** The offset of the destination. */
+			const size_t dest_offset = src_offset + shift;
+
+			for(size_t i = 0; i < n + 128; i++) {
+				buffer[i] = test_pattern_byte(i);
+			}
+
+			memmove(buffer + dest_offset, buffer + src_offset, n);
+
+			for(size_t i = 0; i < n + 128; i++) {
+				if(i >= dest_offset && i < dest_offset + n) {
+					expected = test_pattern_byte(src_offset + (i - dest_offset));
+				} else {
+					expected = test_pattern_byte(i);
+				}
+
+				if(buffer[i] != expected) {
+					kprintf("String self test: memmove of %lu bytes, shift %ld, "
+						"mismatch at %lu: 0x%02x != 0x%02x\n", n, shift, i,
+						buffer[i], expected);
+
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * test_strlen
+ */
+static bool test_strlen(void)
+{
+	/** The string buffer. */
+	char* buffer = (char*)test_dest;
+	/** The length reported by strlen. */
+	size_t length;
+
+	for(size_t offset = 0; offset < 16; offset++) {
+		for(size_t n = 0; n <= 100; n++) {
+			set_scalar(buffer, 'x', 128);
+			buffer[offset + n] = '\0';
+
+			// A byte with the high bit set must not be mistaken for a terminator.
+			if(n > 1) {
+				buffer[offset + n - 1] = (char)0x80;
+			}
+
+			length = strlen(buffer + offset);
+			if(length != n) {
+				kprintf("String self test: strlen at offset %lu: %lu != %lu\n",
+					offset, length, n);
+
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * string_self_test
+ */
+bool string_self_test(void)
+{
+	/** The supported implementations. */
+	const String_Operations* operations[4];
+	/** The number of supported implementations. */
+	const size_t n_operations = get_supported_operations(operations);
+	/** Sizes tested beyond the sweep, around each implementation's thresholds. */
+	const size_t large_sizes[] = {
+		STRING_REP_THRESHOLD - 1, STRING_REP_THRESHOLD, 4095, 65537,
+		STRING_NON_TEMPORAL_THRESHOLD - 1, STRING_NON_TEMPORAL_THRESHOLD + 33
+	};
+	/** Whether every test passed. */
+	bool passed = true;
+
+	if(!allocate_test_buffers()) {
+		kprintf("String self test: No memory for the test buffers\n");
+		return false;
+	}
+
+	for(size_t i = 0; i < STRING_TEST_BUFFER_SIZE; i++) {
+		test_src[i] = test_pattern_byte(i);
+	}
+
+	for(size_t i = 0; i < n_operations; i++) {
+		/** Whether this implementation passed. */
+		bool operations_passed = true;
+
+		for(size_t set = 0; set < 2 && operations_passed; set++) {
+			for(size_t n = 0; n <= STRING_TEST_SWEEP_SIZE && operations_passed; n++) {
+				for(size_t offset = 0; offset < STRING_TEST_ALIGNMENTS; offset++) {
+					// Pairs every destination alignment with a different source
+					// alignment, and with the same one.
+					operations_passed &= test_operation(operations[i], set, n, offset,
+						(offset * 7) % STRING_TEST_ALIGNMENTS);
+					operations_passed &= test_operation(operations[i], set, n, offset,
+						offset);
+				}
+			}
+
+			for(size_t j = 0; j < sizeof(large_sizes) / sizeof(large_sizes[0]); j++) {
+				operations_passed &= test_operation(operations[i], set,
+					large_sizes[j], 3, 5);
+			}
+		}
+
+		kprintf("String self test: %s %s\n", operations[i]->name,
+			operations_passed ? "passed" : "FAILED");
+		passed &= operations_passed;
+	}
+
+	if(!test_memmove() || !test_strlen()) {
+		passed = false;
+	}
+
+	kprintf("String self test: memmove and strlen %s\n", passed ? "passed" : "FAILED");
+
+	free_test_buffers();
+
+	return passed;
+}
+
+
+/**
+ * string_run_benchmark
+ */
+static void string_run_benchmark(void)
+{
+	/** The supported implementations. */
+	const String_Operations* operations[4];
+	/** The number of supported implementations. */
+	const size_t n_operations = get_supported_operations(operations);
+	/** The benchmarked sizes. */
+	const size_t sizes[] = {16, 64, 256, 1024, 4096, 65536, STRING_NON_TEMPORAL_THRESHOLD};
+	/** The benchmarked string lengths. */
+	const size_t string_lengths[] = {16, 256, 4096};
+	/** The timestamp at the start of the benchmark pass. */
+	uint64_t start;
+	/** The number of cycles taken by the benchmark pass. */
+	uint64_t cycles;
+	/** The total of the string lengths, so that strlen is not optimised away. */
+	volatile size_t total_length = 0;
+
+	if(!allocate_test_buffers()) {
+		benchmark_skip("string", "no_free_memory");
+		return;
+	}
+
+	for(size_t i = 0; i < n_operations; i++) {
+		for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			/** The number of iterations of the benchmark pass. */
+			const size_t iterations = STRING_BENCHMARK_BYTES / sizes[s];
+
+			start = read_timestamp_counter();
+			for(size_t n = 0; n < iterations; n++) {
+				operations[i]->copy(test_dest, test_src + 1, sizes[s]);
+			}
+			cycles = read_timestamp_counter() - start;
+			benchmark_report(&(Benchmark_Result){
+				.suite = "string", .name = "copy", .variant = operations[i]->name,
+				.size = sizes[s], .operations = iterations, .cycles = cycles,
+				.bytes = (uint64_t)iterations * sizes[s]
+			});
+
+			start = read_timestamp_counter();
+			for(size_t n = 0; n < iterations; n++) {
+				operations[i]->set(test_dest, (int)n, sizes[s]);
+			}
+			cycles = read_timestamp_counter() - start;
+			benchmark_report(&(Benchmark_Result){
+				.suite = "string", .name = "set", .variant = operations[i]->name,
+				.size = sizes[s], .operations = iterations, .cycles = cycles,
+				.bytes = (uint64_t)iterations * sizes[s]
+			});
+		}
+	}
+
+	for(size_t s = 0; s < sizeof(string_lengths) / sizeof(string_lengths[0]); s++) {
+		/** The number of iterations of the benchmark pass. */
+		const size_t iterations = STRING_BENCHMARK_BYTES / string_lengths[s];
+
+		set_scalar(test_dest, 'x', string_lengths[s]);
+		test_dest[string_lengths[s]] = '\0';
+
+		start = read_timestamp_counter();
+		for(size_t n = 0; n < iterations; n++) {
+			total_length += strlen((const char*)test_dest);
+		}
+		cycles = read_timestamp_counter() - start;
+		benchmark_report(&(Benchmark_Result){
+			.suite = "string", .name = "strlen", .variant = NULL,
+			.size = string_lengths[s], .operations = iterations, .cycles = cycles,
+			.bytes = (uint64_t)iterations * string_lengths[s]
+		});
+	}
+
+	free_test_buffers();
+}
+
+BENCHMARK(string, string_run_benchmark);
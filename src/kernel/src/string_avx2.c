@@ -0,0 +1,30 @@
+/**
+ * @file string_avx2.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief AVX2 memory functions.
+ * Instantiates the memory function template with 256-bit vectors. These must
+ * only be used once `string_initialize` has confirmed that the processor
+ * supports AVX2, and that AVX state is enabled.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#pragma GCC target("avx2")
+
+#define STRING_FUNCTION(name) string_avx2_##name
+#define STRING_VECTOR_SIZE 32
+
+#include <string_template.h>
+
+/**
+ * AVX2 string operations.
+ * Refer to definition in string.h
+ */
+const String_Operations string_avx2_operations = {
+	.name = "AVX2",
+	.copy = string_avx2_copy,
+	.set = string_avx2_set
+};
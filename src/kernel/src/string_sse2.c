@@ -0,0 +1,27 @@
+/**
+ * @file string_sse2.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief SSE2 memory functions.
+ * Instantiates the memory function template with 128-bit vectors. SSE2 is
+ * part of the x86-64 baseline, so these are always available.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STRING_FUNCTION(name) string_sse2_##name
+#define STRING_VECTOR_SIZE 16
+
+#include <string_template.h>
+
+/**
+ * SSE2 string operations.
+ * Refer to definition in string.h
+ */
+const String_Operations string_sse2_operations = {
+	.name = "SSE2",
+	.copy = string_sse2_copy,
+	.set = string_sse2_set
+};
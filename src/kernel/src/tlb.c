@@ -0,0 +1,597 @@
+/**
+ * @file tlb.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief TLB shootdown.
+ * Contains the implementation of cross-CPU TLB invalidation. Each CPU has a
+ * queue of ranges, guarded by a lock, and a pair of counters: `requested` is
+ * advanced by the CPUs queueing invalidations, and `completed` by the CPU
+ * itself once it has processed its queue.
+ * A CPU leaving lazy mode clears its flag, then checks its queue. A CPU
+ * queueing an invalidation appends it, then checks the target's flag. Both
+ * sides order their write before their read with a full barrier, so either the
+ * waking CPU sees the invalidation, or the queueing CPU sees it awake, and
+ * interrupts it.
+ * Interrupt handlers on an idle CPU run outside lazy mode: the CPU leaves it
+ * on interrupt entry, catching up on its queue, and returns to it on exit.
+ * Shootdowns issued while the handler runs therefore interrupt the CPU, and
+ * are processed as soon as the handler returns, as on any busy CPU.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <apic.h>
+#include <benchmark.h>
+#include <clock.h>
+#include <cpu.h>
+#include <interrupts.h>
+#include <page_allocator.h>
+#include <paging.h>
+#include <scheduler.h>
+#include <smp.h>
+#include <spinlock.h>
+#include <tlb.h>
+
+#if SMP_MAX_CPUS > 64
+	#error "The TLB shootdown's pending mask holds at most 64 CPUs"
+#endif
+
+/**
+ * The virtual address of the pages unmapped by the benchmark. Nothing else is
+ * mapped in the top 1GiB of the address space.
+ */
+#define TLB_BENCHMARK_ADDRESS        0xFFFFFFFFC0000000ULL
+/** The order of the block of pages unmapped by the benchmark. */
+#define TLB_BENCHMARK_ORDER          4
+/** The number of times the benchmark unmaps the block. */
+#define TLB_BENCHMARK_ROUNDS         1000
+/** How long to wait for the benchmark's busy CPUs, in nanoseconds. */
+#define TLB_BENCHMARK_TIMEOUT_NS     100000000ULL
+
+/**
+ * @brief A CPU's shootdown state.
+ * `completed` is on its own cache line, so that CPUs waiting on it do not slow
+ * those queueing invalidations.
+ */
+typedef struct s_tlb_cpu {
+	Spinlock lock;
+	uint32_t n_ranges;
+	bool flush_all;
+	bool lazy;
+	Tlb_Range ranges[TLB_MAX_RANGES];
+	uint64_t requested;
+	Tlb_Stats stats;
+	uint64_t completed __attribute__((aligned(64)));
+} __attribute__((aligned(64))) Tlb_Cpu;
+
+/** The shootdown state of each CPU. */
+static Tlb_Cpu tlb_cpus[SMP_MAX_CPUS];
+/** The number of the benchmark's busy CPUs which have started. */
+static uint32_t benchmark_n_busy = 0;
+/** Whether the benchmark's busy CPUs should stop. */
+static bool benchmark_stop = false;
+
+/**
+ * @brief Adds a range to a list of ranges.
+ * Merges the range with any it overlaps or adjoins. Falls back to a full
+ * flush if the list is full, or covers more than `TLB_FULL_FLUSH_PAGES`.
+ * @param[in,out] ranges The list of ranges.
+ * @param[in,out] n_ranges The number of ranges in the list.
+ * @param[in,out] flush_all Whether the whole TLB is to be flushed.
+ * @param[in] start The start of the range, aligned to a page.
+ * @param[in] end The end of the range, aligned to a page.
+ */
+static void add_range(Tlb_Range* ranges,
+	uint32_t* n_ranges,
+	bool* flush_all,
+	uintptr_t start,
+	uintptr_t end);
+
+/**
+ * @brief Flushes a list of ranges from the current CPU's TLB.
+ * @param[in] ranges The list of ranges.
+ * @param[in] n_ranges The number of ranges in the list.
+ * @param[in] flush_all Whether to flush the whole TLB instead.
+ * @param[in,out] stats The current CPU's statistics.
+ */
+static void flush_local(const Tlb_Range* ranges,
+	const uint32_t n_ranges,
+	const bool flush_all,
+	Tlb_Stats* stats);
+
+/**
+ * @brief Processes the current CPU's queue.
+ * @param[in,out] cpu The current CPU's shootdown state.
+ */
+static void process_queue(Tlb_Cpu* cpu);
+
+/**
+ * @brief Handles the shootdown IPI.
+ * @param[in,out] frame The interrupt frame.
+ */
+static void handle_shootdown_ipi(Interrupt_Frame* frame);
+
+/**
+ * @brief Keeps a CPU out of lazy mode until the benchmark stops it.
+ * @param[in] argument Unused.
+ */
+static void benchmark_busy_task(void* argument);
+
+/**
+ * @brief Runs the TLB shootdown benchmarks.
+ * Measures unmapping a block of pages page by page, with one shootdown per
+ * page, and as one batch, while a growing number of CPUs are kept busy. The
+ * remaining CPUs are idle, and so in lazy mode.
+ */
+static void tlb_run_benchmark(void);
+
+BENCHMARK(tlb, tlb_run_benchmark);
+
+
+/**
+ * add_range
+ */
+static void add_range(Tlb_Range* ranges,
+	uint32_t* n_ranges,
+	bool* flush_all,
+	uintptr_t start,
+	uintptr_t end)
+{
+	/** The number of pages covered by the list. */
+	uint64_t n_pages = 0;
+
+	if(*flush_all) {
+		return;
+	}
+
+	for(uint32_t i = 0; i < *n_ranges;) {
+		if(start > ranges[i].end || end < ranges[i].start) {
+			i++;
+			continue;
+		}
+
+		// Absorbs the range, then checks the rest again against the merged one.
+		start = start < ranges[i].start ? start : ranges[i].start;
+		end = end > ranges[i].end ? end : ranges[i].end;
+		ranges[i] = ranges[--(*n_ranges)];
+		i = 0;
+	}
+
+	if(*n_ranges == TLB_MAX_RANGES) {
+		*flush_all = true;
+		*n_ranges = 0;
+		return;
+	}
+
+	ranges[(*n_ranges)++] = (Tlb_Range){ .start = start, .end = end };
+
+	for(uint32_t i = 0; i < *n_ranges; i++) {
+		n_pages += (ranges[i].end - ranges[i].start) / PAGE_SIZE;
+	}
+
+	if(n_pages > TLB_FULL_FLUSH_PAGES) {
+		*flush_all = true;
+		*n_ranges = 0;
+	}
+}
+
+
+/**
+ * flush_local
+ */
+static void flush_local(const Tlb_Range* ranges,
+	const uint32_t n_ranges,
+	const bool flush_all,
+	Tlb_Stats* stats)
+{
+	// With other address spaces in use, the kernel's non-global entries may be
+	// cached under their PCIDs, which `invlpg` does not reach.
+	if(flush_all || (kernel_paging.pcid &&
+		__atomic_load_n(&kernel_paging.n_address_spaces, __ATOMIC_RELAXED) != 0)) {
+		paging_flush_tlb();
+		__atomic_add_fetch(&stats->full_flushes, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	for(uint32_t i = 0; i < n_ranges; i++) {
+		for(uintptr_t page = ranges[i].start; page < ranges[i].end;
+			page += PAGE_SIZE) {
+			invalidate_page(page);
+		}
+
+		__atomic_add_fetch(&stats->page_flushes,
+			(ranges[i].end - ranges[i].start) / PAGE_SIZE, __ATOMIC_RELAXED);
+	}
+}
+
+
+/**
+ * process_queue
+ */
+static void process_queue(Tlb_Cpu* cpu)
+{
+	/** The ranges taken from the queue. */
+	Tlb_Range ranges[TLB_MAX_RANGES];
+	/** The number of ranges taken from the queue. */
+	uint32_t n_ranges;
+	/** Whether the queue asked for a full flush. */
+	bool flush_all;
+	/** The last request covered by the ranges taken. */
+	uint64_t requested;
+	/** The saved interrupt flag. */
+	const uint64_t flags = spinlock_acquire_irqsave(&cpu->lock);
+
+	n_ranges = cpu->n_ranges;
+	flush_all = cpu->flush_all;
+	requested = cpu->requested;
+	for(uint32_t i = 0; i < n_ranges; i++) {
+		ranges[i] = cpu->ranges[i];
+	}
+
+	cpu->n_ranges = 0;
+	cpu->flush_all = false;
+
+	spinlock_release(&cpu->lock);
+
+	flush_local(ranges, n_ranges, flush_all, &cpu->stats);
+	__atomic_store_n(&cpu->completed, requested, __ATOMIC_RELEASE);
+
+	restore_interrupts(flags);
+}
+
+
+/**
+ * handle_shootdown_ipi
+ */
+static void handle_shootdown_ipi(Interrupt_Frame* frame)
+{
+	(void)frame;
+
+	process_queue(&tlb_cpus[smp_get_cpu_index()]);
+}
+
+
+/**
+ * tlb_initialize
+ */
+void tlb_initialize(void)
+{
+	interrupts_register_vector_handler(TLB_SHOOTDOWN_VECTOR,
+		handle_shootdown_ipi);
+}
+
+
+/**
+ * tlb_batch_add
+ */
+void tlb_batch_add(Tlb_Batch* batch,
+	const uintptr_t address,
+	const size_t size)
+{
+	/** The start of the range, aligned down to a page. */
+	const uintptr_t start = address & ~(PAGE_SIZE - 1);
+	/** The end of the range, aligned up to a page. */
+	const uintptr_t end = (address + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+	if(start == end) {
+		return;
+	}
+
+	add_range(batch->ranges, &batch->n_ranges, &batch->flush_all, start, end);
+}
+
+
+/**
+ * tlb_batch_finish
+ */
+void tlb_batch_finish(Tlb_Batch* batch)
+{
+	/** The current CPU's index. */
+	const uint32_t index = smp_get_cpu_index();
+	/** The current CPU's shootdown state. */
+	Tlb_Cpu* self = &tlb_cpus[index];
+	/** The request each CPU interrupted must complete. */
+	uint64_t tickets[SMP_MAX_CPUS];
+	/** The CPUs interrupted which have yet to complete their request. */
+	uint64_t pending = 0;
+
+	if(batch->n_ranges == 0 && !batch->flush_all) {
+		return;
+	}
+
+	flush_local(batch->ranges, batch->n_ranges, batch->flush_all, &self->stats);
+
+	for(uint32_t i = 0; i < smp.n_cpus; i++) {
+		/** The target CPU's shootdown state. */
+		Tlb_Cpu* target = &tlb_cpus[i];
+		/** The saved interrupt flag. */
+		uint64_t flags;
+
+		if(i == index || !__atomic_load_n(&cpu_locals[i].online, __ATOMIC_ACQUIRE)) {
+			continue;
+		}
+
+		flags = spinlock_acquire_irqsave(&target->lock);
+
+		if(batch->flush_all) {
+			target->flush_all = true;
+			target->n_ranges = 0;
+		} else {
+			for(uint32_t range = 0; range < batch->n_ranges; range++) {
+				add_range(target->ranges, &target->n_ranges, &target->flush_all,
+					batch->ranges[range].start, batch->ranges[range].end);
+			}
+		}
+
+		tickets[i] = ++target->requested;
+
+		spinlock_release_irqrestore(&target->lock, flags);
+
+		// Pairs with the barrier in `tlb_exit_lazy`, between clearing the lazy
+		// flag and checking the queue.
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		if(__atomic_load_n(&target->lazy, __ATOMIC_RELAXED)) {
+			__atomic_add_fetch(&self->stats.lazy_skips, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		pending |= 1ULL << i;
+		apic_send_ipi(cpu_locals[i].apic_id, TLB_SHOOTDOWN_VECTOR);
+		__atomic_add_fetch(&self->stats.ipis, 1, __ATOMIC_RELAXED);
+	}
+
+	while(pending) {
+		for(uint64_t mask = pending; mask; mask &= mask - 1) {
+			/** The index of the CPU checked. */
+			const uint32_t i = __builtin_ctzll(mask);
+
+			if(__atomic_load_n(&tlb_cpus[i].completed, __ATOMIC_ACQUIRE) >= tickets[i]) {
+				pending &= ~(1ULL << i);
+			}
+		}
+
+		// Another CPU may be waiting on this one, which may have interrupts
+		// disabled.
+		if(__atomic_load_n(&self->requested, __ATOMIC_RELAXED) !=
+			__atomic_load_n(&self->completed, __ATOMIC_RELAXED)) {
+			process_queue(self);
+		}
+
+		cpu_relax();
+	}
+
+	__atomic_add_fetch(&self->stats.shootdowns, 1, __ATOMIC_RELAXED);
+
+	batch->n_ranges = 0;
+	batch->flush_all = false;
+}
+
+
+/**
+ * tlb_invalidate
+ */
+void tlb_invalidate(const uintptr_t address,
+	const size_t size)
+{
+	/** The batch holding the range. */
+	Tlb_Batch batch = {0};
+
+	tlb_batch_add(&batch, address, size);
+	tlb_batch_finish(&batch);
+}
+
+
+/**
+ * tlb_enter_lazy
+ */
+void tlb_enter_lazy(void)
+{
+	__atomic_store_n(&tlb_cpus[smp_get_cpu_index()].lazy, true,
+		__ATOMIC_RELAXED);
+}
+
+
+/**
+ * tlb_exit_lazy
+ */
+void tlb_exit_lazy(void)
+{
+	/** The current CPU's shootdown state. */
+	Tlb_Cpu* cpu = &tlb_cpus[smp_get_cpu_index()];
+
+	__atomic_store_n(&cpu->lazy, false, __ATOMIC_SEQ_CST);
+
+	if(__atomic_load_n(&cpu->requested, __ATOMIC_RELAXED) !=
+		__atomic_load_n(&cpu->completed, __ATOMIC_RELAXED)) {
+		process_queue(cpu);
+	}
+}
+
+
+/**
+ * tlb_interrupt_enter
+ */
+bool tlb_interrupt_enter(void)
+{
+	if(!__atomic_load_n(&tlb_cpus[smp_get_cpu_index()].lazy, __ATOMIC_RELAXED)) {
+		return false;
+	}
+
+	tlb_exit_lazy();
+
+	return true;
+}
+
+
+/**
+ * tlb_interrupt_exit
+ */
+void tlb_interrupt_exit(const bool lazy)
+{
+	if(lazy) {
+		tlb_enter_lazy();
+	}
+}
+
+
+/**
+ * tlb_get_stats
+ */
+void tlb_get_stats(Tlb_Stats* stats)
+{
+	*stats = (Tlb_Stats){0};
+
+	for(uint32_t i = 0; i < smp.n_cpus; i++) {
+		/** The CPU's statistics. */
+		const Tlb_Stats* cpu_stats = &tlb_cpus[i].stats;
+
+		stats->shootdowns += __atomic_load_n(&cpu_stats->shootdowns, __ATOMIC_RELAXED);
+		stats->ipis += __atomic_load_n(&cpu_stats->ipis, __ATOMIC_RELAXED);
+		stats->lazy_skips += __atomic_load_n(&cpu_stats->lazy_skips, __ATOMIC_RELAXED);
+		stats->full_flushes += __atomic_load_n(&cpu_stats->full_flushes,
+			__ATOMIC_RELAXED);
+		stats->page_flushes += __atomic_load_n(&cpu_stats->page_flushes,
+			__ATOMIC_RELAXED);
+	}
+}
+
+
+/**
+ * benchmark_busy_task
+ */
+static void benchmark_busy_task(void* argument)
+{
+	(void)argument;
+
+	__atomic_add_fetch(&benchmark_n_busy, 1, __ATOMIC_RELAXED);
+	while(!__atomic_load_n(&benchmark_stop, __ATOMIC_ACQUIRE)) {
+		cpu_relax();
+	}
+}
+
+
+/**
+ * tlb_run_benchmark
+ */
+static void tlb_run_benchmark(void)
+{
+	/** The number of pages unmapped in each round. */
+	const size_t n_pages = 1ULL << TLB_BENCHMARK_ORDER;
+	/** The size of the block unmapped in each round. */
+	const size_t size = n_pages * PAGE_SIZE;
+	/** The tasks keeping the other CPUs busy. */
+	Task tasks[SMP_MAX_CPUS];
+	/** The physical address of the block unmapped. */
+	uintptr_t pages;
+	/** The number of CPUs busy during the measurement, including this one. */
+	uint32_t n_busy = 1;
+
+	if(smp.n_online < 2) {
+		benchmark_skip("tlb", "single_cpu");
+		return;
+	}
+
+	pages = page_allocator_alloc(TLB_BENCHMARK_ORDER);
+	if(pages == 0) {
+		benchmark_skip("tlb", "no_free_memory");
+		return;
+	}
+
+	if(paging_map(TLB_BENCHMARK_ADDRESS, pages, size) != PAGING_SUCCESS) {
+		page_allocator_free(pages, TLB_BENCHMARK_ORDER);
+		benchmark_skip("tlb", "kernel_address_space_inactive");
+		return;
+	}
+
+	while(1) {
+		/** The group of the busy tasks. */
+		Task_Group group = {0};
+		/** The time after which to stop waiting for the busy CPUs. */
+		const uint64_t deadline = clock_now_ns() + TLB_BENCHMARK_TIMEOUT_NS;
+		/** Whether every busy CPU started in time. */
+		bool started;
+
+		__atomic_store_n(&benchmark_stop, false, __ATOMIC_RELAXED);
+		__atomic_store_n(&benchmark_n_busy, 0, __ATOMIC_RELAXED);
+
+		for(uint32_t i = 0; i < (n_busy - 1); i++) {
+			scheduler_spawn(&tasks[i], benchmark_busy_task, NULL, &group);
+		}
+
+		while(__atomic_load_n(&benchmark_n_busy, __ATOMIC_RELAXED) < (n_busy - 1) &&
+			clock_now_ns() < deadline) {
+			cpu_relax();
+		}
+
+		started = __atomic_load_n(&benchmark_n_busy, __ATOMIC_RELAXED) ==
+			(n_busy - 1);
+
+		for(int batched = 0; started && batched <= 1; batched++) {
+			/** The statistics before the measurement. */
+			Tlb_Stats before;
+			/** The statistics after the measurement. */
+			Tlb_Stats after;
+			/** The timestamp at the start of the measurement. */
+			uint64_t start;
+			/** The cycles taken by the measurement. */
+			uint64_t cycles = 0;
+
+			tlb_get_stats(&before);
+
+			for(size_t round = 0; round < TLB_BENCHMARK_ROUNDS; round++) {
+				/** The batch holding the unmapped pages. */
+				Tlb_Batch batch = {0};
+
+				start = read_timestamp_counter();
+				for(size_t page = 0; page < n_pages; page++) {
+					if(batched) {
+						paging_unmap_batched(TLB_BENCHMARK_ADDRESS + (page * PAGE_SIZE),
+							PAGE_SIZE, &batch);
+					} else {
+						paging_unmap(TLB_BENCHMARK_ADDRESS + (page * PAGE_SIZE), PAGE_SIZE);
+					}
+				}
+
+				if(batched) {
+					tlb_batch_finish(&batch);
+				}
+				cycles += read_timestamp_counter() - start;
+
+				paging_map(TLB_BENCHMARK_ADDRESS, pages, size);
+			}
+
+			tlb_get_stats(&after);
+
+			benchmark_report(&(Benchmark_Result){
+				.suite = "tlb", .name = "unmap",
+				.variant = batched ? "batched" : "per_page",
+				.size = n_busy,
+				.operations = TLB_BENCHMARK_ROUNDS * n_pages,
+				.cycles = cycles,
+				.counters = {
+					{ "ipis", after.ipis - before.ipis },
+					{ "lazy_skips", after.lazy_skips - before.lazy_skips }
+				}
+			});
+		}
+
+		__atomic_store_n(&benchmark_stop, true, __ATOMIC_RELEASE);
+		scheduler_wait(&group);
+
+		if(!started) {
+			benchmark_skip("tlb", "cpus_unavailable");
+			break;
+		}
+
+		if(n_busy == smp.n_online) {
+			break;
+		}
+
+		n_busy = (n_busy * 2) < smp.n_online ? (n_busy * 2) : smp.n_online;
+	}
+
+	paging_unmap(TLB_BENCHMARK_ADDRESS, size);
+	page_allocator_free(pages, TLB_BENCHMARK_ORDER);
+}
@@ -4,17 +4,194 @@
  * @date Aug 2019
  * @brief UART functionality.
  * Contains the implementation of the UART.
+ * Output is queued in each port's transmit ring, and written to the UART's
+ * FIFO up to `UART_FIFO_DEPTH` bytes at a time: by the transmitter empty
+ * interrupt once interrupts are enabled on the port, and by the writers
+ * themselves before then, or while they wait for space. Each port's lock is
+ * held by writers and by the interrupt handler, so the ring's producer and
+ * consumer state is only ever changed by one CPU at a time. The lock is only
+ * held to copy into the ring and to write at most one FIFO's worth of bytes:
+ * it is never held while waiting for the UART.
  */
 
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <interrupts.h>
+#include <pic.h>
 #include <port_io.h>
+#include <spinlock.h>
 #include <string.h>
 #include <uart.h>
 
-/* COM1 Port address*/
-#define UART_PORT_COM1 0x3f8
+#define UART_REGISTER_DATA                    0
+#define UART_REGISTER_INTERRUPT_ENABLE        1
+#define UART_REGISTER_DIVISOR_LOW             0
+#define UART_REGISTER_DIVISOR_HIGH            1
+#define UART_REGISTER_FIFO_CONTROL            2
+#define UART_REGISTER_LINE_CONTROL            3
+#define UART_REGISTER_MODEM_CONTROL           4
+#define UART_REGISTER_LINE_STATUS             5
+#define UART_REGISTER_SCRATCH                 7
+
+/** Interrupt enable register: Transmitter holding register empty. */
+#define UART_INTERRUPT_TRANSMIT_EMPTY         0x02
+/** FIFO control register: Enable the FIFOs, and clear them. */
+#define UART_FIFO_CONTROL_ENABLE_AND_CLEAR    0x07
+/** Line control register: 8 bits, no parity, one stop bit. */
+#define UART_LINE_CONTROL_8N1                 0x03
+/** Line control register: Divisor latch access. */
+#define UART_LINE_CONTROL_DLAB                0x80
+/** Modem control register: DTR, RTS, and OUT2, which gates the IRQ line. */
+#define UART_MODEM_CONTROL_IRQ_ENABLED        0x0B
+/** Line status register: Data ready. */
+#define UART_LINE_STATUS_DATA_READY           0x01
+/** Line status register: Transmitter holding register, and FIFO, empty. */
+#define UART_LINE_STATUS_TRANSMIT_EMPTY       0x20
+
+/** The value written to the scratch register to detect a UART. */
+#define UART_SCRATCH_TEST_VALUE               0xAE
+
+/** The number of bits sent on the line per byte, with 8N1 framing. */
+#define UART_BITS_PER_FRAME                   10
+/** The number of bytes written by the UART benchmark. */
+#define UART_BENCHMARK_SIZE                   0x10000
+/** The size of each write made by the UART benchmark. */
+#define UART_BENCHMARK_WRITE_SIZE             256
+
+/**
+ * Log port instance.
+ * Refer to definition in uart.h
+ */
+Uart_Port uart_log_port;
+/**
+ * Data port instance.
+ * Refer to definition in uart.h
+ */
+Uart_Port uart_data_port;
+
+/** The initialised ports, for dispatching their shared IRQs. */
+static Uart_Port* initialized_ports[UART_MAX_PORTS];
+/** The number of initialised ports. */
+static size_t n_initialized_ports = 0;
+
+/**
+ * @brief Fills a port's FIFO from its transmit ring.
+ * Must only be called with interrupts disabled, once the FIFO is empty.
+ * @param[in,out] port The port.
+ * @return The number of bytes written to the FIFO.
+ */
+static size_t uart_fill_transmit_fifo(Uart_Port* port);
+
+/**
+ * @brief Checks whether a port's transmit FIFO is empty.
+ * @param[in] port The port.
+ * @return Whether the FIFO is empty.
+ */
+static bool uart_port_is_transmit_fifo_empty(const Uart_Port* port);
+
+/**
+ * @brief Moves output from a port's transmit ring towards the UART.
+ * If transmission is interrupt-driven, this makes sure the transmitter
+ * interrupt is enabled, leaving the handler to drain the ring. Otherwise it
+ * fills the FIFO if it is empty. If `fill` is set, the FIFO is filled if it is
+ * empty regardless, in case the handler cannot run, such as when interrupts
+ * are disabled on the CPU its IRQ is routed to. This never waits for the UART.
+ * Must be called with the port locked.
+ * @param[in,out] port The port.
+ * @param[in] fill Whether to fill an empty FIFO even if transmission is
+ * interrupt-driven.
+ */
+static void uart_service_transmit_ring(Uart_Port* port,
+	const bool fill);
+
+/**
+ * @brief Waits for space in a port's full transmit ring.
+ * Starts the transmitter, then releases the port's lock while the FIFO
+ * drains, so that the interrupt handler and other CPUs' writers are not held
+ * off. The lock is retaken to refill the FIFO each time it empties, until the
+ * ring has space. Must be called with the port locked, and returns with it
+ * locked again. Other writers may have queued output meanwhile.
+ * @param[in,out] port The port.
+ * @param[in,out] flags The interrupt flag saved when the lock was acquired.
+ */
+static void uart_wait_for_transmit_space(Uart_Port* port,
+	uint64_t* flags);
+
+/**
+ * @brief Handles a UART IRQ.
+ * Refills the FIFO of every interrupt-driven port on the IRQ line whose
+ * transmitter has emptied, and stops the transmitter empty interrupt of any
+ * port whose ring is drained.
+ * @param[in] frame The interrupt frame.
+ */
+static void uart_interrupt_handler(Interrupt_Frame* frame);
+
+/**
+ * @brief Runs the UART benchmark.
+ * Measures the cost to the writer of queueing output, and the sustained rate
+ * at which it is transmitted, on the data port if there is one, otherwise on
+ * the log port.
+ */
+static void uart_run_benchmark(void);
+
+
+/**
+ * uart_get_default_irq
+ */
+uint8_t uart_get_default_irq(const uint16_t base)
+{
+	if(base == UART_PORT_COM2 || base == UART_PORT_COM4) {
+		return 3;
+	}
+
+	return 4;
+}
+
+
+/**
+ * uart_port_initialize
+ */
+bool uart_port_initialize(Uart_Port* port,
+	const Uart_Config* config)
+{
+	/** The port's IO port base. */
+	const uint16_t base = config->base;
+
+	port->initialized = false;
+
+	if(config->divisor == 0 || n_initialized_ports == UART_MAX_PORTS) {
+		return false;
+	}
+
+	outb(base + UART_REGISTER_SCRATCH, UART_SCRATCH_TEST_VALUE);
+	if(inb(base + UART_REGISTER_SCRATCH) != UART_SCRATCH_TEST_VALUE) {
+		return false;
+	}
+
+	outb(base + UART_REGISTER_INTERRUPT_ENABLE, 0);
+	outb(base + UART_REGISTER_LINE_CONTROL, UART_LINE_CONTROL_DLAB);
+	outb(base + UART_REGISTER_DIVISOR_LOW, config->divisor & 0xFF);
+	outb(base + UART_REGISTER_DIVISOR_HIGH, config->divisor >> 8);
+	outb(base + UART_REGISTER_LINE_CONTROL, UART_LINE_CONTROL_8N1);
+	outb(base + UART_REGISTER_FIFO_CONTROL,
+		UART_FIFO_CONTROL_ENABLE_AND_CLEAR | config->fifo_trigger);
+	outb(base + UART_REGISTER_MODEM_CONTROL, UART_MODEM_CONTROL_IRQ_ENABLED);
+
+	port->config = *config;
+	port->lock = (Spinlock)SPINLOCK_INITIALIZER;
+	port->interrupt_driven = false;
+	port->transmitter_active = false;
+	port->head = 0;
+	port->tail = 0;
+	port->initialized = true;
+
+	initialized_ports[n_initialized_ports++] = port;
+
+	return true;
+}
 
 
 /**
@@ -22,13 +199,66 @@
  */
 void uart_initialize(void)
 {
-	outb(UART_PORT_COM1 + 1, 0x00);    // Disable all interrupts
-	outb(UART_PORT_COM1 + 3, 0x80);    // Enable DLAB (set baud rate divisor)
-	outb(UART_PORT_COM1 + 0, 0x03);    // Set divisor to 3 (lo byte) 38400 baud
-	outb(UART_PORT_COM1 + 1, 0x00);    //                  (hi byte)
-	outb(UART_PORT_COM1 + 3, 0x03);    // 8 bits, no parity, one stop bit
-	outb(UART_PORT_COM1 + 2, 0xC7);    // Enable FIFO, clear them, with 14-byte threshold
-	outb(UART_PORT_COM1 + 4, 0x0B);    // IRQs enabled, RTS/DSR set
+	/** The port configuration. */
+	Uart_Config config;
+
+	config.base = UART_LOG_PORT_BASE;
+	config.divisor = UART_LOG_DIVISOR;
+	config.fifo_trigger = UART_FIFO_TRIGGER;
+	config.irq = uart_get_default_irq(config.base);
+	uart_port_initialize(&uart_log_port, &config);
+
+	#if UART_DATA_PORT_BASE != 0
+		config.base = UART_DATA_PORT_BASE;
+		config.divisor = UART_DATA_DIVISOR;
+		config.irq = uart_get_default_irq(config.base);
+		uart_port_initialize(&uart_data_port, &config);
+	#endif
+}
+
+
+/**
+ * uart_port_enable_interrupts
+ */
+bool uart_port_enable_interrupts(Uart_Port* port)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(!port->initialized) {
+		return false;
+	}
+
+	if(!interrupts_register_irq_handler(port->config.irq,
+		uart_interrupt_handler)) {
+		return false;
+	}
+
+	flags = spinlock_acquire_irqsave(&port->lock);
+	port->interrupt_driven = true;
+
+	// Start the transmitter for anything queued before now.
+	uart_service_transmit_ring(port, false);
+
+	spinlock_release_irqrestore(&port->lock, flags);
+
+	return true;
+}
+
+
+/**
+ * uart_enable_interrupts
+ */
+bool uart_enable_interrupts(void)
+{
+	/** Whether interrupts were enabled on every port. */
+	bool enabled = true;
+
+	for(size_t i = 0; i < n_initialized_ports; i++) {
+		enabled &= uart_port_enable_interrupts(initialized_ports[i]);
+	}
+
+	return enabled;
 }
 
 
@@ -37,7 +267,8 @@ void uart_initialize(void)
  */
 bool uart_is_receive_buffer_empty(void)
 {
-	return inb(UART_PORT_COM1 + 5) & 1;
+	return inb(uart_log_port.config.base + UART_REGISTER_LINE_STATUS) &
+		UART_LINE_STATUS_DATA_READY;
 }
 
 
@@ -48,7 +279,17 @@ char uart_getchar(void)
 {
 	while(!uart_is_receive_buffer_empty());
 
-	return inb(UART_PORT_COM1);
+	return inb(uart_log_port.config.base + UART_REGISTER_DATA);
+}
+
+
+/**
+ * uart_port_is_transmit_fifo_empty
+ */
+static bool uart_port_is_transmit_fifo_empty(const Uart_Port* port)
+{
+	return (inb(port->config.base + UART_REGISTER_LINE_STATUS) &
+		UART_LINE_STATUS_TRANSMIT_EMPTY) != 0;
 }
 
 
@@ -57,7 +298,248 @@ char uart_getchar(void)
  */
 bool uart_is_transmit_buffer_empty(void)
 {
-	return (inb(UART_PORT_COM1 + 5) & 0x20) != 0;
+	return uart_port_is_transmit_fifo_empty(&uart_log_port);
+}
+
+
+/**
+ * uart_fill_transmit_fifo
+ */
+static size_t uart_fill_transmit_fifo(Uart_Port* port)
+{
+	/** The position of the next byte to transmit. */
+	uint32_t tail = port->tail;
+	/** The number of bytes queued in the ring. */
+	uint32_t queued = __atomic_load_n(&port->head, __ATOMIC_ACQUIRE) - tail;
+	/** The number of bytes to write to the FIFO. */
+	size_t count = queued < UART_FIFO_DEPTH ? queued : UART_FIFO_DEPTH;
+
+	for(size_t i = 0; i < count; i++) {
+		outb(port->config.base + UART_REGISTER_DATA,
+			port->buffer[(tail + i) & (UART_TRANSMIT_RING_SIZE - 1)]);
+	}
+
+	__atomic_store_n(&port->tail, tail + count, __ATOMIC_RELEASE);
+
+	return count;
+}
+
+
+/**
+ * uart_service_transmit_ring
+ */
+static void uart_service_transmit_ring(Uart_Port* port,
+	const bool fill)
+{
+	if((fill || !port->interrupt_driven) && uart_port_is_transmit_fifo_empty(port)) {
+		uart_fill_transmit_fifo(port);
+	}
+
+	// The handler only stops the transmitter with the lock held, after finding
+	// the ring empty, so it is always restarted for anything queued since.
+	if(port->interrupt_driven && !port->transmitter_active &&
+		port->head != port->tail) {
+		port->transmitter_active = true;
+		outb(port->config.base + UART_REGISTER_INTERRUPT_ENABLE,
+			UART_INTERRUPT_TRANSMIT_EMPTY);
+	}
+}
+
+
+/**
+ * uart_wait_for_transmit_space
+ */
+static void uart_wait_for_transmit_space(Uart_Port* port,
+	uint64_t* flags)
+{
+	/** The position of the next byte to transmit when the wait began. */
+	const uint32_t tail = port->tail;
+
+	uart_service_transmit_ring(port, false);
+
+	while(port->tail == tail) {
+		spinlock_release_irqrestore(&port->lock, *flags);
+
+		while(!uart_port_is_transmit_fifo_empty(port) &&
+			__atomic_load_n(&port->tail, __ATOMIC_ACQUIRE) == tail) {
+			cpu_relax();
+		}
+
+		*flags = spinlock_acquire_irqsave(&port->lock);
+		if(port->tail == tail) {
+			uart_service_transmit_ring(port, true);
+		}
+	}
+}
+
+
+/**
+ * uart_interrupt_handler
+ */
+static void uart_interrupt_handler(Interrupt_Frame* frame)
+{
+	/** The IRQ line being handled. */
+	const uint8_t irq = frame->vector - PIC_IRQ_BASE_VECTOR;
+	/** The current port. */
+	Uart_Port* port;
+
+	for(size_t i = 0; i < n_initialized_ports; i++) {
+		port = initialized_ports[i];
+		if(port->config.irq != irq) {
+			continue;
+		}
+
+		spinlock_acquire(&port->lock);
+
+		if(port->transmitter_active && uart_port_is_transmit_fifo_empty(port) &&
+			uart_fill_transmit_fifo(port) == 0) {
+			port->transmitter_active = false;
+			outb(port->config.base + UART_REGISTER_INTERRUPT_ENABLE, 0);
+		}
+
+		spinlock_release(&port->lock);
+	}
+}
+
+
+/**
+ * uart_port_write
+ */
+void uart_port_write(Uart_Port* port,
+	const void* data,
+	const size_t length)
+{
+	/** The next byte to queue. */
+	const char* src = data;
+	/** The number of bytes left to queue. */
+	size_t remaining = length;
+	/** The position of the next byte to queue. */
+	uint32_t head;
+	/** The number of bytes queued at once. */
+	size_t count;
+	/** The offset of the head within the ring. */
+	size_t offset;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(!port->initialized) {
+		return;
+	}
+
+	flags = spinlock_acquire_irqsave(&port->lock);
+	head = port->head;
+
+	while(remaining > 0) {
+		count = UART_TRANSMIT_RING_SIZE -
+			(head - __atomic_load_n(&port->tail, __ATOMIC_ACQUIRE));
+
+		if(count == 0) {
+			// Writers only block once the ring is full.
+			__atomic_store_n(&port->head, head, __ATOMIC_RELEASE);
+			uart_wait_for_transmit_space(port, &flags);
+			head = port->head;
+			continue;
+		}
+
+		// Copy up to the end of the ring, then wrap on the next iteration.
+		offset = head & (UART_TRANSMIT_RING_SIZE - 1);
+		if(count > UART_TRANSMIT_RING_SIZE - offset) {
+			count = UART_TRANSMIT_RING_SIZE - offset;
+		}
+		if(count > remaining) {
+			count = remaining;
+		}
+
+		memcpy(port->buffer + offset, src, count);
+
+		src += count;
+		remaining -= count;
+		head += count;
+	}
+
+	__atomic_store_n(&port->head, head, __ATOMIC_RELEASE);
+	uart_service_transmit_ring(port, false);
+
+	spinlock_release_irqrestore(&port->lock, flags);
+}
+
+
+/**
+ * uart_port_puts
+ */
+void uart_port_puts(Uart_Port* port,
+	const char* str)
+{
+	/** The position of the next byte to queue. */
+	uint32_t head;
+	/** The number of free bytes in the ring. */
+	uint32_t space = 0;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(!port->initialized) {
+		return;
+	}
+
+	flags = spinlock_acquire_irqsave(&port->lock);
+	head = port->head;
+
+	while(*str) {
+		space = UART_TRANSMIT_RING_SIZE -
+			(head - __atomic_load_n(&port->tail, __ATOMIC_ACQUIRE));
+
+		if(space == 0) {
+			// Writers only block once the ring is full.
+			__atomic_store_n(&port->head, head, __ATOMIC_RELEASE);
+			uart_wait_for_transmit_space(port, &flags);
+			head = port->head;
+			continue;
+		}
+
+		for(; space > 0 && *str; space--) {
+			port->buffer[head++ & (UART_TRANSMIT_RING_SIZE - 1)] = *str++;
+		}
+	}
+
+	__atomic_store_n(&port->head, head, __ATOMIC_RELEASE);
+	uart_service_transmit_ring(port, false);
+
+	spinlock_release_irqrestore(&port->lock, flags);
+}
+
+
+/**
+ * uart_port_flush
+ */
+void uart_port_flush(Uart_Port* port)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(!port->initialized) {
+		return;
+	}
+
+	// The lock is only taken to refill the FIFO once it empties, so that the
+	// handler and other writers are not held off for the whole flush.
+	while(__atomic_load_n(&port->tail, __ATOMIC_ACQUIRE) !=
+		__atomic_load_n(&port->head, __ATOMIC_ACQUIRE)) {
+		while(!uart_port_is_transmit_fifo_empty(port) &&
+			__atomic_load_n(&port->tail, __ATOMIC_ACQUIRE) !=
+			__atomic_load_n(&port->head, __ATOMIC_ACQUIRE)) {
+			cpu_relax();
+		}
+
+		flags = spinlock_acquire_irqsave(&port->lock);
+		if(port->tail != port->head) {
+			uart_service_transmit_ring(port, true);
+		}
+		spinlock_release_irqrestore(&port->lock, flags);
+	}
+
+	while(!uart_port_is_transmit_fifo_empty(port)) {
+		cpu_relax();
+	}
 }
 
 
@@ -66,9 +548,7 @@ bool uart_is_transmit_buffer_empty(void)
  */
 void uart_putchar(char a)
 {
-	while(!uart_is_transmit_buffer_empty());
-
-	outb(UART_PORT_COM1, a);
+	uart_port_write(&uart_log_port, &a, 1);
 }
 
 
@@ -77,9 +557,64 @@ void uart_putchar(char a)
  */
 void uart_puts(const char* str)
 {
-	/** The length of the string being written to serial out. */
-	size_t str_len = strlen(str);
-	for(size_t i = 0; i < str_len; i++) {
-		uart_putchar(str[i]);
+	uart_port_puts(&uart_log_port, str);
+}
+
+
+/**
+ * uart_flush
+ */
+void uart_flush(void)
+{
+	uart_port_flush(&uart_log_port);
+}
+
+
+/**
+ * uart_run_benchmark
+ */
+static void uart_run_benchmark(void)
+{
+	/** The port being measured. */
+	Uart_Port* port = uart_data_port.initialized ? &uart_data_port : &uart_log_port;
+	/** The data written by the benchmark. */
+	char data[UART_BENCHMARK_WRITE_SIZE];
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The cycles the writer spent queueing the data. */
+	uint64_t write_cycles = 0;
+	/** The timestamp at the start of the current write. */
+	uint64_t write_start;
+	/** The cycles taken to transmit all of the data. */
+	uint64_t total_cycles;
+
+	for(size_t i = 0; i < UART_BENCHMARK_WRITE_SIZE; i++) {
+		data[i] = (i % 64 == 63) ? '\n' : (char)('0' + (i % 64) % 10);
 	}
+
+	uart_port_flush(port);
+
+	start = read_timestamp_counter();
+	for(size_t i = 0; i < UART_BENCHMARK_SIZE / UART_BENCHMARK_WRITE_SIZE; i++) {
+		write_start = read_timestamp_counter();
+		uart_port_write(port, data, UART_BENCHMARK_WRITE_SIZE);
+		write_cycles += read_timestamp_counter() - write_start;
+	}
+	uart_port_flush(port);
+	total_cycles = read_timestamp_counter() - start;
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "uart", .name = "write",
+		.variant = port->interrupt_driven ? "interrupt" : "polled",
+		.size = UART_BENCHMARK_WRITE_SIZE,
+		.operations = UART_BENCHMARK_SIZE / UART_BENCHMARK_WRITE_SIZE,
+		.cycles = total_cycles, .bytes = UART_BENCHMARK_SIZE,
+		.counters = {
+			{"writer_cycles", write_cycles},
+			{"line_bytes_per_s",
+				UART_MAX_BAUD_RATE / port->config.divisor / UART_BITS_PER_FRAME}
+		}
+	});
 }
+
+BENCHMARK(uart, uart_run_benchmark);
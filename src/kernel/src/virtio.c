@@ -0,0 +1,150 @@
+/**
+ * @file virtio.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Virtio functionality.
+ * Contains the implementation of virtqueues over the legacy virtio PCI
+ * transport.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pci.h>
+#include <port_io.h>
+#include <string.h>
+#include <virtio.h>
+
+
+/**
+ * virtio_legacy_reset_device
+ */
+bool virtio_legacy_reset_device(const Pci_Device* dev,
+	uint16_t* io_base)
+{
+	/** The device's first BAR. */
+	uint32_t bar = pci_config_read32(dev, PCI_CONFIG_BAR0);
+
+	if(!(bar & PCI_BAR_IO_SPACE)) {
+		return false;
+	}
+
+	*io_base = bar & PCI_BAR_IO_ADDRESS_MASK;
+
+	pci_config_write16(dev, PCI_CONFIG_COMMAND,
+		pci_config_read16(dev, PCI_CONFIG_COMMAND) |
+		PCI_COMMAND_IO_SPACE | PCI_COMMAND_BUS_MASTER);
+
+	outb(*io_base + VIRTIO_LEGACY_DEVICE_STATUS, 0);
+	outb(*io_base + VIRTIO_LEGACY_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+	outb(*io_base + VIRTIO_LEGACY_DEVICE_STATUS,
+		VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+	return true;
+}
+
+
+/**
+ * virtqueue_initialize
+ */
+bool virtqueue_initialize(Virtqueue* queue,
+	const uint16_t io_base,
+	const uint16_t queue_index,
+	void* memory)
+{
+	/** The queue memory. */
+	uint8_t* base = memory;
+	/** The size of the queue, set by the device. */
+	uint16_t size;
+	/** The offset of the used ring within the queue memory. */
+	size_t used_offset;
+
+	outw(io_base + VIRTIO_LEGACY_QUEUE_SELECT, queue_index);
+	size = inw(io_base + VIRTIO_LEGACY_QUEUE_SIZE);
+	if(size == 0 || size > VIRTQUEUE_MAX_SIZE) {
+		return false;
+	}
+
+	memset(base, 0, VIRTQUEUE_MEMORY_SIZE);
+
+	used_offset = (sizeof(Virtq_Desc) * size) +
+		sizeof(Virtq_Avail) + (sizeof(uint16_t) * (size + 1));
+	used_offset = (used_offset + VIRTQUEUE_ALIGNMENT - 1) &
+		~(size_t)(VIRTQUEUE_ALIGNMENT - 1);
+
+	queue->io_base = io_base;
+	queue->queue_index = queue_index;
+	queue->size = size;
+	queue->last_used_index = 0;
+	queue->n_unnotified = 0;
+	queue->n_notifications = 0;
+	queue->descriptors = (Virtq_Desc*)base;
+	queue->available = (Virtq_Avail*)(base + (sizeof(Virtq_Desc) * size));
+	queue->used = (Virtq_Used*)(base + used_offset);
+
+	outl(io_base + VIRTIO_LEGACY_QUEUE_ADDRESS,
+		(uintptr_t)base / VIRTQUEUE_ALIGNMENT);
+
+	return true;
+}
+
+
+/**
+ * virtqueue_submit
+ */
+void virtqueue_submit(Virtqueue* queue,
+	const uint16_t descriptor)
+{
+	/** The free-running index of the next available ring entry. */
+	uint16_t index = queue->available->index;
+
+	queue->available->ring[index % queue->size] = descriptor;
+
+	// The ring entry must be visible before the index is published.
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	queue->available->index = index + 1;
+
+	queue->n_unnotified++;
+}
+
+
+/**
+ * virtqueue_notify
+ */
+void virtqueue_notify(Virtqueue* queue)
+{
+	if(queue->n_unnotified == 0) {
+		return;
+	}
+
+	queue->n_unnotified = 0;
+
+	// The published index must be visible before reading whether the device
+	// wants to be notified of it.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(queue->used->flags & VIRTQ_USED_F_NO_NOTIFY) {
+		return;
+	}
+
+	queue->n_notifications++;
+	outw(queue->io_base + VIRTIO_LEGACY_QUEUE_NOTIFY, queue->queue_index);
+}
+
+
+/**
+ * virtqueue_take_used
+ */
+bool virtqueue_take_used(Virtqueue* queue,
+	uint16_t* descriptor)
+{
+	if(queue->used->index == queue->last_used_index) {
+		return false;
+	}
+
+	// The element must not be read before the index that published it.
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	*descriptor = queue->used->ring[queue->last_used_index % queue->size].id;
+	queue->last_used_index++;
+
+	return true;
+}
@@ -0,0 +1,419 @@
+/**
+ * @file virtio_console.c
+ * @author ajxs
+ * @date Oct 2026
+ * @brief Virtio console functionality.
+ * Contains the implementation of the virtio console driver.
+ * Only port 0 is used, so the multiport feature is not negotiated, and the
+ * receive and control queues are left unconfigured.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <benchmark.h>
+#include <cpu.h>
+#include <interrupts.h>
+#include <pci.h>
+#include <pic.h>
+#include <port_io.h>
+#include <spinlock.h>
+#include <string.h>
+#include <virtio.h>
+#include <virtio_console.h>
+
+/** The number of bytes written by the benchmark. */
+#define VIRTIO_CONSOLE_BENCHMARK_SIZE       0x100000
+/** The size of each write made by the benchmark. */
+#define VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE 256
+
+/**
+ * Log console instance.
+ * Refer to definition in virtio_console.h
+ */
+Virtio_Console virtio_log_console;
+/**
+ * Data console instance.
+ * Refer to definition in virtio_console.h
+ */
+Virtio_Console virtio_data_console;
+
+/**
+ * @brief Reclaims the buffers the device has completed.
+ * Must be called with the console locked.
+ * @param[in,out] con The console.
+ */
+static void virtio_console_reclaim_buffers(Virtio_Console* con);
+
+/**
+ * @brief Takes a free transmit buffer to fill.
+ * Waits for the device to complete a buffer if none are free, polling for
+ * completions itself. Must be called with the console locked.
+ * @param[in,out] con The console.
+ */
+static void virtio_console_acquire_buffer(Virtio_Console* con);
+
+/**
+ * @brief Submits the current transmit buffer.
+ * Notifies the device once `VIRTIO_CONSOLE_NOTIFY_BATCH` buffers are waiting.
+ * Must be called with the console locked.
+ * @param[in,out] con The console.
+ */
+static void virtio_console_submit_buffer(Virtio_Console* con);
+
+/**
+ * @brief Handles a virtio console IRQ.
+ * Acknowledges the interrupt of each console on the IRQ line, and reclaims
+ * its completed buffers.
+ * @param[in] frame The interrupt frame.
+ */
+static void virtio_console_interrupt_handler(Interrupt_Frame* frame);
+
+/**
+ * @brief Runs the virtio console benchmark.
+ * Measures the cost to the writer of writing to the data console, or the log
+ * console if there is no data console, and the sustained rate at which the
+ * device consumes it.
+ */
+static void virtio_console_run_benchmark(void);
+
+
+/**
+ * virtio_console_initialize
+ */
+bool virtio_console_initialize(Virtio_Console* con,
+	const size_t index)
+{
+	/** The transmit queue. */
+	Virtqueue* queue = &con->transmit_queue;
+
+	con->initialized = false;
+	con->lock = (Spinlock)SPINLOCK_INITIALIZER;
+
+	if(!pci_find_device(VIRTIO_PCI_VENDOR_ID, VIRTIO_CONSOLE_DEVICE_ID, index,
+		&con->pci_device)) {
+		return false;
+	}
+
+	if(!virtio_legacy_reset_device(&con->pci_device, &con->io_base)) {
+		return false;
+	}
+
+	// No features are needed.
+	outl(con->io_base + VIRTIO_LEGACY_DRIVER_FEATURES, 0);
+
+	if(!virtqueue_initialize(queue, con->io_base, VIRTIO_CONSOLE_TRANSMIT_QUEUE,
+		con->queue_memory) || queue->size < VIRTIO_CONSOLE_BUFFER_COUNT) {
+		outb(con->io_base + VIRTIO_LEGACY_DEVICE_STATUS, VIRTIO_STATUS_FAILED);
+		return false;
+	}
+
+	// Completions are polled until interrupts are enabled.
+	queue->available->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
+
+	for(uint16_t i = 0; i < VIRTIO_CONSOLE_BUFFER_COUNT; i++) {
+		con->free_buffers[i] = i;
+	}
+
+	con->n_free_buffers = VIRTIO_CONSOLE_BUFFER_COUNT;
+	con->current_buffer = VIRTIO_CONSOLE_NO_BUFFER;
+	con->current_length = 0;
+	con->last_submit = 0;
+	con->interrupt_driven = false;
+	con->irq = pci_config_read8(&con->pci_device, PCI_CONFIG_INTERRUPT_LINE);
+
+	outb(con->io_base + VIRTIO_LEGACY_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE |
+		VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+
+	con->initialized = true;
+
+	return true;
+}
+
+
+/**
+ * virtio_console_enable_interrupts
+ */
+bool virtio_console_enable_interrupts(Virtio_Console* con)
+{
+	if(!con->initialized || con->irq >= PIC_IRQ_COUNT) {
+		return false;
+	}
+
+	if(!interrupts_register_irq_handler(con->irq,
+		virtio_console_interrupt_handler)) {
+		return false;
+	}
+
+	con->interrupt_driven = true;
+	con->transmit_queue.available->flags = 0;
+
+	return true;
+}
+
+
+/**
+ * virtio_console_reclaim_buffers
+ */
+static void virtio_console_reclaim_buffers(Virtio_Console* con)
+{
+	/** The descriptor of the completed buffer. */
+	uint16_t descriptor;
+
+	while(virtqueue_take_used(&con->transmit_queue, &descriptor)) {
+		con->free_buffers[con->n_free_buffers++] = descriptor;
+	}
+}
+
+
+/**
+ * virtio_console_acquire_buffer
+ */
+static void virtio_console_acquire_buffer(Virtio_Console* con)
+{
+	while(1) {
+		virtio_console_reclaim_buffers(con);
+		if(con->n_free_buffers > 0) {
+			con->current_buffer = con->free_buffers[--con->n_free_buffers];
+			con->current_length = 0;
+
+			return;
+		}
+
+		// Every buffer is in flight, so make sure the device knows of them.
+		virtqueue_notify(&con->transmit_queue);
+		cpu_relax();
+	}
+}
+
+
+/**
+ * virtio_console_submit_buffer
+ */
+static void virtio_console_submit_buffer(Virtio_Console* con)
+{
+	/** The descriptor of the buffer. */
+	volatile Virtq_Desc* descriptor =
+		&con->transmit_queue.descriptors[con->current_buffer];
+
+	descriptor->address = (uintptr_t)con->buffers[con->current_buffer];
+	descriptor->length = con->current_length;
+	descriptor->flags = 0;
+	descriptor->next = 0;
+
+	virtqueue_submit(&con->transmit_queue, con->current_buffer);
+
+	con->current_buffer = VIRTIO_CONSOLE_NO_BUFFER;
+	con->last_submit = read_timestamp_counter();
+
+	if(con->transmit_queue.n_unnotified >= VIRTIO_CONSOLE_NOTIFY_BATCH) {
+		virtqueue_notify(&con->transmit_queue);
+	}
+}
+
+
+/**
+ * virtio_console_interrupt_handler
+ */
+static void virtio_console_interrupt_handler(Interrupt_Frame* frame)
+{
+	/** The IRQ line being handled. */
+	const uint8_t irq = frame->vector - PIC_IRQ_BASE_VECTOR;
+	/** The consoles which may share the IRQ line. */
+	Virtio_Console* consoles[] = {&virtio_log_console, &virtio_data_console};
+
+	for(size_t i = 0; i < sizeof(consoles) / sizeof(consoles[0]); i++) {
+		if(!consoles[i]->interrupt_driven || consoles[i]->irq != irq) {
+			continue;
+		}
+
+		// Reading the ISR status acknowledges the interrupt.
+		if(inb(consoles[i]->io_base + VIRTIO_LEGACY_ISR_STATUS) & VIRTIO_ISR_QUEUE) {
+			spinlock_acquire(&consoles[i]->lock);
+			virtio_console_reclaim_buffers(consoles[i]);
+			spinlock_release(&consoles[i]->lock);
+		}
+	}
+}
+
+
+/**
+ * virtio_console_write
+ */
+void virtio_console_write(Virtio_Console* con,
+	const void* data,
+	const size_t length)
+{
+	/** The next byte to write. */
+	const uint8_t* src = data;
+	/** The number of bytes left to write. */
+	size_t remaining = length;
+	/** The number of bytes copied into the current buffer at once. */
+	size_t count;
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(!con->initialized) {
+		return;
+	}
+
+	flags = spinlock_acquire_irqsave(&con->lock);
+
+	while(remaining > 0) {
+		if(con->current_buffer == VIRTIO_CONSOLE_NO_BUFFER) {
+			virtio_console_acquire_buffer(con);
+		}
+
+		count = VIRTIO_CONSOLE_BUFFER_SIZE - con->current_length;
+		if(count > remaining) {
+			count = remaining;
+		}
+
+		memcpy(con->buffers[con->current_buffer] + con->current_length, src, count);
+
+		src += count;
+		remaining -= count;
+		con->current_length += count;
+
+		if(con->current_length == VIRTIO_CONSOLE_BUFFER_SIZE) {
+			virtio_console_submit_buffer(con);
+		}
+	}
+
+	// Writes arriving after a quiet period are sent at once, rather than
+	// waiting for the buffer to fill.
+	if((read_timestamp_counter() - con->last_submit) >=
+		VIRTIO_CONSOLE_SUBMIT_INTERVAL_CYCLES) {
+		if(con->current_buffer != VIRTIO_CONSOLE_NO_BUFFER) {
+			virtio_console_submit_buffer(con);
+		}
+
+		virtqueue_notify(&con->transmit_queue);
+	}
+
+	spinlock_release_irqrestore(&con->lock, flags);
+}
+
+
+/**
+ * virtio_console_submit_pending
+ */
+void virtio_console_submit_pending(Virtio_Console* con)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+
+	if(!con->initialized) {
+		return;
+	}
+
+	flags = spinlock_acquire_irqsave(&con->lock);
+
+	if(con->current_buffer != VIRTIO_CONSOLE_NO_BUFFER &&
+		con->current_length > 0) {
+		virtio_console_submit_buffer(con);
+	}
+
+	if(con->transmit_queue.n_unnotified > 0) {
+		virtqueue_notify(&con->transmit_queue);
+	}
+
+	spinlock_release_irqrestore(&con->lock, flags);
+}
+
+
+/**
+ * virtio_console_flush
+ */
+void virtio_console_flush(Virtio_Console* con)
+{
+	/** The saved interrupt flag. */
+	uint64_t flags;
+	/** The number of buffers not in flight. */
+	uint16_t n_idle;
+
+	if(!con->initialized) {
+		return;
+	}
+
+	flags = spinlock_acquire_irqsave(&con->lock);
+
+	if(con->current_buffer != VIRTIO_CONSOLE_NO_BUFFER &&
+		con->current_length > 0) {
+		virtio_console_submit_buffer(con);
+	}
+
+	virtqueue_notify(&con->transmit_queue);
+
+	spinlock_release_irqrestore(&con->lock, flags);
+
+	do {
+		flags = spinlock_acquire_irqsave(&con->lock);
+		virtio_console_reclaim_buffers(con);
+		n_idle = con->n_free_buffers +
+			(con->current_buffer != VIRTIO_CONSOLE_NO_BUFFER ? 1 : 0);
+		spinlock_release_irqrestore(&con->lock, flags);
+
+		cpu_relax();
+	} while(n_idle < VIRTIO_CONSOLE_BUFFER_COUNT);
+}
+
+
+/**
+ * virtio_console_run_benchmark
+ */
+static void virtio_console_run_benchmark(void)
+{
+	/** The console being measured. */
+	Virtio_Console* con = virtio_data_console.initialized ?
+		&virtio_data_console : &virtio_log_console;
+	/** The data written by the benchmark. */
+	char data[VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE];
+	/** The timestamp at the start of the measurement. */
+	uint64_t start;
+	/** The timestamp at the start of the current write. */
+	uint64_t write_start;
+	/** The cycles the writer spent writing the data. */
+	uint64_t write_cycles = 0;
+	/** The cycles taken for the device to consume all of the data. */
+	uint64_t total_cycles;
+	/** The number of notifications before the measurement. */
+	uint64_t n_notifications;
+
+	if(!con->initialized) {
+		benchmark_skip("virtio_console", "no-device");
+		return;
+	}
+
+	for(size_t i = 0; i < VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE; i++) {
+		data[i] = (i % 64 == 63) ? '\n' : (char)('0' + (i % 64) % 10);
+	}
+
+	virtio_console_flush(con);
+	n_notifications = con->transmit_queue.n_notifications;
+
+	start = read_timestamp_counter();
+	for(size_t i = 0;
+		i < VIRTIO_CONSOLE_BENCHMARK_SIZE / VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE;
+		i++) {
+		write_start = read_timestamp_counter();
+		virtio_console_write(con, data, VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE);
+		write_cycles += read_timestamp_counter() - write_start;
+	}
+	virtio_console_flush(con);
+	total_cycles = read_timestamp_counter() - start;
+
+	benchmark_report(&(Benchmark_Result){
+		.suite = "virtio_console", .name = "write",
+		.variant = con->interrupt_driven ? "interrupt" : "polled",
+		.size = VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE,
+		.operations = VIRTIO_CONSOLE_BENCHMARK_SIZE / VIRTIO_CONSOLE_BENCHMARK_WRITE_SIZE,
+		.cycles = total_cycles, .bytes = VIRTIO_CONSOLE_BENCHMARK_SIZE,
+		.counters = {
+			{"writer_cycles", write_cycles},
+			{"notifications", con->transmit_queue.n_notifications - n_notifications}
+		}
+	});
+}
+
+BENCHMARK(virtio_console, virtio_console_run_benchmark);
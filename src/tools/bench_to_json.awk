@@ -0,0 +1,111 @@
+#####################################################################
+#  Copyright (c) 2019, AJXS.
+#  This program is free software; you can redistribute it and/or modify it
+#  under the terms of the GNU General Public License as published by the
+#  Free Software Foundation; either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  Authors:
+#     Anthony <ajxs [at] panoptic.online>
+#####################################################################
+
+# Collects the kernel's benchmark output into JSON.
+# Reads the serial log of a benchmark mode boot, and writes the `BENCH` result
+# lines, skipped suites and per-suite run times as a JSON document. Exits with
+# status 1 if the run did not reach `BENCH_END`.
+# Refer to src/kernel/src/include/benchmark.h for the line format.
+
+# Formats a field value, unquoted if it is a number.
+function json_value(value) {
+	if(value ~ /^[0-9]+$/) {
+		return value
+	}
+
+	gsub(/\\/, "\\\\", value)
+	gsub(/"/, "\\\"", value)
+
+	return "\"" value "\""
+}
+
+# Formats the key=value fields of the current line, from `first`, as an object.
+function json_object(first,    i, separator, key, object) {
+	object = "{"
+
+	for(i = first; i <= NF; i++) {
+		separator = index($i, "=")
+		if(separator == 0) {
+			continue
+		}
+
+		key = substr($i, 1, separator - 1)
+		object = object (object == "{" ? "" : ", ") "\"" key "\": " \
+			json_value(substr($i, separator + 1))
+	}
+
+	return object "}"
+}
+
+BEGIN {
+	header = ""
+	complete = "false"
+	n_results = 0
+	n_skipped = 0
+	n_suites = 0
+}
+
+{
+	sub(/\r$/, "")
+
+	# Other output may share the line, so find where the record starts.
+	start = match($0, /BENCH(_[A-Z]+)? /)
+	if(start == 0) {
+		next
+	}
+
+	$0 = substr($0, start)
+}
+
+$1 == "BENCH_BEGIN" {
+	header = json_object(2)
+}
+
+$1 == "BENCH" {
+	results[n_results++] = json_object(2)
+}
+
+$1 == "BENCH_SKIP" {
+	skipped[n_skipped++] = json_object(2)
+}
+
+$1 == "BENCH_DONE" {
+	suites[n_suites++] = json_object(2)
+}
+
+$1 == "BENCH_END" {
+	complete = "true"
+}
+
+END {
+	printf "{\n  \"complete\": %s,\n", complete
+	printf "  \"machine\": %s,\n", (header == "" ? "null" : header)
+
+	printf "  \"suites\": ["
+	for(i = 0; i < n_suites; i++) {
+		printf "%s\n    %s", (i == 0 ? "" : ","), suites[i]
+	}
+	printf "%s],\n", (n_suites > 0 ? "\n  " : "")
+
+	printf "  \"skipped\": ["
+	for(i = 0; i < n_skipped; i++) {
+		printf "%s\n    %s", (i == 0 ? "" : ","), skipped[i]
+	}
+	printf "%s],\n", (n_skipped > 0 ? "\n  " : "")
+
+	printf "  \"results\": ["
+	for(i = 0; i < n_results; i++) {
+		printf "%s\n    %s", (i == 0 ? "" : ","), results[i]
+	}
+	printf "%s]\n}\n", (n_results > 0 ? "\n  " : "")
+
+	exit (complete == "true" ? 0 : 1)
+}